@@ -33,6 +33,7 @@
 #include "defines.h"
 #include "axi4_segment.h"
 #include "sysbus_axi_struct.h"
+#include "sparse_mem.h"
 
 #ifdef INITIALIZE_RAM
 
@@ -51,17 +52,19 @@ public:
   r_slave<AUTO_PORT>     CCS_INIT_S1(r_slave0);
   w_slave<AUTO_PORT>     CCS_INIT_S1(w_slave0);
 
-  static const int sz = MEM_SIZE; // size in axi_cfg::dataWidth words
-
   typedef NVUINTW(axi_cfg::dataWidth) arr_t;
-  arr_t* array {0};
+
+  // The whole bus address space, allocated a page at a time on first touch.
+  // Untouched words read as their own address.
+  sparse_mem mem{12, bytesPerBeat};
+
+  // If set, the pages touched are dumped here at the end of simulation
+  std::string dump_file;
 
   bool chatty = false;
 
   SC_CTOR(sys_ram)
   {
-    array = new arr_t[sz];
-
     SC_THREAD(slave_r_process);
     sensitive << clk.pos();
     async_reset_signal_is(rst_bar, false);
@@ -70,24 +73,39 @@ public:
     sensitive << clk.pos();
     async_reset_signal_is(rst_bar, false);
 
-    for (int i=0; i < sz; i++)
-      array[i] = i * bytesPerBeat;
-
 #ifdef INITIALIZE_RAM
     load_weights_and_biases();
 #endif
   }
 
+  arr_t read_word(uint64_t addr) { return mem.get<arr_t>(addr - (addr % bytesPerBeat)); }
+  void write_word(uint64_t addr, arr_t data) { mem.set(addr - (addr % bytesPerBeat), data); }
+
   NVUINTW(axi_cfg::dataWidth) debug_read_addr(uint32_t addr)
   {
-    std::string address_error = "invalid addr, attempted access at " + std::to_string(addr);
+    return read_word(addr);
+  }
 
-    if (addr >= (sz * bytesPerBeat)) {
-      SC_REPORT_ERROR("ram", address_error.c_str());
-      return 0;
-    }
+  void load_binary(std::string filename, uint64_t addr)
+  {
+    if (!mem.load_binary(filename, addr))
+      SC_REPORT_ERROR(this->name(), ("Unable to load " + filename).c_str());
+  }
 
-    return(array[addr / bytesPerBeat]);
+  // returns the entry point of the image
+  uint64_t load_elf(std::string filename)
+  {
+    uint64_t entry = 0;
+
+    if (!mem.load_elf(filename, &entry))
+      SC_REPORT_ERROR(this->name(), ("Unable to load ELF file " + filename).c_str());
+    return entry;
+  }
+
+  void end_of_simulation()
+  {
+    if ((dump_file != "") && !mem.dump(dump_file))
+      SC_REPORT_ERROR(this->name(), ("Unable to write " + dump_file).c_str());
   }
 
   void slave_r_process() {
@@ -106,19 +124,11 @@ public:
       while (1) {
         r_payload r;
 
-        if (ar.addr >= (sz * bytesPerBeat)) {
-          std::string address_error = "invalid addr, attempted access at " + std::to_string(ar.addr);
-
-          SC_REPORT_ERROR("ram", address_error.c_str());
-          r.resp = Enc::XRESP::SLVERR;
+        r.data = read_word(ar.addr);
+        r.id = ar.id;
+        r.resp = Enc::XRESP::OKAY;
 
-        } else {
-          r.data = array[ar.addr / bytesPerBeat];
-          r.id = ar.id;
-          r.resp = Enc::XRESP::OKAY;
-
-          if (chatty) printf("Addr: %08x  Data: %08x \n", ar.addr.to_int(), r.data.to_int());
-	}
+        if (chatty) printf("Addr: %08x  Data: %08x \n", ar.addr.to_int(), r.data.to_int());
 
         if (!r_slave0.next_multi_read(ar, r)) break;
       } 
@@ -142,33 +152,24 @@ public:
       while (1) {
         w_payload w = w_slave0.w.Pop();
 
-        if (aw.addr >= (sz * bytesPerBeat)) {
-          std::string address_error = "invalid addr, attempted access at " + std::to_string(aw.addr);
-
-          SC_REPORT_ERROR("ram", address_error.c_str());
-          b.resp = Enc::XRESP::SLVERR;
-          b.id = aw.id;
+        decltype(w.wstrb) all_on{~0};
 
+        if (w.wstrb == all_on) {
+          write_word(aw.addr, w.data.to_uint64());
         } else {
-          decltype(w.wstrb) all_on{~0};
-
-          if (w.wstrb == all_on) {
-            array[aw.addr / bytesPerBeat] = w.data.to_uint64();
-          } else {
-	    if (chatty) CCS_LOG("write strobe enabled");
-            arr_t orig  = array[aw.addr / bytesPerBeat];
-	    arr_t wdata = w.data.to_uint64();
-
-	    #pragma hls_unroll
-            for (int i=0; i<WSTRB_WIDTH; i++) {
-              if (w.wstrb[i]) {
-                orig = nvhls::set_slc(orig, nvhls::get_slc<8>(wdata, (i*8)), (i*8));
-              }
+          if (chatty) CCS_LOG("write strobe enabled");
+          arr_t orig  = read_word(aw.addr);
+          arr_t wdata = w.data.to_uint64();
+
+          #pragma hls_unroll
+          for (int i=0; i<WSTRB_WIDTH; i++) {
+            if (w.wstrb[i]) {
+              orig = nvhls::set_slc(orig, nvhls::get_slc<8>(wdata, (i*8)), (i*8));
             }
-
-            array[aw.addr / bytesPerBeat] = orig;
           }
-	}
+
+          write_word(aw.addr, orig);
+        }
 
         if (!w_slave0.next_multi_write(aw)) break;
       } 
@@ -211,9 +212,9 @@ public:
       float datum;
 
       input_file >> datum;
-      array[offset + addr] = SAT_TYPE(datum).slc<16>(0).to_int();
+      write_word((offset + addr) * bytesPerBeat, SAT_TYPE(datum).slc<16>(0).to_int());
       if (chatty) fprintf(f, "index(d) = %12d index(x) = %08x addr(d) = %12d addr(x) = %08x     value(d): %12d value(x): %08x \n",  
-                              addr, addr, offset+addr*4, offset+addr*4, array[offset+addr].to_int(), 0xFFFF & array[offset+addr].to_int());
+                              addr, addr, offset+addr*4, offset+addr*4, read_word((offset + addr) * bytesPerBeat).to_int(), 0xFFFF & read_word((offset + addr) * bytesPerBeat).to_int());
 
       addr++;
     }
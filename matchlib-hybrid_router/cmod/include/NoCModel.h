@@ -0,0 +1,589 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NOCMODEL_H__
+#define __NOCMODEL_H__
+
+// Cycle-level C++ model of the WHVCMeshNetwork of NoCNetwork.h, with the
+// sources and sinks of NoCTraffic.h, for networks too large to simulate in
+// SystemC. No SystemC processes or channels are involved.
+//   -Each router follows WHVCSourceRouter::run() step by step: receive_credit,
+//   fill_ififo, inputvc_arbiter, compute_route, arbitration with the round
+//   robin Arbiter, send_credit and flit_output. A flow control handshake that
+//   the SystemC network would make in cycle t is made in cycle t here, so
+//   flit latencies match the SystemC network cycle for cycle
+//   (unittests/NoCModelCalibration).
+//   -Routes are the ones of NoCTopology; the route field of a header is not
+//   modelled, the output port is computed from the destination at each hop.
+//   -Every link and credit channel delivers its message in the next cycle,
+//   which is what a Connections::Combinational between two threads that
+//   PopNB every cycle does in CONNECTIONS_ACCURATE_SIM. Pushes then never
+//   fail, so out_stall of the router is always 0 and is left out.
+//   -State is kept as arrays indexed by router, port and virtual channel
+//   rather than one object per router. The fields the arbitration reads are
+//   packed in 32 bits per flit; the packet record a flit carries for the
+//   statistics sits in a separate array.
+//   -Routers and endpoints are split into bands of consecutive routers, one
+//   per thread. Every link is double buffered: in cycle t all routers read
+//   what was sent in cycle t-1 and write what they send in cycle t, so bands
+//   only meet at a barrier between cycles and results do not depend on the
+//   number of threads.
+
+#include <NoCTopology.h>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cassert>
+#include <stdint.h>
+
+// Spin barrier for the threads of WHVCMeshModel, one cycle per phase
+class NoCModelBarrier {
+ public:
+  explicit NoCModelBarrier(unsigned n_) : n(n_), count(0), phase(0) {}
+
+  void wait() {
+    unsigned p = phase.load(std::memory_order_acquire);
+    if (count.fetch_add(1, std::memory_order_acq_rel) + 1 == n) {
+      count.store(0, std::memory_order_relaxed);
+      phase.store(p + 1, std::memory_order_release);
+      return;
+    }
+    for (unsigned spins = 0; phase.load(std::memory_order_acquire) == p; spins++) {
+      if (spins > 64) std::this_thread::yield();
+    }
+  }
+
+ private:
+  const unsigned n;
+  std::atomic<unsigned> count;
+  std::atomic<unsigned> phase;
+};
+
+/**
+ * \brief Cycle-level model of a WHVCMeshNetwork with traffic sources and sinks
+ * \ingroup NoCNetwork
+ *
+ * \tparam Traffic          Traffic generator with the generate() of NoCTraffic
+ *
+ * \par
+ * Sources and sinks behave as NoCSource and NoCSink of NoCTraffic.h. Latency
+ * and throughput are measured as NoCStats does; begin_window(), end_window(),
+ * idle() and point() have the same meaning, at the current cycle().
+ *
+ * \par A Simple Example
+ * \code
+ *      #include <NoCModel.h>
+ *      #include <testbench/NoCTrafficGen.h>
+ *
+ *      ...
+ *        NoCTraffic traffic(32, 1, seed);
+ *        WHVCMeshModel<NoCTraffic> model(32, NoCTopology::Mesh, 1, 2, 4, traffic, 8);
+ *        traffic.set_load(0.2, model.cycle());
+ *        model.run(1000);
+ *        model.begin_window();
+ *        model.run(5000);
+ *        model.end_window();
+ *        traffic.set_load(0, model.cycle());
+ *        model.drain(100000);
+ *        NoCLoadPoint p = model.point();
+ *      ...
+ *
+ * \endcode
+ * \par
+ *
+ */
+template <typename Traffic>
+class WHVCMeshModel {
+ public:
+  WHVCMeshModel(int k, NoCTopology::Kind kind, int num_lports_,
+                int num_vchannels_, int buffersize_, Traffic& traffic_,
+                int num_threads_ = 1)
+      : topology(k, kind),
+        num_lports(num_lports_),
+        num_ports(num_lports_ + NoCTopology::NumDirs),
+        num_routers(k * k),
+        num_endpoints(k * k * num_lports_),
+        num_vchannels(num_vchannels_),
+        buffersize(buffersize_),
+        num_threads(std::max(1, std::min(num_threads_, k * k))),
+        traffic(traffic_),
+        now(0),
+        log(0) {
+    assert((num_ports <= 16) && "Arbiter_model_takes_up_to_16_ports");
+    assert((num_vchannels >= 1) && (num_vchannels <= 64));
+    assert((buffersize >= 1) && (buffersize < 256));
+    assert(num_endpoints < (1 << 23));
+    int npv = num_routers * num_ports * num_vchannels;
+
+    fifo_ctl.resize(npv * buffersize);
+    fifo_pay.resize(npv * buffersize);
+    fifo_head.assign(npv, 0);
+    fifo_count.assign(npv, 0);
+    credit_recv.assign(npv, buffersize);
+    credit_send.assign(npv, 0);
+    out_dest.assign(npv, 0);
+    is_get_new_packet.assign(npv, 1);
+    arb_next.assign(num_routers * num_ports, (1u << num_ports) - 1);
+
+    for (int b = 0; b < 2; b++) {
+      link_ctl[b].assign(num_routers * num_ports, 0);
+      link_pay[b].resize(num_routers * num_ports);
+      link_credit[b].assign(npv, 0);
+      inj_ctl[b].assign(num_endpoints, 0);
+      inj_pay[b].resize(num_endpoints);
+      sink_credit[b].assign(num_endpoints * num_vchannels, 0);
+    }
+
+    // Remote input L+d of router r is fed by remote output L+opposite(d) of
+    // the neighbor in direction d, which takes its credits back
+    in_link.resize(num_routers * num_ports);
+    for (int r = 0; r < num_routers; r++) {
+      for (int i = 0; i < num_ports; i++) {
+        if (i < num_lports) {
+          in_link[r * num_ports + i] = r * num_lports + i;
+        } else {
+          int d = i - num_lports;
+          in_link[r * num_ports + i] =
+              topology.neighbor(r, d) * num_ports + num_lports + NoCTopology::opposite(d);
+        }
+      }
+    }
+
+    queue.resize(num_endpoints);
+    busy.assign(num_endpoints, 0);
+    index.assign(num_endpoints, 0);
+    vc.assign(num_endpoints, 0);
+    next_vc.assign(num_endpoints, 0);
+    inject.assign(num_endpoints, 0);
+    src_credit.assign(num_endpoints * num_vchannels, buffersize);
+    sink_credit_reg.assign(num_endpoints * num_vchannels, 0);
+
+    region.resize(num_threads);
+    for (int t = 0; t < num_threads; t++) {
+      region[t].r0 = num_routers * t / num_threads;
+      region[t].r1 = num_routers * (t + 1) / num_threads;
+      region[t].outstanding = 0;
+    }
+    win_begin = 0;
+    win_end = ~uint64_t(0);
+    begin_window();
+  }
+
+  const NoCTopology topology;
+  const int num_lports;
+  const int num_ports;
+  const int num_routers;
+  const int num_endpoints;
+  const int num_vchannels;
+  const int buffersize;
+  const int num_threads;
+
+  // Next cycle to simulate
+  uint64_t cycle() const { return now; }
+
+  void run(uint64_t cycles) {
+    if (cycles == 0) return;
+    if (num_threads == 1) {
+      for (uint64_t c = 0; c < cycles; c++) {
+        step(region[0], now + c);
+      }
+    } else {
+      NoCModelBarrier barrier(num_threads);
+      std::vector<std::thread> workers;
+      for (int t = 1; t < num_threads; t++) {
+        workers.push_back(std::thread(&WHVCMeshModel::run_region, this,
+                                      &region[t], cycles, &barrier));
+      }
+      run_region(&region[0], cycles, &barrier);
+      for (unsigned t = 0; t < workers.size(); t++) workers[t].join();
+    }
+    now += cycles;
+    if (log) {
+      for (int t = 0; t < num_threads; t++) {
+        log->insert(log->end(), region[t].log.begin(), region[t].log.end());
+        region[t].log.clear();
+      }
+    }
+  }
+
+  // Runs until idle, at most max_cycles. Returns idle().
+  bool drain(uint64_t max_cycles) {
+    const uint64_t chunk = 64;
+    for (uint64_t c = 0; !idle() && (c < max_cycles); c += chunk) {
+      run(std::min(chunk, max_cycles - c));
+    }
+    return idle();
+  }
+
+  // Appends every delivered packet to log from now on, none if log is 0.
+  // Packets are appended at the end of run(), by band of sink endpoints.
+  void log_deliveries(std::vector<NoCDelivery>* log_) { log = log_; }
+
+  // Packets generated from now on are measured, until end_window()
+  void begin_window() {
+    win_begin = now;
+    win_end = ~uint64_t(0);
+    for (int t = 0; t < num_threads; t++) {
+      region_stats& s = region[t];
+      s.gen_flits = s.eject_flits = 0;
+      s.packets = s.latency_sum = s.net_latency_sum = s.max_latency = 0;
+    }
+  }
+
+  void end_window() { win_end = now; }
+
+  // No packet waiting at a source or in the network
+  bool idle() const {
+    int64_t outstanding = 0;
+    for (int t = 0; t < num_threads; t++) outstanding += region[t].outstanding;
+    return outstanding == 0;
+  }
+
+  NoCLoadPoint point() const {
+    uint64_t gen_flits = 0, eject_flits = 0, packets = 0;
+    uint64_t latency_sum = 0, net_latency_sum = 0, max_latency = 0;
+    for (int t = 0; t < num_threads; t++) {
+      const region_stats& s = region[t];
+      gen_flits += s.gen_flits;
+      eject_flits += s.eject_flits;
+      packets += s.packets;
+      latency_sum += s.latency_sum;
+      net_latency_sum += s.net_latency_sum;
+      max_latency = std::max(max_latency, s.max_latency);
+    }
+    NoCLoadPoint p;
+    double cycles = double(win_end - win_begin) * num_endpoints;
+    p.offered = gen_flits / cycles;
+    p.accepted = eject_flits / cycles;
+    p.latency = packets ? double(latency_sum) / packets : 0;
+    p.net_latency = packets ? double(net_latency_sum) / packets : 0;
+    p.max_latency = max_latency;
+    p.packets = packets;
+    return p;
+  }
+
+ private:
+  // Flit fields used by the routers: valid, destination endpoint, virtual
+  // channel and flit id. 0 is an empty link.
+  enum {
+    kHeader = 1u << 0,
+    kTail = 1u << 1,
+    kVcShift = 2,
+    kVcMask = 0x3f,
+    kDstShift = 8,
+    kDstMask = 0x7fffff,
+    kValid = 1u << 31
+  };
+
+  // Packet record carried by every flit, for the sink
+  struct payload {
+    uint64_t gen;
+    uint64_t inject;
+    int src;
+    int size;
+    unsigned seq;
+  };
+
+  struct region_stats {
+    int r0, r1;  // routers [r0, r1) and their endpoints
+    int64_t outstanding;
+    uint64_t gen_flits, eject_flits;
+    uint64_t packets, latency_sum, net_latency_sum, max_latency;
+    std::vector<NoCDelivery> log;
+    char pad[64];  // keeps the counters of two threads off one cache line
+  };
+
+  static uint32_t flit_vc(uint32_t ctl) { return (ctl >> kVcShift) & kVcMask; }
+  static int flit_dst(uint32_t ctl) { return (ctl >> kDstShift) & kDstMask; }
+
+  Traffic& traffic;
+  uint64_t now;
+  uint64_t win_begin, win_end;
+  std::vector<NoCDelivery>* log;
+  std::vector<region_stats> region;
+
+  // Routers, indexed by (router * num_ports + port) * num_vchannels + vc for
+  // input buffers and credit_send, by output port and vc for credit_recv and
+  // is_get_new_packet
+  std::vector<uint32_t> fifo_ctl;  // [.. * buffersize + slot]
+  std::vector<payload> fifo_pay;
+  std::vector<uint8_t> fifo_head;
+  std::vector<uint8_t> fifo_count;
+  std::vector<int16_t> credit_recv;
+  std::vector<int16_t> credit_send;
+  std::vector<uint8_t> out_dest;  // output port of the packet on each input vc
+  std::vector<uint8_t> is_get_new_packet;
+  std::vector<uint32_t> arb_next;  // Arbiter state per router output
+  std::vector<int> in_link;        // link feeding each router input
+
+  // Links, [cycle & 1]: written in the cycle they are sent, read in the next
+  std::vector<uint32_t> link_ctl[2];  // router * num_ports + output
+  std::vector<payload> link_pay[2];
+  std::vector<uint8_t> link_credit[2];  // credits returned per router input vc
+  std::vector<uint32_t> inj_ctl[2];     // source e to its router
+  std::vector<payload> inj_pay[2];
+  std::vector<uint8_t> sink_credit[2];  // sink e to its router, per vc
+
+  // Sources and sinks, per endpoint
+  std::vector<std::deque<NoCPacket> > queue;
+  std::vector<uint8_t> busy;
+  std::vector<int> index;
+  std::vector<uint8_t> vc;
+  std::vector<uint8_t> next_vc;
+  std::vector<uint64_t> inject;
+  std::vector<int> src_credit;       // [e * num_vchannels + vc]
+  std::vector<int> sink_credit_reg;  // [e * num_vchannels + vc]
+
+  void run_region(region_stats* s, uint64_t cycles, NoCModelBarrier* barrier) {
+    for (uint64_t c = 0; c < cycles; c++) {
+      step(*s, now + c);
+      barrier->wait();
+    }
+  }
+
+  void step(region_stats& s, uint64_t t) {
+    int cur = t & 1;
+    for (int e = s.r0 * num_lports; e < s.r1 * num_lports; e++) {
+      source(s, e, t, cur);
+      sink(s, e, t, cur);
+    }
+    for (int r = s.r0; r < s.r1; r++) {
+      router(r, cur);
+    }
+  }
+
+  bool measured(uint64_t gen) const { return (gen >= win_begin) && (gen < win_end); }
+
+  // NoCSource<Net, true>::run() and NoCPacketizer
+  void source(region_stats& s, int e, uint64_t t, int cur) {
+    int prv = cur ^ 1;
+    int r = e / num_lports, lp = e % num_lports;
+    int cbase = (r * num_ports + lp) * num_vchannels;
+    for (int v = 0; v < num_vchannels; v++) {
+      src_credit[e * num_vchannels + v] += link_credit[prv][cbase + v];
+    }
+
+    std::deque<NoCPacket>& q = queue[e];
+    size_t before = q.size();
+    traffic.generate(e, t, q);
+    for (size_t i = before; i < q.size(); i++) {
+      s.outstanding++;
+      if (measured(q[i].gen)) s.gen_flits += q[i].size;
+    }
+
+    inj_ctl[cur][e] = 0;
+    if (!busy[e]) {
+      if (q.empty()) return;
+      busy[e] = 1;
+      index[e] = 0;
+      vc[e] = next_vc[e];
+      next_vc[e] = (next_vc[e] + 1) % num_vchannels;
+    }
+    int v = vc[e];
+    if (src_credit[e * num_vchannels + v] == 0) return;
+    src_credit[e * num_vchannels + v]--;
+
+    const NoCPacket& p = q.front();
+    if (index[e] == 0) inject[e] = t;
+    uint32_t ctl = kValid | (uint32_t(p.dst) << kDstShift) | (v << kVcShift);
+    if (index[e] == 0) ctl |= kHeader;
+    if (index[e] == p.size - 1) ctl |= kTail;
+    inj_ctl[cur][e] = ctl;
+    payload& pay = inj_pay[cur][e];
+    pay.gen = p.gen;
+    pay.inject = inject[e];
+    pay.src = p.src;
+    pay.size = p.size;
+    pay.seq = p.seq;
+    if (++index[e] == p.size) {
+      q.pop_front();
+      busy[e] = 0;
+    }
+  }
+
+  // NoCSink<Net, true>::run() and NoCStats::delivered()
+  void sink(region_stats& s, int e, uint64_t t, int cur) {
+    int prv = cur ^ 1;
+    int r = e / num_lports, lp = e % num_lports;
+    uint32_t ctl = link_ctl[prv][r * num_ports + lp];
+    if (ctl & kValid) {
+      sink_credit_reg[e * num_vchannels + flit_vc(ctl)]++;
+      if ((t >= win_begin) && (t < win_end)) s.eject_flits++;
+      if (ctl & kTail) {
+        const payload& pay = link_pay[prv][r * num_ports + lp];
+        assert(flit_dst(ctl) == e);
+        if (measured(pay.gen)) {
+          uint64_t latency = t - pay.gen + 1;
+          s.packets++;
+          s.latency_sum += latency;
+          s.net_latency_sum += t - pay.inject + 1;
+          s.max_latency = std::max(s.max_latency, latency);
+        }
+        if (log) {
+          NoCPacket p = {pay.gen, pay.src, e, pay.size, pay.seq};
+          NoCDelivery d = {p, pay.inject, t};
+          s.log.push_back(d);
+        }
+        s.outstanding--;
+      }
+    }
+    for (int v = 0; v < num_vchannels; v++) {
+      int& c = sink_credit_reg[e * num_vchannels + v];
+      sink_credit[cur][e * num_vchannels + v] = (c > 0);
+      if (c > 0) c--;
+    }
+  }
+
+  // Arbiter<size>::pick() with the round robin state next
+  static uint32_t arbiter_pick(uint32_t& next, uint32_t valid, int size) {
+    if (valid == 0) return 0;
+    uint32_t all = (1u << size) - 1;
+    uint32_t low = all >> 1;
+    uint32_t unrolled_valid = ((valid >> 1) & low) | (valid << (size - 1));
+    uint32_t unrolled_next = (next << (size - 1)) | low;
+    uint32_t priority = unrolled_valid & unrolled_next;
+    if (priority == 0) return 0;
+    int first_one_idx = 31 - __builtin_clz(priority);
+    uint32_t unrolled_choice = 1u << first_one_idx;
+    uint32_t choice = ((unrolled_choice >> (size - 1)) & 1) |
+                      ((((unrolled_choice >> size) | (unrolled_choice & low)) << 1) & all);
+    if (first_one_idx != size - 1) {
+      next &= ~(1u << (size - 1));
+      for (int i = size - 2; i > 0; --i) {
+        uint32_t bit = ((next | choice) >> (i + 1)) & 1;
+        next = (next & ~(1u << i)) | (bit << i);
+      }
+    } else {
+      next = all;
+    }
+    return choice;
+  }
+
+  // WHVCSourceRouter::run() of router r. Sizes and arrays are copied to
+  // locals first: the byte arrays written here may alias anything, which
+  // would make the compiler reload them after every store.
+  void router(int r, int cur) {
+    const int P = num_ports, V = num_vchannels, B = buffersize, L = num_lports;
+    const int prv = cur ^ 1;
+    const int base = r * P;
+    const int* link = &in_link[base];
+    uint32_t* ctl_buf = &fifo_ctl[0];
+    payload* pay_buf = &fifo_pay[0];
+    uint8_t* head = &fifo_head[0];
+    uint8_t* count = &fifo_count[0];
+    int16_t* recv = &credit_recv[base * V];  // [k * V + vc]
+    int16_t* send = &credit_send[base * V];  // [i * V + vc]
+    uint8_t* dest = &out_dest[base * V];
+    uint8_t* get_new = &is_get_new_packet[base * V];
+
+    // receive_credit: a local output takes credits from its sink, a remote
+    // one from the router input it feeds, which has the same index as the
+    // link into input k
+    const uint8_t* sink_in = &sink_credit[prv][0];
+    const uint8_t* link_in = &link_credit[prv][0];
+    for (int k = 0; k < P; k++) {
+      const uint8_t* in = ((k < L) ? sink_in : link_in) + link[k] * V;
+      for (int v = 0; v < V; v++) {
+        recv[k * V + v] += in[v];
+        assert(recv[k * V + v] <= B);
+      }
+    }
+
+    // fill_ififo
+    for (int i = 0; i < P; i++) {
+      uint32_t ctl = (i < L) ? inj_ctl[prv][link[i]] : link_ctl[prv][link[i]];
+      if (!(ctl & kValid)) continue;
+      int q = (base + i) * V + flit_vc(ctl);
+      assert((count[q] < B) && "Input_fifo_is_full");
+      int slot = head[q] + count[q];
+      if (slot >= B) slot -= B;
+      ctl_buf[q * B + slot] = ctl;
+      pay_buf[q * B + slot] = (i < L) ? inj_pay[prv][link[i]] : link_pay[prv][link[i]];
+      count[q]++;
+    }
+
+    // inputvc_arbiter, peek_ififo and compute_route
+    int vcin[16];
+    uint32_t flit_in[16];
+    uint32_t in_valid = 0;
+    for (int i = 0; i < P; i++) {
+      int q = (base + i) * V;
+      int v = 0;
+      while ((v < V) && (count[q + v] == 0)) v++;
+      if (v == V) continue;
+      in_valid |= 1u << i;
+      vcin[i] = v;
+      flit_in[i] = ctl_buf[(q + v) * B + head[q + v]];
+      if (flit_in[i] & kHeader) {
+        int dst = flit_dst(flit_in[i]);
+        int dir = topology.next_dir(r, dst / L);
+        dest[i * V + v] = (dir < 0) ? (dst % L) : (L + dir);
+      }
+    }
+    if (in_valid == 0) {
+      for (int k = 0; k < P; k++) link_ctl[cur][base + k] = 0;
+      send_credit(base, cur);
+      return;
+    }
+
+    // arbitration
+    uint32_t valid[16];
+    for (int k = 0; k < P; k++) valid[k] = 0;
+    for (int i = 0; i < P; i++) {
+      if (!(in_valid & (1u << i))) continue;
+      int k = dest[i * V + vcin[i]];
+      int out_idx = k * V + vcin[i];
+      if ((recv[out_idx] != 0) && (get_new[out_idx] || !(flit_in[i] & kHeader))) {
+        valid[k] |= 1u << i;
+      }
+    }
+
+    // Pop input fifos, crossbar_traversal and flit_output
+    for (int k = 0; k < P; k++) {
+      link_ctl[cur][base + k] = 0;
+      if (valid[k] == 0) continue;
+      uint32_t select = arbiter_pick(arb_next[base + k], valid[k], P);
+      if (select == 0) continue;
+      int i = __builtin_ctz(select);
+      int q = (base + i) * V + vcin[i];
+      link_ctl[cur][base + k] = flit_in[i];
+      link_pay[cur][base + k] = pay_buf[q * B + head[q]];
+      if (++head[q] == B) head[q] = 0;
+      count[q]--;
+      send[i * V + vcin[i]]++;
+      int out_idx = k * V + vcin[i];
+      get_new[out_idx] = (flit_in[i] & kTail) ? 1 : 0;
+      recv[out_idx]--;
+    }
+
+    send_credit(base, cur);
+  }
+
+  // send_credit: one credit per input vc and cycle
+  void send_credit(int base, int cur) {
+    const int n = num_ports * num_vchannels;
+    int16_t* send = &credit_send[base * num_vchannels];
+    uint8_t* out = &link_credit[cur][base * num_vchannels];
+    for (int i = 0; i < n; i++) {
+      out[i] = (send[i] > 0);
+      if (send[i] > 0) send[i]--;
+    }
+  }
+};
+
+#endif
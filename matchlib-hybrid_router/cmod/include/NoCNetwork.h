@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NOCNETWORK_H__
+#define __NOCNETWORK_H__
+
+// KxK mesh and torus networks built from WHVCSourceRouter or HybridRouter.
+//   -Every router has NumLPorts local ports and 4 remote ports. Remote port
+//   L+0 goes to +x, L+1 to -x, L+2 to +y and L+3 to -y.
+//   -Router r sits at x = r % K, y = r / K. Endpoint e is local port e % L of
+//   router e / L.
+//   -All 4 links of every router are wired, wrap-around links included. Mesh or
+//   torus only changes the routes (NoCTopology): a mesh never routes over a
+//   wrap-around link.
+//   -Routes are dimension ordered, x first. On a torus each ring takes the
+//   shorter direction that does not pass through node 0 of the ring; node 0 may
+//   be the first or the last node of a route, never an intermediate one. No
+//   packet then waits for the link out of node 0 while holding the link into
+//   it, which breaks the channel dependency cycle of the ring with a single
+//   virtual channel. This is a restricted-wrap torus, not a true torus: a wrap
+//   link only carries routes that end at node 0 (k-1 to 0), so most routes are
+//   those of the mesh.
+//   -The network has the ports of one router with K*K*L local ports: a source
+//   drives in_port[e], a sink is driven by out_port[e].
+//   -Header data bits from route_width up are not modified by the routers and
+//   are free for the payload.
+
+#include <nvhls_packet.h>
+#include <nvhls_connections.h>
+#include <NoCTopology.h>
+#include <WHVCRouter.h>
+#include <HybridRouter.h>
+#include <sstream>
+
+/**
+ * \brief KxK mesh or torus of WHVCSourceRouter
+ * \ingroup NoCNetwork
+ *
+ * \tparam K                Routers per row and per column
+ * \tparam NumLPorts        Local ports per router
+ * \tparam NumVchannels     Number of virtual channels
+ * \tparam BufferSize       Buffersize of router input fifos, and credits of
+ *                          the sources
+ * \tparam FlitType         Indicates the Flit type
+ *
+ * \par
+ * route() gives the route field of a header flit. The virtual channel of a
+ * packet goes in the LSBs of its packet id. Each endpoint also has a credit
+ * channel per virtual channel in each direction, as a router local port has:
+ * out_credit[e * num_vchannels + vc] returns credits to the source on in_port[e],
+ * in_credit[e * num_vchannels + vc] takes credits from the sink on out_port[e].
+ *
+ * \par A Simple Example
+ * \code
+ *      #include <NoCNetwork.h>
+ *
+ *      ...
+ *        typedef WHVCMeshNetwork<4, 1, 2, 4> Net;
+ *        Net net("net", NoCTopology::Torus);
+ *
+ *        Net::Flit_t flit;
+ *        flit.data = net.route(src, dst);
+ *      ...
+ *
+ * \endcode
+ * \par
+ *
+ */
+template <int K, int NumLPorts, int NumVchannels, int BufferSize,
+          typename FlitType =
+              Flit<64, 0, 0,
+                   (NumVchannels > 1) ? nvhls::index_width<NumVchannels>::val : 0,
+                   FlitId2bit, WormHole> >
+class WHVCMeshNetwork : public sc_module {
+ public:
+  typedef FlitType Flit_t;
+  enum {
+    k = K,
+    num_lports = NumLPorts,
+    num_rports = NoCTopology::NumDirs,
+    num_routers = K * K,
+    num_endpoints = K * K * NumLPorts,
+    num_vchannels = NumVchannels,
+    buffersize = BufferSize,
+    credit_based = 1,
+    // Longest mesh route plus the hop to the local port. Torus routes are
+    // never longer.
+    max_hops = 2 * (K - 1) + 1
+  };
+  typedef WHVCSourceRouter<NumLPorts, NoCTopology::NumDirs, NumVchannels,
+                           BufferSize, FlitType, max_hops> Router;
+  typedef typename Router::Credit_ret_t Credit_ret_t;
+  enum {
+    dest_width_per_hop = Router::dest_width_per_hop,
+    route_width = Router::dest_width
+  };
+  typedef NVUINTW(route_width) route_t;
+
+  Connections::In<Flit_t> in_port[num_endpoints];
+  Connections::Out<Flit_t> out_port[num_endpoints];
+  Connections::In<Credit_ret_t> in_credit[num_endpoints * num_vchannels];
+  Connections::Out<Credit_ret_t> out_credit[num_endpoints * num_vchannels];
+  sc_in_clk clk;
+  sc_in<bool> rst;
+
+  NoCTopology topology;
+  Router* router[num_routers];
+
+  // link[r * 4 + dir] carries flits out of remote port dir of router r,
+  // link_credit[(r * 4 + dir) * num_vchannels + vc] returns its credits
+  Connections::Combinational<Flit_t> link[num_routers * NoCTopology::NumDirs];
+  Connections::Combinational<Credit_ret_t>
+      link_credit[num_routers * NoCTopology::NumDirs * num_vchannels];
+
+  WHVCMeshNetwork(sc_module_name name_, NoCTopology::Kind kind)
+      : sc_module(name_), clk("clk"), rst("rst"), topology(K, kind) {
+    NVHLS_ASSERT_MSG(route_width < Flit_t::data_width, "Route_field_does_not_fit_in_flit_data");
+    for (int r = 0; r < num_routers; r++) {
+      std::ostringstream ss;
+      ss << "router_" << topology.x(r) << "_" << topology.y(r);
+      router[r] = new Router(ss.str().c_str());
+      router[r]->clk(clk);
+      router[r]->rst(rst);
+    }
+
+    for (int r = 0; r < num_routers; r++) {
+      for (int dir = 0; dir < NoCTopology::NumDirs; dir++) {
+        int nb = topology.neighbor(r, dir);
+        int out_port_id = num_lports + dir;
+        int in_port_id = num_lports + NoCTopology::opposite(dir);
+        int l = r * NoCTopology::NumDirs + dir;
+        router[r]->out_port[out_port_id](link[l]);
+        router[nb]->in_port[in_port_id](link[l]);
+        for (int vc = 0; vc < num_vchannels; vc++) {
+          router[nb]->out_credit[in_port_id * num_vchannels + vc](
+              link_credit[l * num_vchannels + vc]);
+          router[r]->in_credit[out_port_id * num_vchannels + vc](
+              link_credit[l * num_vchannels + vc]);
+        }
+      }
+    }
+
+    for (int e = 0; e < num_endpoints; e++) {
+      int r = e / num_lports;
+      int lp = e % num_lports;
+      router[r]->in_port[lp](in_port[e]);
+      router[r]->out_port[lp](out_port[e]);
+      for (int vc = 0; vc < num_vchannels; vc++) {
+        router[r]->out_credit[lp * num_vchannels + vc](
+            out_credit[e * num_vchannels + vc]);
+        router[r]->in_credit[lp * num_vchannels + vc](
+            in_credit[e * num_vchannels + vc]);
+      }
+    }
+  }
+
+  // Source route from endpoint src to endpoint dst: one hop per router visited,
+  // first hop in the LSBs. A hop is <remote port> <1-hot local port>; the last
+  // one only has the local port, which also ends the route.
+  route_t route(int src, int dst) const {
+    std::vector<int> dirs;
+    topology.route(src / num_lports, dst / num_lports, dirs);
+    route_t r = 0;
+    for (unsigned h = 0; h < dirs.size(); h++) {
+      NVUINTW(dest_width_per_hop) hop = dirs[h];
+      hop <<= num_lports;
+      r = nvhls::set_slc(r, hop, h * dest_width_per_hop);
+    }
+    NVUINTW(dest_width_per_hop) hop = 0;
+    hop[dst % num_lports] = 1;
+    r = nvhls::set_slc(r, hop, dirs.size() * dest_width_per_hop);
+    return r;
+  }
+};
+
+/**
+ * \brief KxK mesh or torus of HybridRouter
+ * \ingroup NoCNetwork
+ *
+ * \tparam K                Routers per row and per column
+ * \tparam NumLPorts        Local ports per router
+ * \tparam BufferSize       Buffersize of router output fifos
+ * \tparam MaxPacketSize    Largest packet, in flits
+ * \tparam FlitType         Indicates the Flit type
+ *
+ * \par
+ * Every endpoint is a NoC destination and all routers are in one NoC2 domain.
+ * The LUTs of each router are driven with the routes of NoCTopology when the
+ * network is built. Unicast only; there are no credits, the routers use
+ * latency insensitive backpressure.
+ *
+ */
+template <int K, int NumLPorts, int BufferSize, int MaxPacketSize,
+          typename FlitType = Flit<64, 0, 0, 0, FlitId2bit, WormHole> >
+class HybridMeshNetwork : public sc_module {
+ public:
+  typedef FlitType Flit_t;
+  enum {
+    k = K,
+    num_lports = NumLPorts,
+    num_rports = NoCTopology::NumDirs,
+    num_ports = NumLPorts + NoCTopology::NumDirs,
+    num_routers = K * K,
+    num_endpoints = K * K * NumLPorts,
+    num_vchannels = 1,
+    buffersize = BufferSize,
+    max_packet_size = MaxPacketSize,
+    credit_based = 0,
+    noc_ucast_dest_width = nvhls::index_width<num_endpoints>::val
+  };
+  // The multicast flag sits right above the unicast destination
+  typedef HybridRouter<NumLPorts, NoCTopology::NumDirs, BufferSize, FlitType, 1,
+                       num_endpoints, noc_ucast_dest_width, MaxPacketSize> Router;
+  enum {
+    // Unicast destination, NoC2 destination and multicast flag
+    route_width = Router::mcast_dest_width + 1
+  };
+  typedef NVUINTW(route_width) route_t;
+
+  Connections::In<Flit_t> in_port[num_endpoints];
+  Connections::Out<Flit_t> out_port[num_endpoints];
+  sc_in_clk clk;
+  sc_in<bool> rst;
+
+  NoCTopology topology;
+  Router* router[num_routers];
+
+  Connections::Combinational<Flit_t> link[num_routers * NoCTopology::NumDirs];
+
+  // Jtag
+  sc_signal<typename Router::NoCRouteLUT_t> NoCRouteLUT_jtag[num_routers][num_endpoints];
+  sc_signal<typename Router::NoC2RouteLUT_t> NoC2RouteLUT_jtag[num_routers];
+  sc_signal<typename Router::noc2_id_t> noc2_id_jtag[num_routers];
+
+  HybridMeshNetwork(sc_module_name name_, NoCTopology::Kind kind)
+      : sc_module(name_), clk("clk"), rst("rst"), topology(K, kind) {
+    NVHLS_ASSERT_MSG(route_width < Flit_t::data_width, "Route_field_does_not_fit_in_flit_data");
+    for (int r = 0; r < num_routers; r++) {
+      std::ostringstream ss;
+      ss << "router_" << topology.x(r) << "_" << topology.y(r);
+      router[r] = new Router(ss.str().c_str());
+      router[r]->clk(clk);
+      router[r]->rst(rst);
+
+      for (int e = 0; e < num_endpoints; e++) {
+        typename Router::NoCRouteLUT_t lut = 0;
+        int dir = topology.next_dir(r, e / num_lports);
+        lut[(dir < 0) ? (e % num_lports) : (num_lports + dir)] = 1;
+        router[r]->NoCRouteLUT_jtag[e](NoCRouteLUT_jtag[r][e]);
+        NoCRouteLUT_jtag[r][e].write(lut);
+      }
+      router[r]->NoC2RouteLUT_jtag[0](NoC2RouteLUT_jtag[r]);
+      NoC2RouteLUT_jtag[r].write(0);
+      router[r]->noc2_id_jtag(noc2_id_jtag[r]);
+      noc2_id_jtag[r].write(0);
+    }
+
+    for (int r = 0; r < num_routers; r++) {
+      for (int dir = 0; dir < NoCTopology::NumDirs; dir++) {
+        int l = r * NoCTopology::NumDirs + dir;
+        router[r]->out_port[num_lports + dir](link[l]);
+        router[topology.neighbor(r, dir)]->in_port[num_lports + NoCTopology::opposite(dir)](link[l]);
+      }
+    }
+
+    for (int e = 0; e < num_endpoints; e++) {
+      router[e / num_lports]->in_port[e % num_lports](in_port[e]);
+      router[e / num_lports]->out_port[e % num_lports](out_port[e]);
+    }
+  }
+
+  // Unicast route field for endpoint dst: the destination id, NoC2 id 0 and
+  // the multicast flag cleared
+  route_t route(int src, int dst) const {
+    route_t r = dst;
+    return r;
+  }
+};
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NOCTOPOLOGY_H__
+#define __NOCTOPOLOGY_H__
+
+// Plain C++ parts of the mesh and torus NoCs, shared by the SystemC networks
+// of NoCNetwork.h, the traffic generators and the cycle-level model of
+// NoCModel.h: the topology and its routing function, and the records of a
+// packet.
+
+#include <vector>
+#include <stdint.h>
+
+/**
+ * \brief Routes of a KxK mesh or torus
+ * \ingroup NoCNetwork
+ *
+ * \par
+ * next_dir() is the routing function. It only depends on the current and the
+ * destination router, so it serves both the source routes of WHVCMeshNetwork
+ * and the LUTs of HybridMeshNetwork.
+ *
+ * \par
+ * The torus is a restricted-wrap torus. A route never passes through node 0
+ * of a ring, and ring_step() never takes the 0 to k-1 link, so the only
+ * wrap-around hop is k-1 to 0, taken by routes that end at node 0 of the ring.
+ * Routes that start at node 0 never wrap. This keeps the routes deadlock free without a dateline
+ * virtual channel switch, which the routers do not have, but most routes are
+ * those of the mesh (for k = 4, 60 of the 256 router pairs route differently):
+ * latencies and saturation throughputs measured on it are not those of a true
+ * torus.
+ *
+ */
+class NoCTopology {
+ public:
+  enum Kind { Mesh, Torus };
+  enum Dir { XPlus = 0, XMinus = 1, YPlus = 2, YMinus = 3, NumDirs = 4 };
+
+  NoCTopology(int k_, Kind kind_) : k(k_), kind(kind_) {}
+
+  int k;
+  Kind kind;
+
+  int num_routers() const { return k * k; }
+  int x(int r) const { return r % k; }
+  int y(int r) const { return r / k; }
+  int router(int x_, int y_) const { return y_ * k + x_; }
+  static int opposite(int dir) { return dir ^ 1; }
+  const char* name() const { return (kind == Mesh) ? "mesh" : "restricted-wrap torus"; }
+
+  int neighbor(int r, int dir) const {
+    int nx = x(r), ny = y(r);
+    switch (dir) {
+      case XPlus: nx = (nx + 1) % k; break;
+      case XMinus: nx = (nx + k - 1) % k; break;
+      case YPlus: ny = (ny + 1) % k; break;
+      default: ny = (ny + k - 1) % k; break;
+    }
+    return router(nx, ny);
+  }
+
+  // Direction from s to d along one row or column: +1, -1, or 0 if s == d
+  int ring_step(int s, int d) const {
+    if (s == d) return 0;
+    if (kind == Mesh) return (d > s) ? 1 : -1;
+    int plus_len = (d - s + k) % k;
+    int minus_len = k - plus_len;
+    bool plus_ok = (s + plus_len <= k);  // does not go through 0
+    bool minus_ok = (s >= minus_len);
+    if (plus_ok && minus_ok) return (plus_len <= minus_len) ? 1 : -1;
+    return plus_ok ? 1 : -1;
+  }
+
+  // Remote direction to take at router cur towards router dst, -1 if cur == dst
+  int next_dir(int cur, int dst) const {
+    int step = ring_step(x(cur), x(dst));
+    if (step != 0) return (step > 0) ? XPlus : XMinus;
+    step = ring_step(y(cur), y(dst));
+    if (step != 0) return (step > 0) ? YPlus : YMinus;
+    return -1;
+  }
+
+  // Remote directions taken from router src to router dst, in order
+  void route(int src, int dst, std::vector<int>& dirs) const {
+    dirs.clear();
+    for (int dir = next_dir(src, dst); dir >= 0; dir = next_dir(src, dst)) {
+      dirs.push_back(dir);
+      src = neighbor(src, dir);
+    }
+  }
+
+  int hops(int src, int dst) const {
+    std::vector<int> dirs;
+    route(src, dst, dirs);
+    return dirs.size();
+  }
+};
+
+// A packet, as generated by a traffic source
+struct NoCPacket {
+  uint64_t gen;  // cycle the packet was generated in
+  int src;
+  int dst;
+  int size;      // in flits
+  unsigned seq;  // number of the packet at its source
+};
+
+// A delivered packet
+struct NoCDelivery {
+  NoCPacket pkt;
+  uint64_t inject;   // cycle its header entered the network
+  uint64_t deliver;  // cycle its tail left the network
+};
+
+// Measurement of one load point
+struct NoCLoadPoint {
+  double offered;       // flits generated per endpoint per cycle
+  double accepted;      // flits ejected per endpoint per cycle
+  double latency;       // generation to tail ejection, cycles
+  double net_latency;   // header injection to tail ejection, cycles
+  uint64_t max_latency;
+  uint64_t packets;     // measured packets delivered
+};
+
+#endif
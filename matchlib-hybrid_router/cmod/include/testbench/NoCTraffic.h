@@ -0,0 +1,627 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NOCTRAFFIC_H__
+#define __NOCTRAFFIC_H__
+
+// Traffic sources, sinks and measurement for the networks of NoCNetwork.h.
+//   -NoCTraffic (NoCTrafficGen.h) decides which packets an endpoint generates
+//   each cycle.
+//   -Generated packets wait in an unbounded queue at their source, so packet
+//   latency counts from generation and includes source queueing (open loop).
+//   -Each packet in the network carries a tag in the data bits above the route
+//   field of the network, in every flit. NoCStats hands out the tags and keeps
+//   source, destination, size and times of the packet under its tag.
+//   -Sinks check that every packet reaches its destination whole and in order;
+//   violations are reported as SC_ERRORs.
+//   -Packets generated inside the measurement window are the measured ones.
+//   The window is followed by a drain with generation stopped, so all of them
+//   are delivered before a load point is reported.
+
+#include <systemc.h>
+#include <nvhls_connections.h>
+#include <nvhls_packet.h>
+#include <NoCNetwork.h>
+#include <testbench/NoCTrafficGen.h>
+#include <deque>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+class NoCStats {
+ public:
+  typedef NoCLoadPoint Point;
+
+  NoCStats(int num_endpoints_, int tag_width, const sc_time& period_)
+      : num_endpoints(num_endpoints_),
+        capacity(1u << std::min(tag_width, 20)),
+        period(period_),
+        log(0) {
+    begin_window(0);
+    win_end = 0;
+    outstanding = 0;
+  }
+
+  const int num_endpoints;
+
+  sc_dt::uint64 cycle() const {
+    return static_cast<sc_dt::uint64>(sc_time_stamp() / period);
+  }
+
+  // Source side
+  void generated(const NoCPacket& p) {
+    outstanding++;
+    if (measured(p.gen)) gen_flits += p.size;
+  }
+
+  // Tag for packet p, false if all tags are in use
+  bool alloc(const NoCPacket& p, unsigned& tag) {
+    if (free_tags.empty()) {
+      if (table.size() == capacity) return false;
+      free_tags.push_back(table.size());
+      table.push_back(entry());
+    }
+    tag = free_tags.back();
+    free_tags.pop_back();
+    table[tag].pkt = p;
+    table[tag].in_use = true;
+    return true;
+  }
+
+  // The header of the packet with this tag entered the network in cycle now
+  void injected(unsigned tag, sc_dt::uint64 now) { table[tag].inject = now; }
+
+  // Sink side
+  const NoCPacket* lookup(unsigned tag) const {
+    return ((tag < table.size()) && table[tag].in_use) ? &table[tag].pkt : 0;
+  }
+
+  void flit_ejected(sc_dt::uint64 now) {
+    if ((now >= win_begin) && (now < win_end)) eject_flits++;
+  }
+
+  void delivered(unsigned tag, sc_dt::uint64 now) {
+    entry& e = table[tag];
+    if (measured(e.pkt.gen)) {
+      sc_dt::uint64 latency = now - e.pkt.gen + 1;
+      packets++;
+      latency_sum += latency;
+      net_latency_sum += now - e.inject + 1;
+      max_latency = std::max(max_latency, latency);
+    }
+    if (log) {
+      NoCDelivery d = {e.pkt, e.inject, now};
+      log->push_back(d);
+    }
+    e.in_use = false;
+    free_tags.push_back(tag);
+    outstanding--;
+  }
+
+  // Packets generated from now on are measured, until end_window()
+  void begin_window(sc_dt::uint64 now) {
+    win_begin = now;
+    win_end = ~sc_dt::uint64(0);
+    gen_flits = eject_flits = 0;
+    packets = latency_sum = net_latency_sum = max_latency = 0;
+  }
+
+  void end_window(sc_dt::uint64 now) { win_end = now; }
+
+  // Appends every delivered packet to log from now on, none if log is 0
+  void log_deliveries(std::vector<NoCDelivery>* log_) { log = log_; }
+
+  // No packet waiting at a source or in the network
+  bool idle() const { return outstanding == 0; }
+
+  Point point() const {
+    Point p;
+    double cycles = double(win_end - win_begin) * num_endpoints;
+    p.offered = gen_flits / cycles;
+    p.accepted = eject_flits / cycles;
+    p.latency = packets ? double(latency_sum) / packets : 0;
+    p.net_latency = packets ? double(net_latency_sum) / packets : 0;
+    p.max_latency = max_latency;
+    p.packets = packets;
+    return p;
+  }
+
+ private:
+  struct entry {
+    entry() : inject(0), in_use(false) {}
+    NoCPacket pkt;
+    sc_dt::uint64 inject;
+    bool in_use;
+  };
+
+  const unsigned capacity;
+  const sc_time period;
+  std::vector<entry> table;
+  std::vector<unsigned> free_tags;
+  std::vector<NoCDelivery>* log;
+  sc_dt::uint64 outstanding;
+  sc_dt::uint64 win_begin, win_end;
+  sc_dt::uint64 gen_flits, eject_flits;
+  sc_dt::uint64 packets, latency_sum, net_latency_sum, max_latency;
+
+  bool measured(sc_dt::uint64 gen) const {
+    return (gen >= win_begin) && (gen < win_end);
+  }
+};
+
+// Virtual channel of a packet goes in the LSBs of its packet id
+template <int DataWidth, int PacketIdWidth, class FlitId>
+void noc_set_vc(Flit<DataWidth, 0, 0, PacketIdWidth, FlitId, WormHole>& flit,
+                unsigned vc) {
+  flit.packet_id = vc;
+}
+
+template <int DataWidth, class FlitId>
+void noc_set_vc(Flit<DataWidth, 0, 0, 0, FlitId, WormHole>& flit, unsigned vc) {}
+
+// Turns the packets an endpoint generates into flits. Every flit carries the
+// packet tag above the route field; the header has the route below it, the
+// other flits their index in the packet.
+template <typename Net>
+class NoCPacketizer {
+ public:
+  typedef typename Net::Flit_t Flit_t;
+  enum { data_width = Flit_t::data_width, tag_start = Net::route_width };
+
+  NoCPacketizer(int id_, const Net& net_, NoCTraffic& traffic_, NoCStats& stats_)
+      : id(id_), net(net_), traffic(traffic_), stats(stats_) {
+    reset();
+  }
+
+  Flit_t flit;
+  unsigned vc;
+
+  void reset() {
+    queue.clear();
+    busy = false;
+    flit_valid = false;
+    next_vc = 0;
+  }
+
+  // Generates the packets of cycle now. Returns true with the flit to send
+  // next in flit, false if there is none.
+  bool next_flit(sc_dt::uint64 now) {
+    size_t before = queue.size();
+    traffic.generate(id, now, queue);
+    for (size_t i = before; i < queue.size(); i++) {
+      stats.generated(queue[i]);
+    }
+    if (flit_valid) return true;
+    if (!busy) {
+      if (queue.empty() || !stats.alloc(queue.front(), tag)) return false;
+      busy = true;
+      index = 0;
+      vc = next_vc;
+      next_vc = (next_vc + 1) % Net::num_vchannels;
+    }
+
+    const NoCPacket& p = queue.front();
+    NVUINTW(data_width) data = tag;
+    data <<= tag_start;
+    if (index == 0) {
+      NVUINTW(data_width) route = net.route(p.src, p.dst);
+      data |= route;
+    } else {
+      NVUINTW(data_width) seq = index;
+      data |= seq;
+    }
+    flit.data = data;
+    if (p.size == 1) {
+      flit.flit_id.set(FlitId2bit::SNGL);
+    } else if (index == 0) {
+      flit.flit_id.set(FlitId2bit::HEAD);
+    } else if (index == p.size - 1) {
+      flit.flit_id.set(FlitId2bit::TAIL);
+    } else {
+      flit.flit_id.set(FlitId2bit::BODY);
+    }
+    noc_set_vc(flit, vc);
+    flit_valid = true;
+    return true;
+  }
+
+  // The flit from next_flit() entered the network in cycle now
+  void flit_sent(sc_dt::uint64 now) {
+    flit_valid = false;
+    if (index == 0) stats.injected(tag, now);
+    if (++index == queue.front().size) {
+      queue.pop_front();
+      busy = false;
+    }
+  }
+
+ private:
+  const int id;
+  const Net& net;
+  NoCTraffic& traffic;
+  NoCStats& stats;
+  std::deque<NoCPacket> queue;
+  bool busy;
+  bool flit_valid;
+  int index;
+  unsigned tag;
+  unsigned next_vc;
+};
+
+// Checks the flits arriving at an endpoint and reports delivered packets
+template <typename Net>
+class NoCPacketChecker {
+ public:
+  typedef typename Net::Flit_t Flit_t;
+  enum { data_width = Flit_t::data_width, tag_start = Net::route_width };
+
+  NoCPacketChecker(const char* name_, int id_, NoCStats& stats_)
+      : name(name_), id(id_), stats(stats_) {
+    reset();
+  }
+
+  void reset() {
+    for (int i = 0; i < Net::num_vchannels; i++) open[i] = false;
+  }
+
+  void receive(const Flit_t& flit, sc_dt::uint64 now) {
+    stats.flit_ejected(now);
+    int vc = flit.get_packet_id();
+    NVUINTW(data_width) tag_bits = flit.data >> tag_start;
+    unsigned tag = tag_bits.to_uint64();
+    if (flit.flit_id.isHeader()) {
+      const NoCPacket* p = stats.lookup(tag);
+      if (open[vc]) error("header flit inside a packet");
+      if (!p) {
+        error("header flit with unknown tag");
+        open[vc] = false;
+        return;
+      }
+      if (p->dst != id) error("packet delivered to the wrong endpoint");
+      open[vc] = true;
+      cur_tag[vc] = tag;
+      count[vc] = 0;
+    } else {
+      NVUINTW(tag_start) seq = nvhls::get_slc<tag_start>(flit.data, 0);
+      if (!open[vc] || (tag != cur_tag[vc]) || (seq.to_uint64() != count[vc])) {
+        error("flit out of order");
+        return;
+      }
+    }
+    count[vc]++;
+    if (flit.flit_id.isTail()) {
+      if (count[vc] != static_cast<unsigned>(stats.lookup(tag)->size)) error("packet size mismatch");
+      stats.delivered(tag, now);
+      open[vc] = false;
+    }
+  }
+
+ private:
+  std::string name;
+  const int id;
+  NoCStats& stats;
+  bool open[Net::num_vchannels];
+  unsigned cur_tag[Net::num_vchannels];
+  unsigned count[Net::num_vchannels];
+
+  void error(const char* msg) {
+    std::ostringstream ss;
+    ss << name << " @" << sc_time_stamp() << ": " << msg;
+    SC_REPORT_ERROR("NoCTraffic", ss.str().c_str());
+  }
+};
+
+// Source and sink of one endpoint. The credit based ones return and take
+// credits per virtual channel the way a router local port does.
+template <typename Net, bool CreditBased = (Net::credit_based != 0)>
+class NoCSource;
+
+template <typename Net, bool CreditBased = (Net::credit_based != 0)>
+class NoCSink;
+
+template <typename Net>
+class NoCSource<Net, true> : public sc_module {
+ public:
+  typedef typename Net::Flit_t Flit_t;
+  typedef typename Net::Credit_ret_t Credit_ret_t;
+  enum { num_vchannels = Net::num_vchannels };
+
+  sc_in_clk clk;
+  sc_in<bool> rst;
+  Connections::Out<Flit_t> out;
+  Connections::In<Credit_ret_t> credit[num_vchannels];
+
+  NoCPacketizer<Net> packetizer;
+  NoCStats& stats;
+  int credit_reg[num_vchannels];
+
+  void run() {
+    out.Reset();
+    for (int i = 0; i < num_vchannels; i++) {
+      credit[i].Reset();
+      credit_reg[i] = Net::buffersize;
+    }
+    packetizer.reset();
+
+    wait();
+    while (1) {
+      Credit_ret_t temp;
+      for (int i = 0; i < num_vchannels; i++) {
+        if (credit[i].PopNB(temp)) credit_reg[i] += temp;
+      }
+      sc_dt::uint64 now = stats.cycle();
+      if (packetizer.next_flit(now) && (credit_reg[packetizer.vc] > 0) &&
+          out.PushNB(packetizer.flit)) {
+        credit_reg[packetizer.vc]--;
+        packetizer.flit_sent(now);
+      }
+      wait();
+    }
+  }
+
+  void bind(Net& net, int e) {
+    Connections::Combinational<Flit_t>* data_chan = new Connections::Combinational<Flit_t>();
+    out(*data_chan);
+    net.in_port[e](*data_chan);
+    for (int vc = 0; vc < num_vchannels; vc++) {
+      Connections::Combinational<Credit_ret_t>* credit_chan = new Connections::Combinational<Credit_ret_t>();
+      credit[vc](*credit_chan);
+      net.out_credit[e * num_vchannels + vc](*credit_chan);
+    }
+  }
+
+  SC_HAS_PROCESS(NoCSource);
+  NoCSource(sc_module_name name_, int id_, const Net& net_, NoCTraffic& traffic_,
+            NoCStats& stats_)
+      : sc_module(name_), clk("clk"), rst("rst"), out("out"),
+        packetizer(id_, net_, traffic_, stats_), stats(stats_) {
+    SC_THREAD(run);
+    sensitive << clk.pos();
+    NVHLS_NEG_RESET_SIGNAL_IS(rst);
+  }
+};
+
+template <typename Net>
+class NoCSource<Net, false> : public sc_module {
+ public:
+  typedef typename Net::Flit_t Flit_t;
+
+  sc_in_clk clk;
+  sc_in<bool> rst;
+  Connections::Out<Flit_t> out;
+
+  NoCPacketizer<Net> packetizer;
+  NoCStats& stats;
+
+  void run() {
+    out.Reset();
+    packetizer.reset();
+
+    wait();
+    while (1) {
+      sc_dt::uint64 now = stats.cycle();
+      if (packetizer.next_flit(now) && out.PushNB(packetizer.flit)) {
+        packetizer.flit_sent(now);
+      }
+      wait();
+    }
+  }
+
+  void bind(Net& net, int e) {
+    Connections::Combinational<Flit_t>* data_chan = new Connections::Combinational<Flit_t>();
+    out(*data_chan);
+    net.in_port[e](*data_chan);
+  }
+
+  SC_HAS_PROCESS(NoCSource);
+  NoCSource(sc_module_name name_, int id_, const Net& net_, NoCTraffic& traffic_,
+            NoCStats& stats_)
+      : sc_module(name_), clk("clk"), rst("rst"), out("out"),
+        packetizer(id_, net_, traffic_, stats_), stats(stats_) {
+    SC_THREAD(run);
+    sensitive << clk.pos();
+    NVHLS_NEG_RESET_SIGNAL_IS(rst);
+  }
+};
+
+template <typename Net>
+class NoCSink<Net, true> : public sc_module {
+ public:
+  typedef typename Net::Flit_t Flit_t;
+  typedef typename Net::Credit_ret_t Credit_ret_t;
+  enum { num_vchannels = Net::num_vchannels };
+
+  sc_in_clk clk;
+  sc_in<bool> rst;
+  Connections::In<Flit_t> in;
+  Connections::Out<Credit_ret_t> credit[num_vchannels];
+
+  NoCPacketChecker<Net> checker;
+  NoCStats& stats;
+  int credit_reg[num_vchannels];
+
+  void run() {
+    in.Reset();
+    for (int i = 0; i < num_vchannels; i++) {
+      credit[i].Reset();
+      credit_reg[i] = 0;
+    }
+    checker.reset();
+
+    wait();
+    while (1) {
+      Flit_t flit;
+      if (in.PopNB(flit)) {
+        int vc = flit.get_packet_id();
+        credit_reg[vc]++;
+        checker.receive(flit, stats.cycle());
+      }
+      // flush out credits
+      for (int i = 0; i < num_vchannels; i++) {
+        if (credit_reg[i] > 0) {
+          Credit_ret_t temp = 1;
+          if (credit[i].PushNB(temp)) credit_reg[i]--;
+        }
+      }
+      wait();
+    }
+  }
+
+  void bind(Net& net, int e) {
+    Connections::Combinational<Flit_t>* data_chan = new Connections::Combinational<Flit_t>();
+    in(*data_chan);
+    net.out_port[e](*data_chan);
+    for (int vc = 0; vc < num_vchannels; vc++) {
+      Connections::Combinational<Credit_ret_t>* credit_chan = new Connections::Combinational<Credit_ret_t>();
+      credit[vc](*credit_chan);
+      net.in_credit[e * num_vchannels + vc](*credit_chan);
+    }
+  }
+
+  SC_HAS_PROCESS(NoCSink);
+  NoCSink(sc_module_name name_, int id_, NoCStats& stats_)
+      : sc_module(name_), clk("clk"), rst("rst"), in("in"),
+        checker(name(), id_, stats_), stats(stats_) {
+    SC_THREAD(run);
+    sensitive << clk.pos();
+    NVHLS_NEG_RESET_SIGNAL_IS(rst);
+  }
+};
+
+template <typename Net>
+class NoCSink<Net, false> : public sc_module {
+ public:
+  typedef typename Net::Flit_t Flit_t;
+
+  sc_in_clk clk;
+  sc_in<bool> rst;
+  Connections::In<Flit_t> in;
+
+  NoCPacketChecker<Net> checker;
+  NoCStats& stats;
+
+  void run() {
+    in.Reset();
+    checker.reset();
+
+    wait();
+    while (1) {
+      Flit_t flit;
+      if (in.PopNB(flit)) checker.receive(flit, stats.cycle());
+      wait();
+    }
+  }
+
+  void bind(Net& net, int e) {
+    Connections::Combinational<Flit_t>* data_chan = new Connections::Combinational<Flit_t>();
+    in(*data_chan);
+    net.out_port[e](*data_chan);
+  }
+
+  SC_HAS_PROCESS(NoCSink);
+  NoCSink(sc_module_name name_, int id_, NoCStats& stats_)
+      : sc_module(name_), clk("clk"), rst("rst"), in("in"),
+        checker(name(), id_, stats_), stats(stats_) {
+    SC_THREAD(run);
+    sensitive << clk.pos();
+    NVHLS_NEG_RESET_SIGNAL_IS(rst);
+  }
+};
+
+// Interface of NoCHarness for code that drives harnesses of different networks
+class NoCHarnessIf {
+ public:
+  virtual ~NoCHarnessIf() {}
+  virtual const std::string& config() const = 0;
+  virtual const NoCTopology& topology() const = 0;
+  virtual NoCTraffic& traffic() = 0;
+  virtual NoCStats& stats() = 0;
+};
+
+/**
+ * \brief A network of NoCNetwork.h with a source and a sink on every endpoint
+ * \ingroup NoCNetwork
+ *
+ * \tparam Net              WHVCMeshNetwork or HybridMeshNetwork
+ *
+ * \par A Simple Example
+ * \code
+ *      #include <testbench/NoCTraffic.h>
+ *
+ *      ...
+ *        NoCHarness<WHVCMeshNetwork<4, 1, 2, 4> > mesh("mesh", NoCTopology::Mesh, seed, clk.period());
+ *        mesh.clk(clk);
+ *        mesh.rst(rst);
+ *        ...
+ *        mesh.traffic().set_load(0.1, mesh.stats().cycle());
+ *      ...
+ *
+ * \endcode
+ * \par
+ *
+ */
+template <typename Net>
+class NoCHarness : public sc_module, public NoCHarnessIf {
+ public:
+  sc_in_clk clk;
+  sc_in<bool> rst;
+
+  Net net;
+  NoCSource<Net>* source[Net::num_endpoints];
+  NoCSink<Net>* sink[Net::num_endpoints];
+
+  NoCHarness(sc_module_name name_, NoCTopology::Kind kind, unsigned seed,
+             const sc_time& period)
+      : sc_module(name_),
+        clk("clk"),
+        rst("rst"),
+        net("net", kind),
+        traffic_(Net::k, Net::num_lports, seed),
+        stats_(Net::num_endpoints, Net::Flit_t::data_width - Net::route_width,
+               period),
+        config_(basename()) {
+    net.clk(clk);
+    net.rst(rst);
+    for (int e = 0; e < Net::num_endpoints; e++) {
+      std::ostringstream ss;
+      ss << "source_" << e;
+      source[e] = new NoCSource<Net>(ss.str().c_str(), e, net, traffic_, stats_);
+      source[e]->clk(clk);
+      source[e]->rst(rst);
+      source[e]->bind(net, e);
+
+      ss.str("");
+      ss << "sink_" << e;
+      sink[e] = new NoCSink<Net>(ss.str().c_str(), e, stats_);
+      sink[e]->clk(clk);
+      sink[e]->rst(rst);
+      sink[e]->bind(net, e);
+    }
+  }
+
+  const std::string& config() const { return config_; }
+  const NoCTopology& topology() const { return net.topology; }
+  NoCTraffic& traffic() { return traffic_; }
+  NoCStats& stats() { return stats_; }
+
+ private:
+  NoCTraffic traffic_;
+  NoCStats stats_;
+  std::string config_;
+};
+
+#endif
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NOCTRAFFICGEN_H__
+#define __NOCTRAFFICGEN_H__
+
+// Traffic of the mesh and torus NoCs, without SystemC: the same generator
+// drives the networks of NoCNetwork.h through NoCTraffic.h and the model of
+// NoCModel.h.
+//   -The synthetic patterns are Bernoulli processes at the offered load, in
+//   flits per endpoint per cycle; a trace is replayed with its time axis scaled
+//   to the offered load.
+//   -Every source draws from its own random generator, so the packets of a
+//   source only depend on the seed and on the cycles it asked for packets.
+
+#include <NoCTopology.h>
+#include <deque>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <stdint.h>
+
+class NoCTraffic {
+ public:
+  enum Pattern {
+    UniformRandom,
+    Transpose,
+    BitComplement,
+    Hotspot,
+    TraceDriven,
+    NumPatterns
+  };
+
+  NoCTraffic(int k_, int num_lports_, unsigned seed)
+      : k(k_),
+        num_lports(num_lports_),
+        num_endpoints(k_ * k_ * num_lports_),
+        pattern(UniformRandom),
+        load(0),
+        packet_size(4),
+        max_packet_size(0),
+        hotspot(0),
+        hotspot_fraction(0.2),
+        trace(num_endpoints),
+        trace_span(0),
+        trace_load(0),
+        trace_rate(0),
+        trace_origin(0),
+        cursor(num_endpoints, 0),
+        epoch(num_endpoints, 0),
+        seq(num_endpoints, 0),
+        rng(num_endpoints) {
+    for (int i = 0; i < num_endpoints; i++) {
+      rng[i].seed(seed + i);
+    }
+  }
+
+  const int k;
+  const int num_lports;
+  const int num_endpoints;
+
+  static const char* pattern_name(Pattern p) {
+    static const char* names[NumPatterns] = {"uniform", "transpose", "bitcomp",
+                                             "hotspot", "trace"};
+    return names[p];
+  }
+
+  static bool parse_pattern(const std::string& s, Pattern& p) {
+    for (int i = 0; i < NumPatterns; i++) {
+      if (s == pattern_name(static_cast<Pattern>(i))) {
+        p = static_cast<Pattern>(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void set_pattern(Pattern p) { pattern = p; }
+  Pattern get_pattern() const { return pattern; }
+
+  // Fixed packet size of the synthetic patterns
+  void set_packet_size(int flits) { packet_size = flits; }
+
+  // Largest packet the network takes, 0 if unlimited. Checked on trace load.
+  void set_max_packet_size(int flits) { max_packet_size = flits; }
+
+  // Fraction of the packets of every other endpoint sent to endpoint e
+  void set_hotspot(int e, double fraction) {
+    hotspot = e;
+    hotspot_fraction = fraction;
+  }
+
+  // Offered load in flits per endpoint per cycle, 0 stops generation. Restarts
+  // trace replay at cycle now.
+  void set_load(double flits_per_cycle, uint64_t now) {
+    load = flits_per_cycle;
+    trace_rate = (trace_load > 0) ? (load / trace_load) : 0;
+    trace_origin = now;
+    std::fill(cursor.begin(), cursor.end(), 0);
+    std::fill(epoch.begin(), epoch.end(), 0);
+  }
+  double get_load() const { return load; }
+
+  // Reads a trace with one packet per line: "<cycle> <src> <dst> [<flits>]",
+  // endpoint ids as in NoCNetwork.h. Lines starting with # are comments. The
+  // trace repeats when replay gets to its end.
+  bool load_trace(const char* fname) {
+    std::ifstream ifs(fname);
+    if (!ifs.is_open()) {
+      std::cerr << "Cannot open trace file '" << fname << "'" << std::endl;
+      return false;
+    }
+    for (int i = 0; i < num_endpoints; i++) trace[i].clear();
+    trace_span = 0;
+    double flits = 0;
+    std::string line;
+    for (int n = 1; std::getline(ifs, line); n++) {
+      if (line.empty() || (line[0] == '#')) continue;
+      std::istringstream ss(line);
+      trace_entry e;
+      int src;
+      e.size = packet_size;
+      if (!(ss >> e.cycle >> src >> e.dst)) {
+        std::cerr << fname << ":" << n << ": expected <cycle> <src> <dst> [<flits>]" << std::endl;
+        return false;
+      }
+      ss >> e.size;
+      if ((src < 0) || (src >= num_endpoints) || (e.dst < 0) ||
+          (e.dst >= num_endpoints) || (src == e.dst)) {
+        std::cerr << fname << ":" << n << ": bad endpoints " << src << " -> " << e.dst << std::endl;
+        return false;
+      }
+      if ((e.size < 1) || (max_packet_size && (e.size > max_packet_size))) {
+        std::cerr << fname << ":" << n << ": bad packet size " << e.size << std::endl;
+        return false;
+      }
+      trace[src].push_back(e);
+      trace_span = std::max(trace_span, e.cycle + 1);
+      flits += e.size;
+    }
+    for (int i = 0; i < num_endpoints; i++) {
+      std::stable_sort(trace[i].begin(), trace[i].end(), trace_entry::before);
+    }
+    trace_load = (trace_span > 0) ? (flits / (num_endpoints * double(trace_span))) : 0;
+    std::cout << "Trace " << fname << ": " << trace_span << " cycles, "
+              << trace_load << " flits/endpoint/cycle" << std::endl;
+    return trace_span > 0;
+  }
+
+  // Appends to queue the packets endpoint src generates in cycle now. Calls
+  // for different sources may run in parallel.
+  void generate(int src, uint64_t now, std::deque<NoCPacket>& queue) {
+    if (load <= 0) return;
+    if (pattern == TraceDriven) {
+      generate_trace(src, now, queue);
+      return;
+    }
+    double p = std::min(1.0, load / packet_size);
+    if (uniform(src) >= p) return;
+    int dst = destination(src);
+    if (dst < 0) return;
+    NoCPacket pkt = {now, src, dst, packet_size, seq[src]++};
+    queue.push_back(pkt);
+  }
+
+ private:
+  struct trace_entry {
+    uint64_t cycle;
+    int dst;
+    int size;
+    static bool before(const trace_entry& a, const trace_entry& b) {
+      return a.cycle < b.cycle;
+    }
+  };
+
+  Pattern pattern;
+  double load;
+  int packet_size;
+  int max_packet_size;
+  int hotspot;
+  double hotspot_fraction;
+  std::vector<std::vector<trace_entry> > trace;  // per source, by cycle
+  uint64_t trace_span;
+  double trace_load;  // natural load of the trace
+  double trace_rate;  // trace cycles per cycle
+  uint64_t trace_origin;
+  std::vector<unsigned> cursor;  // next trace entry, per source
+  std::vector<uint64_t> epoch;  // replays done, per source
+  std::vector<unsigned> seq;  // packets generated, per source
+  std::vector<std::mt19937> rng;  // per source, independent of process order
+
+  double uniform(int src) {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng[src]);
+  }
+
+  int uniform_destination(int src) {
+    int d = std::uniform_int_distribution<int>(0, num_endpoints - 2)(rng[src]);
+    return (d >= src) ? (d + 1) : d;
+  }
+
+  // Destination endpoint of a packet from src, -1 if src sends nothing
+  int destination(int src) {
+    int r = src / num_lports, lp = src % num_lports;
+    int x = r % k, y = r / k;
+    int d = -1;
+    switch (pattern) {
+      case Transpose:
+        d = (x * k + y) * num_lports + lp;
+        break;
+      case BitComplement:
+        d = ((k - 1 - y) * k + (k - 1 - x)) * num_lports + lp;
+        break;
+      case Hotspot:
+        if ((src != hotspot) && (uniform(src) < hotspot_fraction)) {
+          d = hotspot;
+        } else {
+          d = uniform_destination(src);
+        }
+        break;
+      default:
+        d = uniform_destination(src);
+        break;
+    }
+    return (d == src) ? -1 : d;
+  }
+
+  void generate_trace(int src, uint64_t now, std::deque<NoCPacket>& queue) {
+    const std::vector<trace_entry>& v = trace[src];
+    if (v.empty()) return;
+    double t = (now - trace_origin) * trace_rate;
+    while (epoch[src] * trace_span + v[cursor[src]].cycle <= t) {
+      NoCPacket pkt = {now, src, v[cursor[src]].dst, v[cursor[src]].size,
+                       seq[src]++};
+      queue.push_back(pkt);
+      if (++cursor[src] == v.size()) {
+        cursor[src] = 0;
+        epoch[src]++;
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <systemc.h>
+#include <nvhls_connections.h>
+#include <NoCNetwork.h>
+#include <testbench/NoCTraffic.h>
+#include <testbench/nvhls_rand.h>
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+
+#ifndef NOC_K
+#define NOC_K 4
+#endif
+#ifndef NOC_LPORTS
+#define NOC_LPORTS 1
+#endif
+#ifndef NOC_VCHANNELS
+#define NOC_VCHANNELS 2
+#endif
+#ifndef NOC_BUFFERSIZE
+#define NOC_BUFFERSIZE 4
+#endif
+#ifndef NOC_PACKET_SIZE
+#define NOC_PACKET_SIZE 4
+#endif
+
+using namespace ::std;
+
+typedef WHVCMeshNetwork<NOC_K, NOC_LPORTS, NOC_VCHANNELS, NOC_BUFFERSIZE> WHVCNet;
+typedef HybridMeshNetwork<NOC_K, NOC_LPORTS, NOC_PACKET_SIZE + 2, NOC_PACKET_SIZE> HybridNet;
+
+struct Options {
+  Options()
+      : step(0.05), max_load(1.0), warmup(500), measure(2000),
+        hotspot(-1), hotspot_fraction(0.2) {
+    patterns.push_back(NoCTraffic::UniformRandom);
+    patterns.push_back(NoCTraffic::Transpose);
+    patterns.push_back(NoCTraffic::BitComplement);
+    patterns.push_back(NoCTraffic::Hotspot);
+  }
+
+  vector<NoCTraffic::Pattern> patterns;
+  string trace;
+  double step;
+  double max_load;
+  unsigned warmup;
+  unsigned measure;
+  int hotspot;
+  double hotspot_fraction;
+  string csv;
+
+  bool parse(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+      string opt = argv[i], val = argv[i + 1];
+      if (opt == "-pattern") {
+        patterns.clear();
+        istringstream ss(val);
+        string name;
+        while (getline(ss, name, ',')) {
+          NoCTraffic::Pattern p;
+          if (!NoCTraffic::parse_pattern(name, p)) {
+            cerr << "Unknown traffic pattern '" << name << "'" << endl;
+            return false;
+          }
+          patterns.push_back(p);
+        }
+      } else if (opt == "-trace") {
+        trace = val;
+      } else if (opt == "-step") {
+        step = atof(val.c_str());
+      } else if (opt == "-max") {
+        max_load = atof(val.c_str());
+      } else if (opt == "-warmup") {
+        warmup = atoi(val.c_str());
+      } else if (opt == "-measure") {
+        measure = atoi(val.c_str());
+      } else if (opt == "-hotspot") {
+        hotspot = atoi(val.c_str());
+      } else if (opt == "-hotspot_fraction") {
+        hotspot_fraction = atof(val.c_str());
+      } else if (opt == "-csv") {
+        csv = val;
+      } else {
+        cerr << "Unknown option '" << opt << "'" << endl;
+        return false;
+      }
+    }
+    bool listed = false;
+    for (unsigned i = 0; i < patterns.size(); i++) {
+      listed |= (patterns[i] == NoCTraffic::TraceDriven);
+    }
+    if (listed && trace.empty()) {
+      cerr << "Trace driven traffic needs -trace" << endl;
+      return false;
+    }
+    if (!trace.empty() && !listed) patterns.push_back(NoCTraffic::TraceDriven);
+    return (step > 0) && (measure > 0);
+  }
+};
+
+SC_MODULE(testbench) {
+  sc_clock clk;
+  sc_signal<bool> rst;
+
+  NoCHarness<WHVCNet> whvc_mesh;
+  NoCHarness<WHVCNet> whvc_torus;
+  NoCHarness<HybridNet> hybrid_mesh;
+  NoCHarness<HybridNet> hybrid_torus;
+  vector<NoCHarnessIf*> configs;
+
+  const Options& opt;
+  ofstream csv;
+
+  SC_HAS_PROCESS(testbench);
+  testbench(sc_module_name name_, const Options& opt_, unsigned seed)
+      : sc_module(name_),
+        clk("clk", 1.0, SC_NS, 0.5, 0, SC_NS, true),
+        rst("rst"),
+        whvc_mesh("whvc_mesh", NoCTopology::Mesh, seed, clk.period()),
+        whvc_torus("whvc_torus", NoCTopology::Torus, seed, clk.period()),
+        hybrid_mesh("hybrid_mesh", NoCTopology::Mesh, seed, clk.period()),
+        hybrid_torus("hybrid_torus", NoCTopology::Torus, seed, clk.period()),
+        opt(opt_) {
+
+    Connections::set_sim_clk(&clk);
+
+    whvc_mesh.clk(clk);
+    whvc_mesh.rst(rst);
+    whvc_torus.clk(clk);
+    whvc_torus.rst(rst);
+    hybrid_mesh.clk(clk);
+    hybrid_mesh.rst(rst);
+    hybrid_torus.clk(clk);
+    hybrid_torus.rst(rst);
+
+    configs.push_back(&whvc_mesh);
+    configs.push_back(&whvc_torus);
+    configs.push_back(&hybrid_mesh);
+    configs.push_back(&hybrid_torus);
+
+    // Hotspot defaults to the endpoint in the middle of the network
+    int hotspot = opt.hotspot;
+    if (hotspot < 0) hotspot = ((NOC_K / 2) * NOC_K + NOC_K / 2) * NOC_LPORTS;
+    for (unsigned c = 0; c < configs.size(); c++) {
+      NoCTraffic& t = configs[c]->traffic();
+      t.set_packet_size(NOC_PACKET_SIZE);
+      t.set_max_packet_size(NOC_PACKET_SIZE);
+      t.set_hotspot(hotspot, opt.hotspot_fraction);
+      if (!opt.trace.empty() && !t.load_trace(opt.trace.c_str())) {
+        SC_REPORT_ERROR("testbench", "Cannot load trace");
+      }
+    }
+
+    if (!opt.csv.empty()) {
+      csv.open(opt.csv.c_str());
+      csv << "config,pattern,load,offered,accepted,latency,net_latency,max_latency,packets" << endl;
+    }
+
+    SC_THREAD(run);
+  }
+
+  sc_dt::uint64 now() { return configs[0]->stats().cycle(); }
+
+  void wait_cycles(sc_dt::uint64 n) { wait(clk.period() * double(n)); }
+
+  // Sweeps the offered load of one pattern on all configurations, until each
+  // of them saturates: average latency over 3x the zero-load latency, or less
+  // than 90% of the offered traffic accepted
+  void sweep(NoCTraffic::Pattern pattern) {
+    unsigned n = configs.size();
+    vector<bool> saturated(n, false);
+    vector<double> zero_load(n, 0), saturation(n, 0);
+    vector<vector<NoCStats::Point> > curve(n);
+    vector<vector<double> > curve_load(n);
+
+    for (unsigned c = 0; c < n; c++) configs[c]->traffic().set_pattern(pattern);
+
+    for (int i = 1; i * opt.step <= opt.max_load + 1e-9; i++) {
+      double load = i * opt.step;
+      bool active = false;
+      for (unsigned c = 0; c < n; c++) {
+        configs[c]->traffic().set_load(saturated[c] ? 0 : load, now());
+        active |= !saturated[c];
+      }
+      if (!active) break;
+
+      wait_cycles(opt.warmup);
+      for (unsigned c = 0; c < n; c++) configs[c]->stats().begin_window(now());
+      wait_cycles(opt.measure);
+      for (unsigned c = 0; c < n; c++) {
+        configs[c]->stats().end_window(now());
+        configs[c]->traffic().set_load(0, now());
+      }
+
+      // Drain: every measured packet gets delivered
+      sc_dt::uint64 limit = 20 * (sc_dt::uint64(opt.warmup) + opt.measure);
+      for (sc_dt::uint64 t = 0; t < limit; t++) {
+        bool idle = true;
+        for (unsigned c = 0; c < n; c++) idle &= configs[c]->stats().idle();
+        if (idle) break;
+        wait_cycles(1);
+      }
+
+      for (unsigned c = 0; c < n; c++) {
+        if (saturated[c]) continue;
+        if (!configs[c]->stats().idle()) {
+          ostringstream ss;
+          ss << configs[c]->config() << " did not drain at load " << load;
+          SC_REPORT_ERROR("testbench", ss.str().c_str());
+          saturated[c] = true;
+          continue;
+        }
+        NoCStats::Point p = configs[c]->stats().point();
+        curve[c].push_back(p);
+        curve_load[c].push_back(load);
+        if (zero_load[c] == 0) {
+          zero_load[c] = p.latency;
+          if (p.accepted < 0.9 * p.offered) {
+            ostringstream ss;
+            ss << configs[c]->config() << " does not accept load " << load;
+            SC_REPORT_ERROR("testbench", ss.str().c_str());
+          }
+        }
+        saturation[c] = max(saturation[c], p.accepted);
+        if ((p.latency > 3 * zero_load[c]) || (p.accepted < 0.9 * p.offered)) {
+          saturated[c] = true;
+        }
+        if (csv.is_open()) {
+          csv << configs[c]->config() << "," << NoCTraffic::pattern_name(pattern)
+              << "," << load << "," << p.offered << "," << p.accepted << ","
+              << p.latency << "," << p.net_latency << "," << p.max_latency
+              << "," << p.packets << endl;
+        }
+      }
+    }
+
+    for (unsigned c = 0; c < n; c++) {
+      cout << endl
+           << configs[c]->config() << " (" << configs[c]->topology().name()
+           << "), " << NoCTraffic::pattern_name(pattern) << " traffic" << endl;
+      cout << "   load  offered accepted  latency net_lat  max_lat  packets" << endl;
+      for (unsigned i = 0; i < curve[c].size(); i++) {
+        const NoCStats::Point& p = curve[c][i];
+        cout << fixed << setprecision(3) << setw(7) << curve_load[c][i]
+             << setw(9) << p.offered << setw(9) << p.accepted
+             << setprecision(1) << setw(9) << p.latency << setw(8)
+             << p.net_latency << setw(9) << p.max_latency << setw(9)
+             << p.packets << endl;
+      }
+      cout << "Saturation throughput: " << setprecision(3) << saturation[c]
+           << " flits/endpoint/cycle" << (saturated[c] ? "" : " (not reached)")
+           << endl;
+    }
+  }
+
+  // Router pairs whose torus route differs from their mesh route, i.e. that
+  // take a wrap-around link
+  static int wrap_routes() {
+    NoCTopology mesh(NOC_K, NoCTopology::Mesh), torus(NOC_K, NoCTopology::Torus);
+    std::vector<int> mesh_dirs, torus_dirs;
+    int n = 0;
+    for (int s = 0; s < mesh.num_routers(); s++) {
+      for (int d = 0; d < mesh.num_routers(); d++) {
+        mesh.route(s, d, mesh_dirs);
+        torus.route(s, d, torus_dirs);
+        if (mesh_dirs != torus_dirs) n++;
+      }
+    }
+    return n;
+  }
+
+  void run() {
+    // reset
+    rst = 0;
+    cout << "@" << sc_time_stamp() << " Asserting Reset " << endl;
+    wait(2, SC_NS);
+    cout << "@" << sc_time_stamp() << " Deasserting Reset " << endl;
+    rst = 1;
+    wait_cycles(2);
+
+    cout << NOC_K << "x" << NOC_K << " networks, " << NOC_LPORTS
+         << " endpoint(s) per router, " << NOC_PACKET_SIZE << "-flit packets"
+         << endl;
+    cout << "The torus networks are restricted-wrap tori: only routes that end"
+         << " at node 0 of a ring use its" << endl
+         << "wrap-around link. " << wrap_routes() << " of the "
+         << NOC_K * NOC_K * NOC_K * NOC_K << " router pairs route differently"
+         << " from the mesh, so the torus" << endl
+         << "numbers are not those of a true torus." << endl;
+    for (unsigned i = 0; i < opt.patterns.size(); i++) {
+      sweep(opt.patterns[i]);
+    }
+    cout << "@" << sc_time_stamp() << " Stop " << endl;
+    sc_stop();
+  }
+};
+
+int sc_main(int argc, char* argv[]) {
+  Options opt;
+  if (!opt.parse(argc, argv)) {
+    cerr << "Usage: " << argv[0]
+         << " [-pattern uniform,transpose,bitcomp,hotspot,trace] [-trace file]"
+         << " [-step load] [-max load] [-warmup cycles] [-measure cycles]"
+         << " [-hotspot endpoint] [-hotspot_fraction f] [-csv file]" << endl;
+    return 1;
+  }
+  unsigned seed = nvhls::set_random_seed();
+  testbench my_testbench("my_testbench", opt, seed);
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+  sc_start();
+  bool rc = (sc_report_handler::get_count(SC_ERROR) > 0);
+  if (rc)
+    cout << "Simulation FAILED\n";
+  else
+    cout << "Simulation PASSED\n";
+  return rc;
+};
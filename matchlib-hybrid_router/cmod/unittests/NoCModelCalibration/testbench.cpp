@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <systemc.h>
+#include <nvhls_connections.h>
+#include <NoCNetwork.h>
+#include <NoCModel.h>
+#include <testbench/NoCTraffic.h>
+#include <testbench/nvhls_rand.h>
+
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+
+#ifndef NOC_VCHANNELS
+#define NOC_VCHANNELS 2
+#endif
+#ifndef NOC_BUFFERSIZE
+#define NOC_BUFFERSIZE 4
+#endif
+#ifndef NOC_PACKET_SIZE
+#define NOC_PACKET_SIZE 4
+#endif
+
+using namespace ::std;
+
+typedef WHVCMeshNetwork<2, 1, NOC_VCHANNELS, NOC_BUFFERSIZE> Net2;
+typedef WHVCMeshNetwork<3, 1, NOC_VCHANNELS, NOC_BUFFERSIZE> Net3;
+typedef WHVCMeshNetwork<4, 1, NOC_VCHANNELS, NOC_BUFFERSIZE> Net4;
+typedef WHVCMeshModel<NoCTraffic> Model;
+
+struct Options {
+  Options()
+      : pattern(NoCTraffic::UniformRandom), load(0.3), cycles(3000), k(32),
+        threads(4) {}
+
+  NoCTraffic::Pattern pattern;
+  double load;
+  unsigned cycles;
+  int k;
+  int threads;
+
+  bool parse(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+      string opt = argv[i], val = argv[i + 1];
+      if (opt == "-pattern") {
+        if (!NoCTraffic::parse_pattern(val, pattern) ||
+            (pattern == NoCTraffic::TraceDriven)) {
+          cerr << "Unknown traffic pattern '" << val << "'" << endl;
+          return false;
+        }
+      } else if (opt == "-load") {
+        load = atof(val.c_str());
+      } else if (opt == "-cycles") {
+        cycles = atoi(val.c_str());
+      } else if (opt == "-k") {
+        k = atoi(val.c_str());
+      } else if (opt == "-threads") {
+        threads = atoi(val.c_str());
+      } else {
+        cerr << "Unknown option '" << opt << "'" << endl;
+        return false;
+      }
+    }
+    return (load > 0) && (cycles > 0) && (k > 1) && (threads > 0);
+  }
+};
+
+// Deliveries by source endpoint and packet number
+typedef map<pair<int, unsigned>, NoCDelivery> DeliveryMap;
+
+DeliveryMap by_packet(const vector<NoCDelivery>& log) {
+  DeliveryMap m;
+  for (unsigned i = 0; i < log.size(); i++) {
+    m[make_pair(log[i].pkt.src, log[i].pkt.seq)] = log[i];
+  }
+  return m;
+}
+
+double seconds_since(const chrono::steady_clock::time_point& t0) {
+  return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+SC_MODULE(testbench) {
+  sc_clock clk;
+  sc_signal<bool> rst;
+
+  NoCHarness<Net2> mesh2;
+  NoCHarness<Net3> mesh3;
+  NoCHarness<Net3> torus3;
+  NoCHarness<Net4> mesh4;
+  NoCHarness<Net4> torus4;
+
+  struct Config {
+    NoCHarnessIf* harness;
+    int k;
+    NoCTopology::Kind kind;
+    vector<NoCDelivery> log;
+  };
+  vector<Config> configs;
+
+  const Options& opt;
+  const unsigned seed;
+
+  SC_HAS_PROCESS(testbench);
+  testbench(sc_module_name name_, const Options& opt_, unsigned seed_)
+      : sc_module(name_),
+        clk("clk", 1.0, SC_NS, 0.5, 0, SC_NS, true),
+        rst("rst"),
+        mesh2("mesh2", NoCTopology::Mesh, seed_, clk.period()),
+        mesh3("mesh3", NoCTopology::Mesh, seed_, clk.period()),
+        torus3("torus3", NoCTopology::Torus, seed_, clk.period()),
+        mesh4("mesh4", NoCTopology::Mesh, seed_, clk.period()),
+        torus4("torus4", NoCTopology::Torus, seed_, clk.period()),
+        opt(opt_),
+        seed(seed_) {
+
+    Connections::set_sim_clk(&clk);
+
+    mesh2.clk(clk);
+    mesh2.rst(rst);
+    mesh3.clk(clk);
+    mesh3.rst(rst);
+    torus3.clk(clk);
+    torus3.rst(rst);
+    mesh4.clk(clk);
+    mesh4.rst(rst);
+    torus4.clk(clk);
+    torus4.rst(rst);
+
+    add(&mesh2, 2, NoCTopology::Mesh);
+    add(&mesh3, 3, NoCTopology::Mesh);
+    add(&torus3, 3, NoCTopology::Torus);
+    add(&mesh4, 4, NoCTopology::Mesh);
+    add(&torus4, 4, NoCTopology::Torus);
+
+    // Sources generate from their first cycle out of reset on, as the model
+    // does from its cycle 0
+    for (unsigned c = 0; c < configs.size(); c++) {
+      setup(configs[c].harness->traffic());
+      configs[c].harness->stats().log_deliveries(&configs[c].log);
+    }
+
+    SC_THREAD(run);
+  }
+
+  void add(NoCHarnessIf* h, int k, NoCTopology::Kind kind) {
+    Config c;
+    c.harness = h;
+    c.k = k;
+    c.kind = kind;
+    configs.push_back(c);
+  }
+
+  void setup(NoCTraffic& t) {
+    t.set_pattern(opt.pattern);
+    t.set_packet_size(NOC_PACKET_SIZE);
+    t.set_load(opt.load, 0);
+  }
+
+  // Runs the model of config c on the same traffic and compares every packet
+  // SystemC delivered
+  void calibrate(Config& c) {
+    NoCTraffic traffic(c.k, 1, seed);
+    setup(traffic);
+    Model model(c.k, c.kind, 1, NOC_VCHANNELS, NOC_BUFFERSIZE, traffic);
+    vector<NoCDelivery> log;
+    model.log_deliveries(&log);
+    // SystemC ran a few cycles more than opt.cycles, out of reset
+    model.run(opt.cycles + 64);
+    DeliveryMap m = by_packet(log);
+
+    unsigned matched = 0;
+    sc_dt::uint64 max_diff = 0;
+    double sc_latency = 0, model_latency = 0;
+    for (unsigned i = 0; i < c.log.size(); i++) {
+      const NoCDelivery& d = c.log[i];
+      sc_dt::uint64 latency = d.deliver - d.pkt.gen;
+      sc_latency += latency;
+      DeliveryMap::const_iterator it = m.find(make_pair(d.pkt.src, d.pkt.seq));
+      if (it == m.end()) {
+        max_diff = ~sc_dt::uint64(0);
+        continue;
+      }
+      const NoCDelivery& e = it->second;
+      sc_dt::uint64 model_lat = e.deliver - e.pkt.gen;
+      model_latency += model_lat;
+      sc_dt::uint64 diff = (latency > model_lat) ? (latency - model_lat) : (model_lat - latency);
+      max_diff = max(max_diff, diff);
+      if ((diff == 0) && (d.inject - d.pkt.gen == e.inject - e.pkt.gen) &&
+          (d.pkt.dst == e.pkt.dst)) {
+        matched++;
+      }
+    }
+
+    unsigned n = c.log.size();
+    cout << setw(8) << c.harness->config() << setw(9) << n << setw(9) << matched
+         << fixed << setprecision(2) << setw(10) << (n ? sc_latency / n : 0)
+         << setw(10) << (n ? model_latency / n : 0) << setw(10);
+    if (max_diff == ~sc_dt::uint64(0)) {
+      cout << "missing" << endl;
+    } else {
+      cout << max_diff << endl;
+    }
+    if ((n == 0) || (matched != n)) {
+      ostringstream ss;
+      ss << c.harness->config() << ": " << (n - matched) << " of " << n
+         << " packets differ between SystemC and the model";
+      SC_REPORT_ERROR("testbench", ss.str().c_str());
+    }
+  }
+
+  // Runs a large mesh in the model on 1 and on opt.threads threads
+  void scale() {
+    vector<NoCDelivery> log[2];
+    NoCLoadPoint p[2];
+    int threads[2] = {1, opt.threads};
+    for (int i = 0; i < 2; i++) {
+      NoCTraffic traffic(opt.k, 1, seed);
+      setup(traffic);
+      Model model(opt.k, NoCTopology::Mesh, 1, NOC_VCHANNELS, NOC_BUFFERSIZE,
+                  traffic, threads[i]);
+      model.log_deliveries(&log[i]);
+      chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+      model.begin_window();
+      model.run(opt.cycles);
+      model.end_window();
+      double s = seconds_since(t0);
+      p[i] = model.point();
+      cout << opt.k << "x" << opt.k << " mesh model, " << model.num_threads
+           << " thread(s): " << setprecision(2) << p[i].accepted
+           << " flits/endpoint/cycle accepted, latency " << p[i].latency << ", "
+           << setprecision(0) << (double(opt.cycles) * opt.k * opt.k / s)
+           << " router cycles/s" << endl;
+    }
+    DeliveryMap m0 = by_packet(log[0]), m1 = by_packet(log[1]);
+    bool same = (m0.size() == m1.size());
+    for (DeliveryMap::const_iterator it = m0.begin(); same && (it != m0.end()); ++it) {
+      DeliveryMap::const_iterator jt = m1.find(it->first);
+      same = (jt != m1.end()) && (jt->second.deliver == it->second.deliver) &&
+             (jt->second.inject == it->second.inject);
+    }
+    if (!same) {
+      SC_REPORT_ERROR("testbench", "Model results depend on the number of threads");
+    }
+  }
+
+  void run() {
+    // reset
+    rst = 0;
+    cout << "@" << sc_time_stamp() << " Asserting Reset " << endl;
+    wait(2, SC_NS);
+    cout << "@" << sc_time_stamp() << " Deasserting Reset " << endl;
+    rst = 1;
+
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    wait(clk.period() * double(opt.cycles));
+    double s = seconds_since(t0);
+    double router_cycles = 0;
+    for (unsigned c = 0; c < configs.size(); c++) {
+      router_cycles += double(opt.cycles) * configs[c].k * configs[c].k;
+    }
+    cout << "SystemC: " << fixed << setprecision(0) << (router_cycles / s)
+         << " router cycles/s" << endl;
+
+    cout << NoCTraffic::pattern_name(opt.pattern) << " traffic, load "
+         << setprecision(2) << opt.load << ", " << NOC_PACKET_SIZE
+         << "-flit packets, " << opt.cycles << " cycles" << endl;
+    cout << "  config  packets  matched    sc_lat model_lat  max_diff" << endl;
+    for (unsigned c = 0; c < configs.size(); c++) {
+      calibrate(configs[c]);
+    }
+    scale();
+
+    cout << "@" << sc_time_stamp() << " Stop " << endl;
+    sc_stop();
+  }
+};
+
+int sc_main(int argc, char* argv[]) {
+  Options opt;
+  if (!opt.parse(argc, argv)) {
+    cerr << "Usage: " << argv[0]
+         << " [-pattern uniform|transpose|bitcomp|hotspot] [-load flits]"
+         << " [-cycles n] [-k routers] [-threads n]" << endl;
+    return 1;
+  }
+  unsigned seed = nvhls::set_random_seed();
+  testbench my_testbench("my_testbench", opt, seed);
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+  sc_start();
+  bool rc = (sc_report_handler::get_count(SC_ERROR) > 0);
+  if (rc)
+    cout << "Simulation FAILED\n";
+  else
+    cout << "Simulation PASSED\n";
+  return rc;
+};
@@ -22,7 +22,22 @@
 #include <nvhls_int.h>
 #include <nvhls_assert.h>
 
-enum arbiter_type { Static, Roundrobin };
+enum arbiter_type { Static, Roundrobin, WeightedRoundrobin, OldestFirst, Matrix };
+
+// In C++ simulation pick() works on machine words with native bit scans when
+// the arbiter fits in one. Define ARBITER_NO_HOST_PICK to simulate the code
+// that gets synthesized instead; both make the same grants.
+#if !defined(__SYNTHESIS__) && !defined(ARBITER_NO_HOST_PICK)
+#define ARBITER_HOST_PICK
+namespace nvhls {
+inline sc_dt::uint64 arbiter_mask(unsigned n) {
+  return (n >= 64) ? ~static_cast<sc_dt::uint64>(0) : ((static_cast<sc_dt::uint64>(1) << n) - 1);
+}
+// Lowest and highest set bit of a nonzero word
+inline unsigned arbiter_ctz(sc_dt::uint64 x) { return __builtin_ctzll(x); }
+inline unsigned arbiter_msb(sc_dt::uint64 x) { return 63 - __builtin_clzll(x); }
+}
+#endif
 
 
 /**
@@ -84,6 +99,11 @@ class Arbiter {
         // output : select mask
         // side effect : updates internal state of next select
         Mask pick(const Mask& valid) {
+#ifdef ARBITER_HOST_PICK
+            if (UNROLLED_SIZE <= 64) {
+              return pick_host(valid);
+            }
+#endif
             if (valid == 0) {
               return 0;
             }
@@ -128,6 +148,36 @@ class Arbiter {
             //NVHLS_ASSERT_MSG(valid!=0, "Arbiter input is zero and output is non-zero");
             return choice;
         }
+
+#ifdef ARBITER_HOST_PICK
+        // pick() on machine words. After a grant of input c other than through
+        // the wrap-around, next keeps bit 0 and has bits 1 to c-1 set.
+        Mask pick_host(const Mask& valid) {
+            sc_dt::uint64 v = valid.to_uint64();
+            if (v == 0) {
+              return 0;
+            }
+            const sc_dt::uint64 all = nvhls::arbiter_mask(size_);
+            const sc_dt::uint64 low = all >> 1;
+            sc_dt::uint64 n = next.to_uint64();
+            sc_dt::uint64 priority = (((v >> 1) & low) | (v << (size_ - 1))) &
+                                     ((n << (size_ - 1)) | low);
+            if (priority == 0) {
+              return 0;
+            }
+            unsigned first_one_idx = nvhls::arbiter_msb(priority);
+            sc_dt::uint64 unrolled_choice = static_cast<sc_dt::uint64>(1) << first_one_idx;
+            sc_dt::uint64 choice = ((unrolled_choice >> (size_ - 1)) & 1) |
+                ((((unrolled_choice >> size_) | (unrolled_choice & low)) << 1) & all);
+            if (first_one_idx != (size_ - 1)) {
+              n = (n & 1) | (nvhls::arbiter_mask(nvhls::arbiter_ctz(choice)) & ~static_cast<sc_dt::uint64>(1));
+            } else {
+              n = all;
+            }
+            next = n;
+            return choice;
+        }
+#endif
 };
 
 /**
@@ -178,6 +228,15 @@ class Arbiter<size_, Static> {
         // side effect : updates internal state of next select
         Mask pick(const Mask& valid) {
             Mask select = static_cast<Mask>(0);
+#ifdef ARBITER_HOST_PICK
+            if (size_ <= 64) {
+              sc_dt::uint64 v = valid.to_uint64();
+              if (v != 0) {
+                select = static_cast<sc_dt::uint64>(1) << nvhls::arbiter_msb(v);
+              }
+              return select;
+            }
+#endif
             NVUINTW(log_size) first_one_idx;
             if (valid != 0) {
                 first_one_idx =
@@ -189,4 +248,349 @@ class Arbiter<size_, Static> {
 };
 
 
+/**
+ * \brief Weighted roundrobin arbitration specialization. Usage similar to generic Arbiter class.
+ * \ingroup Arbiter
+ *
+ * \tparam size_            Number of elements to be arbitrated.
+ *
+ * \par Overview
+ * - Inputs take turns in increasing index order, wrapping around.
+ * - An input keeps the grant for up to weight consecutive picks while it stays valid; a weight of 0 counts as 1.
+ * - Under full contention input i gets weight[i] / sum(weight) of the grants.
+ * - Weights default to 1 (plain roundrobin) and are kept by reset().
+ *
+ * \par A Simple Example
+ * \code
+ *      #include <Arbiter.h>
+ *
+ *      ...
+ *      Arbiter<4, WeightedRoundrobin> arbiter;
+ *      arbiter.set_weight(0, 3); // input 0 gets 3 grants per turn
+ *      ...
+ *          Arbiter<4, WeightedRoundrobin>::Mask select = arbiter.pick(valid);
+ *      ...
+ *
+ * \endcode
+ * \par
+ *
+ */
+template <unsigned int size_>
+class Arbiter<size_, WeightedRoundrobin> {
+    public:
+        typedef NVUINTW(size_) Mask;
+        enum { weight_width = 8 };
+        typedef NVUINTW(weight_width) Weight;
+
+    protected:
+        enum _ { log_size = nvhls::index_width<size_>::val };
+        typedef NVUINTW(log_size) Index;
+
+        Weight weight[size_];
+        Index last;   // last input granted
+        Weight left;  // grants left in the turn of last
+
+    public:
+        Arbiter() {
+#pragma hls_unroll yes
+            for (unsigned i = 0; i < size_; i++) {
+                weight[i] = 1;
+            }
+            reset();
+        }
+
+        inline void reset() {
+            last = size_ - 1;
+            left = 0;
+        }
+
+        void set_weight(unsigned i, const Weight& w) { weight[i] = w; }
+        Weight get_weight(unsigned i) const { return weight[i]; }
+
+        Mask pick(const Mask& valid) {
+            Mask select = static_cast<Mask>(0);
+            if (valid == 0) {
+              return select;
+            }
+            if ((valid[last] == 1) && (left != 0)) {
+              select[last] = 1;
+              left--;
+              return select;
+            }
+
+            // first valid input after last
+            Index idx = 0;
+#ifdef ARBITER_HOST_PICK
+            if (size_ <= 64) {
+              sc_dt::uint64 v = valid.to_uint64();
+              sc_dt::uint64 after = v & ~nvhls::arbiter_mask(last.to_uint() + 1);
+              idx = nvhls::arbiter_ctz(after ? after : v);
+            } else
+#endif
+            {
+              bool found = false;
+#pragma hls_unroll yes
+              for (unsigned j = 1; j <= size_; j++) {
+                  unsigned cand = last.to_uint() + j;
+                  if (cand >= size_) {
+                    cand -= size_;
+                  }
+                  if (!found && (valid[cand] == 1)) {
+                    idx = cand;
+                    found = true;
+                  }
+              }
+            }
+            select[idx] = 1;
+            last = idx;
+            left = (weight[idx] == 0) ? static_cast<Weight>(0) : static_cast<Weight>(weight[idx] - 1);
+            return select;
+        }
+};
+
+/**
+ * \brief Oldest-first arbitration specialization. Usage similar to generic Arbiter class.
+ * \ingroup Arbiter
+ *
+ * \tparam size_            Number of elements to be arbitrated.
+ *
+ * \par Overview
+ * - The age of an input is the number of picks it has been valid for without a grant. It drops to 0 on a grant or when the input is not valid, and saturates at 2^age_width-1.
+ * - The valid input with the highest age is granted, the lowest index among equal ages.
+ * - Under full contention inputs are granted in turn; an input that stays valid is granted within size_ picks.
+ *
+ */
+template <unsigned int size_>
+class Arbiter<size_, OldestFirst> {
+    public:
+        typedef NVUINTW(size_) Mask;
+        enum { age_width = 8 };
+        typedef NVUINTW(age_width) Age;
+
+    protected:
+        enum _ { log_size = nvhls::index_width<size_>::val };
+        typedef NVUINTW(log_size) Index;
+
+        Age age[size_];
+
+    public:
+        Arbiter() { reset(); }
+
+        inline void reset() {
+#pragma hls_unroll yes
+            for (unsigned i = 0; i < size_; i++) {
+                age[i] = 0;
+            }
+        }
+
+        Age get_age(unsigned i) const { return age[i]; }
+
+        Mask pick(const Mask& valid) {
+            Mask select = static_cast<Mask>(0);
+            if (valid == 0) {
+              reset();
+              return select;
+            }
+
+            Index idx = 0;
+#ifdef ARBITER_HOST_PICK
+            if (size_ <= 64) {
+              sc_dt::uint64 v = valid.to_uint64();
+              unsigned best = nvhls::arbiter_ctz(v);
+              for (sc_dt::uint64 rest = v & (v - 1); rest != 0; rest &= rest - 1) {
+                  unsigned i = nvhls::arbiter_ctz(rest);
+                  if (age[i] > age[best]) {
+                    best = i;
+                  }
+              }
+              idx = best;
+            } else
+#endif
+            {
+              bool found = false;
+              Age oldest = 0;
+#pragma hls_unroll yes
+              for (unsigned i = 0; i < size_; i++) {
+                  if ((valid[i] == 1) && (!found || (age[i] > oldest))) {
+                    idx = i;
+                    oldest = age[i];
+                    found = true;
+                  }
+              }
+            }
+
+            const Age max_age = ~static_cast<Age>(0);
+#pragma hls_unroll yes
+            for (unsigned i = 0; i < size_; i++) {
+                if ((valid[i] == 0) || (i == idx)) {
+                  age[i] = 0;
+                } else if (age[i] != max_age) {
+                  age[i]++;
+                }
+            }
+            select[idx] = 1;
+            return select;
+        }
+};
+
+/**
+ * \brief Matrix (least recently granted) arbitration specialization. Usage similar to generic Arbiter class.
+ * \ingroup Arbiter
+ *
+ * \tparam size_            Number of elements to be arbitrated.
+ *
+ * \par Overview
+ * - Keeps a priority order of all inputs as a matrix: beaten_by[i] has bit j set if input j has priority over input i.
+ * - The valid input that no other valid input beats is granted, and drops to the lowest priority.
+ * - After reset lower indices have priority.
+ *
+ */
+template <unsigned int size_>
+class Arbiter<size_, Matrix> {
+    public:
+        typedef NVUINTW(size_) Mask;
+
+    protected:
+        enum _ { log_size = nvhls::index_width<size_>::val };
+        typedef NVUINTW(log_size) Index;
+
+        Mask beaten_by[size_];
+
+    public:
+        Arbiter() { reset(); }
+
+        inline void reset() {
+#pragma hls_unroll yes
+            for (unsigned i = 0; i < size_; i++) {
+                beaten_by[i] = 0;
+#pragma hls_unroll yes
+                for (unsigned j = 0; j < i; j++) {
+                    beaten_by[i][j] = 1;
+                }
+            }
+        }
+
+        Mask pick(const Mask& valid) {
+            Mask select = static_cast<Mask>(0);
+            if (valid == 0) {
+              return select;
+            }
+
+            Index idx = 0;
+#ifdef ARBITER_HOST_PICK
+            if (size_ <= 64) {
+              sc_dt::uint64 v = valid.to_uint64();
+              for (sc_dt::uint64 rest = v; rest != 0; rest &= rest - 1) {
+                  unsigned i = nvhls::arbiter_ctz(rest);
+                  if ((beaten_by[i].to_uint64() & v) == 0) {
+                    idx = i;
+                    break;
+                  }
+              }
+            } else
+#endif
+            {
+#pragma hls_unroll yes
+              for (unsigned i = 0; i < size_; i++) {
+                  if ((valid[i] == 1) && ((beaten_by[i] & valid) == 0)) {
+                    idx = i;
+                  }
+              }
+            }
+
+#pragma hls_unroll yes
+            for (unsigned i = 0; i < size_; i++) {
+                beaten_by[i][idx] = 0;
+            }
+            beaten_by[idx] = ~static_cast<Mask>(0);
+            beaten_by[idx][idx] = 0;
+            select[idx] = 1;
+            return select;
+        }
+};
+
+/**
+ * \brief Two-level QoS arbiter: strict priority between classes, an Arbiter within each class.
+ * \ingroup Arbiter
+ *
+ * \tparam size_            Number of elements to be arbitrated.
+ * \tparam num_classes_     Number of QoS classes. Class num_classes_-1 has the highest priority.
+ * \tparam ClassArbiterType Arbiter used among the valid inputs of a class (default: Roundrobin).
+ *
+ * \par Overview
+ * - Every input belongs to one class, class 0 after construction. set_class() moves an input.
+ * - pick() grants within the highest class that has a valid input; the arbiters of the other classes keep their state.
+ * - A class only gets grants when no higher class is valid.
+ * - Usage of pick() is identical to generic Arbiter class.
+ *
+ * \par A Simple Example
+ * \code
+ *      #include <Arbiter.h>
+ *
+ *      ...
+ *      QosArbiter<4, 2> arbiter;
+ *      arbiter.set_class(3, 1); // input 3 goes first
+ *      ...
+ *          QosArbiter<4, 2>::Mask select = arbiter.pick(valid);
+ *      ...
+ *
+ * \endcode
+ * \par
+ *
+ */
+template <unsigned int size_, unsigned int num_classes_,
+          arbiter_type ClassArbiterType = Roundrobin>
+class QosArbiter {
+    public:
+        typedef NVUINTW(size_) Mask;
+        typedef NVUINTW(nvhls::index_width<num_classes_>::val) Class;
+        typedef Arbiter<size_, ClassArbiterType> ClassArbiter;
+
+        // Arbiter of each class, e.g. to set weights
+        ClassArbiter arbiter[num_classes_];
+
+    protected:
+        Mask members[num_classes_];
+
+    public:
+        QosArbiter() {
+#pragma hls_unroll yes
+            for (unsigned c = 0; c < num_classes_; c++) {
+                members[c] = 0;
+            }
+            members[0] = ~static_cast<Mask>(0);
+        }
+
+        inline void reset() {
+#pragma hls_unroll yes
+            for (unsigned c = 0; c < num_classes_; c++) {
+                arbiter[c].reset();
+            }
+        }
+
+        void set_class(unsigned i, const Class& cls) {
+            NVHLS_ASSERT_MSG(cls < num_classes_, "QoS_class_out_of_range");
+#pragma hls_unroll yes
+            for (unsigned c = 0; c < num_classes_; c++) {
+                members[c][i] = (c == cls) ? 1 : 0;
+            }
+        }
+
+        Mask get_members(unsigned cls) const { return members[cls]; }
+
+        Mask pick(const Mask& valid) {
+            Mask select = static_cast<Mask>(0);
+            bool done = false;
+#pragma hls_unroll yes
+            for (int c = num_classes_ - 1; c >= 0; c--) {
+                Mask class_valid = valid & members[c];
+                if (!done && (class_valid != 0)) {
+                  select = arbiter[c].pick(class_valid);
+                  done = true;
+                }
+            }
+            return select;
+        }
+};
+
 #endif  // __ARBITER_H__
@@ -25,6 +25,53 @@
 #include <arbitrated_crossbar.h>
 #include <ArbitratedScratchpad/ArbitratedScratchpadTypes.h>
 #include <crossbar.h>
+#ifndef __SYNTHESIS__
+#include <iostream>
+#include <iomanip>
+#endif
+
+// Mappings of a word address to a bank and a row (address within the bank).
+// Row r holds addresses r*NumBanks to r*NumBanks+NumBanks-1, except for
+// BankPrimeModulo.
+//   BankLowBits:     bank = addr % NumBanks
+//   BankXorHash:     bank = (addr % NumBanks) ^ (XOR of the log2(NumBanks)-bit
+//                    fields of the row); added modulo NumBanks instead of
+//                    XORed if NumBanks is not a power of 2
+//   BankSkewed:      bank = (addr + row) % NumBanks, each row rotated by one
+//                    bank from the previous one
+//   BankPrimeModulo: bank = addr % P, row = addr / P, for P the largest prime
+//                    not above NumBanks. Banks P and up are unused, so pick a
+//                    prime NumBanks.
+enum bank_map_type { BankLowBits, BankXorHash, BankSkewed, BankPrimeModulo };
+
+namespace nvhls {
+// Whether N is prime, and the largest prime not above N (1 for N < 2)
+template <unsigned int N, unsigned int D = 2, bool Done = (D * D > N)>
+struct is_prime {
+  enum { val = (N % D != 0) && is_prime<N, D + 1>::val };
+};
+template <unsigned int N, unsigned int D>
+struct is_prime<N, D, true> {
+  enum { val = (N >= 2) };
+};
+template <unsigned int N, bool Prime = is_prime<N>::val>
+struct largest_prime {
+  enum { val = largest_prime<N - 1>::val };
+};
+template <unsigned int N>
+struct largest_prime<N, true> {
+  enum { val = N };
+};
+template <>
+struct largest_prime<1, false> {
+  enum { val = 1 };
+};
+template <>
+struct largest_prime<0, false> {
+  enum { val = 1 };
+};
+}
+
 /**
  * \brief Scratchpad Memories with arbitration and queuing 
  * \ingroup ArbitratedScratchpad
@@ -35,6 +82,11 @@
  * \tparam NumBanks         Number of Banks 
  * \tparam LenInputBuffer   Length of Input Buffer 
  * \tparam LenOutputBuffer  Length of Output Buffer 
+ * \tparam BankMap          Mapping of addresses to banks (default: BankLowBits)
+ *
+ * \par Overview
+ * - Strided accesses whose stride is a multiple of NumBanks all go to one bank with BankLowBits. BankXorHash and BankSkewed spread such strides over the banks, BankPrimeModulo spreads every stride that is not a multiple of P.
+ * - In C++ simulation, enable_stats() counts per bank the requests, the requests beyond the first to the bank in the same cycle (conflicts) and the requests that were not accepted (stalls).
  *
  * \par A Simple Example
  * \code
@@ -54,7 +106,7 @@
 
 template <typename DataType, unsigned int CapacityInBytes,
           unsigned int NumInputs, unsigned int NumBanks,
-          unsigned int InputQueueLen>
+          unsigned int InputQueueLen, bank_map_type BankMap = BankLowBits>
 class ArbitratedScratchpad {
 
  public:
@@ -66,12 +118,19 @@ class ArbitratedScratchpad {
   static const int log2_inputs = (NumInputs == 1) ? 1 : nvhls::nbits<NumInputs - 1>::val;
 
   static const bool is_nbanks_power_of_2 = (NumBanks & (NumBanks - 1)) == 0;
-  static const int bank_addr_width = (is_nbanks_power_of_2 && (NumBanks > 1)) ? (addr_width - log2_nbanks) : (addr_width - log2_nbanks + 1);
+  // Banks addresses are spread over, and rows per bank
+  static const unsigned int num_used_banks =
+      (BankMap == BankPrimeModulo) ? nvhls::largest_prime<NumBanks>::val : NumBanks;
+  static const unsigned int bank_entries =
+      (CapacityInBytes + num_used_banks - 1) / num_used_banks;
+  static const int bank_addr_width = (BankMap == BankPrimeModulo) ? nvhls::index_width<bank_entries>::val :
+      (is_nbanks_power_of_2 && (NumBanks > 1)) ? (addr_width - log2_nbanks) : (addr_width - log2_nbanks + 1);
 
   //------------Local typedefs---------------------------
   typedef NVUINTW(log2_nbanks) bank_sel_t;        // index of bank
   typedef NVUINTW(bank_addr_width) bank_addr_t;   // address within bank
   typedef NVUINTW(log2_inputs) input_sel_t;       // index of input
+  typedef NVUINTW(addr_width) addr_t;             // word address
 
   struct bank_req_t : public nvhls_message {
     NVUINT1 do_store;
@@ -104,13 +163,62 @@ class ArbitratedScratchpad {
   typedef cli_rsp_t<DataType, NumInputs> rsp_t;             // response output type
 
   //------------Local Variables Here---------------------
-  mem_array_sep<DataType, CapacityInBytes, NumBanks> banks;
+  mem_array_sep<DataType, NumBanks * bank_entries, NumBanks> banks;
   bank_req_t bank_reqs[NumInputs];
   bank_rsp_t bank_rsps[NumInputs];
 
   ArbitratedCrossbar<bank_req_t, NumInputs, NumBanks, InputQueueLen, 0>
       request_xbar;
 
+  // XOR of the log2_nbanks-bit fields of x
+  static bank_sel_t xor_fold(bank_addr_t x) {
+    bank_sel_t h = 0;
+    #pragma hls_unroll yes
+    for (int i = 0; i < bank_addr_width; i += log2_nbanks) {
+      h ^= nvhls::get_slc<log2_nbanks>(static_cast<NVUINTW(bank_addr_width + log2_nbanks)>(x), i);
+    }
+    return h;
+  }
+
+ public:
+  // Bank and row of word address addr under BankMap
+  static void map_address(const addr_t& addr, bank_sel_t& bank, bank_addr_t& row) {
+    if (NumBanks == 1) {
+      bank = 0;
+      row = addr;
+      return;
+    }
+    if (BankMap == BankPrimeModulo) {
+      bank = addr % num_used_banks;
+      row = addr / num_used_banks;
+      return;
+    }
+    bank_sel_t low;
+    if (is_nbanks_power_of_2) {
+      low = nvhls::get_slc<log2_nbanks>(addr, 0);
+      row = nvhls::get_slc<addr_width - log2_nbanks>(addr, log2_nbanks);
+    } else {
+      low = addr % NumBanks;
+      row = addr / NumBanks;
+    }
+    if (BankMap == BankXorHash) {
+      bank_sel_t h = xor_fold(row);
+      if (is_nbanks_power_of_2) {
+        bank = low ^ h;
+      } else {
+        bank = (static_cast<NVUINTW(log2_nbanks + 1)>(low) + h) % NumBanks;
+      }
+    } else if (BankMap == BankSkewed) {
+      if (is_nbanks_power_of_2) {
+        bank = low + nvhls::get_slc<log2_nbanks>(static_cast<NVUINTW(bank_addr_width + log2_nbanks)>(row), 0);
+      } else {
+        bank = (static_cast<NVUINTW(log2_nbanks + 1)>(low) + (row % NumBanks)) % NumBanks;
+      }
+    } else {
+      bank = low;
+    }
+  }
+
   void compute_bank_request(req_t &curr_cli_req, bank_req_t bank_req[NumInputs],
                             bank_sel_t bank_sel[NumInputs],
                             bool bank_req_valid[NumInputs]) {
@@ -119,30 +227,13 @@ class ArbitratedScratchpad {
     #pragma hls_unroll yes
     for (unsigned in_chan = 0; in_chan < NumInputs; in_chan++) {
 
-      // Get the target bank
-      if (NumInputs == 1) {
-        bank_sel[in_chan] = 0;
-      } else {
-        if (is_nbanks_power_of_2) {
-          bank_sel[in_chan] = nvhls::get_slc<log2_nbanks>(curr_cli_req.addr[in_chan], 0);
-        } else {
-          bank_sel[in_chan] = curr_cli_req.addr[in_chan] % NumBanks;
-        }
-      }
+      // Get the target bank and the address within it
+      map_address(curr_cli_req.addr[in_chan], bank_sel[in_chan], bank_req[in_chan].addr);
+
       // Compile the bank request
       bank_req[in_chan].do_store = (curr_cli_req.valids[in_chan] == true) &&
                                    (curr_cli_req.type.val == CLITYPE_T::STORE);
 
-      if (NumInputs == 1) {
-        bank_req[in_chan].addr = curr_cli_req.addr[in_chan];
-      } else {
-        if (is_nbanks_power_of_2) {
-          bank_req[in_chan].addr = nvhls::get_slc<addr_width - log2_nbanks>(curr_cli_req.addr[in_chan], log2_nbanks);
-        } else {
-          bank_req[in_chan].addr = curr_cli_req.addr[in_chan] / NumBanks;
-        }
-      }
-
       if (bank_req[in_chan].do_store) {
         bank_req[in_chan].wdata = curr_cli_req.data[in_chan];
       }
@@ -175,8 +266,90 @@ class ArbitratedScratchpad {
     }
   }
 
+#ifndef __SYNTHESIS__
  public:
-  ArbitratedScratchpad() { reset(); }
+  // Simulation-only per-bank counters, see enable_stats()
+  struct BankStats {
+    sc_dt::uint64 requests;   // valid requests to the bank
+    sc_dt::uint64 accesses;   // requests served by the bank
+    sc_dt::uint64 conflicts;  // requests beyond the first to the bank in a cycle
+    sc_dt::uint64 stalls;     // requests to the bank not accepted (input not ready)
+    BankStats() : requests(0), accesses(0), conflicts(0), stalls(0) {}
+  };
+
+ private:
+  bool stats_enabled;
+  BankStats bank_stats[NumBanks];
+  sc_dt::uint64 stats_cycles;
+
+  void update_stats(bank_sel_t bank_sel[NumInputs], bool bank_req_valid[NumInputs],
+                    bool input_ready[NumInputs], bool bank_req_winner_valid[NumBanks]) {
+    unsigned requests[NumBanks] = {0};
+    for (unsigned i = 0; i < NumInputs; i++) {
+      if (bank_req_valid[i]) {
+        unsigned bank = bank_sel[i];
+        requests[bank]++;
+        bank_stats[bank].stalls += !input_ready[i];
+      }
+    }
+    for (unsigned bank = 0; bank < NumBanks; bank++) {
+      bank_stats[bank].requests += requests[bank];
+      bank_stats[bank].accesses += bank_req_winner_valid[bank];
+      bank_stats[bank].conflicts += (requests[bank] > 1) ? (requests[bank] - 1) : 0;
+    }
+    stats_cycles++;
+  }
+
+ public:
+  // Counting is off by default and does not change the behavior of the
+  // scratchpad
+  void enable_stats(bool enable = true) { stats_enabled = enable; }
+
+  void reset_stats() {
+    for (unsigned bank = 0; bank < NumBanks; bank++) {
+      bank_stats[bank] = BankStats();
+    }
+    stats_cycles = 0;
+  }
+
+  const BankStats& get_stats(unsigned bank) const { return bank_stats[bank]; }
+
+  // Calls of load_store() since reset_stats() with stats enabled
+  sc_dt::uint64 get_stats_cycles() const { return stats_cycles; }
+
+  BankStats get_total_stats() const {
+    BankStats total;
+    for (unsigned bank = 0; bank < NumBanks; bank++) {
+      total.requests += bank_stats[bank].requests;
+      total.accesses += bank_stats[bank].accesses;
+      total.conflicts += bank_stats[bank].conflicts;
+      total.stalls += bank_stats[bank].stalls;
+    }
+    return total;
+  }
+
+  void print_stats(std::ostream& os) const {
+    os << "bank   requests   accesses  conflicts     stalls" << std::endl;
+    for (unsigned bank = 0; bank < NumBanks; bank++) {
+      os << std::setw(4) << bank << std::setw(11) << bank_stats[bank].requests
+         << std::setw(11) << bank_stats[bank].accesses << std::setw(11)
+         << bank_stats[bank].conflicts << std::setw(11) << bank_stats[bank].stalls
+         << std::endl;
+    }
+    BankStats total = get_total_stats();
+    os << " all" << std::setw(11) << total.requests << std::setw(11) << total.accesses
+       << std::setw(11) << total.conflicts << std::setw(11) << total.stalls << std::endl;
+  }
+#endif
+
+ public:
+  ArbitratedScratchpad() {
+#ifndef __SYNTHESIS__
+    stats_enabled = false;
+    reset_stats();
+#endif
+    reset();
+  }
 
   void reset() { request_xbar.reset(); }
 
@@ -211,6 +384,11 @@ class ArbitratedScratchpad {
     bool bank_req_winner_valid[NumBanks];
     request_xbar.run(bank_req, bank_sel, bank_req_valid, bank_req_winner,
                      bank_req_winner_valid, input_ready);
+#ifndef __SYNTHESIS__
+    if (stats_enabled) {
+      update_stats(bank_sel, bank_req_valid, input_ready, bank_req_winner_valid);
+    }
+#endif
 
     CDCOUT("\t\tbank winner transactions:" << endl, kDebugLevel);
     for (unsigned i = 0; i < NumBanks; ++i) {
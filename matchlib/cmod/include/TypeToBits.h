@@ -114,7 +114,18 @@ T BitsToType(sc_lv<Wrapped<T>::width> mbits)
 template <typename T>
 NVUINTW(Wrapped<T>::width) TypeToNVUINT(T in)
 {
+#ifdef CONNECTIONS_MARSHALLER_PACKED
+  // Convert in the Marshaller's packed words, without building an sc_lv
+  Marshaller<Wrapped<T>::width> marshaller;
+  Wrapped<T> wm(in);
+  wm.Marshall(marshaller);
+  marshaller.Rewind();
+  Wrapped<NVUINTW(Wrapped<T>::width)> result;
+  result.Marshall(marshaller);
+  return result.val;
+#else
   return BitsToType<NVUINTW(Wrapped<T>::width)>(TypeToBits(in));
+#endif
 }
 
 /**
@@ -143,7 +154,17 @@ NVUINTW(Wrapped<T>::width) TypeToNVUINT(T in)
 template <typename T>
 T NVUINTToType(const NVUINTW(Wrapped<T>::width) & uintbits)
 {
+#ifdef CONNECTIONS_MARSHALLER_PACKED
+  Marshaller<Wrapped<T>::width> marshaller;
+  Wrapped<NVUINTW(Wrapped<T>::width)> wm(uintbits);
+  wm.Marshall(marshaller);
+  marshaller.Rewind();
+  Wrapped<T> result;
+  result.Marshall(marshaller);
+  return result.val;
+#else
   return BitsToType<T>(TypeToBits(uintbits));
+#endif
 }
 
 #endif
@@ -24,9 +24,15 @@
 #include <nvhls_marshaller.h>
 #include <nvhls_message.h>
 
-// Need to add in virtual output queueing at the input. Can replace the input
-// FIFOs with a Queue class which internally has multiple parallel FIFOs and
-// keeps track of where to put each new input
+// Allocators matching the inputs of an ArbitratedCrossbar to its outputs
+//   OutputFirst: one roundrobin arbiter per output (and, with virtual output
+//                queues, one per input accepting among the grants it got)
+//   ISLIP:       iSLIP, NumIterations request-grant-accept rounds. Arbiters
+//                only move on grants accepted in the first round.
+//   Wavefront:   wavefront allocator, diagonals of the request matrix in turn
+//                starting from one that rotates every cycle
+enum crossbar_allocator_type { OutputFirst, ISLIP, Wavefront };
+
 /**
  * \brief Crossbar with conflict arbitration and input queuing 
  * \ingroup ArbitratedCrossbar
@@ -36,6 +42,13 @@
  * \tparam NumOutputs       Number of Outputs 
  * \tparam LenInputBuffer   Length of Input Buffer 
  * \tparam LenOutputBuffer  Length of Output Buffer 
+ * \tparam Allocator        Allocator matching inputs to outputs (default: OutputFirst)
+ * \tparam VirtualOutputQueues  Queue each input per output, LenInputBuffer entries each, so that a blocked head does not hold back the other outputs. Needs LenInputBuffer > 0. (default: false)
+ * \tparam NumIterations    Rounds of ISLIP allocation (default: 1)
+ *
+ * \par Overview
+ * - With a single queue per input each input requests one output, and any of the allocators reaches the same, head-of-line blocked, throughput (about 60% under uniform load).
+ * - With VirtualOutputQueues an input requests every output it has data for, and ISLIP or Wavefront find a matching close to maximum.
  *
  * \par A Simple Example
  * \code
@@ -62,7 +75,9 @@
  */
 
 template <typename DataType, unsigned int NumInputs, unsigned int NumOutputs,
-          unsigned int LenInputBuffer, unsigned int LenOutputBuffer>
+          unsigned int LenInputBuffer, unsigned int LenOutputBuffer,
+          crossbar_allocator_type Allocator = OutputFirst,
+          bool VirtualOutputQueues = false, unsigned int NumIterations = 1>
 class ArbitratedCrossbar {
 
  public:
@@ -76,7 +91,13 @@ class ArbitratedCrossbar {
   typedef NVUINTW(Wrapped<DataType>::width + log2_outputs) DataDestType;
   #endif
 
+  static const bool UseVOQ = VirtualOutputQueues && (LenInputBuffer > 0);
+
  private:
+  static const unsigned int WavefrontSize =
+      (NumInputs > NumOutputs) ? NumInputs : NumOutputs;
+  typedef NVUINTW(nvhls::index_width<WavefrontSize>::val) Diagonal;
+
   // Convenience class which stores a data and destination
   // This is what is stored in the input FIFOs
   class DataDest : public nvhls_message {
@@ -108,14 +129,21 @@ class ArbitratedCrossbar {
   };
 
   // Input + output FIFOs, arbiters
+  // With virtual output queues, queue in * NumOutputs + out holds the data of
+  // input in for output out, and input_queues is unused
+  static const unsigned int LenInputQueue = UseVOQ ? 0 : LenInputBuffer;
+  static const unsigned int LenVOQ = UseVOQ ? LenInputBuffer : 0;
   #ifndef SKIP_LV2TYPE
-  FIFO<DataDest, LenInputBuffer, NumInputs> input_queues;
+  FIFO<DataDest, LenInputQueue, NumInputs> input_queues;
   #else
-  FIFO<DataDestType, LenInputBuffer,  NumInputs> input_queues;
+  FIFO<DataDestType, LenInputQueue,  NumInputs> input_queues;
   #endif
+  FIFO<DataType, LenVOQ, NumInputs * NumOutputs> voqs;
   FIFO<DataType, LenOutputBuffer, NumOutputs> output_queues;
 
-  Arbiter<NumInputs> arbiters[NumOutputs];
+  Arbiter<NumInputs> arbiters[NumOutputs];         // grant, per output
+  Arbiter<NumOutputs> accept_arbiters[NumInputs];  // accept, per input
+  Diagonal wavefront_priority;
 
  public:
   ArbitratedCrossbar() { reset(); }
@@ -125,17 +153,25 @@ class ArbitratedCrossbar {
 #pragma hls_unroll yes
     for (unsigned in = 0; in < NumInputs; in++) {
       input_queues.reset();
+      accept_arbiters[in].reset();
     }
+    voqs.reset();
 #pragma hls_unroll yes
     for (unsigned out = 0; out < NumOutputs; out++) {
       output_queues.reset();
       arbiters[out].reset();
     }
+    wavefront_priority = 0;
   }
 
-  // The next few functions report status of a given input or output lane
+  // The next few functions report status of a given input or output lane.
+  // With virtual output queues an input is empty when all its queues are, and
+  // full when any of them is.
   bool isInputEmpty(InputIdx index) {
     NVHLS_ASSERT_MSG(index <= NumInputs, "Input index greater than number of inputs");
+    if (UseVOQ) {
+      return voq_requests(index) == 0;
+    }
     return input_queues.isEmpty(index);
   }
 
@@ -146,6 +182,14 @@ class ArbitratedCrossbar {
 
   bool isInputFull(InputIdx index) {
     NVHLS_ASSERT_MSG(index <= NumInputs, "Input index greater than number of inputs");
+    if (UseVOQ) {
+      bool full = false;
+#pragma hls_unroll yes
+      for (unsigned out = 0; out < NumOutputs; out++) {
+        full = full | voqs.isFull(voq_index(index, out));
+      }
+      return full;
+    }
     return input_queues.isFull(index);
   }
 
@@ -156,6 +200,10 @@ class ArbitratedCrossbar {
 
   // Add data to a specified input lane, with a specified destination lane
   void push(DataType data, InputIdx src, OutputIdx dest) {
+    if (UseVOQ) {
+      voqs.push(data, voq_index(src, dest));
+      return;
+    }
     DataDest tmp;
     tmp.data = data;
     tmp.dest = dest;
@@ -174,6 +222,215 @@ class ArbitratedCrossbar {
   // Pop the data from a specified output lane
   DataType pop(OutputIdx index) { return output_queues.pop(index); }
 
+ private:
+  static unsigned voq_index(unsigned in, unsigned out) {
+    return in * NumOutputs + out;
+  }
+
+  // Outputs input in has data queued for
+  NVUINTW(NumOutputs) voq_requests(InputIdx in) {
+    NVUINTW(NumOutputs) requests = 0;
+#pragma hls_unroll yes
+    for (unsigned out = 0; out < NumOutputs; out++) {
+      requests[out] = !voqs.isEmpty(voq_index(in, out));
+    }
+    return requests;
+  }
+
+  // Allocators: requests[in] has a bit per output input in requests, grants[out]
+  // is the one-hot input output out transfers from, or 0. Every input gets at
+  // most one output and outputs that are not ready get none.
+  void allocate_output_first(NVUINTW(NumOutputs) requests_transpose[NumInputs],
+                             bool output_ready[NumOutputs],
+                             NVUINTW(NumInputs) grants[NumOutputs]) {
+    NVUINTW(NumInputs) requests[NumOutputs];  // requests for all outputs
+
+// Form transpose request matrix
+#pragma hls_unroll yes
+    for (unsigned out = 0; out < NumOutputs; out++) {
+#pragma hls_unroll yes
+      for (unsigned in = 0; in < NumInputs; in++) {
+        requests[out][in] = requests_transpose[in][out];
+      }
+    }
+
+#pragma hls_unroll yes
+    for (unsigned out = 0; out < NumOutputs; out++) {
+      grants[out] = 0;
+      // Stall the arbiters and the crossbar if the output is full
+      // This is also needed to get any pipelining (otherwise the tool will
+      // infer that you want to write in a single cycle)
+      if (output_ready[out]) {
+        grants[out] = arbiters[out].pick(requests[out]);
+      }
+    }
+
+    // An input with a single queue requests one output, so only gets one grant
+    if (UseVOQ) {
+#pragma hls_unroll yes
+      for (unsigned in = 0; in < NumInputs; in++) {
+        NVUINTW(NumOutputs) offers;
+#pragma hls_unroll yes
+        for (unsigned out = 0; out < NumOutputs; out++) {
+          offers[out] = grants[out][in];
+        }
+        NVUINTW(NumOutputs) accept = accept_arbiters[in].pick(offers);
+#pragma hls_unroll yes
+        for (unsigned out = 0; out < NumOutputs; out++) {
+          grants[out][in] = accept[out];
+        }
+      }
+    }
+  }
+
+  void allocate_islip(NVUINTW(NumOutputs) requests_transpose[NumInputs],
+                      bool output_ready[NumOutputs],
+                      NVUINTW(NumInputs) grants[NumOutputs]) {
+    NVUINTW(NumInputs) input_matched = 0;
+    NVUINTW(NumOutputs) output_matched = 0;
+#pragma hls_unroll yes
+    for (unsigned out = 0; out < NumOutputs; out++) {
+      grants[out] = 0;
+    }
+
+#pragma hls_unroll yes
+    for (unsigned iter = 0; iter < NumIterations; iter++) {
+      // Grant: each free output offers itself to one free requesting input
+      Arbiter<NumInputs> grant_arbiters[NumOutputs];
+      NVUINTW(NumInputs) offers[NumOutputs];
+#pragma hls_unroll yes
+      for (unsigned out = 0; out < NumOutputs; out++) {
+        NVUINTW(NumInputs) requests = 0;
+        if (output_ready[out] && (output_matched[out] == 0)) {
+#pragma hls_unroll yes
+          for (unsigned in = 0; in < NumInputs; in++) {
+            requests[in] = requests_transpose[in][out] & !input_matched[in];
+          }
+        }
+        grant_arbiters[out] = arbiters[out];
+        offers[out] = grant_arbiters[out].pick(requests);
+      }
+
+      // Accept: each input takes one of the outputs offered to it
+      NVUINTW(NumOutputs) accepts[NumInputs];
+#pragma hls_unroll yes
+      for (unsigned in = 0; in < NumInputs; in++) {
+        NVUINTW(NumOutputs) offered;
+#pragma hls_unroll yes
+        for (unsigned out = 0; out < NumOutputs; out++) {
+          offered[out] = offers[out][in];
+        }
+        Arbiter<NumOutputs> accept_arbiter = accept_arbiters[in];
+        accepts[in] = accept_arbiter.pick(offered);
+        if (iter == 0) {
+          accept_arbiters[in] = accept_arbiter;
+        }
+        if (accepts[in] != 0) {
+          input_matched[in] = 1;
+        }
+      }
+
+#pragma hls_unroll yes
+      for (unsigned out = 0; out < NumOutputs; out++) {
+        bool accepted = false;
+#pragma hls_unroll yes
+        for (unsigned in = 0; in < NumInputs; in++) {
+          if (accepts[in][out]) {
+            grants[out][in] = 1;
+            accepted = true;
+          }
+        }
+        if (accepted) {
+          output_matched[out] = 1;
+          if (iter == 0) {
+            arbiters[out] = grant_arbiters[out];
+          }
+        }
+      }
+    }
+  }
+
+  void allocate_wavefront(NVUINTW(NumOutputs) requests_transpose[NumInputs],
+                          bool output_ready[NumOutputs],
+                          NVUINTW(NumInputs) grants[NumOutputs]) {
+    NVUINTW(NumInputs) input_matched = 0;
+    NVUINTW(NumOutputs) output_matched = 0;
+#pragma hls_unroll yes
+    for (unsigned out = 0; out < NumOutputs; out++) {
+      grants[out] = 0;
+      output_matched[out] = !output_ready[out];
+    }
+
+    // Cells (in, out) with in + out == d (mod WavefrontSize) are in distinct
+    // rows and columns, so a diagonal is granted at once
+#pragma hls_unroll yes
+    for (unsigned k = 0; k < WavefrontSize; k++) {
+      unsigned d = wavefront_priority + k;
+      if (d >= WavefrontSize) {
+        d -= WavefrontSize;
+      }
+#pragma hls_unroll yes
+      for (unsigned in = 0; in < NumInputs; in++) {
+        unsigned out = d + WavefrontSize - in;
+        if (out >= WavefrontSize) {
+          out -= WavefrontSize;
+        }
+        if ((out < NumOutputs) && requests_transpose[in][out] &&
+            (input_matched[in] == 0) && (output_matched[out] == 0)) {
+          grants[out][in] = 1;
+          input_matched[in] = 1;
+          output_matched[out] = 1;
+        }
+      }
+    }
+
+    if (wavefront_priority == WavefrontSize - 1) {
+      wavefront_priority = 0;
+    } else {
+      wavefront_priority++;
+    }
+  }
+
+  void allocate(NVUINTW(NumOutputs) requests_transpose[NumInputs],
+                bool output_ready[NumOutputs],
+                NVUINTW(NumInputs) grants[NumOutputs]) {
+    if (Allocator == ISLIP) {
+      allocate_islip(requests_transpose, output_ready, grants);
+    } else if (Allocator == Wavefront) {
+      allocate_wavefront(requests_transpose, output_ready, grants);
+    } else {
+      allocate_output_first(requests_transpose, output_ready, grants);
+    }
+  }
+
+  // Crossbar for virtual output queues: allocate, move the data of each grant
+  // and pop its queue
+  void xbar_voq(DataType data_out[NumOutputs], bool valid_out[NumOutputs],
+                bool output_ready[NumOutputs], InputIdx source[NumOutputs]) {
+    NVUINTW(NumOutputs) requests_transpose[NumInputs];
+#pragma hls_unroll yes
+    for (unsigned in = 0; in < NumInputs; in++) {
+      requests_transpose[in] = voq_requests(in);
+    }
+
+    NVUINTW(NumInputs) grants[NumOutputs];
+    allocate(requests_transpose, output_ready, grants);
+
+#pragma hls_unroll yes
+    for (unsigned out = 0; out < NumOutputs; out++) {
+      valid_out[out] = false;
+      if (grants[out] != 0) {
+        InputIdx source_local;
+        one_hot_to_bin<NumInputs, log2_inputs>(grants[out], source_local);
+        data_out[out] = voqs.peek(voq_index(source_local, out));
+        voqs.incrHead(voq_index(source_local, out));
+        valid_out[out] = true;
+        source[out] = source_local;
+      }
+    }
+  }
+
+ public:
   // Run the crossbar (not the queues)
   void xbar(DataDest input_data[NumInputs], bool input_valid[NumInputs],
             bool input_consumed[NumInputs], DataType data_out[NumOutputs],
@@ -185,8 +442,6 @@ class ArbitratedCrossbar {
     // with its transpose)
     // Doing this facilitates writing it in one dimension and reading it in
     // another
-    NVUINTW(NumInputs) requests[NumOutputs];  // requests for all outputs
-
     NVUINTW(NumOutputs) requests_transpose[NumInputs];
 
 #pragma hls_unroll yes
@@ -199,14 +454,9 @@ class ArbitratedCrossbar {
       requests_transpose[in] = empty;
     }
 
-// Form transpose request matrix
-#pragma hls_unroll yes
-    for (unsigned out = 0; out < NumOutputs; out++) {
-#pragma hls_unroll yes
-      for (unsigned in = 0; in < NumInputs; in++) {
-        requests[out][in] = requests_transpose[in][out];
-      }
-    }
+    // Run the allocator
+    NVUINTW(NumInputs) grants[NumOutputs];
+    allocate(requests_transpose, output_ready, grants);
 
 // Keep track of which input queues need to be popped
 // This signal is the OR of all grant bits sent by output lanes to this
@@ -220,22 +470,17 @@ class ArbitratedCrossbar {
       input_consumed[in] = false;
     }
 
-// Loop over output lanes: run arbiter, then resolve contention
+// Loop over output lanes: resolve contention
 #pragma hls_unroll yes
     for (unsigned out = 0; out < NumOutputs; out++) {
       valid_out[out] = false;
 
-      NVUINTW(NumInputs) one_hot_grant = 0;
+      NVUINTW(NumInputs) one_hot_grant = grants[out];
       InputIdx source_local;
 
-      // Stall the arbiters and the crossbar if the output is full
-      // This is also needed to get any pipelining (otherwise the tool will
-      // infer that you want to write in a single cycle)
       // For some reason separating these two if statements gives better results
       if (output_ready[out]) {
-
-        // Run through the Arbiter pick() function, convert to binary
-        one_hot_grant = arbiters[out].pick(requests[out]);
+        // Convert the grant to binary
         one_hot_to_bin<NumInputs, log2_inputs>(one_hot_grant, source_local);
       }
 
@@ -340,7 +585,17 @@ class ArbitratedCrossbar {
       output_data[i] = BitsToType<DataType>(0);
     }
 
-    if (LenInputBuffer > 0) {
+    if (UseVOQ) {
+// Inputs are ready when the queue for their destination has room
+#pragma hls_unroll yes
+      for (unsigned in = 0; in < NumInputs; in++) {
+        bool full = voqs.isFull(voq_index(in, destin_tmp[in]));
+        ready[in] = !full || !valid_in_tmp[in];
+        if (!full & valid_in_tmp[in]) {
+          push(data_in[in], in, destin_tmp[in]);
+        }
+      }
+    } else if (LenInputBuffer > 0) {
 // If lane is ready and input data is valid, write to it
 #pragma hls_unroll yes
       for (unsigned in = 0; in < NumInputs; in++) {
@@ -384,8 +639,17 @@ class ArbitratedCrossbar {
     }
 
     // Process the XBAR and arbiters
-    xbar(input_data, input_valid, input_consumed, output_data, output_valid,
-         output_ready, source);
+    if (UseVOQ) {
+      // xbar_voq() pops the queues it forwards from
+#pragma hls_unroll yes
+      for (unsigned in = 0; in < NumInputs; in++) {
+        input_consumed[in] = false;
+      }
+      xbar_voq(output_data, output_valid, output_ready, source);
+    } else {
+      xbar(input_data, input_valid, input_consumed, output_data, output_valid,
+           output_ready, source);
+    }
 	for (unsigned out = 0; out < NumOutputs; out++) {
       //DCOUT("DUT - Output: " << out << "\t valid: " << output_valid[out] << "\t data: " << output_data[out] << "\tReady: " << output_ready[out] << endl);
 	}
@@ -24,6 +24,7 @@
 #include <nvhls_array.h>
 #include <axi/axi4.h>
 #include "Arbiter.h"
+#include "fifo.h"
 #include "TypeToBits.h"
 
 /**
@@ -35,12 +36,14 @@
  * \tparam numAddrBitsToInspect     The number of address bits to inspect when determining which slave to direct traffic to.  If this is less than the full address width, the routing determination will be made based on the number of address LSBs specified.  (Default: axiCfg::addrWidth)
  * \tparam default_output           If true, requests with addresses that do not fall in any of the specified address ranges will be directed to the highest-indexed slave port.  (Default: false)
  * \tparam translate_addr           If true, requests are re-addressed relative to the base address of the receiving slave when they are passed through the splitter.  (Default: false)
+ * \tparam maxOutstanding           The number of reads, and of writes, that may be outstanding per AXI ID.  (Default: 1)
  *
  * \par Overview
  * AxiSplitter connects one or more AXI slaves to a single AXI master.  Requests from the master are routed by address to the appropriate slave.
  * - The address ranges for each slave must be contiguous (except for the highest-indexed slave if default_output is true).  Address bounds for each slave are set by writing to a (numSlaves x 2) array of sc_in.
- * - Only a single outstanding request to all slaves is allowed; AxiSplitter blocks further requests until the response has been returned.
- * - As implemented, the splitter directs all writes from a burst to the destination indicated by the base address of the burst.  Guards against crossing address boundaries are not implemented.
+ * - Up to maxOutstanding reads and maxOutstanding writes per AXI ID may be in flight.  All requests in flight with one ID go to the same slave, so their responses return in order; a request with that ID for another slave waits until they have completed.  Responses with different IDs may return in a different order than their requests, so masters behind an AxiArbiter, which expects responses in order, should share one ID.
+ * - Responses are taken from the slaves in round robin, a whole read burst at a time.
+ * - A burst that crosses the upper bound of its slave's address range is split at the bound, and the rest is routed as a new request once the first part has completed.  The first part is only sent when no other request with its ID is in flight, so the part in flight is the only request of that ID to complete.  The master sees a single burst: one last beat for reads and one write response, the worst of those of the parts.  Bursts are assumed to be incrementing with full-width beats.
  * - The AXI configs of all ports must be the same.
  *
  * \par Usage Guidelines
@@ -58,7 +61,7 @@
  * \par
  *
  */
-template <typename axiCfg, int numSlaves, int numAddrBitsToInspect = axiCfg::addrWidth, bool default_output = false, bool translate_addr = false>
+template <typename axiCfg, int numSlaves, int numAddrBitsToInspect = axiCfg::addrWidth, bool default_output = false, bool translate_addr = false, int maxOutstanding = 1>
 class AxiSplitter : public sc_module {
  public:
   static const int kDebugLevel = 5;
@@ -74,6 +77,17 @@ class AxiSplitter : public sc_module {
   typedef typename axi4_::write::template master<>::BPort axi_wr_master_b;
 
   static const unsigned int log_numSlaves = nvhls::log2_ceil<numSlaves>::val + 1;
+  static const int numIds = 1 << axi4_::ID_WIDTH;
+  static const int idIdxWidth = (axi4_::ID_WIDTH > 0) ? axi4_::ID_WIDTH : 1;
+  static const int lenWidth = (axi4_::ALEN_WIDTH > 0) ? axi4_::ALEN_WIDTH : 1;
+  static const int bytesPerBeat = axi4_::DATA_WIDTH >> 3;
+  static const int log_bytesPerBeat = nvhls::log2_ceil<bytesPerBeat>::val;
+  static const int outstandingWidth = nvhls::nbits<maxOutstanding>::val;
+
+  typedef NVUINTW(log_numSlaves) SlaveIdx;
+  typedef NVUINTW(idIdxWidth) IdIdx;
+  typedef NVUINTW(lenWidth) Len;
+  typedef NVUINTW(outstandingWidth) Outstanding;
 
   // [ben] Unfortunately HLS cannot handle an nv_array of the master/slave wrapper classes.
   // It will work fine in C but die mysteriously in Catapult 10.1b when methods of the
@@ -112,8 +126,60 @@ class AxiSplitter : public sc_module {
     async_reset_signal_is(reset_bar, false);
   }
 
-  // As an optimization, responses with different IDs could be allowed
-  // through, since it is safe to return them out of order.
+  // Where the W beats of a request sent to a slave go
+  struct WriteRoute : public nvhls_message {
+    SlaveIdx slave;
+    Len len;
+    static const int width = log_numSlaves + lenWidth;
+
+    template <unsigned int Size>
+    void Marshall(Marshaller<Size>& m) {
+      m& slave;
+      m& len;
+    }
+  };
+
+  // Finds the slave req goes to. If the burst crosses the upper bound of the
+  // slave's range, first is the part up to the bound, rest is the remainder,
+  // and the function returns true.
+  bool route(typename axi4_::AddrPayload req, SlaveIdx& pushedTo,
+             typename axi4_::AddrPayload& first, typename axi4_::AddrPayload& rest) {
+    NVUINTW(numAddrBitsToInspect)
+        addr(static_cast<sc_uint<numAddrBitsToInspect> >(req.addr)); // Cast larger to smaller
+    pushedTo = numSlaves;
+    // TODO - refactor this so it can be unrolled
+    for (int i=0; i<numSlaves; i++) {
+      if (addr >= addrBound[i][0].read() && addr <= addrBound[i][1].read() && pushedTo == numSlaves) {
+        pushedTo = i;
+      }
+    }
+    bool in_range = (pushedTo != numSlaves);
+    if (default_output && pushedTo == numSlaves) {
+      pushedTo = numSlaves-1;
+    }
+    // If the address did not fall in any valid range, that's bad
+    NVHLS_ASSERT_MSG(pushedTo != numSlaves, "Address did not fall into any output address range, and default output is not set");
+
+    first = req;
+    rest = req;
+    bool split = false;
+    if (axiCfg::useBurst && in_range) {
+      Len len = req.len.to_uint64();
+      NVUINTW(numAddrBitsToInspect) upper = addrBound[pushedTo][1].read();
+      NVUINTW(numAddrBitsToInspect + 1) last_addr = addr;
+      last_addr += static_cast<NVUINTW(numAddrBitsToInspect + 1)>(len) << log_bytesPerBeat;
+      if (last_addr > upper) {
+        Len beats = ((upper - addr) >> log_bytesPerBeat) + 1;
+        first.len = beats - 1;
+        rest.len = len - beats;
+        rest.addr = req.addr + (static_cast<typename axi4_::Addr>(beats) << log_bytesPerBeat);
+        split = true;
+      }
+    }
+    if (translate_addr)
+      first.addr -= addrBound[pushedTo][0].read();
+    return split;
+  }
 
   void run_r() {
 #pragma hls_unroll yes
@@ -125,47 +191,98 @@ class AxiSplitter : public sc_module {
     axi_rd_m.r.Reset();
 
     typename axi4_::AddrPayload AR_reg;
-    typename axi4_::ReadPayload R_reg;
+    typename axi4_::AddrPayload AR_first;
+    typename axi4_::AddrPayload AR_rest;
+    bool AR_valid = 0;
+    nvhls::nv_array<typename axi4_::ReadPayload, numSlaves> R_reg;
+    NVUINTW(numSlaves) R_valid = 0;
+    typename axi4_::ReadPayload R_out;
 
-    bool read_inFlight = 0;
-    NVUINTW(log_numSlaves) pushedTo = numSlaves;
+    // Per ID: reads in flight, the slave they went to, and whether the one in
+    // flight is the first part of a split burst (then it is the only one)
+    Outstanding inFlight[numIds];
+    SlaveIdx inFlightTo[numIds];
+    bool inFlightSplit[numIds];
+#pragma hls_unroll yes
+    for (int i=0; i<numIds; i++) {
+      inFlight[i] = 0;
+      inFlightTo[i] = 0;
+      inFlightSplit[i] = 0;
+    }
+
+    Arbiter<numSlaves> arb;
+    bool burst_active = 0;
+    SlaveIdx burstFrom = 0;
     
       #pragma hls_pipeline_init_interval 1
       #pragma pipeline_stall_mode flush
     while (1) {
       wait();
 
-      switch (read_inFlight) {
-        case false:
-          if (axi_rd_m.ar.PopNB(AR_reg)) {
-            NVUINTW(numAddrBitsToInspect)
-                addr(static_cast<sc_uint<numAddrBitsToInspect> >(AR_reg.addr)); // Cast larger to smaller
-            pushedTo = numSlaves;
-            // TODO - refactor this so it can be unrolled
-            for (int i=0; i<numSlaves; i++) {
-              if (addr >= addrBound[i][0].read() && addr <= addrBound[i][1].read() && pushedTo == numSlaves) {
-                pushedTo = i;
-              }
-            }
-            if (default_output && pushedTo == numSlaves) {
-              pushedTo = numSlaves-1;
+      // Requests
+      if (!AR_valid) {
+        AR_valid = axi_rd_m.ar.PopNB(AR_reg);
+      }
+      if (AR_valid) {
+        SlaveIdx pushedTo;
+        bool split = route(AR_reg, pushedTo, AR_first, AR_rest);
+        IdIdx id = AR_reg.id.to_uint64();
+        // A split burst goes out alone, so that inFlightSplit describes the
+        // request that completes next
+        if ((inFlight[id] == 0) ||
+            (!split && (inFlightTo[id] == pushedTo) && (inFlight[id] < maxOutstanding) && !inFlightSplit[id])) {
+          if (axi_rd_s_ar[pushedTo].PushNB(AR_first)) {
+            CDCOUT(sc_time_stamp() << " " << name() << " Pushed read request:"
+                          << " to_port=" << pushedTo
+                          << " request=[" << AR_first << "]"
+                          << endl, kDebugLevel);
+            inFlight[id]++;
+            inFlightTo[id] = pushedTo;
+            inFlightSplit[id] = split;
+            if (split) {
+              AR_reg = AR_rest;
+            } else {
+              AR_valid = 0;
             }
-            // If the address did not fall in any valid range, that's bad
-            NVHLS_ASSERT_MSG(pushedTo != numSlaves, "Read address did not fall into any output address range, and default output is not set");
-
-            if (translate_addr)
-              AR_reg.addr -= addrBound[pushedTo][0].read();
+          }
+        }
+      }
 
-            axi_rd_s_ar[pushedTo].Push(AR_reg);
-            read_inFlight = 1;
+      // Responses
+#pragma hls_unroll yes
+      for (int i=0; i<numSlaves; i++) {
+        if (nvhls::get_slc<1>(R_valid, i) == 0) {
+          if (axi_rd_s_r[i].PopNB(R_reg[i])) {
+            R_valid = R_valid | (1 << i);
           }
-          break;
-        case true:
-          if (axi_rd_s_r[pushedTo].PopNB(R_reg)) {
-            axi_rd_m.r.Push(R_reg);
-            if (R_reg.last == 1) read_inFlight = 0;
+        }
+      }
+      if (!burst_active) {
+        NVUINTW(numSlaves) select = arb.pick(R_valid);
+#pragma hls_unroll yes
+        for (int i=0; i<numSlaves; i++) {
+          if (nvhls::get_slc<1>(select, i) == 1) {
+            burstFrom = i;
+            burst_active = 1;
+          }
+        }
+      }
+      if (burst_active && (nvhls::get_slc<1>(R_valid, burstFrom) == 1)) {
+        R_out = R_reg[burstFrom];
+        IdIdx id = R_out.id.to_uint64();
+        bool slave_last = (R_out.last == 1);
+        // The first part of a split burst does not end the burst
+        if (slave_last && inFlightSplit[id]) {
+          R_out.last = 0;
+        }
+        if (axi_rd_m.r.PushNB(R_out)) {
+          R_valid = ~(~R_valid | (1 << burstFrom));
+          if (slave_last) {
+            inFlight[id]--;
+            inFlightSplit[id] = 0;
+            burst_active = 0;
           }
-          break;
+        }
       }
     }
   }
@@ -182,69 +299,133 @@ class AxiSplitter : public sc_module {
     axi_wr_m.b.Reset();
 
     typename axi4_::AddrPayload AW_reg;
+    typename axi4_::AddrPayload AW_first;
+    typename axi4_::AddrPayload AW_rest;
+    bool AW_valid = 0;
     typename axi4_::WritePayload W_reg;
-    typename axi4_::WRespPayload B_reg;
-    
-    NVUINTW(log_numSlaves) pushedTo = numSlaves;
-    enum {
-      IDLE = 0,
-      WRITE_INFLIGHT = 1,
-      RESP_INFLIGHT = 2,
-    };
-    NVUINT2 s = IDLE;
+    bool W_valid = 0;
+    nvhls::nv_array<typename axi4_::WRespPayload, numSlaves> B_reg;
+    NVUINTW(numSlaves) B_valid = 0;
+    typename axi4_::WRespPayload B_out;
+
+    // W beats follow the order in which their requests were sent. Every slave
+    // may hold maxOutstanding requests per ID whose data is yet to come.
+    FIFO<WriteRoute, maxOutstanding * numSlaves> routeQ;
+    Len beat = 0;
+
+    // Per ID: writes in flight, the slave they went to, whether the one in
+    // flight is the first part of a split burst (then it is the only one), and the worst response of
+    // the parts of a split burst completed so far
+    Outstanding inFlight[numIds];
+    SlaveIdx inFlightTo[numIds];
+    bool inFlightSplit[numIds];
+    typename axi4_::Resp splitResp[numIds];
+#pragma hls_unroll yes
+    for (int i=0; i<numIds; i++) {
+      inFlight[i] = 0;
+      inFlightTo[i] = 0;
+      inFlightSplit[i] = 0;
+      splitResp[i] = axi4_::Enc::XRESP::OKAY;
+    }
+
+    Arbiter<numSlaves> arb;
     
       #pragma hls_pipeline_init_interval 1
       #pragma pipeline_stall_mode flush
     while (1) {
       wait();
 
-      switch (s) {
-        case IDLE:
-          if (axi_wr_m.aw.PopNB(AW_reg)) {
-            NVUINTW(numAddrBitsToInspect)
-                addr(static_cast<sc_uint<numAddrBitsToInspect> >(AW_reg.addr)); // Cast larger to smaller
-            pushedTo = numSlaves;
-            // TODO - refactor this so it can be unrolled
-            for (int i=0; i<numSlaves; i++) {
-              if (addr >= addrBound[i][0].read() && addr <= addrBound[i][1].read() && pushedTo == numSlaves) {
-                pushedTo = i;
-              }
+      // Requests
+      if (!AW_valid) {
+        AW_valid = axi_wr_m.aw.PopNB(AW_reg);
+      }
+      if (AW_valid && !routeQ.isFull()) {
+        SlaveIdx pushedTo;
+        bool split = route(AW_reg, pushedTo, AW_first, AW_rest);
+        IdIdx id = AW_reg.id.to_uint64();
+        // Without write responses there is nothing to keep in order
+        // A split burst goes out alone, as for reads
+        if (!axiCfg::useWriteResponses || (inFlight[id] == 0) ||
+            (!split && (inFlightTo[id] == pushedTo) && (inFlight[id] < maxOutstanding) && !inFlightSplit[id])) {
+          if (axi_wr_s_aw[pushedTo].PushNB(AW_first)) {
+            CDCOUT(sc_time_stamp() << " " << name() << " Pushed write request:"
+                          << " to_port=" << pushedTo
+                          << " request=[" << AW_first << "]"
+                          << endl, kDebugLevel);
+            WriteRoute r;
+            r.slave = pushedTo;
+            r.len = axiCfg::useBurst ? static_cast<Len>(AW_first.len.to_uint64()) : Len(0);
+            routeQ.push(r);
+            if (axiCfg::useWriteResponses) {
+              inFlight[id]++;
+              inFlightTo[id] = pushedTo;
+              inFlightSplit[id] = split;
             }
-            if (default_output && pushedTo == numSlaves) {
-              pushedTo = numSlaves-1;
+            if (split) {
+              AW_reg = AW_rest;
+            } else {
+              AW_valid = 0;
             }
-            NVHLS_ASSERT_MSG(pushedTo != numSlaves, "Write address did not fall into any output address range, and default output is not set");
-            if (translate_addr)
-              AW_reg.addr -= addrBound[pushedTo][0].read();
+          }
+        }
+      }
 
-            axi_wr_s_aw[pushedTo].Push(AW_reg);
-            s = WRITE_INFLIGHT;
+      // Data
+      if (!W_valid) {
+        W_valid = axi_wr_m.w.PopNB(W_reg);
+      }
+      if (W_valid && !routeQ.isEmpty()) {
+        WriteRoute r = routeQ.peek();
+        bool last = (beat == r.len);
+        typename axi4_::WritePayload W_out = W_reg;
+        W_out.last = last;
+        if (axi_wr_s_w[r.slave].PushNB(W_out)) {
+          W_valid = 0;
+          if (last) {
+            routeQ.incrHead();
+            beat = 0;
+          } else {
+            beat++;
           }
-          break;
-        case WRITE_INFLIGHT:
-          NVHLS_ASSERT_MSG(pushedTo != numSlaves, "Write address did not fall into any output address range, and default output is not set");
-          if (axi_wr_m.w.PopNB(W_reg)) {
-            axi_wr_s_w[pushedTo].Push(W_reg);
-            if (W_reg.last == 1) {
-              if (axiCfg::useWriteResponses) {
-                s = RESP_INFLIGHT;
-              } else {
-                s = IDLE;
-              }
+        }
+      }
+
+      // Responses
+      if (axiCfg::useWriteResponses) {
+#pragma hls_unroll yes
+        for (int i=0; i<numSlaves; i++) {
+          if (nvhls::get_slc<1>(B_valid, i) == 0) {
+            if (axi_wr_s_b[i].PopNB(B_reg[i])) {
+              B_valid = B_valid | (1 << i);
             }
           }
-          break;
-        case RESP_INFLIGHT:
-          if (axiCfg::useWriteResponses) {
-            if (axi_wr_s_b[pushedTo].PopNB(B_reg)) {
-              axi_wr_m.b.Push(B_reg);
-              s = IDLE;
-            }
-          } 
-          else {
-            NVHLS_ASSERT_MSG(0, "Should never reach this state if write responses are disabled");
+        }
+        NVUINTW(numSlaves) select = arb.pick(B_valid);
+        SlaveIdx from = 0;
+#pragma hls_unroll yes
+        for (int i=0; i<numSlaves; i++) {
+          if (nvhls::get_slc<1>(select, i) == 1) {
+            from = i;
+          }
+        }
+        if (select != 0) {
+          B_out = B_reg[from];
+          IdIdx id = B_out.id.to_uint64();
+          if (splitResp[id] > B_out.resp) {
+            B_out.resp = splitResp[id];
+          }
+          if (inFlightSplit[id]) {
+            // The first part of a split burst: keep its response for the rest
+            splitResp[id] = B_out.resp;
+            B_valid = ~(~B_valid | (1 << from));
+            inFlight[id]--;
+            inFlightSplit[id] = 0;
+          } else if (axi_wr_m.b.PushNB(B_out)) {
+            B_valid = ~(~B_valid | (1 << from));
+            inFlight[id]--;
+            splitResp[id] = axi4_::Enc::XRESP::OKAY;
           }
-          break;
+        }
       }
     }
   }
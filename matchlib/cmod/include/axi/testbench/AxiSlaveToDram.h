@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __AXI_T_SLAVE_TO_DRAM__
+#define __AXI_T_SLAVE_TO_DRAM__
+
+#include <systemc.h>
+#include <ac_reset_signal_is.h>
+
+#include <axi/axi4.h>
+#include <axi/testbench/DramModel.h>
+#include <nvhls_connections.h>
+#include <hls_globals.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <iostream>
+
+/**
+ * \brief An AXI slave memory with DRAM timing, for use in a testbench.
+ * \ingroup AXI
+ *
+ * \tparam axiCfg     A valid AXI config.
+ * \tparam capacity   The capacity in bytes of the memory.
+ * \tparam fifoDepth  Depth of the write address queue.
+ * \tparam dramCfg    A valid DRAM config (such as dram::cfg::hbm2), DDR4-2400 by default.
+ *
+ * \par Overview
+ * AxiSlaveToDram has the ports, constructor and leading template parameters
+ * of AxiSlaveToMem and can replace it in a testbench when the latency and
+ * bandwidth of a DRAM matter.
+ * Data is stored functionally: reads return the memory contents when the read
+ * is accepted, and writes update it as their data beats arrive, honoring write
+ * strobes.  When responses go out is decided by a DramModel, which each
+ * request enters as a read or write of its full burst once it is accepted (for
+ * writes, once all data beats have arrived):
+ * - Read data is returned a beat per cycle, a burst at a time, after the DRAM
+ * has transferred the whole burst.
+ * - Write responses are sent once the DRAM has written the burst.
+ * - Responses with the same ID are returned in request order; across IDs the
+ * oldest completed request goes first.
+ *
+ * Unwritten memory reads as zero.  The DRAM statistics (row hits, misses and
+ * conflicts per bank, and bandwidth) are available through print_stats() and
+ * the public dram_model member.
+ *
+ * \par A Simple Example
+ * \code
+ *      #include <axi/testbench/AxiSlaveToDram.h>
+ *
+ *      ...
+ *      AxiSlaveToDram<axi::cfg::standard, 1 << 24, 8, dram::cfg::hbm2> slave;
+ *      ...
+ *      slave.if_rd(axi_read);
+ *      slave.if_wr(axi_write);
+ *      ...
+ *      slave.print_stats();
+ * \endcode
+ * \par
+ *
+ */
+template <typename axiCfg, int capacity, int fifoDepth = 8,
+          typename dramCfg = dram::cfg::ddr4_2400>
+class AxiSlaveToDram : public sc_module {
+ public:
+  static const int kDebugLevel = 2;
+  typedef axi::axi4<axiCfg> axi4_;
+  static const int bytesPerWord = axiCfg::dataWidth >> 3;
+
+  typename axi4_::read::template slave<> if_rd;
+  typename axi4_::write::template slave<> if_wr;
+
+  sc_in<bool> reset_bar;
+  sc_in<bool> clk;
+
+  dram::DramModel<dramCfg> dram_model;
+
+  SC_CTOR(AxiSlaveToDram)
+      : if_rd("if_rd"), if_wr("if_wr"), reset_bar("reset_bar"), clk("clk") {
+    SC_THREAD(run);
+    sensitive << clk.pos();
+    async_reset_signal_is(reset_bar, false);
+  }
+
+  void print_stats(std::ostream& os = std::cout) const {
+    os << name() << ": ";
+    dram_model.print_stats(os);
+  }
+
+ protected:
+  typedef unsigned long long uint64;
+
+  struct Txn {
+    typename axi4_::Id id;
+    bool write;
+    bool done;
+    std::vector<typename axi4_::Data> data;
+  };
+
+  std::map<uint64, Txn> txns;                         // by tag
+  std::map<uint64, std::deque<uint64> > rd_order;     // tags by ID
+  std::map<uint64, std::deque<uint64> > wr_order;
+  std::map<uint64, typename axi4_::Data> mem;         // by word address
+  std::deque<typename axi4_::AddrPayload> wr_addr;
+  uint64 next_tag;
+
+  static uint64 beats(typename axi4_::AddrPayload& pld) {
+    NVUINTW(axi4_::ALEN_WIDTH) len = (axiCfg::useBurst ? pld.len : NVUINTW(axi4_::ALEN_WIDTH)(0));
+    return len.to_uint64() + 1;
+  }
+
+  // Oldest completed request at the front of its ID's queue
+  bool pick(std::map<uint64, std::deque<uint64> >& order, uint64& tag) {
+    bool found = false;
+    for (typename std::map<uint64, std::deque<uint64> >::iterator it = order.begin();
+         it != order.end(); ++it) {
+      if (!it->second.empty() && txns[it->second.front()].done &&
+          (!found || (it->second.front() < tag))) {
+        tag = it->second.front();
+        found = true;
+      }
+    }
+    return found;
+  }
+
+  void retire(std::map<uint64, std::deque<uint64> >& order, uint64 tag) {
+    order[txns[tag].id.to_uint64()].pop_front();
+    txns.erase(tag);
+  }
+
+  void run() {
+    if_rd.reset();
+    if_wr.reset();
+
+    next_tag = 0;
+    bool ar_valid = false;
+    typename axi4_::AddrPayload ar;
+    bool rd_active = false;
+    uint64 rd_tag = 0;
+    unsigned rd_beat = 0;
+    unsigned wr_beat = 0;
+
+    while (1) {
+      wait();
+
+      dram_model.tick();
+      uint64 tag;
+      while (dram_model.pop_done(tag)) {
+        txns[tag].done = true;
+        if (txns[tag].write && !axiCfg::useWriteResponses) {
+          retire(wr_order, tag);
+        }
+      }
+
+      // Read data, a beat per cycle
+      if (!rd_active) {
+        rd_active = pick(rd_order, rd_tag);
+        rd_beat = 0;
+      }
+      if (rd_active) {
+        Txn& txn = txns[rd_tag];
+        typename axi4_::ReadPayload data_pld;
+        data_pld.id = txn.id;
+        data_pld.data = txn.data[rd_beat];
+        data_pld.resp = axi4_::Enc::XRESP::OKAY;
+        data_pld.last = (rd_beat + 1 == txn.data.size());
+        if (if_rd.nb_rwrite(data_pld)) {
+          CDCOUT(sc_time_stamp() << " " << name() << " Returned read data: ["
+                        << data_pld << "]" << endl, kDebugLevel);
+          if (++rd_beat == txn.data.size()) {
+            retire(rd_order, rd_tag);
+            rd_active = false;
+          }
+        }
+      }
+
+      // Write responses
+      if (axiCfg::useWriteResponses && pick(wr_order, tag)) {
+        typename axi4_::WRespPayload resp_pld;
+        resp_pld.id = txns[tag].id;
+        resp_pld.resp = axi4_::Enc::XRESP::OKAY;
+        if (if_wr.nb_bwrite(resp_pld)) {
+          CDCOUT(sc_time_stamp() << " " << name() << " Sent write response: ["
+                        << resp_pld << "]" << endl, kDebugLevel);
+          retire(wr_order, tag);
+        }
+      }
+
+      // Read requests enter the DRAM with the data they read now
+      if (!ar_valid) {
+        ar_valid = if_rd.nb_aread(ar);
+        if (ar_valid) {
+          CDCOUT(sc_time_stamp() << " " << name() << " Received read request: ["
+                        << ar << "]" << endl, kDebugLevel);
+        }
+      }
+      if (ar_valid) {
+        uint64 addr = ar.addr.to_uint64();
+        uint64 n = beats(ar);
+        NVHLS_ASSERT_MSG(addr % bytesPerWord == 0, "Addresses must be word aligned");
+        NVHLS_ASSERT_MSG(addr + n * bytesPerWord <= uint64(capacity), "Read beyond the capacity of the memory");
+        if (dram_model.can_push(addr, n * bytesPerWord)) {
+          Txn& txn = txns[next_tag];
+          txn.id = ar.id;
+          txn.write = false;
+          txn.done = false;
+          for (uint64 i = 0; i < n; i++) {
+            typename std::map<uint64, typename axi4_::Data>::iterator it =
+                mem.find(addr / bytesPerWord + i);
+            txn.data.push_back((it == mem.end()) ? typename axi4_::Data(0) : it->second);
+          }
+          dram_model.push(false, addr, n * bytesPerWord, next_tag);
+          rd_order[ar.id.to_uint64()].push_back(next_tag++);
+          ar_valid = false;
+        }
+      }
+
+      // Write requests enter the DRAM when their last beat has arrived
+      if (!wr_addr.empty()) {
+        typename axi4_::AddrPayload& aw = wr_addr.front();
+        uint64 addr = aw.addr.to_uint64();
+        uint64 n = beats(aw);
+        typename axi4_::WritePayload write_pld;
+        if ((wr_beat < n) && if_wr.w.PopNB(write_pld)) {
+          CDCOUT(sc_time_stamp() << " " << name() << " Received write data:"
+                        << " data=[" << write_pld << "]"
+                        << " beat=" << dec << wr_beat << endl, kDebugLevel);
+          write(addr / bytesPerWord + wr_beat, write_pld);
+          wr_beat++;
+          if (wr_beat == n) {
+            NVHLS_ASSERT_MSG(write_pld.last == true, "WRLEN indicates that this should be the last beat, but WRLAST is not set");
+          } else {
+            NVHLS_ASSERT_MSG(write_pld.last == false, "WRLEN indicates that this should not be the last beat, but WRLAST is set");
+          }
+        }
+        if ((wr_beat == n) && dram_model.can_push(addr, n * bytesPerWord)) {
+          Txn& txn = txns[next_tag];
+          txn.id = aw.id;
+          txn.write = true;
+          txn.done = false;
+          dram_model.push(true, addr, n * bytesPerWord, next_tag);
+          wr_order[aw.id.to_uint64()].push_back(next_tag++);
+          wr_addr.pop_front();
+          wr_beat = 0;
+        }
+      }
+
+      if (wr_addr.size() < unsigned(fifoDepth)) {
+        typename axi4_::AddrPayload aw;
+        if (if_wr.aw.PopNB(aw)) {
+          CDCOUT(sc_time_stamp() << " " << name() << " Received write request: ["
+                        << aw << "]" << endl, kDebugLevel);
+          uint64 addr = aw.addr.to_uint64();
+          NVHLS_ASSERT_MSG(addr % bytesPerWord == 0, "Addresses must be word aligned");
+          NVHLS_ASSERT_MSG(addr + beats(aw) * bytesPerWord <= uint64(capacity), "Write beyond the capacity of the memory");
+          wr_addr.push_back(aw);
+        }
+      }
+    }
+  }
+
+  void write(uint64 word, typename axi4_::WritePayload& write_pld) {
+    typename axi4_::Data& data =
+        mem.insert(std::make_pair(word, typename axi4_::Data(0))).first->second;
+    if (axiCfg::useWriteStrobes) {
+      for (int j = 0; j < axi4_::WSTRB_WIDTH; j++) {
+        if (write_pld.wstrb[j] == 1) {
+          data = nvhls::set_slc(data, nvhls::get_slc<8>(write_pld.data, 8 * j), 8 * j);
+        }
+      }
+    } else {
+      data = write_pld.data;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __AXI_TRACE_FILE__
+#define __AXI_TRACE_FILE__
+
+#include <axi/testbench/CSVFileReader.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * \brief A request or memory entry of an AXI trace.
+ *
+ * data points to dataBytes little-endian bytes owned by the reader, valid until
+ * the next record is read.  Memory entries have no delay or type.
+ */
+struct AxiTraceRecord {
+  unsigned delay;
+  char type;
+  unsigned long long addr;
+  const unsigned char* data;
+};
+
+/**
+ * \brief Streams the AXI traces of MasterFromFile and SlaveFromFile from CSV or binary files.
+ *
+ * \par Overview
+ * A trace holds either requests (delay,type,address,data, as read by
+ * MasterFromFile) or memory contents (address,data, as read by SlaveFromFile).
+ * AxiTraceReader returns one record at a time from a memory mapped file, so
+ * traces of any length can be replayed in constant memory.  A file starting
+ * with the binary magic is read as binary, anything else as CSV.
+ *
+ * The binary format is little-endian, with a 24-byte header:
+ * - char magic[8] = "AXITRACE", uint32 version = 1, uint32 kind (0 requests, 1 memory), uint32 dataBytes, uint32 reserved = 0
+ *
+ * followed by fixed size records:
+ * - requests: uint32 delay, uint8 type ('R', 'W' or 'Q'), uint8 reserved[3], uint64 address, uint8 data[dataBytes]
+ * - memory: uint64 address, uint8 data[dataBytes]
+ *
+ * Binary traces are written with AxiTraceWriter, and AxiTraceWriter::convert()
+ * turns a CSV trace into a binary one.  Data of a different width than the
+ * reader's is zero extended or truncated.
+ *
+ * A trace that cannot be opened or is malformed throws std::runtime_error,
+ * in builds with NDEBUG as well.
+ *
+ * \par A Simple Example
+ * \code
+ *      AxiTraceWriter::convert("requests.csv", "requests.bin", AxiTraceReader::Requests, 8);
+ *
+ *      AxiTraceReader trace("requests.bin", AxiTraceReader::Requests, 8);
+ *      AxiTraceRecord rec;
+ *      while (trace.next(rec)) {
+ *        ...
+ *      }
+ * \endcode
+ */
+class AxiTraceReader {
+ public:
+  enum Kind { Requests = 0, Memory = 1 };
+
+  static const unsigned kHeaderBytes = 24;
+  static const unsigned kVersion = 1;
+  static const char* magic() { return "AXITRACE"; }
+
+  static unsigned recordBytes(Kind kind, unsigned dataBytes) {
+    return ((kind == Requests) ? 16 : 8) + dataBytes;
+  }
+
+  AxiTraceReader(std::string filename, Kind kind_, unsigned dataBytes_)
+      : kind(kind_), dataBytes(dataBytes_), fileName(filename), csv(filename), binary(false),
+        pos(0), end(0), fileDataBytes(0), records(0), data(dataBytes_) {
+    if (!file.open(filename)) {
+      throw std::runtime_error("Cannot open trace file " + filename);
+    }
+    if ((file.size() >= kHeaderBytes) && (memcmp(file.data(), magic(), 8) == 0)) {
+      const unsigned char* h = reinterpret_cast<const unsigned char*>(file.data());
+      if (get(h + 8, 4) != kVersion) {
+        throw std::runtime_error("Unsupported binary trace version in " + filename);
+      }
+      if (get(h + 12, 4) != unsigned(kind)) {
+        throw std::runtime_error("Binary trace " + filename + " holds the wrong kind of records");
+      }
+      binary = true;
+      fileDataBytes = get(h + 16, 4);
+      pos = h + kHeaderBytes;
+      end = h + file.size();
+      if ((end - pos) % recordBytes(kind, fileDataBytes) != 0) {
+        throw std::runtime_error("Binary trace " + filename + " ends in a partial record");
+      }
+    } else {
+      file.close();
+    }
+  }
+
+  // Reads the next record; false at the end of the trace
+  bool next(AxiTraceRecord& rec) {
+    rec.delay = 0;
+    rec.type = 0;
+    rec.data = &data[0];
+    if (binary) {
+      if (pos == end) {
+        return false;
+      }
+      if (kind == Requests) {
+        rec.delay = get(pos, 4);
+        rec.type = pos[4];
+        pos += 8;
+      }
+      rec.addr = get(pos, 8);
+      pos += 8;
+      unsigned n = std::min(fileDataBytes, dataBytes);
+      memcpy(&data[0], pos, n);
+      memset(&data[0] + n, 0, dataBytes - n);
+      pos += fileDataBytes;
+    } else {
+      if (!csv.nextRecord()) {
+        return false;
+      }
+      if (kind == Requests) {
+        if (csv.numFields() != 4) fail("Each request must have four elements");
+        rec.delay = csv.fieldDec(0);
+        unsigned len;
+        const char* type = csv.field(1, len);
+        if (len != 1) fail("Requests must be R or W or Q");
+        rec.type = type[0];
+        if (rec.type == 'Q') {
+          rec.addr = 0;
+          memset(&data[0], 0, dataBytes);
+        } else {
+          rec.addr = csv.fieldHex(2);
+          csv.fieldHexBytes(3, &data[0], dataBytes);
+        }
+      } else {
+        if (csv.numFields() != 2) fail("Each memory entry must have two elements");
+        rec.addr = csv.fieldHex(0);
+        csv.fieldHexBytes(1, &data[0], dataBytes);
+      }
+    }
+    if ((kind == Requests) && (rec.type != 'R') && (rec.type != 'W') && (rec.type != 'Q')) {
+      fail("Requests must be R or W or Q");
+    }
+    records++;
+    return true;
+  }
+
+  bool isBinary() const { return binary; }
+
+  // Records read so far
+  unsigned long long count() const { return records; }
+
+ private:
+  Kind kind;
+  unsigned dataBytes;
+  std::string fileName;
+  CSVFileReader csv;
+  MappedFile file;
+  bool binary;
+  const unsigned char* pos;
+  const unsigned char* end;
+  unsigned fileDataBytes;
+  unsigned long long records;
+  std::vector<unsigned char> data;
+
+  void fail(const char* what) const {
+    std::ostringstream msg;
+    msg << fileName;
+    if (binary) {
+      msg << ": record " << records;
+    } else {
+      msg << ":" << csv.lineNumber();
+    }
+    msg << ": " << what;
+    throw std::runtime_error(msg.str());
+  }
+
+  static unsigned long long get(const unsigned char* p, unsigned n) {
+    unsigned long long v = 0;
+    for (unsigned i = n; i > 0; i--) {
+      v = (v << 8) | p[i - 1];
+    }
+    return v;
+  }
+};
+
+/**
+ * \brief Writes binary AXI traces for AxiTraceReader.
+ */
+class AxiTraceWriter {
+ public:
+  AxiTraceWriter(std::string filename, AxiTraceReader::Kind kind_, unsigned dataBytes_)
+      : kind(kind_), dataBytes(dataBytes_), buffer(1 << 20) {
+    out.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+    out.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      throw std::runtime_error("Cannot write trace file " + filename);
+    }
+    unsigned char h[AxiTraceReader::kHeaderBytes];
+    memcpy(h, AxiTraceReader::magic(), 8);
+    put(h + 8, AxiTraceReader::kVersion, 4);
+    put(h + 12, kind, 4);
+    put(h + 16, dataBytes, 4);
+    put(h + 20, 0, 4);
+    out.write(reinterpret_cast<const char*>(h), sizeof(h));
+  }
+
+  void write(const AxiTraceRecord& rec) {
+    unsigned char r[16];
+    unsigned n = 0;
+    if (kind == AxiTraceReader::Requests) {
+      put(r, rec.delay, 4);
+      r[4] = rec.type;
+      r[5] = r[6] = r[7] = 0;
+      n = 8;
+    }
+    put(r + n, rec.addr, 8);
+    out.write(reinterpret_cast<const char*>(r), n + 8);
+    out.write(reinterpret_cast<const char*>(rec.data), dataBytes);
+  }
+
+  void close() { out.close(); }
+
+  // Converts a CSV trace to binary, and returns the number of records
+  static unsigned long long convert(std::string csvFile, std::string binFile,
+                                    AxiTraceReader::Kind kind, unsigned dataBytes) {
+    AxiTraceReader reader(csvFile, kind, dataBytes);
+    AxiTraceWriter writer(binFile, kind, dataBytes);
+    AxiTraceRecord rec;
+    while (reader.next(rec)) {
+      writer.write(rec);
+    }
+    return reader.count();
+  }
+
+ private:
+  AxiTraceReader::Kind kind;
+  unsigned dataBytes;
+  std::vector<char> buffer;
+  std::ofstream out;
+
+  static void put(unsigned char* p, unsigned long long v, unsigned n) {
+    for (unsigned i = 0; i < n; i++, v >>= 8) {
+      p[i] = v & 0xff;
+    }
+  }
+};
+
+#endif
@@ -21,39 +21,281 @@
 #include <sstream>
 #include <vector>
 #include <math.h>
-#include <boost/assert.hpp>
+#include <stdexcept>
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
-#include <boost/algorithm/string.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * \brief A read-only memory mapping of a file.
+ *
+ * The mapping is advised for sequential access, so pages are read ahead and
+ * dropped behind by the kernel and a file much larger than memory can be
+ * streamed through.
+ */
+class MappedFile {
+  const char* base;
+  size_t length;
+  bool opened;
+
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+ public:
+  MappedFile() : base(0), length(0), opened(false) {}
+  explicit MappedFile(const std::string& filename) : base(0), length(0), opened(false) {
+    open(filename);
+  }
+  ~MappedFile() { close(); }
+
+  // Returns false if the file cannot be opened; an empty file opens with no data
+  bool open(const std::string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    opened = (fstat(fd, &st) == 0);
+    if (opened && (st.st_size > 0)) {
+      void* p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      opened = (p != MAP_FAILED);
+      if (opened) {
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        base = static_cast<const char*>(p);
+        length = st.st_size;
+      }
+    }
+    ::close(fd);
+    return opened;
+  }
+
+  void close() {
+    if (base) {
+      munmap(const_cast<char*>(base), length);
+    }
+    base = 0;
+    length = 0;
+    opened = false;
+  }
+
+  bool is_open() const { return opened; }
+  const char* data() const { return base; }
+  size_t size() const { return length; }
+};
 
 /**
  * \brief A helper class to read CSV files.
  *
  * The constructor takes two arguments: a string containing the filename, and an optional string containing the delimiting character (default is ',').
+ *
+ * readCSV() returns the whole file as strings.  For large files, the file can
+ * instead be streamed a record at a time: nextRecord() moves to the next
+ * non-empty line, and the fields of that line are accessed in place in the
+ * memory mapped file, as text or through the numeric parsers.  Nothing is
+ * copied or allocated per record.  A file that cannot be opened, and fields
+ * that do not parse, throw std::runtime_error with the file name and line.
+ *
+ * \code
+ *      CSVFileReader reader("requests.csv");
+ *      while (reader.nextRecord()) {
+ *        long long delay = reader.fieldDec(0);
+ *        bool read = reader.fieldIs(1, "R");
+ *        unsigned long long addr = reader.fieldHex(2);
+ *        ...
+ *      }
+ * \endcode
  */
 class CSVFileReader {
   std::string fileName;
   std::string seperator;
 
+  MappedFile file;
+  const char* pos;
+  const char* end;
+  unsigned line;
+  bool isSeparator[256];
+  std::vector<const char*> fieldStart;
+  std::vector<unsigned> fieldLength;
+
+  static int hexDigit(char c) {
+    if ((c >= '0') && (c <= '9')) return c - '0';
+    if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+    if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+    return -1;
+  }
+
+  // Malformed input is reported with an exception rather than an assertion,
+  // so that it is caught in builds with NDEBUG as well
+  void fail(const char* what) const {
+    std::ostringstream msg;
+    msg << fileName << ":" << line << ": " << what;
+    throw std::runtime_error(msg.str());
+  }
+
+  // Field i without surrounding blanks
+  void trimmed(unsigned i, const char*& s, const char*& e) const {
+    if (i >= fieldStart.size()) fail("CSV record has too few fields");
+    s = fieldStart[i];
+    e = s + fieldLength[i];
+    while ((s < e) && ((*s == ' ') || (*s == '\t'))) s++;
+    while ((e > s) && ((e[-1] == ' ') || (e[-1] == '\t'))) e--;
+  }
+
+  void hexDigits(unsigned i, const char*& s, const char*& e) const {
+    trimmed(i, s, e);
+    if ((e - s > 2) && (s[0] == '0') && ((s[1] == 'x') || (s[1] == 'X'))) s += 2;
+    if (s >= e) fail("Empty hex field in CSV record");
+  }
+
  public:
   CSVFileReader(std::string filename, std::string sep = ",")
-      : fileName(filename), seperator(sep) {}
+      : fileName(filename), seperator(sep), pos(0), end(0), line(0) {
+    for (unsigned c = 0; c < 256; c++) {
+      isSeparator[c] = false;
+    }
+    for (unsigned c = 0; c < seperator.size(); c++) {
+      isSeparator[static_cast<unsigned char>(seperator[c])] = true;
+    }
+  }
 
   std::vector<std::vector<std::string> > readCSV() {
-    std::ifstream file(fileName.c_str());
     std::vector<std::vector<std::string> > dataList;
-    std::string line = "";
-    while (getline(file, line)) {
+    if (!open()) {
+      return dataList;
+    }
+    while (nextRecord()) {
       std::vector<std::string> vec;
-      boost::algorithm::split(vec, line, boost::is_any_of(seperator));
+      for (unsigned i = 0; i < numFields(); i++) {
+        vec.push_back(fieldString(i));
+      }
       dataList.push_back(vec);
     }
-    file.close();
     return dataList;
   }
+
+  // (Re)starts streaming at the beginning of the file; false if it cannot be opened
+  bool open() {
+    if (!file.open(fileName)) {
+      return false;
+    }
+    pos = file.data();
+    end = pos + file.size();
+    line = 0;
+    return true;
+  }
+
+  // Moves to the next non-empty line, opening the file on the first call.
+  // Returns false at the end of the file, throws std::runtime_error if the
+  // file cannot be opened.
+  bool nextRecord() {
+    if (!file.is_open() && !open()) {
+      throw std::runtime_error("Cannot open CSV file " + fileName);
+    }
+    fieldStart.clear();
+    fieldLength.clear();
+    while (pos < end) {
+      const char* eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+      if (!eol) eol = end;
+      const char* start = pos;
+      const char* stop = ((eol > start) && (eol[-1] == '\r')) ? (eol - 1) : eol;
+      pos = (eol < end) ? (eol + 1) : end;
+      line++;
+      if (stop == start) {
+        continue;
+      }
+      const char* f = start;
+      for (const char* c = start; c < stop; c++) {
+        if (isSeparator[static_cast<unsigned char>(*c)]) {
+          fieldStart.push_back(f);
+          fieldLength.push_back(c - f);
+          f = c + 1;
+        }
+      }
+      fieldStart.push_back(f);
+      fieldLength.push_back(stop - f);
+      return true;
+    }
+    return false;
+  }
+
+  unsigned numFields() const { return fieldStart.size(); }
+
+  // Line number of the current record, from 1
+  unsigned lineNumber() const { return line; }
+
+  // Field i of the current record, in place
+  const char* field(unsigned i, unsigned& len) const {
+    if (i >= fieldStart.size()) fail("CSV record has too few fields");
+    len = fieldLength[i];
+    return fieldStart[i];
+  }
+
+  std::string fieldString(unsigned i) const {
+    unsigned len;
+    const char* s = field(i, len);
+    return std::string(s, len);
+  }
+
+  // Whether field i, without surrounding blanks, is str
+  bool fieldIs(unsigned i, const char* str) const {
+    const char *s, *e;
+    trimmed(i, s, e);
+    size_t n = strlen(str);
+    return (size_t(e - s) == n) && (strncmp(s, str, n) == 0);
+  }
+
+  // Field i as a signed decimal number
+  long long fieldDec(unsigned i) const {
+    const char *s, *e;
+    trimmed(i, s, e);
+    bool negative = (s < e) && (*s == '-');
+    if ((s < e) && ((*s == '-') || (*s == '+'))) s++;
+    if (s >= e) fail("Empty decimal field in CSV record");
+    long long v = 0;
+    for (; s < e; s++) {
+      if ((*s < '0') || (*s > '9')) fail("Invalid decimal digit in CSV record");
+      v = v * 10 + (*s - '0');
+    }
+    return negative ? -v : v;
+  }
+
+  // Field i as a hex number with an optional 0x prefix, truncated to 64 bits
+  unsigned long long fieldHex(unsigned i) const {
+    const char *s, *e;
+    hexDigits(i, s, e);
+    unsigned long long v = 0;
+    for (; s < e; s++) {
+      int d = hexDigit(*s);
+      if (d < 0) fail("Invalid hex digit in CSV record");
+      v = (v << 4) | d;
+    }
+    return v;
+  }
+
+  // Field i as a hex number of any width, into nbytes little-endian bytes,
+  // zero extended or truncated
+  void fieldHexBytes(unsigned i, unsigned char* bytes, unsigned nbytes) const {
+    const char *s, *e;
+    hexDigits(i, s, e);
+    memset(bytes, 0, nbytes);
+    unsigned nibble = 0;
+    for (const char* c = e; c > s; c--, nibble++) {
+      int d = hexDigit(c[-1]);
+      if (d < 0) fail("Invalid hex digit in CSV record");
+      if (nibble / 2 < nbytes) {
+        bytes[nibble / 2] |= d << (4 * (nibble % 2));
+      }
+    }
+  }
 };
 
 #endif
@@ -0,0 +1,538 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __DRAM_MODEL_H__
+#define __DRAM_MODEL_H__
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+
+namespace dram {
+
+enum page_policy { OpenPage, ClosedPage };
+
+/**
+ * \brief DRAM configurations for DramModel.
+ * \ingroup AXI
+ *
+ * \par  A DRAM config consists of a struct with an enum defining the following constants. Timings are in cycles of the clock the model is ticked with.
+ * - numChannels: The number of independent channels.
+ * - numBanks: The number of banks per channel.
+ * - rowBytes: The bytes of a row (page) of a bank.
+ * - busBytes: The bytes a channel transfers per cycle.
+ * - interleaveBytes: The bytes mapped to one channel before moving to the next.  Requests are split into pieces that do not cross this granularity.
+ * - tRCD: Activate to column command.
+ * - tRP: Precharge to activate.
+ * - tCL: Read column command to first data.
+ * - tCWL: Write column command to first data.
+ * - tRAS: Activate to precharge.
+ * - tRRD: Activate to activate of another bank.
+ * - tFAW: Window in which at most four activates may issue.
+ * - tWR: End of write data to precharge.
+ * - tWTR: End of write data to the first read data (write to read turnaround).
+ * - tRTW: End of read data to the first write data (read to write turnaround).
+ * - tREFI: Refresh interval.
+ * - tRFC: Refresh duration.
+ * - queueDepth: Request pieces queued per channel.
+ * - starvationLimit: Age in cycles after which the oldest request may close a row that younger requests still hit.
+ * - pagePolicy: OpenPage leaves rows open after an access; ClosedPage precharges a row as soon as no queued request hits it.
+ */
+namespace cfg {
+
+/**
+ * \brief A DDR4-2400 64-bit channel, in cycles of its 1.2 GHz clock.
+ */
+struct ddr4_2400 {
+  enum {
+    numChannels = 1,
+    numBanks = 16,
+    rowBytes = 8192,
+    busBytes = 16,
+    interleaveBytes = 256,
+    tRCD = 16,
+    tRP = 16,
+    tCL = 16,
+    tCWL = 12,
+    tRAS = 39,
+    tRRD = 4,
+    tFAW = 26,
+    tWR = 18,
+    tWTR = 9,
+    tRTW = 8,
+    tREFI = 9360,
+    tRFC = 420,
+    queueDepth = 32,
+    starvationLimit = 1000,
+    pagePolicy = OpenPage,
+  };
+};
+
+/**
+ * \brief An HBM2 stack of 8 128-bit channels, in cycles of its 1 GHz clock.
+ */
+struct hbm2 {
+  enum {
+    numChannels = 8,
+    numBanks = 16,
+    rowBytes = 2048,
+    busBytes = 32,
+    interleaveBytes = 256,
+    tRCD = 14,
+    tRP = 14,
+    tCL = 14,
+    tCWL = 4,
+    tRAS = 33,
+    tRRD = 4,
+    tFAW = 16,
+    tWR = 16,
+    tWTR = 8,
+    tRTW = 6,
+    tREFI = 3900,
+    tRFC = 350,
+    queueDepth = 32,
+    starvationLimit = 1000,
+    pagePolicy = ClosedPage,
+  };
+};
+
+}  // namespace cfg
+
+/**
+ * \brief A cycle-based DRAM timing model.
+ * \ingroup AXI
+ *
+ * \tparam dramCfg     A valid DRAM config.
+ *
+ * \par Overview
+ * DramModel tracks when requests to a DRAM complete, not the data.  Each
+ * request is split into pieces that stay in one channel and row, and queued in
+ * its channel.  Every cycle each channel issues at most one command:
+ * - Refresh takes priority once tREFI has elapsed: open banks are precharged,
+ * and all banks are then busy for tRFC.
+ * - Otherwise the scheduler is FR-FCFS: the oldest queued piece that hits an
+ * open row and whose data fits on the bus gets its column command; failing
+ * that, the oldest piece that needs an activate or precharge its bank can take
+ * gets it.  Activates are further limited by tRRD and tFAW.  A row that queued pieces still hit is not closed for an older
+ * piece until that piece is starvationLimit cycles old.
+ * - The data bus carries busBytes per cycle, and a change of direction costs
+ * tWTR or tRTW.
+ * A request completes when the data of all of its pieces has been transferred.
+ *
+ * Per bank the model counts row hits (column commands to a row that was
+ * already open), misses (the bank was closed) and conflicts (another row had to
+ * be closed first); per channel it counts bytes, refreshes and turnarounds.
+ *
+ * \par A Simple Example
+ * \code
+ *      #include <axi/testbench/DramModel.h>
+ *
+ *      ...
+ *      dram::DramModel<dram::cfg::ddr4_2400> dram;
+ *
+ *      if (dram.can_push(addr, bytes)) {
+ *        dram.push(false, addr, bytes, tag);
+ *      }
+ *      dram.tick();
+ *      while (dram.pop_done(tag)) {
+ *        // request tag has completed
+ *      }
+ *      ...
+ *      dram.print_stats(std::cout);
+ * \endcode
+ * \par
+ *
+ */
+template <typename dramCfg>
+class DramModel {
+ public:
+  typedef unsigned long long uint64;
+
+  static const unsigned numChannels = dramCfg::numChannels;
+  static const unsigned numBanks = dramCfg::numBanks;
+
+  struct BankStats {
+    uint64 reads;
+    uint64 writes;
+    uint64 hits;
+    uint64 misses;
+    uint64 conflicts;
+    BankStats() : reads(0), writes(0), hits(0), misses(0), conflicts(0) {}
+  };
+
+  struct ChannelStats {
+    uint64 bytes;
+    uint64 refreshes;
+    uint64 turnarounds;
+    ChannelStats() : bytes(0), refreshes(0), turnarounds(0) {}
+  };
+
+  DramModel() : now(0), stats_start(0), channels(numChannels) {
+    for (unsigned c = 0; c < numChannels; c++) {
+      channels[c].next_refresh = dramCfg::tREFI;
+    }
+  }
+
+  // Channel, bank and row of addr: interleaveBytes chunks go round the
+  // channels, then fill a row, then go round the banks
+  static void map(uint64 addr, unsigned& channel, unsigned& bank, uint64& row) {
+    uint64 chunk = addr / dramCfg::interleaveBytes;
+    channel = chunk % numChannels;
+    uint64 in_channel = chunk / numChannels;
+    uint64 row_chunk = in_channel / (dramCfg::rowBytes / dramCfg::interleaveBytes);
+    bank = row_chunk % numBanks;
+    row = row_chunk / numBanks;
+  }
+
+  // Whether all pieces of a request of bytes at addr fit in their queues
+  bool can_push(uint64 addr, unsigned bytes) const {
+    std::vector<unsigned> pieces(numChannels, 0);
+    for (uint64 a = addr; a < addr + bytes; a = next_chunk(a)) {
+      unsigned channel, bank;
+      uint64 row;
+      map(a, channel, bank, row);
+      pieces[channel]++;
+    }
+    for (unsigned c = 0; c < numChannels; c++) {
+      if (channels[c].queue.size() + pieces[c] > dramCfg::queueDepth) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Queues a read or write of bytes at addr, which completes as tag
+  void push(bool write, uint64 addr, unsigned bytes, uint64 tag) {
+    assert(bytes > 0);
+    assert(can_push(addr, bytes));
+    unsigned& left = pending[tag];
+    assert(left == 0);
+    for (uint64 a = addr; a < addr + bytes; a = next_chunk(a)) {
+      Piece p;
+      p.write = write;
+      map(a, p.channel, p.bank, p.row);
+      uint64 end = next_chunk(a);
+      p.bytes = ((end < addr + bytes) ? end : (addr + bytes)) - a;
+      p.tag = tag;
+      p.arrival = now;
+      channels[p.channel].queue.push_back(p);
+      left++;
+    }
+  }
+
+  // Advances the model by a cycle
+  void tick() {
+    for (unsigned c = 0; c < numChannels; c++) {
+      schedule(channels[c]);
+    }
+    now++;
+    while (!in_flight.empty() && (in_flight.begin()->first <= now)) {
+      uint64 tag = in_flight.begin()->second;
+      in_flight.erase(in_flight.begin());
+      typename std::map<uint64, unsigned>::iterator it = pending.find(tag);
+      if (--it->second == 0) {
+        pending.erase(it);
+        done.push_back(tag);
+      }
+    }
+  }
+
+  // Returns the next completed request, in order of completion
+  bool pop_done(uint64& tag) {
+    if (done.empty()) {
+      return false;
+    }
+    tag = done.front();
+    done.pop_front();
+    return true;
+  }
+
+  // Requests queued or in flight
+  unsigned outstanding() const { return pending.size(); }
+
+  uint64 cycle() const { return now; }
+
+  const BankStats& get_bank_stats(unsigned channel, unsigned bank) const {
+    return channels[channel].banks[bank].stats;
+  }
+
+  const ChannelStats& get_channel_stats(unsigned channel) const {
+    return channels[channel].stats;
+  }
+
+  void reset_stats() {
+    stats_start = now;
+    for (unsigned c = 0; c < numChannels; c++) {
+      channels[c].stats = ChannelStats();
+      for (unsigned b = 0; b < numBanks; b++) {
+        channels[c].banks[b].stats = BankStats();
+      }
+    }
+  }
+
+  // Fraction of column commands that hit an open row
+  double row_hit_rate() const {
+    uint64 hits = 0, accesses = 0;
+    for (unsigned c = 0; c < numChannels; c++) {
+      for (unsigned b = 0; b < numBanks; b++) {
+        const BankStats& s = channels[c].banks[b].stats;
+        hits += s.hits;
+        accesses += s.reads + s.writes;
+      }
+    }
+    return accesses ? (double(hits) / accesses) : 0;
+  }
+
+  // Bytes per cycle since the stats were reset, and the peak
+  double bandwidth() const {
+    uint64 bytes = 0;
+    for (unsigned c = 0; c < numChannels; c++) {
+      bytes += channels[c].stats.bytes;
+    }
+    return (now > stats_start) ? (double(bytes) / (now - stats_start)) : 0;
+  }
+
+  static double peak_bandwidth() { return double(numChannels) * dramCfg::busBytes; }
+
+  void print_stats(std::ostream& os) const {
+    os << "DRAM stats over " << (now - stats_start) << " cycles: "
+       << std::fixed << std::setprecision(2) << bandwidth() << " of "
+       << peak_bandwidth() << " bytes/cycle, row hit rate "
+       << row_hit_rate() << std::endl;
+    for (unsigned c = 0; c < numChannels; c++) {
+      const ChannelStats& cs = channels[c].stats;
+      os << "  channel " << c << ": " << cs.bytes << " bytes, " << cs.refreshes
+         << " refreshes, " << cs.turnarounds << " turnarounds" << std::endl;
+      os << "    bank     reads    writes      hits    misses conflicts  hit rate" << std::endl;
+      for (unsigned b = 0; b < numBanks; b++) {
+        const BankStats& s = channels[c].banks[b].stats;
+        uint64 accesses = s.reads + s.writes;
+        if (accesses == 0) {
+          continue;
+        }
+        os << std::setw(8) << b << std::setw(10) << s.reads << std::setw(10)
+           << s.writes << std::setw(10) << s.hits << std::setw(10) << s.misses
+           << std::setw(10) << s.conflicts << std::setw(10)
+           << (double(s.hits) / accesses) << std::endl;
+      }
+    }
+  }
+
+ private:
+  struct Piece {
+    bool write;
+    unsigned channel;
+    unsigned bank;
+    uint64 row;
+    unsigned bytes;
+    uint64 tag;
+    uint64 arrival;
+  };
+
+  struct Bank {
+    bool open;
+    uint64 row;
+    uint64 act_ok;      // earliest activate
+    uint64 cas_ok;      // earliest column command
+    uint64 pre_ok;      // earliest precharge
+    bool activated;     // no column command since the activate
+    bool conflicted;    // the last precharge closed a row for another one
+    BankStats stats;
+    Bank() : open(false), row(0), act_ok(0), cas_ok(0), pre_ok(0),
+             activated(false), conflicted(false) {}
+  };
+
+  struct Channel {
+    std::deque<Piece> queue;
+    Bank banks[numBanks];
+    uint64 bus_free;     // first cycle the data bus is free
+    bool last_write;     // direction of the last transfer
+    uint64 next_refresh;
+    std::deque<uint64> acts;  // the last four activates
+    ChannelStats stats;
+    Channel() : bus_free(0), last_write(false), next_refresh(0) {}
+  };
+
+  uint64 now;
+  uint64 stats_start;
+  std::vector<Channel> channels;
+  std::map<uint64, unsigned> pending;            // pieces left per tag
+  std::multimap<uint64, uint64> in_flight;       // data end cycle, tag
+  std::deque<uint64> done;
+
+  static uint64 next_chunk(uint64 addr) {
+    return (addr / dramCfg::interleaveBytes + 1) * dramCfg::interleaveBytes;
+  }
+
+  static uint64 max(uint64 a, uint64 b) { return (a > b) ? a : b; }
+
+  static unsigned data_cycles(unsigned bytes) {
+    return (bytes + dramCfg::busBytes - 1) / dramCfg::busBytes;
+  }
+
+  bool row_hit_queued(const Channel& ch, unsigned bank, uint64 row) const {
+    for (unsigned i = 0; i < ch.queue.size(); i++) {
+      if ((ch.queue[i].bank == bank) && (ch.queue[i].row == row)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool act_allowed(const Channel& ch) const {
+    if (ch.acts.empty()) {
+      return true;
+    }
+    return (now >= ch.acts.back() + dramCfg::tRRD) &&
+           ((ch.acts.size() < 4) || (now >= ch.acts.front() + dramCfg::tFAW));
+  }
+
+  void precharge(Bank& bank) {
+    bank.open = false;
+    bank.act_ok = max(bank.act_ok, max(now, bank.pre_ok) + dramCfg::tRP);
+  }
+
+  void schedule(Channel& ch) {
+    // Refresh: close all banks, then refresh them together
+    if (now >= ch.next_refresh) {
+      bool all_closed = true;
+      uint64 act_ok = 0;
+      for (unsigned b = 0; b < numBanks; b++) {
+        Bank& bank = ch.banks[b];
+        if (bank.open) {
+          all_closed = false;
+          if (now >= bank.pre_ok) {
+            bank.conflicted = false;
+            precharge(bank);
+            return;
+          }
+        }
+        act_ok = max(act_ok, bank.act_ok);
+      }
+      if (all_closed && (now >= act_ok)) {
+        for (unsigned b = 0; b < numBanks; b++) {
+          ch.banks[b].act_ok = now + dramCfg::tRFC;
+        }
+        ch.next_refresh += dramCfg::tREFI;
+        ch.stats.refreshes++;
+      }
+      return;
+    }
+
+    if (ch.queue.empty()) {
+      return;
+    }
+
+    // A starving oldest piece keeps younger hits off its bank until it has
+    // had its row
+    const Piece& oldest = ch.queue.front();
+    int blocked_bank = -1;
+    if ((now - oldest.arrival > dramCfg::starvationLimit) &&
+        !(ch.banks[oldest.bank].open && (ch.banks[oldest.bank].row == oldest.row))) {
+      blocked_bank = oldest.bank;
+    }
+
+    // First ready: the oldest row hit whose data fits on the bus
+    for (unsigned i = 0; i < ch.queue.size(); i++) {
+      const Piece& p = ch.queue[i];
+      Bank& bank = ch.banks[p.bank];
+      if (!bank.open || (bank.row != p.row) || (now < bank.cas_ok) ||
+          (int(p.bank) == blocked_bank)) {
+        continue;
+      }
+      uint64 data_start = now + (p.write ? dramCfg::tCWL : dramCfg::tCL);
+      bool turnaround = (p.write != ch.last_write) && (ch.stats.bytes > 0 || ch.bus_free > 0);
+      uint64 bus_ok = ch.bus_free + (turnaround ? (p.write ? dramCfg::tRTW : dramCfg::tWTR) : 0);
+      if (data_start < bus_ok) {
+        continue;
+      }
+      issue_column(ch, i, data_start, turnaround);
+      return;
+    }
+
+    // Then first come: the oldest piece whose bank can take the activate or
+    // precharge it needs
+    for (unsigned i = 0; i < ch.queue.size(); i++) {
+      const Piece& p = ch.queue[i];
+      Bank& bank = ch.banks[p.bank];
+      if (!bank.open) {
+        if ((now >= bank.act_ok) && act_allowed(ch)) {
+          bank.open = true;
+          bank.row = p.row;
+          bank.cas_ok = now + dramCfg::tRCD;
+          bank.pre_ok = now + dramCfg::tRAS;
+          bank.activated = true;
+          ch.acts.push_back(now);
+          if (ch.acts.size() > 4) {
+            ch.acts.pop_front();
+          }
+          return;
+        }
+      } else if (bank.row != p.row) {
+        if ((now >= bank.pre_ok) &&
+            ((int(p.bank) == blocked_bank) || !row_hit_queued(ch, p.bank, bank.row))) {
+          bank.conflicted = true;
+          precharge(bank);
+          return;
+        }
+      }
+    }
+  }
+
+  void issue_column(Channel& ch, unsigned i, uint64 data_start, bool turnaround) {
+    Piece p = ch.queue[i];
+    ch.queue.erase(ch.queue.begin() + i);
+    Bank& bank = ch.banks[p.bank];
+    unsigned cycles = data_cycles(p.bytes);
+    uint64 data_end = data_start + cycles;
+
+    if (p.write) {
+      bank.stats.writes++;
+      bank.pre_ok = max(bank.pre_ok, data_end + dramCfg::tWR);
+    } else {
+      bank.stats.reads++;
+      bank.pre_ok = max(bank.pre_ok, now + cycles);
+    }
+    if (!bank.activated) {
+      bank.stats.hits++;
+    } else if (bank.conflicted) {
+      bank.stats.conflicts++;
+    } else {
+      bank.stats.misses++;
+    }
+    bank.activated = false;
+    bank.conflicted = false;
+    bank.cas_ok = now + cycles;
+
+    ch.bus_free = data_end;
+    ch.last_write = p.write;
+    ch.stats.bytes += p.bytes;
+    if (turnaround) {
+      ch.stats.turnarounds++;
+    }
+    in_flight.insert(std::make_pair(data_end, p.tag));
+
+    if ((int(dramCfg::pagePolicy) == ClosedPage) && !row_hit_queued(ch, p.bank, p.row)) {
+      precharge(bank);
+    }
+  }
+};
+
+}  // namespace dram
+
+#endif
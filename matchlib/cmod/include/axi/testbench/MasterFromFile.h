@@ -22,7 +22,7 @@
 #include <ac_reset_signal_is.h>
 
 #include <axi/axi4.h>
-#include <axi/testbench/CSVFileReader.h>
+#include <axi/testbench/AxiTraceFile.h>
 #include <nvhls_connections.h>
 #include <hls_globals.h>
 
@@ -48,6 +48,14 @@
  * 
  *  For reads, it's best to specify the full DATA_WIDTH of expected response data.
  *
+ * The requests are read lazily as they are issued, from a CSV or from the
+ * equivalent binary trace (see AxiTraceReader), so traces of any length can be
+ * replayed.  Up to maxOutstanding requests (a constructor argument, default 1)
+ * are in flight at a time; the delay of a request counts from when it could
+ * otherwise issue, so with one outstanding request it is the delay from the
+ * previous response.  An interrupt instruction waits for all outstanding
+ * requests to complete.  Read responses are expected in request order.
+ *
  */
 
 // Allow an sc_in to be present only if a template parameter is enabled
@@ -71,13 +79,8 @@ template <typename axiCfg, bool enable_interrupts = false> class MasterFromFile
   static const int bytesPerWord = axi4_::DATA_WIDTH >> 3;
   static const int axiAddrBitsPerWord = nvhls::log2_ceil<bytesPerWord>::val;
 
-  std::queue< int > delay_q;
-  std::queue< int > req_q;
-  std::queue< typename axi4_::AddrPayload > raddr_q;
-  std::queue< typename axi4_::AddrPayload > waddr_q;
-  std::queue< typename axi4_::WritePayload > wdata_q;
   std::queue<typename axi4_::Data> rresp_q;
-    
+
   typename axi4_::AddrPayload addr_pld;
   typename axi4_::WritePayload wr_data_pld;
   typename axi4_::ReadPayload data_pld;
@@ -88,54 +91,12 @@ template <typename axiCfg, bool enable_interrupts = false> class MasterFromFile
 
   SC_HAS_PROCESS(MasterFromFile);
 
-  MasterFromFile(sc_module_name name_, std::string filename="requests.csv")
-      : sc_module(name_), if_rd("if_rd"), if_wr("if_wr"), reset_bar("reset_bar"), clk("clk") {
-
-    CDCOUT("Reading file: " << filename << endl, kDebugLevel);
-    CSVFileReader reader(filename);
-    std::vector< std::vector<std::string> > dataList = reader.readCSV();
-    for (unsigned int i=0; i < dataList.size(); i++) {
-      std::vector<std::string> vec = dataList[i];
-      NVHLS_ASSERT_MSG(vec.size() == 4, "Each request must have four elements");
-      delay_q.push(atoi(vec[0].c_str()));
-      if (vec[1] == "R") {
-        req_q.push(0);
-        std::stringstream ss;
-        sc_uint<axi4_::ADDR_WIDTH> addr;
-        ss << hex << vec[2];
-        ss >> addr;
-        addr_pld.addr = static_cast<typename axi4_::Addr>(addr);
-        addr_pld.len = 0;
-        raddr_q.push(addr_pld);
-        std::stringstream ss_data;
-        sc_biguint<axi4_::DATA_WIDTH> data;
-        ss_data << hex << vec[3];
-        ss_data >> data;
-        rresp_q.push(TypeToNVUINT(data));
-      } else if (vec[1] == "W") {
-        req_q.push(1);
-        std::stringstream ss;
-        sc_uint<axi4_::ADDR_WIDTH> addr;
-        ss << hex << vec[2];
-        ss >> addr;
-        addr_pld.addr = static_cast<typename axi4_::Addr>(addr);
-        addr_pld.len = 0;
-        waddr_q.push(addr_pld);
-        std::stringstream ss_data;
-        sc_biguint<axi4_::DATA_WIDTH> data;
-        ss_data << hex << vec[3];
-        ss_data >> data;
-        wr_data_pld.data = TypeToNVUINT(data);
-        wr_data_pld.wstrb = ~0;
-        wr_data_pld.last = 1;
-        wdata_q.push(wr_data_pld);
-      } else if (vec[1] == "Q") {
-        NVHLS_ASSERT_MSG(enable_interrupts,"Interrupt command read, but interrupts are not enabled");
-        req_q.push(2);
-      } else {
-        NVHLS_ASSERT_MSG(1,"Requests must be R or W or Q");
-      }
-    }
+  MasterFromFile(sc_module_name name_, std::string filename="requests.csv", unsigned maxOutstanding_=1)
+      : sc_module(name_), if_rd("if_rd"), if_wr("if_wr"), reset_bar("reset_bar"), clk("clk"),
+        trace(filename, AxiTraceReader::Requests, bytesPerWord), maxOutstanding(maxOutstanding_) {
+
+    CDCOUT("Reading file: " << filename << (trace.isBinary() ? " (binary)" : "") << endl, kDebugLevel);
+    NVHLS_ASSERT_MSG(maxOutstanding > 0, "At least one request must be allowed in flight");
 
     SC_THREAD(run);
     sensitive << clk.pos();
@@ -143,6 +104,17 @@ template <typename axiCfg, bool enable_interrupts = false> class MasterFromFile
   }
 
  protected:
+  AxiTraceReader trace;
+  unsigned maxOutstanding;
+
+  typename axi4_::Data toData(const unsigned char* bytes) {
+    typename axi4_::Data data = 0;
+    for (int i = 0; i < bytesPerWord; i++) {
+      data = nvhls::set_slc(data, NVUINT8(bytes[i]), 8 * i);
+    }
+    return data;
+  }
+
   void run() {
 
     done = 0;
@@ -152,45 +124,83 @@ template <typename axiCfg, bool enable_interrupts = false> class MasterFromFile
 
     wait(20);
 
-    while (!delay_q.empty()) {
-      int delay = delay_q.front();
-      if (delay > 0) wait(delay);
-      delay_q.pop();
-      if (req_q.front() == 2) {
-        NVHLS_ASSERT_MSG(enable_interrupts,"Interrupt command found, but interrupts are not enabled");
-        CDCOUT(sc_time_stamp() << " " << name() << " Beginning wait for interrupt"
-                      << endl, kDebugLevel);
-        while (interrupt.read() == 0) wait();
-        CDCOUT(sc_time_stamp() << " " << name() << " Interrupt received"
-                      << endl, kDebugLevel);
-      } else if (req_q.front() == 1) {
-        addr_pld = waddr_q.front();
-        if_wr.aw.Push(addr_pld);
-        waddr_q.pop();
-        wr_data_pld = wdata_q.front();
-        if_wr.w.Push(wr_data_pld);
-        wdata_q.pop();
-        if_wr.b.Pop();
-        CDCOUT(sc_time_stamp() << " " << name() << " Sent write request:"
-                      << " addr=[" << addr_pld << "]"
-                      << " data=[" << wr_data_pld << "]"
-                      << endl, kDebugLevel);
-      } else {
-        addr_pld = raddr_q.front();
-        if_rd.ar.Push(addr_pld);
-        raddr_q.pop();
-        CDCOUT(sc_time_stamp() << " " << name() << " Sent read request: "
-                      << addr_pld
-                      << endl, kDebugLevel);
-        data_pld = if_rd.r.Pop();
+    AxiTraceRecord rec;
+    bool pending = false;
+    unsigned delay = 0;
+    bool aw_sent = false;
+    bool w_sent = false;
+    unsigned outstanding = 0;
+
+    while (1) {
+      if (if_rd.r.PopNB(data_pld)) {
         CDCOUT(sc_time_stamp() << " " << name() << " Received read response: ["
                       << data_pld << "]"
                       << endl, kDebugLevel);
+        NVHLS_ASSERT_MSG(!rresp_q.empty(), "Read response without a read request");
         NVHLS_ASSERT_MSG(data_pld.data == rresp_q.front(),"Read response did not match expected value");
         rresp_q.pop();
+        outstanding--;
+      }
+      if (axiCfg::useWriteResponses && if_wr.b.PopNB(wr_resp_pld)) {
+        outstanding--;
+      }
+
+      if (!pending) {
+        pending = trace.next(rec);
+        if (!pending && (outstanding == 0)) {
+          break;
+        }
+        delay = rec.delay;
+      }
+
+      if (pending && (outstanding < ((rec.type == 'Q') ? 1 : maxOutstanding))) {
+        if (delay > 0) {
+          delay--;
+        } else if (rec.type == 'Q') {
+          NVHLS_ASSERT_MSG(enable_interrupts,"Interrupt command found, but interrupts are not enabled");
+          CDCOUT(sc_time_stamp() << " " << name() << " Beginning wait for interrupt"
+                        << endl, kDebugLevel);
+          while (interrupt.read() == 0) wait();
+          CDCOUT(sc_time_stamp() << " " << name() << " Interrupt received"
+                        << endl, kDebugLevel);
+          pending = false;
+        } else if (rec.type == 'W') {
+          if (!aw_sent) {
+            wr_addr_pld.addr = static_cast<typename axi4_::Addr>(rec.addr);
+            wr_addr_pld.len = 0;
+            aw_sent = if_wr.aw.PushNB(wr_addr_pld);
+          }
+          if (!w_sent) {
+            wr_data_pld.data = toData(rec.data);
+            wr_data_pld.wstrb = ~0;
+            wr_data_pld.last = 1;
+            w_sent = if_wr.w.PushNB(wr_data_pld);
+          }
+          if (aw_sent && w_sent) {
+            CDCOUT(sc_time_stamp() << " " << name() << " Sent write request:"
+                          << " addr=[" << wr_addr_pld << "]"
+                          << " data=[" << wr_data_pld << "]"
+                          << endl, kDebugLevel);
+            if (axiCfg::useWriteResponses) outstanding++;
+            aw_sent = w_sent = pending = false;
+          }
+        } else {
+          addr_pld.addr = static_cast<typename axi4_::Addr>(rec.addr);
+          addr_pld.len = 0;
+          if (if_rd.ar.PushNB(addr_pld)) {
+            CDCOUT(sc_time_stamp() << " " << name() << " Sent read request: "
+                          << addr_pld
+                          << endl, kDebugLevel);
+            rresp_q.push(toData(rec.data));
+            outstanding++;
+            pending = false;
+          }
+        }
       }
-      req_q.pop();
+      wait();
     }
+    CDCOUT(sc_time_stamp() << " " << name() << " Completed " << trace.count()
+                  << " requests" << endl, kDebugLevel);
     done = 1;
   }
 };
@@ -21,12 +21,13 @@
 #include <ac_reset_signal_is.h>
 
 #include <axi/axi4.h>
-#include <axi/testbench/CSVFileReader.h>
+#include <axi/testbench/AxiTraceFile.h>
 #include <nvhls_connections.h>
 #include <hls_globals.h>
 
 #include <queue>
 #include <map>
+#include <set>
 #include <boost/assert.hpp>
 #include <algorithm>
 #include <string>
@@ -44,6 +45,9 @@
  * 
  *  It's best to specify the full DATA_WIDTH of data.
  *
+ * The file can also be the equivalent binary memory trace (see AxiTraceReader).
+ * It is streamed in, so only the memory contents are kept.
+ *
  */
 template <typename axiCfg> class SlaveFromFile : public sc_module {
  public:
@@ -64,7 +68,7 @@ template <typename axiCfg> class SlaveFromFile : public sc_module {
 
   std::map<typename axi4_::Addr, typename axi4_::Data> localMem;
   std::map<typename axi4_::Addr, NVUINT8> localMem_wstrb;
-  std::vector<typename axi4_::Addr> validReadAddresses;
+  std::set<typename axi4_::Addr> validReadAddresses;
 
   typename axi4_::WritePayload load_data_pld;
 
@@ -75,21 +79,14 @@ template <typename axiCfg> class SlaveFromFile : public sc_module {
   SlaveFromFile(sc_module_name name_, std::string filename="mem.csv")
       : sc_module(name_), if_rd("if_rd"), if_wr("if_wr"), reset_bar("reset_bar"), clk("clk") {
 
-    CSVFileReader reader(filename);
-    std::vector< std::vector<std::string> > dataList = reader.readCSV();
-    for (unsigned int i=0; i < dataList.size(); i++) {
-      std::vector<std::string> vec = dataList[i];
-      NVHLS_ASSERT_MSG(vec.size() == 2, "Each request must have two elements");
-      std::stringstream ss;
-      sc_uint<axi4_::ADDR_WIDTH> addr_sc_uint;
-      ss << hex << vec[0];
-      ss >> addr_sc_uint;
-      std::stringstream ss_data;
-      sc_biguint<axi4_::DATA_WIDTH> data;
-      ss_data << hex << vec[1];
-      ss_data >> data;
-      load_data_pld.data = TypeToNVUINT(data);
-      typename axi4_::Addr addr = static_cast<typename axi4_::Addr>(addr_sc_uint);
+    AxiTraceReader reader(filename, AxiTraceReader::Memory, bytesPerBeat);
+    AxiTraceRecord rec;
+    while (reader.next(rec)) {
+      load_data_pld.data = 0;
+      for (int j=0; j<bytesPerBeat; j++) {
+        load_data_pld.data = nvhls::set_slc(load_data_pld.data, NVUINT8(rec.data[j]), 8*j);
+      }
+      typename axi4_::Addr addr = static_cast<typename axi4_::Addr>(rec.addr);
       if (axiCfg::useWriteStrobes) {
         for (int j=0; j<axi4_::WSTRB_WIDTH; j++) {
           localMem_wstrb[addr+j] = nvhls::get_slc<8>(load_data_pld.data, 8*j);
@@ -97,8 +94,9 @@ template <typename axiCfg> class SlaveFromFile : public sc_module {
       } else {
         localMem[addr] = load_data_pld.data;
       }  
-      validReadAddresses.push_back(addr);
+      validReadAddresses.insert(addr);
     }
+    CDCOUT("Loaded " << reader.count() << " words from " << filename << endl, kDebugLevel);
 
     SC_THREAD(run_rd);
     sensitive << clk.pos();
@@ -130,10 +128,7 @@ protected:
               << ": Received a read request from an address that has not yet been written to"
               << ", addr=" << hex << addr
               << endl;
-          bool validAddr = false;
-          for (unsigned int j=0; j<validReadAddresses.size(); j++) {
-            if (validReadAddresses[j] == rd_addr_pld.addr) validAddr = true;
-          }
+          bool validAddr = (validReadAddresses.count(rd_addr_pld.addr) > 0);
           BOOST_ASSERT_MSG( validAddr, msg.str().c_str() );
           typename axi4_::ReadPayload data_pld;
           if (axiCfg::useWriteStrobes) {
@@ -242,7 +237,7 @@ protected:
         } else {
           localMem[wresp_addr] = wr_data_pld.data;
         }
-        validReadAddresses.push_back(wresp_addr);
+        validReadAddresses.insert(wresp_addr);
         wresp_addr += bytesPerBeat;
         if (wr_data_pld.last == 1) {
           wr_addr.pop();
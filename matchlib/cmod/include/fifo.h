@@ -377,4 +377,177 @@ class FIFO<DataType, 1, NumBanks> {
     }
 };
 
+/**
+ * \brief FIFO with several push and pop ports
+ * \ingroup FIFO
+ *
+ * \tparam DataType         DataType of entry in FIFO
+ * \tparam FifoLen          Length of FIFO, a multiple of NumBanks
+ * \tparam NumPush          Number of entries that can be pushed per call
+ * \tparam NumPop           Number of entries that can be popped per call
+ * \tparam NumBanks         Number of memory banks, at least NumPush and NumPop
+ *
+ * \par Overview
+ * A single queue that takes up to NumPush entries and gives up to NumPop entries
+ * per cycle. Entry i of the queue is kept in bank i % NumBanks, so the
+ * consecutive entries pushed or popped in one cycle are all in different banks
+ * and each bank sees at most one write and one read.
+ *
+ * push() appends the entries of the ports with a set mask bit, lowest port
+ * first. pop() hands the oldest entries to the ports with a set mask bit,
+ * oldest to the lowest port. Calling pop() before push() in a cycle lets a full
+ * FIFO take as many entries as were popped.
+ *
+ * \par A Simple Example
+ * \code
+ *      #include <fifo.h>
+ *
+ *      ...
+ *      MultiPortFIFO<DataType, 16, 4, 2> fifo_inst;
+ *
+ *      ...
+ *      // Pop 2 entries
+ *      DataType out[2];
+ *      if (fifo_inst.numFilled() >= 2) {
+ *        fifo_inst.pop(out, 0x3);
+ *      }
+ *      ...
+ *      // Push 4 entries
+ *      if (!fifo_inst.isFull(4)) {
+ *        fifo_inst.push(in, 0xf);
+ *      }
+ *      ...
+ *
+ * \endcode
+ * \par
+ *
+ */
+template <typename DataType, unsigned int FifoLen, unsigned int NumPush,
+          unsigned int NumPop,
+          unsigned int NumBanks = ((NumPush > NumPop) ? NumPush : NumPop)>
+class MultiPortFIFO {
+  static_assert(NumBanks >= NumPush && NumBanks >= NumPop, "Fewer banks than ports");
+  static_assert(FifoLen % NumBanks == 0, "FIFO length must be a multiple of the number of banks");
+
+ public:
+  static const unsigned int EntriesPerBank = FifoLen / NumBanks;
+  static const int AddrWidth =
+      (FifoLen == 1) ? 1 : nvhls::nbits<FifoLen - 1>::val;
+  static const int CountWidth = nvhls::nbits<FifoLen>::val;
+  typedef NVUINTW(AddrWidth) FifoIdx;
+  typedef NVUINTW(CountWidth) Count;
+  typedef NVUINTW(NumPush) PushMask;
+  typedef NVUINTW(NumPop) PopMask;
+  typedef mem_array_sep<DataType, FifoLen, NumBanks> Body;
+
+  FifoIdx head;  // where to read from
+  FifoIdx tail;  // where to write to
+  Count count;   // number of entries filled
+  Body fifo_body;
+  static const int width = Body::width + 2 * AddrWidth + CountWidth;
+
+  MultiPortFIFO() { reset(); }
+
+  // Function to push the entries of data with a set bit in mask
+  void push(const DataType data[NumPush], PushMask mask) {
+    Count num = 0;
+#pragma hls_unroll yes
+    for (unsigned i = 0; i < NumPush; i++) {
+      if (mask[i] == 1) { num++; }
+    }
+    NVHLS_ASSERT_MSG(num <= numFree(), "Pushing data to full FIFO");
+
+    Count idx = 0;
+#pragma hls_unroll yes
+    for (unsigned i = 0; i < NumPush; i++) {
+      if (mask[i] == 1) {
+        write(AddMod(tail, idx), data[i]);
+        idx++;
+      }
+    }
+    tail = AddMod(tail, num);
+    count += num;
+  }
+
+  // Function to pop an entry to each port of data with a set bit in mask
+  void pop(DataType data[NumPop], PopMask mask) {
+    Count num = 0;
+#pragma hls_unroll yes
+    for (unsigned i = 0; i < NumPop; i++) {
+      if (mask[i] == 1) {
+        NVHLS_ASSERT_MSG(num < count, "Popping data from empty FIFO");
+        data[i] = read(AddMod(head, num));
+        num++;
+      }
+    }
+    head = AddMod(head, num);
+    count -= num;
+  }
+
+  // Function to read the oldest min(NumPop, numFilled()) entries to data
+  // without popping them
+  void peek(DataType data[NumPop]) {
+#pragma hls_unroll yes
+    for (unsigned i = 0; i < NumPop; i++) {
+      if (i < count) {
+        data[i] = read(AddMod(head, i));
+      }
+    }
+  }
+
+  // Function to drop num entries (emulate a pop)
+  void incrHead(Count num = 1) {
+    NVHLS_ASSERT_MSG(num <= count, "Incrementing Head past the tail of FIFO");
+    head = AddMod(head, num);
+    count -= num;
+  }
+
+  bool isEmpty() { return (count == 0); }
+
+  // Checks if fewer than num entries are free
+  bool isFull(Count num = 1) { return (numFree() < num); }
+
+  Count numFilled() { return count; }
+
+  Count numFree() { return FifoLen - count; }
+
+  // Reset head and tail pointers
+  void reset() {
+    head = 0;
+    tail = 0;
+    count = 0;
+  }
+
+  FifoIdx get_head() { return head; }
+  FifoIdx get_tail() { return tail; }
+
+  template<unsigned int Size>
+  void Marshall(Marshaller<Size>& m) {
+    m & head;
+    m & tail;
+    m & count;
+    m & fifo_body;
+  }
+
+ private:
+  typedef NVUINTW(AddrWidth + 1) FifoIdxPlusOne;
+
+  // Function to do modulo add of an offset of at most FifoLen to pointer
+  static FifoIdx AddMod(FifoIdx idx, Count offset) {
+    FifoIdxPlusOne sum = idx + offset;
+    if (sum >= FifoLen) {
+      return sum - FifoLen;
+    }
+    return sum;
+  }
+
+  DataType read(FifoIdx idx) {
+    return fifo_body.read(idx / NumBanks, idx % NumBanks);
+  }
+
+  void write(FifoIdx idx, DataType data) {
+    fifo_body.write(idx / NumBanks, idx % NumBanks, data);
+  }
+};
+
 #endif  // end #define FIFO_H macro
@@ -22,6 +22,13 @@
 #include <nvhls_marshaller.h>
 #include <TypeToBits.h>
 
+#if !defined(__SYNTHESIS__) && !defined(SLEC_CPC) && !defined(MEM_ARRAY_4STATE)
+#include <vector>
+// Simulation keeps mem_array_sep in 2-state pages allocated on first use. Define
+// MEM_ARRAY_4STATE to simulate the sc_lv storage that is synthesized instead.
+#define MEM_ARRAY_PAGED
+#endif
+
 // T: data type
 // N: number of lines
 template <typename T, int N>
@@ -60,6 +67,14 @@ class mem_array_2d_transp {
  * \tparam T                Datatype of an entry to be stored in memory 
  * \tparam NumEntries       Number of entries in memory 
  * \tparam NumBanks         Number of banks in memory
+ * \tparam NumByteEnables   Number of separately writable slices of an entry
+ *
+ * \par Overview
+ * In synthesis every entry is held as NumByteEnables sc_lv slices, X until
+ * written. In simulation (MEM_ARRAY_PAGED) entries are held as T in pages that
+ * are allocated on their first write, and a bitmap of written slices replaces
+ * the X, so host memory grows with the entries used rather than NumEntries.
+ * Reads of unwritten data assert in both.
  *
  *
  * \par A Simple Example
@@ -94,6 +109,144 @@ class mem_array_sep {
   typedef NVUINTW(NumByteEnables) WriteMask;
   typedef NVUINTW(nvhls::index_width<NumByteEnables>::val) ByteEnableIndex;
 
+#ifdef MEM_ARRAY_PAGED
+  static const int width =  NumEntries * WordWidth;
+
+  // Entries are kept as T in pages of PageEntries, allocated on the first write
+  // to the page. A bit per byte enable slice records whether it was written,
+  // and stands in for the X of the 4-state storage.
+  static const unsigned int PageEntries = (NumEntriesPerBank < 4096) ? NumEntriesPerBank : 4096;
+  static const unsigned int NumPages = (NumEntriesPerBank + PageEntries - 1) / PageEntries;
+
+  struct Page {
+    std::vector<T> data;
+    std::vector<bool> written;
+  };
+
+  mem_array_sep() : pages(NumBanks * NumPages), cleared(false) {}
+
+  // Reads of entries not written since return 0
+  void clear() {
+    pages.assign(NumBanks * NumPages, Page());
+    cleared = true;
+  }
+
+  T read(LocalIndex idx, BankIndex bank_sel=0) {
+    NVHLS_ASSERT_MSG(bank_sel<NumBanks, "bank index out of bounds");
+    NVHLS_ASSERT_MSG(idx<NumEntriesPerBank, "local index out of bounds");
+    unsigned entry = static_cast<unsigned>(idx);
+    const Page& page = pages[static_cast<unsigned>(bank_sel) * NumPages + entry / PageEntries];
+    if (page.data.empty()) {
+      CMOD_ASSERT_MSG(cleared, "Read data is X");
+      return zero();
+    }
+    unsigned offset = entry % PageEntries;
+    for (unsigned i = 0; i < NumByteEnables; i++) {
+      CMOD_ASSERT_MSG(page.written[offset * NumByteEnables + i], "Read data is X");
+    }
+    return page.data[offset];
+  }
+
+  // Full writes store val as is. Partial writes merge the enabled slices into
+  // the entry through bit vectors. A 2-state T cannot carry X, so write data is
+  // not checked.
+  void write(LocalIndex idx, BankIndex bank_sel, T val, WriteMask write_mask=~static_cast<WriteMask>(0), bool wce=1) {
+    if (!wce || (write_mask == 0)) {
+      return;
+    }
+    NVHLS_ASSERT_MSG(bank_sel<NumBanks, "bank index out of bounds");
+    NVHLS_ASSERT_MSG(idx<NumEntriesPerBank, "local index out of bounds");
+    unsigned entry = static_cast<unsigned>(idx);
+    Page& page = get_page(static_cast<unsigned>(bank_sel) * NumPages + entry / PageEntries);
+    unsigned offset = entry % PageEntries;
+    if (write_mask == ~static_cast<WriteMask>(0)) {
+      page.data[offset] = val;
+    } else {
+      Data_t old_data = TypeToBits<T>(page.data[offset]);
+      Data_t write_data = TypeToBits<T>(val);
+      for (unsigned i = 0; i < NumByteEnables; i++) {
+        if (write_mask[i] == 1) {
+          old_data.range((i+1)*SliceWidth-1, i*SliceWidth) = write_data.range((i+1)*SliceWidth-1, i*SliceWidth);
+        }
+      }
+      page.data[offset] = BitsToType<T>(old_data);
+    }
+    for (unsigned i = 0; i < NumByteEnables; i++) {
+      if (write_mask[i] == 1) {
+        page.written[offset * NumByteEnables + i] = true;
+      }
+    }
+  }
+
+  // Same layout as the 4-state storage: one slice per byte enable, entries in
+  // order within a bank, unwritten slices as X
+  template<unsigned int Size>
+  void Marshall(Marshaller<Size>& m) {
+    for (unsigned i = 0; i < NumBanks; i++) {
+      for (unsigned j = 0; j < NumEntriesPerBank; j++) {
+        Data_t cur = entry_bits(i * NumPages + j / PageEntries, j % PageEntries);
+        Data_t next = cur;
+        for (unsigned k = 0; k < NumByteEnables; k++) {
+          Slice_t slice = cur.range((k+1)*SliceWidth-1, k*SliceWidth);
+          m & slice;
+          next.range((k+1)*SliceWidth-1, k*SliceWidth) = slice;
+        }
+        // Marshalling leaves the entry as it was, unmarshalling stores it
+        if (next == cur) {
+          continue;
+        }
+        Page& page = get_page(i * NumPages + j / PageEntries);
+        unsigned offset = j % PageEntries;
+        Data_t data = TypeToBits<NVUINTW(WordWidth)>(0);
+        for (unsigned k = 0; k < NumByteEnables; k++) {
+          Slice_t slice = next.range((k+1)*SliceWidth-1, k*SliceWidth);
+          bool written = (slice.xor_reduce() != sc_logic('X'));
+          page.written[offset * NumByteEnables + k] = written;
+          if (written) {
+            data.range((k+1)*SliceWidth-1, k*SliceWidth) = slice;
+          }
+        }
+        page.data[offset] = BitsToType<T>(data);
+      }
+    }
+  }
+
+ private:
+  std::vector<Page> pages;
+  bool cleared;
+
+  static T zero() {
+    return BitsToType<T>(TypeToBits<NVUINTW(WordWidth)>(0));
+  }
+
+  Page& get_page(unsigned p) {
+    Page& page = pages[p];
+    if (page.data.empty()) {
+      page.data.assign(PageEntries, cleared ? zero() : T());
+      page.written.assign(PageEntries * NumByteEnables, cleared);
+    }
+    return page;
+  }
+
+  // Entry offset of page p as bits, X where not written
+  Data_t entry_bits(unsigned p, unsigned offset) {
+    const Page& page = pages[p];
+    Data_t bits;
+    if (page.data.empty()) {
+      if (cleared) {
+        bits = TypeToBits<NVUINTW(WordWidth)>(0);
+      }
+      return bits;
+    }
+    Data_t data = TypeToBits<T>(page.data[offset]);
+    for (unsigned k = 0; k < NumByteEnables; k++) {
+      if (page.written[offset * NumByteEnables + k]) {
+        bits.range((k+1)*SliceWidth-1, k*SliceWidth) = data.range((k+1)*SliceWidth-1, k*SliceWidth);
+      }
+    }
+    return bits;
+  }
+#else
   typedef Slice_t BankType[NumEntriesPerBank*NumByteEnables];
   nvhls::nv_array<BankType, NumBanks> bank;
   static const int width =  NumEntries * WordWidth;
@@ -160,7 +313,7 @@ class mem_array_sep {
       }
     }
   } 
+#endif
 };
 
-
 #endif
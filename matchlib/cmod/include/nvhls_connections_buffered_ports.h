@@ -172,7 +172,11 @@ class StateSignal<Message, TLM_PORT> : public StateSignal<Message, DIRECT_PORT>
 //------------------------------------------------------------------------
 
 template <typename Message, connections_port_t port_marshall_type>
-class Bypass : public sc_module {
+class Bypass : public sc_module
+#ifdef CONNECTIONS_SIM_ONLY
+    , public Connections::sc_profile_marker
+#endif
+{
   SC_HAS_PROCESS(Bypass);
 
  public:
@@ -194,6 +198,24 @@ class Bypass : public sc_module {
     Init();
   }
 
+#ifdef CONNECTIONS_SIM_ONLY
+  void set_profile(std::vector<Connections::channel_probe> &probes) {
+    Connections::channel_probe p;
+    p.name = this->name();
+    p.kind = "Bypass";
+    p.sample = [this](Connections::channel_sample &s) {
+      s.in_vld = enq.vld.read();
+      s.in_rdy = enq.rdy.read();
+      s.out_vld = deq.vld.read();
+      s.out_rdy = deq.rdy.read();
+      s.occupancy = full.read();
+      s.capacity = 1;
+    };
+    p.edge = [this]() -> const sc_event * { return &(clk->posedge_event()); };
+    probes.push_back(p);
+  }
+#endif
+
  protected:
   typedef bool Bit;
 
@@ -317,7 +339,11 @@ class Bypass<Message, TLM_PORT> : public Bypass<Message, DIRECT_PORT>
 //------------------------------------------------------------------------
 
 template <typename Message, connections_port_t port_marshall_type>
-class Pipeline : public sc_module {
+class Pipeline : public sc_module
+#ifdef CONNECTIONS_SIM_ONLY
+    , public Connections::sc_profile_marker
+#endif
+{
   SC_HAS_PROCESS(Pipeline);
 
  public:
@@ -339,6 +365,24 @@ class Pipeline : public sc_module {
     Init();
   }
 
+#ifdef CONNECTIONS_SIM_ONLY
+  void set_profile(std::vector<Connections::channel_probe> &probes) {
+    Connections::channel_probe p;
+    p.name = this->name();
+    p.kind = "Pipeline";
+    p.sample = [this](Connections::channel_sample &s) {
+      s.in_vld = enq.vld.read();
+      s.in_rdy = enq.rdy.read();
+      s.out_vld = deq.vld.read();
+      s.out_rdy = deq.rdy.read();
+      s.occupancy = full.read();
+      s.capacity = 1;
+    };
+    p.edge = [this]() -> const sc_event * { return &(clk->posedge_event()); };
+    probes.push_back(p);
+  }
+#endif
+
  protected:
   typedef bool Bit;
 
@@ -464,7 +508,11 @@ class Pipeline<Message, TLM_PORT> : public Pipeline<Message, DIRECT_PORT>
 //------------------------------------------------------------------------
 
 template <typename Message, unsigned int NumEntries, connections_port_t port_marshall_type = AUTO_PORT>
-class BypassBuffered : public sc_module {
+class BypassBuffered : public sc_module
+#ifdef CONNECTIONS_SIM_ONLY
+    , public Connections::sc_profile_marker
+#endif
+{
   SC_HAS_PROCESS(BypassBuffered);
 
  public:
@@ -486,6 +534,26 @@ class BypassBuffered : public sc_module {
     Init();
   }
 
+#ifdef CONNECTIONS_SIM_ONLY
+  void set_profile(std::vector<Connections::channel_probe> &probes) {
+    Connections::channel_probe p;
+    p.name = this->name();
+    p.kind = "BypassBuffered";
+    p.sample = [this](Connections::channel_sample &s) {
+      s.in_vld = enq.vld.read();
+      s.in_rdy = enq.rdy.read();
+      s.out_vld = deq.vld.read();
+      s.out_rdy = deq.rdy.read();
+      unsigned h = head.read().to_uint();
+      unsigned t = tail.read().to_uint();
+      s.occupancy = full.read() ? NumEntries : ((h + NumEntries - t) % NumEntries);
+      s.capacity = NumEntries;
+    };
+    p.edge = [this]() -> const sc_event * { return &(clk->posedge_event()); };
+    probes.push_back(p);
+  }
+#endif
+
  protected:
   typedef bool Bit;
   static const int AddrWidth = nvhls::nbits<NumEntries - 1>::val;
@@ -700,7 +768,11 @@ class BypassBuffered<Message, NumEntries, TLM_PORT> : public BypassBuffered<Mess
 //------------------------------------------------------------------------
 
 template <typename Message, unsigned int NumEntries, connections_port_t port_marshall_type>
-class Buffer : public sc_module {
+class Buffer : public sc_module
+#ifdef CONNECTIONS_SIM_ONLY
+    , public Connections::sc_profile_marker
+#endif
+{
   SC_HAS_PROCESS(Buffer);
 
  public:
@@ -722,6 +794,26 @@ class Buffer : public sc_module {
     Init();
   }
 
+#ifdef CONNECTIONS_SIM_ONLY
+  void set_profile(std::vector<Connections::channel_probe> &probes) {
+    Connections::channel_probe p;
+    p.name = this->name();
+    p.kind = "Buffer";
+    p.sample = [this](Connections::channel_sample &s) {
+      s.in_vld = enq.vld.read();
+      s.in_rdy = enq.rdy.read();
+      s.out_vld = deq.vld.read();
+      s.out_rdy = deq.rdy.read();
+      unsigned h = head.read().to_uint();
+      unsigned t = tail.read().to_uint();
+      s.occupancy = full.read() ? NumEntries : ((h + NumEntries - t) % NumEntries);
+      s.capacity = NumEntries;
+    };
+    p.edge = [this]() -> const sc_event * { return &(clk->posedge_event()); };
+    probes.push_back(p);
+  }
+#endif
+
  protected:
   typedef bool Bit;
   static const int AddrWidth = nvhls::index_width<NumEntries>::val;
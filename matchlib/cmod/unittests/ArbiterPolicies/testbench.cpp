@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <match_scverify.h>
+#include <testbench/nvhls_rand.h>
+#include <nvhls_int.h>
+#include <nvhls_types.h>
+#include <Arbiter.h>
+#include <hls_globals.h>
+
+#include <vector>
+#include <algorithm>
+#include <ctime>
+
+#ifndef NUM_ITERS
+#define NUM_ITERS 20000
+#endif
+
+typedef sc_dt::uint64 word_t;
+
+// Random valid mask of n bits, sometimes 0, sometimes sparse
+word_t semi_random(unsigned n, int iter) {
+  if (iter % 17 == 0) return 0;
+  word_t v = (static_cast<word_t>(rand()) << 31) ^ rand();
+  if (iter % 3 == 0) v &= rand();
+  v &= (n == 64) ? ~static_cast<word_t>(0) : ((static_cast<word_t>(1) << n) - 1);
+  return v;
+}
+
+// Reference models on plain words, written from the documented policies
+
+// Roundrobin: priority rotates right from the last grant (as ArbiterTop)
+struct RefRoundrobin {
+  unsigned n;
+  word_t iter;
+  RefRoundrobin(unsigned n_) : n(n_), iter(1) {}
+  word_t pick(word_t valid) {
+    if (valid == 0) return 0;
+    for (unsigned i = 0; i <= n; i++) {
+      iter = (iter >> 1) | ((iter & 1) << (n - 1));
+      if (iter & valid) return iter;
+    }
+    return 0;
+  }
+};
+
+// Static: highest index wins
+struct RefStatic {
+  RefStatic(unsigned) {}
+  word_t pick(word_t valid) {
+    if (valid == 0) return 0;
+    word_t s = 1;
+    while (valid >>= 1) s <<= 1;
+    return s;
+  }
+};
+
+struct RefWeighted {
+  unsigned n;
+  std::vector<unsigned> weight;
+  unsigned last, left;
+  RefWeighted(unsigned n_) : n(n_), weight(n_, 1), last(n_ - 1), left(0) {}
+  word_t pick(word_t valid) {
+    if (valid == 0) return 0;
+    if (((valid >> last) & 1) && left) {
+      left--;
+      return static_cast<word_t>(1) << last;
+    }
+    for (unsigned j = 1; j <= n; j++) {
+      unsigned i = (last + j) % n;
+      if ((valid >> i) & 1) {
+        last = i;
+        left = weight[i] ? weight[i] - 1 : 0;
+        return static_cast<word_t>(1) << i;
+      }
+    }
+    return 0;
+  }
+};
+
+struct RefOldest {
+  unsigned n;
+  std::vector<unsigned> age;
+  RefOldest(unsigned n_) : n(n_), age(n_, 0) {}
+  word_t pick(word_t valid) {
+    int best = -1;
+    for (unsigned i = 0; i < n; i++) {
+      if (((valid >> i) & 1) && ((best < 0) || (age[i] > age[best]))) best = i;
+    }
+    for (unsigned i = 0; i < n; i++) {
+      if (!((valid >> i) & 1) || (int(i) == best)) {
+        age[i] = 0;
+      } else if (age[i] < 255) {
+        age[i]++;
+      }
+    }
+    return (best < 0) ? 0 : (static_cast<word_t>(1) << best);
+  }
+};
+
+// Matrix: least recently granted first, as an ordered list
+struct RefMatrix {
+  std::vector<unsigned> order;  // highest priority first
+  RefMatrix(unsigned n) {
+    for (unsigned i = 0; i < n; i++) order.push_back(i);
+  }
+  word_t pick(word_t valid) {
+    for (unsigned k = 0; k < order.size(); k++) {
+      unsigned i = order[k];
+      if ((valid >> i) & 1) {
+        order.erase(order.begin() + k);
+        order.push_back(i);
+        return static_cast<word_t>(1) << i;
+      }
+    }
+    return 0;
+  }
+};
+
+// Same grants as the reference for random valids, one grant per pick with
+// a nonzero valid and none otherwise
+template <unsigned N, arbiter_type T, class Ref>
+void check_reference(const char* name, Arbiter<N, T>& arb, Ref& ref) {
+  typedef typename Arbiter<N, T>::Mask Mask;
+  for (int it = 0; it < NUM_ITERS; it++) {
+    word_t valid = semi_random(N, it);
+    word_t select = arb.pick(static_cast<Mask>(valid)).to_uint64();
+    word_t expect = ref.pick(valid);
+    if (select != expect) {
+      printf("%s<%u>: valid %llx select %llx, expected %llx\n", name, N,
+             (unsigned long long)valid, (unsigned long long)select,
+             (unsigned long long)expect);
+      assert(0);
+    }
+    assert((select & ~valid) == 0);
+    assert((select & (select - 1)) == 0);
+    assert((select != 0) == (valid != 0));
+  }
+}
+
+// Under full contention every input gets share[i] of every period grants, and
+// input watch, when it stays valid, is never kept waiting more than max_wait picks
+template <unsigned N, class Arb>
+void check_fairness(const char* name, Arb& arb, const std::vector<unsigned>& share,
+                    unsigned period, unsigned watch, unsigned max_wait) {
+  typedef typename Arb::Mask Mask;
+  std::vector<unsigned> count(N, 0);
+  word_t all = (N == 64) ? ~static_cast<word_t>(0) : ((static_cast<word_t>(1) << N) - 1);
+  for (unsigned p = 0; p < 10 * period; p++) {
+    word_t select = arb.pick(static_cast<Mask>(all)).to_uint64();
+    for (unsigned i = 0; i < N; i++) count[i] += (select >> i) & 1;
+  }
+  for (unsigned i = 0; i < N; i++) {
+    if (count[i] != 10 * share[i]) {
+      printf("%s<%u>: input %u got %u of %u grants, expected %u\n", name, N, i,
+             count[i], 10 * period, 10 * share[i]);
+      assert(0);
+    }
+  }
+
+  // The watched input stays valid, the others come and go
+  unsigned wait = 0;
+  for (int it = 0; it < NUM_ITERS; it++) {
+    word_t valid = semi_random(N, it) | (static_cast<word_t>(1) << watch);
+    word_t select = arb.pick(static_cast<Mask>(valid)).to_uint64();
+    wait = ((select >> watch) & 1) ? 0 : (wait + 1);
+    if (wait > max_wait) {
+      printf("%s<%u>: input %u waited %u picks, bound %u\n", name, N, watch, wait,
+             max_wait);
+      assert(0);
+    }
+  }
+}
+
+template <unsigned N, arbiter_type T>
+double picks_per_second() {
+  typedef typename Arbiter<N, T>::Mask Mask;
+  Arbiter<N, T> arb;
+  std::vector<Mask> valid(1024);
+  for (unsigned i = 0; i < valid.size(); i++) valid[i] = semi_random(N, i + 1) | 1;
+  const unsigned picks = 2000000;
+  word_t sink = 0;
+  clock_t t0 = clock();
+  for (unsigned i = 0; i < picks; i++) {
+    // Each pick depends on the one before, so none can be skipped
+    sink += arb.pick(valid[(i + sink) & 1023]).to_uint64();
+  }
+  double s = double(clock() - t0) / CLOCKS_PER_SEC;
+  if (sink == 0xdeadbeef) printf(" ");
+  return (s > 0) ? (picks / s) : 0;
+}
+
+template <unsigned N>
+void test_size() {
+  {
+    Arbiter<N, Roundrobin> arb;
+    RefRoundrobin ref(N);
+    check_reference("Roundrobin", arb, ref);
+  }
+  {
+    Arbiter<N, Static> arb;
+    RefStatic ref(N);
+    check_reference("Static", arb, ref);
+  }
+  {
+    Arbiter<N, WeightedRoundrobin> arb;
+    RefWeighted ref(N);
+    unsigned sum = 0;
+    std::vector<unsigned> share(N);
+    for (unsigned i = 0; i < N; i++) {
+      ref.weight[i] = share[i] = (i % 4) + 1;
+      arb.set_weight(i, ref.weight[i]);
+      sum += share[i];
+    }
+    check_reference("WeightedRoundrobin", arb, ref);
+    arb.reset();
+    check_fairness<N>("WeightedRoundrobin", arb, share, sum, 0, sum - share[0]);
+
+    // weight 0 counts as 1
+    Arbiter<N, WeightedRoundrobin> zero;
+    for (unsigned i = 0; i < N; i++) zero.set_weight(i, 0);
+    check_fairness<N>("WeightedRoundrobin", zero, std::vector<unsigned>(N, 1), N, 0, N - 1);
+  }
+  {
+    Arbiter<N, OldestFirst> arb;
+    RefOldest ref(N);
+    check_reference("OldestFirst", arb, ref);
+    arb.reset();
+    check_fairness<N>("OldestFirst", arb, std::vector<unsigned>(N, 1), N, 0, N - 1);
+  }
+  {
+    Arbiter<N, Matrix> arb;
+    RefMatrix ref(N);
+    check_reference("Matrix", arb, ref);
+    arb.reset();
+    check_fairness<N>("Matrix", arb, std::vector<unsigned>(N, 1), N, 0, N - 1);
+  }
+  {
+    // Upper half of the inputs in class 1. A valid class 1 input always wins;
+    // class 0 shares the rest in roundrobin.
+    QosArbiter<N, 2> arb;
+    typedef typename QosArbiter<N, 2>::Mask Mask;
+    word_t high = 0;
+    for (unsigned i = N / 2; i < N; i++) {
+      arb.set_class(i, 1);
+      high |= static_cast<word_t>(1) << i;
+    }
+    RefRoundrobin ref_high(N), ref_low(N);
+    for (int it = 0; it < NUM_ITERS; it++) {
+      word_t valid = semi_random(N, it);
+      word_t select = arb.pick(static_cast<Mask>(valid)).to_uint64();
+      word_t expect = (valid & high) ? ref_high.pick(valid & high) : ref_low.pick(valid & ~high);
+      assert(select == expect);
+    }
+    std::vector<unsigned> share(N, 0);
+    for (unsigned i = N / 2; i < N; i++) share[i] = 1;
+    arb.reset();
+    check_fairness<N>("QosArbiter", arb, share, N - N / 2, N - 1, N - N / 2 - 1);
+  }
+
+  printf("%2u inputs, picks/s: Roundrobin %.3g Static %.3g WeightedRoundrobin %.3g"
+         " OldestFirst %.3g Matrix %.3g\n", N,
+         picks_per_second<N, Roundrobin>(), picks_per_second<N, Static>(),
+         picks_per_second<N, WeightedRoundrobin>(),
+         picks_per_second<N, OldestFirst>(), picks_per_second<N, Matrix>());
+}
+
+CCS_MAIN(int argc, char *argv[]) {
+  nvhls::set_random_seed();
+#ifdef ARBITER_HOST_PICK
+  printf("pick() on machine words\n");
+#else
+  printf("pick() as synthesized\n");
+#endif
+  test_size<2>();
+  test_size<5>();
+  test_size<8>();
+  test_size<16>();
+  test_size<32>();
+
+  DCOUT("CMODEL PASS" << endl);
+  CCS_RETURN(0);
+}
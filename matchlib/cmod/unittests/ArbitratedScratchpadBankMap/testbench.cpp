@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <match_scverify.h>
+#include <testbench/nvhls_rand.h>
+#include <nvhls_int.h>
+#include <nvhls_types.h>
+#include <ArbitratedScratchpad.h>
+
+#include <vector>
+
+#ifndef NUM_INPUTS
+#define NUM_INPUTS 8
+#endif
+
+#ifndef NUM_BANK_ENTRIES
+#define NUM_BANK_ENTRIES 256
+#endif
+
+#ifndef LEN_INPUT_BUFFER
+#define LEN_INPUT_BUFFER 0
+#endif
+
+typedef NVUINT32 DataType;
+
+static const char* map_name(bank_map_type m) {
+  switch (m) {
+    case BankLowBits: return "LowBits";
+    case BankXorHash: return "XorHash";
+    case BankSkewed: return "Skewed";
+    default: return "PrimeModulo";
+  }
+}
+
+// Every address maps to its own row of a used bank, within the bank
+template <class Mem>
+void check_mapping(bank_map_type m, unsigned capacity) {
+  std::vector<bool> used(Mem::bank_entries * Mem::num_used_banks, false);
+  for (unsigned a = 0; a < capacity; a++) {
+    typename Mem::bank_sel_t bank;
+    typename Mem::bank_addr_t row;
+    Mem::map_address(a, bank, row);
+    if ((bank >= Mem::num_used_banks) || (row >= Mem::bank_entries) ||
+        used[bank * Mem::bank_entries + row]) {
+      printf("%s: address %u maps to bank %u row %u\n", map_name(m), a,
+             bank.to_uint(), row.to_uint());
+      assert(0);
+    }
+    used[bank * Mem::bank_entries + row] = true;
+  }
+}
+
+// Runs groups of NUM_INPUTS accesses, one per input, to addresses
+// base + i * stride. Each group is issued until every input was accepted. Loads
+// are checked against ref. Returns the cycles taken.
+template <class Mem>
+unsigned run_strided(Mem& mem, std::vector<unsigned>& ref, unsigned stride,
+                     unsigned groups, bool store) {
+  const unsigned capacity = ref.size();
+  unsigned cycles = 0;
+  for (unsigned g = 0; g < groups; g++) {
+    typename Mem::req_t req;
+    typename Mem::rsp_t rsp;
+    req.type.val = store ? CLITYPE_T::STORE : CLITYPE_T::LOAD;
+    unsigned base = rand() % capacity;
+    for (unsigned i = 0; i < NUM_INPUTS; i++) {
+      req.valids[i] = true;
+      req.addr[i] = (base + i * stride) % capacity;
+      req.data[i] = rand();
+    }
+    // Two inputs storing to one address in one group would leave the result
+    // up to the arbiters, so only the last one of them stores
+    for (unsigned i = 0; i < NUM_INPUTS; i++) {
+      for (unsigned j = i + 1; store && (j < NUM_INPUTS); j++) {
+        if (req.addr[i] == req.addr[j]) req.valids[i] = false;
+      }
+    }
+    bool pending = true;
+    while (pending) {
+      bool ready[NUM_INPUTS];
+      mem.load_store(req, rsp, ready);
+      cycles++;
+      assert(cycles < 100 * (groups + 1) * NUM_INPUTS);
+      pending = false;
+      for (unsigned i = 0; i < NUM_INPUTS; i++) {
+        if (req.valids[i] && ready[i]) {
+          unsigned a = req.addr[i].to_uint();
+          if (store) {
+            ref[a] = req.data[i].to_uint();
+          } else {
+            assert(rsp.valids[i]);
+            if (rsp.data[i].to_uint() != ref[a]) {
+              printf("load of address %u returned %x, expected %x\n", a,
+                     rsp.data[i].to_uint(), ref[a]);
+              assert(0);
+            }
+          }
+          req.valids[i] = false;
+        }
+        pending |= req.valids[i];
+      }
+    }
+  }
+  return cycles;
+}
+
+template <unsigned NumBanks, bank_map_type BankMap>
+void test_map(unsigned cycles_out[4], const unsigned strides[4]) {
+  typedef ArbitratedScratchpad<DataType, NumBanks * NUM_BANK_ENTRIES, NUM_INPUTS,
+                               NumBanks, LEN_INPUT_BUFFER, BankMap> Mem;
+  check_mapping<Mem>(BankMap, NumBanks * NUM_BANK_ENTRIES);
+
+  Mem mem;
+  std::vector<unsigned> ref(NumBanks * NUM_BANK_ENTRIES);
+  // Fill memory so every load has a known value
+  for (unsigned a = 0; a < ref.size(); a += NUM_INPUTS) {
+    typename Mem::req_t req;
+    typename Mem::rsp_t rsp;
+    req.type.val = CLITYPE_T::STORE;
+    for (unsigned i = 0; i < NUM_INPUTS; i++) {
+      req.valids[i] = (a + i < ref.size());
+      req.addr[i] = (a + i) % ref.size();
+      req.data[i] = rand();
+    }
+    bool pending = true;
+    while (pending) {
+      bool ready[NUM_INPUTS];
+      mem.load_store(req, rsp, ready);
+      pending = false;
+      for (unsigned i = 0; i < NUM_INPUTS; i++) {
+        if (req.valids[i] && ready[i]) {
+          ref[req.addr[i].to_uint()] = req.data[i].to_uint();
+          req.valids[i] = false;
+        }
+        pending |= req.valids[i];
+      }
+    }
+  }
+
+  printf("%2u banks %-12s", NumBanks, map_name(BankMap));
+  mem.enable_stats();
+  for (unsigned s = 0; s < 4; s++) {
+    mem.reset_stats();
+    unsigned cycles = run_strided(mem, ref, strides[s], 200, false);
+    cycles += run_strided(mem, ref, strides[s], 200, true);
+    typename Mem::BankStats total = mem.get_total_stats();
+    assert(total.accesses + total.stalls == total.requests);
+    assert(mem.get_stats_cycles() == cycles);
+    cycles_out[s] = cycles;
+    printf(" %8u %9llu", cycles, (unsigned long long)total.conflicts);
+  }
+  printf("\n");
+  // Random accesses mix loads and stores
+  for (unsigned i = 0; i < 50; i++) {
+    run_strided(mem, ref, 1 + rand() % 64, 1, rand() & 1);
+  }
+}
+
+template <unsigned NumBanks>
+void test_banks() {
+  // Unit stride, a stride of NumBanks (a matrix column), twice that, and an
+  // odd stride
+  const unsigned strides[4] = {1, NumBanks, 2 * NumBanks, 3};
+  printf("%-21s", "");
+  for (unsigned s = 0; s < 4; s++) {
+    printf("   stride %-3u conflicts", strides[s]);
+  }
+  printf("\n");
+  unsigned low[4], xor_hash[4], skewed[4], prime[4];
+  test_map<NumBanks, BankLowBits>(low, strides);
+  test_map<NumBanks, BankXorHash>(xor_hash, strides);
+  test_map<NumBanks, BankSkewed>(skewed, strides);
+  test_map<NumBanks, BankPrimeModulo>(prime, strides);
+
+  // A stride of NumBanks serializes on one bank with the low bits only
+  const unsigned groups = 400;
+  assert(low[1] == groups * NUM_INPUTS);
+  assert(xor_hash[1] < low[1] / 2);
+  assert(skewed[1] < low[1] / 2);
+  if (nvhls::largest_prime<NumBanks>::val != NumBanks) {
+    assert(prime[1] < low[1] / 2);
+  }
+}
+
+CCS_MAIN(int argc, char *argv[]) {
+  nvhls::set_random_seed();
+  printf("Cycles and bank conflicts of %u-input strided accesses\n", NUM_INPUTS);
+  test_banks<8>();
+  test_banks<16>();
+  test_banks<5>();
+
+  DCOUT("CMODEL PASS" << endl);
+  CCS_RETURN(0);
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <stdio.h>
+#include <match_scverify.h>
+#include <testbench/nvhls_rand.h>
+#include <nvhls_int.h>
+#include <nvhls_types.h>
+#include <mem_array.h>
+#include <TypeToBits.h>
+
+#include <vector>
+#include <ctime>
+
+#ifndef NUM_ITERS
+#define NUM_ITERS 20000
+#endif
+
+// Entries of the sparse memory. The sc_lv storage holds all of them.
+#ifndef SPARSE_ENTRIES
+#ifdef MEM_ARRAY_PAGED
+#define SPARSE_ENTRIES (1 << 24)
+#else
+#define SPARSE_ENTRIES (1 << 16)
+#endif
+#endif
+
+// Reference of an entry: its value and which byte enable slices were written
+struct RefEntry {
+  NVUINT32 data;
+  unsigned written;
+  RefEntry() : data(0), written(0) {}
+};
+
+// Random byte enable writes, and reads of the entries written in full,
+// against the reference
+template <class Mem>
+void check_random(Mem& mem, std::vector<RefEntry>& ref, unsigned num_banks,
+                  unsigned iters) {
+  const unsigned entries = ref.size() / num_banks;
+  for (unsigned it = 0; it < iters; it++) {
+    unsigned bank = rand() % num_banks;
+    unsigned idx = rand() % entries;
+    RefEntry& r = ref[bank * entries + idx];
+    if ((r.written == 0xf) && (rand() & 1)) {
+      NVUINT32 data = mem.read(idx, bank);
+      if (data != r.data) {
+        printf("bank %u entry %u read %x, expected %x\n", bank, idx, data.to_uint(),
+               r.data.to_uint());
+        assert(0);
+      }
+    } else {
+      NVUINT32 data = (static_cast<unsigned>(rand()) << 16) ^ rand();
+      NVUINT4 mask = (it % 4 == 0) ? 0xf : (rand() & 0xf);
+      bool wce = (it % 13 != 0);
+      mem.write(idx, bank, data, mask, wce);
+      for (unsigned i = 0; wce && (i < 4); i++) {
+        if (mask[i] == 1) {
+          r.data.set_slc(8 * i, data.template slc<8>(8 * i));
+          r.written |= 1 << i;
+        }
+      }
+    }
+  }
+}
+
+void test_small() {
+  typedef mem_array_sep<NVUINT32, 256, 4, 4> Mem;
+  Mem mem;
+  std::vector<RefEntry> ref(256);
+  check_random(mem, ref, 4, NUM_ITERS);
+
+  // Marshalling keeps written and unwritten slices, and leaves the memory as
+  // it was
+  sc_lv<Mem::width> bits = TypeToBits<Mem>(mem);
+  assert(TypeToBits<Mem>(mem) == bits);
+  Mem copy = BitsToType<Mem>(bits);
+  assert(TypeToBits<Mem>(copy) == bits);
+  for (unsigned e = 0; e < ref.size(); e++) {
+    if (ref[e].written == 0xf) {
+      assert(copy.read(e % 64, e / 64) == ref[e].data);
+    }
+  }
+  check_random(copy, ref, 4, NUM_ITERS);
+
+  // Cleared memory reads 0 until written
+  mem.clear();
+  for (unsigned e = 0; e < ref.size(); e++) {
+    assert(mem.read(e % 64, e / 64) == 0);
+    ref[e].data = 0;
+    ref[e].written = 0xf;
+  }
+  check_random(mem, ref, 4, NUM_ITERS);
+  Mem cleared = BitsToType<Mem>(TypeToBits<Mem>(mem));
+  for (unsigned e = 0; e < ref.size(); e++) {
+    assert(cleared.read(e % 64, e / 64) == ref[e].data);
+  }
+}
+
+// A large memory of which only a few entries are used, as in a testbench model
+// of DRAM
+void test_sparse() {
+  typedef mem_array_sep<NVUINT64, SPARSE_ENTRIES, 4> Mem;
+  const unsigned entries = SPARSE_ENTRIES / 4;
+  const unsigned accesses = 1000000;
+  clock_t t0 = clock();
+  Mem* mem = new Mem;
+  double construct = double(clock() - t0) / CLOCKS_PER_SEC;
+
+  std::vector<unsigned> addr(4096);
+  for (unsigned i = 0; i < addr.size(); i++) {
+    addr[i] = rand() % SPARSE_ENTRIES;
+  }
+  t0 = clock();
+  NVUINT64 sum = 0;
+  for (unsigned i = 0; i < accesses; i++) {
+    unsigned a = addr[i % addr.size()];
+    if (i < addr.size()) {
+      mem->write(a % entries, a / entries, a);
+    } else {
+      NVUINT64 data = mem->read(a % entries, a / entries);
+      assert(data == a);
+      sum += data;
+    }
+  }
+  double s = double(clock() - t0) / CLOCKS_PER_SEC;
+  printf("%u-entry memory: constructed in %.3f s, %.3g accesses/s\n", SPARSE_ENTRIES,
+         construct, (s > 0) ? (accesses / s) : 0);
+  delete mem;
+}
+
+CCS_MAIN(int argc, char *argv[]) {
+  nvhls::set_random_seed();
+#ifdef MEM_ARRAY_PAGED
+  printf("mem_array_sep in 2-state pages\n");
+#else
+  printf("mem_array_sep in sc_lv\n");
+#endif
+  test_small();
+  test_sparse();
+
+  DCOUT("CMODEL PASS" << endl);
+  CCS_RETURN(0);
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fifo.h>
+#include <hls_globals.h>
+#include <nvhls_assert.h>
+#include "MultiPortFifoTop.h"
+
+void MultiPortFifoTop(const DataType in[NUM_PUSH], const PushMask& push_mask,
+                      const PopMask& pop_mask, DataType out[NUM_POP],
+                      DataType head[NUM_POP], Count& filled, Count& free,
+                      bool& full)
+{
+    static Fifo_ fifo;
+    fifo.pop(out, pop_mask);
+    fifo.push(in, push_mask);
+    fifo.peek(head);
+    filled = fifo.numFilled();
+    free = fifo.numFree();
+    full = fifo.isFull(NUM_PUSH);
+}
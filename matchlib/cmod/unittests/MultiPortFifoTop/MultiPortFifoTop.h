@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MULTI_PORT_FIFO_TOP_H
+#define MULTI_PORT_FIFO_TOP_H
+
+#include <fifo.h>
+#include <hls_globals.h>
+#include <nvhls_assert.h>
+
+#ifndef FIFO_LENGTH
+#define FIFO_LENGTH 12
+#endif
+
+#ifndef WORD_WIDTH
+#define WORD_WIDTH 16
+#endif
+
+#ifndef NUM_PUSH
+#define NUM_PUSH 4
+#endif
+
+#ifndef NUM_POP
+#define NUM_POP 3
+#endif
+
+typedef NVUINTC(WORD_WIDTH) MemWord_t;
+
+typedef MultiPortFIFO<MemWord_t, FIFO_LENGTH, NUM_PUSH, NUM_POP> Fifo_;
+typedef MemWord_t DataType;
+typedef Fifo_::PushMask PushMask;
+typedef Fifo_::PopMask PopMask;
+typedef Fifo_::Count Count;
+
+// Pops to the ports in pop_mask, then pushes the ports in push_mask. Returns the
+// oldest entries left (peek), the entries filled and free, and whether fewer
+// than NUM_PUSH are free.
+void MultiPortFifoTop(const DataType in[NUM_PUSH], const PushMask& push_mask,
+                      const PopMask& pop_mask, DataType out[NUM_POP],
+                      DataType head[NUM_POP], Count& filled, Count& free,
+                      bool& full);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include "MultiPortFifoTop.h"
+#include <match_scverify.h>
+#include <testbench/nvhls_rand.h>
+
+#include <deque>
+
+#ifndef NUM_ITER
+#define NUM_ITER 10000
+#endif
+
+// Random mask of at most max set bits out of n
+unsigned semi_rand_mask(unsigned n, unsigned max)
+{
+    unsigned mask = 0, num = 0;
+    for (unsigned i = 0; i < n; i++) {
+        if ((num < max) && (rand() & 1)) {
+            mask |= 1 << i;
+            num++;
+        }
+    }
+    return mask;
+}
+
+CCS_MAIN(int argc, char *argv[]) {
+
+    nvhls::set_random_seed();
+
+    std::deque<MemWord_t> ref_q;
+    unsigned full_pushes = 0;
+
+    for (int i=0; i< NUM_ITER; ++i)
+    {
+        // Phases of mostly pushing and mostly popping, so the FIFO runs both
+        // full and empty
+        bool filling = ((i / 100) % 2 == 0);
+        unsigned max_pop = filling ? (rand() % 2) : NUM_POP;
+        if (max_pop > ref_q.size()) max_pop = ref_q.size();
+        PopMask pop_mask = semi_rand_mask(NUM_POP, max_pop);
+        unsigned num_pop = 0;
+        for (unsigned j = 0; j < NUM_POP; j++) num_pop += pop_mask[j];
+
+        unsigned max_push = filling ? NUM_PUSH : (rand() % 2);
+        unsigned room = FIFO_LENGTH - ref_q.size() + num_pop;
+        if (max_push > room) max_push = room;
+        PushMask push_mask = semi_rand_mask(NUM_PUSH, max_push);
+        if (ref_q.size() - num_pop + max_push == FIFO_LENGTH) full_pushes++;
+
+        DataType in[NUM_PUSH], out[NUM_POP], head[NUM_POP];
+        for (unsigned j = 0; j < NUM_PUSH; j++) in[j] = rand();
+        Count filled, free;
+        bool full;
+        CCS_DESIGN(MultiPortFifoTop)(in, push_mask, pop_mask, out, head, filled, free, full);
+
+        for (unsigned j = 0; j < NUM_POP; j++) {
+            if (pop_mask[j] == 1) {
+                assert(!ref_q.empty());
+                assert(out[j] == ref_q.front());
+                ref_q.pop_front();
+            }
+        }
+        for (unsigned j = 0; j < NUM_PUSH; j++) {
+            if (push_mask[j] == 1) {
+                ref_q.push_back(in[j]);
+            }
+        }
+        assert(ref_q.size() <= FIFO_LENGTH);
+        assert(filled == ref_q.size());
+        assert(free == FIFO_LENGTH - ref_q.size());
+        assert(full == (FIFO_LENGTH - ref_q.size() < NUM_PUSH));
+        for (unsigned j = 0; (j < NUM_POP) && (j < ref_q.size()); j++) {
+            assert(head[j] == ref_q[j]);
+        }
+    }
+    assert(full_pushes > 0);
+
+    DCOUT("CMODEL PASS" << endl);
+    CCS_RETURN(0) ;
+}
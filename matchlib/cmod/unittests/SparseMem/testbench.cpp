@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <match_scverify.h>
+#include <sparse_mem.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+typedef unsigned long long uint64;
+typedef ac_int<64, false> word_t;
+
+static const unsigned kPageBytes = 4096;
+
+uint64 align8(uint64 a) { return (a + 7) & ~7ULL; }
+
+unsigned char pattern(uint64 i) { return (unsigned char)((i * 7) ^ (i >> 8)); }
+
+std::vector<unsigned char> file_bytes(const char *name) {
+  std::ifstream in(name, std::ios::binary);
+  return std::vector<unsigned char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void write_file(const char *name, const std::vector<unsigned char> &bytes) {
+  std::ofstream out(name, std::ios::binary);
+  out.write((const char *)bytes.data(), bytes.size());
+}
+
+void check_bytes(sparse_mem &mem, uint64 addr, const unsigned char *expected, uint64 len) {
+  std::vector<unsigned char> got(len);
+  mem.read(addr, got.data(), len);
+  for (uint64 i = 0; i < len; i++) {
+    if (got[i] != expected[i]) {
+      printf("byte at %llx is %02x, expected %02x\n", addr + i, got[i], expected[i]);
+      assert(0);
+    }
+  }
+}
+
+// New pages are zero, or with fill_bytes hold their own word addresses as ram.h expects
+void test_fill() {
+  sparse_mem zero_mem;
+  assert(zero_mem.get<word_t>(0x1234560) == 0);
+
+  sparse_mem mem(12, 8);
+  assert(mem.pages_present() == 0);
+  assert(mem.get<word_t>(0) == 0);
+  assert(mem.get<word_t>(0x1008) == 0x1008);
+  assert(mem.get<word_t>(0xfffffff8ULL) == 0xfffffff8ULL);
+  assert(mem.get<word_t>(0x123456789000ULL) == 0x123456789000ULL);
+  assert(mem.pages_present() == 4);
+
+  unsigned char b;
+  mem.read(0x2009, &b, 1);
+  assert(b == 0x20);
+
+  // Whole and byte enabled writes, and a read across a page boundary
+  mem.set(0x3ffc, word_t(0x1122334455667788ULL));
+  assert(mem.get<word_t>(0x3ffc) == 0x1122334455667788ULL);
+  mem.set(0x5000, word_t(0xffffffffffffffffULL), ac_int<8, false>(0x0f));
+  assert(mem.get<word_t>(0x5000) == 0x00000000ffffffffULL);
+}
+
+// Pages fully covered by an image are mapped, the rest are copied. Writes to a
+// mapped page change the memory but not the file or other memories loaded from it.
+void test_binary() {
+  const char *name = "sparse_mem_test.bin";
+  std::vector<unsigned char> image(3 * kPageBytes + 100);
+  for (uint64 i = 0; i < image.size(); i++) { image[i] = pattern(i); }
+  write_file(name, image);
+
+  sparse_mem mem(12, 8);
+  assert(mem.load_binary(name, 0x10000));
+  assert(mem.load_binary(name, 0x20010));
+  assert(!mem.load_binary("sparse_mem_test_missing.bin", 0));
+  check_bytes(mem, 0x10000, image.data(), image.size());
+  check_bytes(mem, 0x20010, image.data(), image.size());
+
+  // The bytes around the unaligned image keep their fill
+  assert(mem.get<word_t>(0x20000) == 0x20000);
+  uint64 after = align8(0x20010 + image.size());
+  assert(mem.get<word_t>(after) == after);
+
+  mem.set(0x11000, word_t(0xdeadbeefcafef00dULL));
+  assert(mem.get<word_t>(0x11000) == 0xdeadbeefcafef00dULL);
+  check_bytes(mem, 0x11008, &image[kPageBytes + 8], kPageBytes - 8);
+
+  sparse_mem other;
+  assert(other.load_binary(name, 0x10000));
+  check_bytes(other, 0x10000, image.data(), image.size());
+  assert(file_bytes(name) == image);
+  remove(name);
+}
+
+template <class Ehdr, class Phdr>
+std::vector<unsigned char> make_elf(unsigned char elf_class, uint64 entry, uint64 paddr,
+                                    const std::vector<unsigned char> &data, uint64 memsz) {
+  Ehdr eh;
+  memset(&eh, 0, sizeof(eh));
+  memcpy(eh.e_ident, ELFMAG, SELFMAG);
+  eh.e_ident[EI_CLASS] = elf_class;
+  eh.e_ident[EI_DATA] = ELFDATA2LSB;
+  eh.e_ident[EI_VERSION] = EV_CURRENT;
+  eh.e_type = ET_EXEC;
+  eh.e_version = EV_CURRENT;
+  eh.e_entry = entry;
+  eh.e_phoff = sizeof(Ehdr);
+  eh.e_ehsize = sizeof(Ehdr);
+  eh.e_phentsize = sizeof(Phdr);
+  eh.e_phnum = 2;
+
+  // A note segment that must be skipped, then the loadable segment at a page
+  // aligned file offset so its full pages are mapped
+  Phdr ph[2];
+  memset(ph, 0, sizeof(ph));
+  ph[0].p_type = PT_NOTE;
+  ph[0].p_paddr = 0x1000;
+  ph[1].p_type = PT_LOAD;
+  ph[1].p_offset = kPageBytes;
+  ph[1].p_vaddr = paddr + 0x40000000;
+  ph[1].p_paddr = paddr;
+  ph[1].p_filesz = data.size();
+  ph[1].p_memsz = memsz;
+
+  std::vector<unsigned char> elf(kPageBytes + data.size());
+  memcpy(elf.data(), &eh, sizeof(eh));
+  memcpy(elf.data() + sizeof(eh), ph, sizeof(ph));
+  memcpy(elf.data() + kPageBytes, data.data(), data.size());
+  return elf;
+}
+
+// Segments load at their physical addresses, with the .bss part zeroed
+void test_elf() {
+  const char *name = "sparse_mem_test.elf";
+  std::vector<unsigned char> data(2 * kPageBytes + 300);
+  for (uint64 i = 0; i < data.size(); i++) { data[i] = pattern(i + 5); }
+  const uint64 memsz = data.size() + 5000;
+  std::vector<unsigned char> zeros(memsz - data.size(), 0);
+
+  write_file(name, make_elf<Elf64_Ehdr, Elf64_Phdr>(ELFCLASS64, 0x80000100ULL, 0x80000000ULL, data, memsz));
+  sparse_mem mem64(12, 8);
+  uint64_t entry = 0;
+  assert(mem64.load_elf(name, &entry));
+  assert(entry == 0x80000100ULL);
+  check_bytes(mem64, 0x80000000ULL, data.data(), data.size());
+  check_bytes(mem64, 0x80000000ULL + data.size(), zeros.data(), zeros.size());
+  uint64 after = align8(0x80000000ULL + memsz);
+  assert(mem64.get<word_t>(after) == after);
+  assert(mem64.get<word_t>(0x1000) == 0x1000);
+
+  mem64.set(0x80001000ULL, word_t(0x0123456789abcdefULL));
+  assert(mem64.get<word_t>(0x80001000ULL) == 0x0123456789abcdefULL);
+  check_bytes(mem64, 0x80000000ULL, data.data(), kPageBytes);
+
+  write_file(name, make_elf<Elf32_Ehdr, Elf32_Phdr>(ELFCLASS32, 0x2004, 0x2000, data, memsz));
+  sparse_mem mem32;
+  assert(mem32.load_elf(name, &entry));
+  assert(entry == 0x2004);
+  check_bytes(mem32, 0x2000, data.data(), data.size());
+  check_bytes(mem32, 0x2000 + data.size(), zeros.data(), zeros.size());
+
+  // Not an ELF file
+  write_file(name, data);
+  sparse_mem bad;
+  assert(!bad.load_elf(name));
+  assert(!bad.load_elf("sparse_mem_test_missing.elf"));
+  remove(name);
+}
+
+// dump() lists the pages present in address order in $readmemh format
+void test_dump() {
+  const char *name = "sparse_mem_test.hex";
+  sparse_mem mem;
+  unsigned char b[3] = {0xa5, 0x01, 0xff};
+  mem.write(0x300010, b, 3);
+  mem.write(0x1fff, b, 2);
+  assert(mem.pages_present() == 3);
+  assert(mem.dump(name));
+
+  std::ifstream in(name);
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(in, line)) { lines.push_back(line); }
+  remove(name);
+
+  const unsigned lines_per_page = 1 + kPageBytes / 16;
+  assert(lines.size() == 1 + 3 * lines_per_page);
+  assert(lines[0] == "// 3 pages of 4096 bytes");
+  assert(lines[1] == "@00001000");
+  assert(lines[1 + lines_per_page - 1] == "00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 a5");
+  assert(lines[1 + lines_per_page] == "@00002000");
+  assert(lines[2 + lines_per_page] == "01 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00");
+  assert(lines[1 + 2 * lines_per_page] == "@00300000");
+  assert(lines[3 + 2 * lines_per_page] == "a5 01 ff 00 00 00 00 00 00 00 00 00 00 00 00 00");
+}
+
+CCS_MAIN(int argc, char *argv[]) {
+  test_fill();
+  test_binary();
+  test_elf();
+  test_dump();
+
+  DCOUT("CMODEL PASS" << endl);
+  CCS_RETURN(0);
+}
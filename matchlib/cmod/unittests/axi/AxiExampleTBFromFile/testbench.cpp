@@ -24,7 +24,19 @@
 #include <testbench/nvhls_rand.h>
 
 // A simple AXI testbench example.  A Master and Slave are wired together
-// directly with no DUT in between.
+// directly with no DUT in between.  With TRACE_BINARY the CSV files are
+// converted to binary traces first, and the master keeps up to four requests
+// in flight.
+
+#ifdef TRACE_BINARY
+static const char* kMemFile = "mem.bin";
+static const char* kRequestsFile = "requests.bin";
+static const unsigned kMaxOutstanding = 4;
+#else
+static const char* kMemFile = "mem.csv";
+static const char* kRequestsFile = "requests.csv";
+static const unsigned kMaxOutstanding = 1;
+#endif
 
 SC_MODULE(testbench) {
 
@@ -40,8 +52,8 @@ SC_MODULE(testbench) {
   typename axi::axi4<axi::cfg::standard>::write::template chan<> axi_write;
 
   SC_CTOR(testbench)
-      : slave("slave", "mem.csv"),
-        master("master", "requests.csv"),
+      : slave("slave", kMemFile),
+        master("master", kRequestsFile, kMaxOutstanding),
         clk("clk", 1.0, SC_NS, 0.5, 0, SC_NS, true),
         reset_bar("reset_bar"),
         axi_read("axi_read"),
@@ -84,6 +96,11 @@ SC_MODULE(testbench) {
 
 int sc_main(int argc, char *argv[]) {
   nvhls::set_random_seed();
+#ifdef TRACE_BINARY
+  const int bytesPerWord = axi::axi4<axi::cfg::standard>::DATA_WIDTH >> 3;
+  AxiTraceWriter::convert("mem.csv", kMemFile, AxiTraceReader::Memory, bytesPerWord);
+  AxiTraceWriter::convert("requests.csv", kRequestsFile, AxiTraceReader::Requests, bytesPerWord);
+#endif
   testbench tb("tb");
   sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
   sc_start();
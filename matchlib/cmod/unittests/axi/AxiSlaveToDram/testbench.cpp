@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <systemc.h>
+#include <ac_reset_signal_is.h>
+
+#include <axi/axi4.h>
+#include <mc_scverify.h>
+#include <axi/testbench/Master.h>
+#include <axi/testbench/AxiSlaveToDram.h>
+#include <testbench/nvhls_rand.h>
+
+// Random AXI traffic from Masters against DRAM timed slaves: a DDR4 channel
+// with write strobes, and an HBM2 stack without.
+
+static const int kCapacity = 1 << 20;
+
+struct dramMasterCfg {
+  enum {
+    numWrites = 400,
+    numReads = 400,
+    readDelay = 0,
+    seed = 0,
+  };
+  static const uint64_t addrBoundLower = 0;
+  static const uint64_t addrBoundUpper = kCapacity - 1;
+};
+
+SC_MODULE(testbench) {
+  typedef axi::axi4<axi::cfg::standard> axi_;
+  typedef axi::axi4<axi::cfg::no_wstrb> axi_no_wstrb_;
+
+  AxiSlaveToDram<axi::cfg::standard, kCapacity> ddr4;
+  Master<axi::cfg::standard, dramMasterCfg> ddr4_master;
+  AxiSlaveToDram<axi::cfg::no_wstrb, kCapacity, 8, dram::cfg::hbm2> hbm2;
+  Master<axi::cfg::no_wstrb, dramMasterCfg> hbm2_master;
+
+  sc_clock clk;
+  sc_signal<bool> reset_bar;
+
+  sc_signal<bool> ddr4_done;
+  sc_signal<bool> hbm2_done;
+
+  axi_::read::template chan<> ddr4_read;
+  axi_::write::template chan<> ddr4_write;
+  axi_no_wstrb_::read::template chan<> hbm2_read;
+  axi_no_wstrb_::write::template chan<> hbm2_write;
+
+  SC_CTOR(testbench)
+      : ddr4("ddr4"),
+        ddr4_master("ddr4_master"),
+        hbm2("hbm2"),
+        hbm2_master("hbm2_master"),
+        clk("clk", 1.0, SC_NS, 0.5, 0, SC_NS, true),
+        reset_bar("reset_bar"),
+        ddr4_read("ddr4_read"),
+        ddr4_write("ddr4_write"),
+        hbm2_read("hbm2_read"),
+        hbm2_write("hbm2_write") {
+
+    Connections::set_sim_clk(&clk);
+
+    ddr4.clk(clk);
+    ddr4_master.clk(clk);
+    hbm2.clk(clk);
+    hbm2_master.clk(clk);
+
+    ddr4.reset_bar(reset_bar);
+    ddr4_master.reset_bar(reset_bar);
+    hbm2.reset_bar(reset_bar);
+    hbm2_master.reset_bar(reset_bar);
+
+    ddr4_master.if_rd(ddr4_read);
+    ddr4.if_rd(ddr4_read);
+    ddr4_master.if_wr(ddr4_write);
+    ddr4.if_wr(ddr4_write);
+
+    hbm2_master.if_rd(hbm2_read);
+    hbm2.if_rd(hbm2_read);
+    hbm2_master.if_wr(hbm2_write);
+    hbm2.if_wr(hbm2_write);
+
+    ddr4_master.done(ddr4_done);
+    hbm2_master.done(hbm2_done);
+
+    SC_THREAD(run);
+  }
+
+  template <class T>
+  void check(T& slave) {
+    slave.print_stats();
+    unsigned long long reads = 0, writes = 0;
+    for (unsigned c = 0; c < slave.dram_model.numChannels; c++) {
+      for (unsigned b = 0; b < slave.dram_model.numBanks; b++) {
+        reads += slave.dram_model.get_bank_stats(c, b).reads;
+        writes += slave.dram_model.get_bank_stats(c, b).writes;
+      }
+    }
+    // Every request has gone through the DRAM
+    if ((reads == 0) || (writes == 0) || (slave.dram_model.outstanding() != 0)) {
+      SC_REPORT_ERROR("testbench", "DRAM did not see the expected requests");
+    }
+  }
+
+  void run() {
+    reset_bar = 1;
+    wait(2, SC_NS);
+    reset_bar = 0;
+    wait(2, SC_NS);
+    reset_bar = 1;
+
+    while (1) {
+      wait(1, SC_NS);
+      if (ddr4_done && hbm2_done) {
+        check(ddr4);
+        check(hbm2);
+        sc_stop();
+      }
+    }
+  }
+};
+
+int sc_main(int argc, char *argv[]) {
+  nvhls::set_random_seed();
+  testbench tb("tb");
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+  sc_start();
+  bool rc = (sc_report_handler::get_count(SC_ERROR) > 0);
+  if (rc)
+    DCOUT("TESTBENCH FAIL" << endl);
+  else
+    DCOUT("TESTBENCH PASS" << endl);
+  return rc;
+};
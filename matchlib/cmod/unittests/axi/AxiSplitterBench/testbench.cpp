@@ -0,0 +1,508 @@
+/*
+ * Copyright (c) 2017-2019, NVIDIA CORPORATION.  All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <systemc.h>
+#include <ac_reset_signal_is.h>
+
+#include <axi/axi4.h>
+#include <mc_scverify.h>
+#include <axi/AxiSplitter.h>
+#include <testbench/nvhls_rand.h>
+
+#include <deque>
+#include <vector>
+#include <iomanip>
+
+#ifndef NUM_REQUESTS
+#define NUM_REQUESTS 2000
+#endif
+
+typedef axi::cfg::standard axiCfg;
+typedef axi::axi4<axiCfg> axi4_;
+
+enum {
+  numSlaves = 3,
+  numAddrBitsToInspect = 20,
+  numIds = 6,
+  burstLen = 2,
+  bytesPerBeat = axi4_::DATA_WIDTH >> 3,
+  slaveSize = 0x40000,  // bytes of each slave's address range
+};
+
+// Slave i answers after kLatency[i] cycles
+static const unsigned kLatency[numSlaves] = {8, 32, 64};
+
+// Data of the beat at addr
+typename axi4_::Data beat_data(sc_dt::uint64 addr) {
+  return (addr << 32) ^ (addr * 0x9e3779b1);
+}
+
+// Whether a write to the beat at addr fails. A write burst gets SLVERR if any
+// of its beats fails, so the master expects the same response whether or not
+// the splitter splits the burst.
+bool beat_fails(sc_dt::uint64 addr) {
+  return (((addr / bytesPerBeat) * 0x9e3779b1) >> 8) % 23 == 0;
+}
+
+// A pipelined slave: takes a request per cycle on AR and AW, and answers each
+// after a fixed latency. Checks that every beat it sees lies in its range.
+class LatencySlave : public sc_module {
+ public:
+  typename axi4_::read::template slave<> if_rd;
+  typename axi4_::write::template slave<> if_wr;
+  sc_in<bool> reset_bar;
+  sc_in<bool> clk;
+
+  const unsigned latency;
+  const sc_dt::uint64 lower, upper;
+
+  SC_HAS_PROCESS(LatencySlave);
+
+  LatencySlave(sc_module_name name, unsigned latency_, sc_dt::uint64 lower_)
+      : sc_module(name),
+        if_rd("if_rd"),
+        if_wr("if_wr"),
+        reset_bar("reset_bar"),
+        clk("clk"),
+        latency(latency_),
+        lower(lower_),
+        upper(lower_ + slaveSize - 1) {
+    SC_THREAD(run_rd);
+    sensitive << clk.pos();
+    async_reset_signal_is(reset_bar, false);
+
+    SC_THREAD(run_wr);
+    sensitive << clk.pos();
+    async_reset_signal_is(reset_bar, false);
+  }
+
+  void check_addr(sc_dt::uint64 addr) {
+    if ((addr < lower) || (addr > upper)) {
+      SC_REPORT_ERROR(name(), "Beat outside of the slave's address range");
+    }
+  }
+
+  void run_rd() {
+    if_rd.reset();
+    sc_dt::uint64 cycle = 0;
+    std::deque<std::pair<sc_dt::uint64, typename axi4_::ReadPayload> > beats;
+
+    while (1) {
+      wait();
+      cycle++;
+
+      typename axi4_::AddrPayload ar;
+      if (if_rd.nb_aread(ar)) {
+        sc_dt::uint64 addr = ar.addr.to_uint64();
+        for (unsigned i = 0; i <= ar.len.to_uint(); i++) {
+          check_addr(addr);
+          typename axi4_::ReadPayload r;
+          r.id = ar.id;
+          r.data = beat_data(addr);
+          r.resp = axi4_::Enc::XRESP::OKAY;
+          r.last = (i == ar.len.to_uint());
+          beats.push_back(std::make_pair(cycle + latency, r));
+          addr += bytesPerBeat;
+        }
+      }
+
+      if (!beats.empty() && (beats.front().first <= cycle)) {
+        if (if_rd.nb_rwrite(beats.front().second)) {
+          beats.pop_front();
+        }
+      }
+    }
+  }
+
+  void run_wr() {
+    if_wr.reset();
+    sc_dt::uint64 cycle = 0;
+    std::deque<typename axi4_::AddrPayload> requests;
+    unsigned beat = 0;
+    bool fails = false;
+    std::deque<std::pair<sc_dt::uint64, typename axi4_::WRespPayload> > responses;
+
+    while (1) {
+      wait();
+      cycle++;
+
+      typename axi4_::AddrPayload aw;
+      if (if_wr.aw.PopNB(aw)) {
+        requests.push_back(aw);
+      }
+
+      typename axi4_::WritePayload w;
+      if (!requests.empty() && if_wr.w.PopNB(w)) {
+        typename axi4_::AddrPayload& req = requests.front();
+        sc_dt::uint64 addr = req.addr.to_uint64() + beat * bytesPerBeat;
+        check_addr(addr);
+        fails |= beat_fails(addr);
+        if (w.data != beat_data(addr)) {
+          SC_REPORT_ERROR(name(), "Write data does not match its address");
+        }
+        bool last = (beat == req.len.to_uint());
+        if ((w.last == 1) != last) {
+          SC_REPORT_ERROR(name(), "Last write beat does not match the burst length");
+        }
+        if (last) {
+          typename axi4_::WRespPayload b;
+          b.id = req.id;
+          b.resp = fails ? axi4_::Enc::XRESP::SLVERR : axi4_::Enc::XRESP::OKAY;
+          responses.push_back(std::make_pair(cycle + latency, b));
+          requests.pop_front();
+          beat = 0;
+          fails = false;
+        } else {
+          beat++;
+        }
+      }
+
+      if (!responses.empty() && (responses.front().first <= cycle)) {
+        if (if_wr.nb_bwrite(responses.front().second)) {
+          responses.pop_front();
+        }
+      }
+    }
+  }
+};
+
+// Issues NUM_REQUESTS reads and NUM_REQUESTS writes of burstLen beats as fast
+// as they are accepted. ID i streams through the range of slave i % numSlaves;
+// one request in 16 goes to another slave instead, and one in 16 crosses into
+// the next slave's range. Checks the data and order of the responses per ID,
+// and that each write response carries the response of its whole request.
+class BenchMaster : public sc_module {
+ public:
+  typename axi4_::read::template master<> if_rd;
+  typename axi4_::write::template master<> if_wr;
+  sc_in<bool> reset_bar;
+  sc_in<bool> clk;
+
+  bool rd_done, wr_done;
+  sc_dt::uint64 rd_cycles, wr_cycles;
+
+  SC_HAS_PROCESS(BenchMaster);
+
+  BenchMaster(sc_module_name name)
+      : sc_module(name),
+        if_rd("if_rd"),
+        if_wr("if_wr"),
+        reset_bar("reset_bar"),
+        clk("clk"),
+        rd_done(false),
+        wr_done(false),
+        rd_cycles(0),
+        wr_cycles(0) {
+    SC_THREAD(run_rd);
+    sensitive << clk.pos();
+    async_reset_signal_is(reset_bar, false);
+
+    SC_THREAD(run_wr);
+    sensitive << clk.pos();
+    async_reset_signal_is(reset_bar, false);
+  }
+
+  // Address of request n with id, and the number of its beats in the first
+  // slave's range
+  static sc_dt::uint64 request_addr(unsigned n, unsigned id) {
+    const unsigned burstBytes = burstLen * bytesPerBeat;
+    unsigned slave = id % numSlaves;
+    sc_dt::uint64 offset = (sc_dt::uint64(n) * burstBytes) % slaveSize;
+    switch (rand() % 16) {
+      case 0:
+        slave = rand() % numSlaves;
+        break;
+      case 1:
+        if (slave < numSlaves - 1) {
+          offset = slaveSize - (1 + rand() % (burstLen - 1)) * bytesPerBeat;
+        }
+        break;
+    }
+    return sc_dt::uint64(slave) * slaveSize + offset;
+  }
+
+  void run_rd() {
+    if_rd.reset();
+    sc_dt::uint64 cycle = 0;
+    unsigned issued = 0, completed = 0;
+    std::vector<std::deque<sc_dt::uint64> > expected(numIds);
+    std::vector<unsigned> beat(numIds, 0);
+    typename axi4_::AddrPayload ar;
+    bool ar_valid = false;
+
+    while (1) {
+      wait();
+      cycle++;
+
+      if (!ar_valid && (issued < NUM_REQUESTS)) {
+        ar.id = issued % numIds;
+        ar.addr = request_addr(issued / numIds, issued % numIds);
+        ar.len = burstLen - 1;
+        ar_valid = true;
+      }
+      if (ar_valid && if_rd.ar.PushNB(ar)) {
+        expected[ar.id.to_uint()].push_back(ar.addr.to_uint64());
+        issued++;
+        ar_valid = false;
+      }
+
+      typename axi4_::ReadPayload r;
+      if (if_rd.r.PopNB(r)) {
+        unsigned id = r.id.to_uint();
+        if (expected[id].empty()) {
+          SC_REPORT_ERROR(name(), "Read response without a request");
+          continue;
+        }
+        sc_dt::uint64 addr = expected[id].front() + beat[id] * bytesPerBeat;
+        if (r.data != beat_data(addr)) {
+          SC_REPORT_ERROR(name(), "Read data out of order within an ID");
+        }
+        bool last = (beat[id] == burstLen - 1);
+        if ((r.last == 1) != last) {
+          SC_REPORT_ERROR(name(), "Last read beat does not match the burst length");
+        }
+        if (last) {
+          expected[id].pop_front();
+          beat[id] = 0;
+          if (++completed == NUM_REQUESTS) {
+            rd_cycles = cycle;
+            rd_done = true;
+          }
+        } else {
+          beat[id]++;
+        }
+      }
+    }
+  }
+
+  void run_wr() {
+    if_wr.reset();
+    sc_dt::uint64 cycle = 0;
+    unsigned issued = 0, completed = 0;
+    std::vector<std::deque<bool> > expected_fail(numIds);
+    std::deque<std::pair<sc_dt::uint64, bool> > data_q;  // write beats to send: address, last
+    typename axi4_::AddrPayload aw;
+    bool aw_valid = false;
+
+    while (1) {
+      wait();
+      cycle++;
+
+      if (!aw_valid && (issued < NUM_REQUESTS)) {
+        aw.id = issued % numIds;
+        aw.addr = request_addr(issued / numIds, issued % numIds);
+        aw.len = burstLen - 1;
+        aw_valid = true;
+      }
+      if (aw_valid && if_wr.aw.PushNB(aw)) {
+        bool fails = false;
+        for (unsigned i = 0; i < burstLen; i++) {
+          data_q.push_back(std::make_pair(aw.addr.to_uint64() + i * bytesPerBeat, i == burstLen - 1));
+          fails |= beat_fails(aw.addr.to_uint64() + i * bytesPerBeat);
+        }
+        expected_fail[aw.id.to_uint()].push_back(fails);
+        issued++;
+        aw_valid = false;
+      }
+
+      if (!data_q.empty()) {
+        typename axi4_::WritePayload w;
+        w.data = beat_data(data_q.front().first);
+        w.wstrb = ~0;
+        w.last = data_q.front().second;
+        if (if_wr.w.PushNB(w)) {
+          data_q.pop_front();
+        }
+      }
+
+      typename axi4_::WRespPayload b;
+      if (if_wr.b.PopNB(b)) {
+        unsigned id = b.id.to_uint();
+        if (expected_fail[id].empty()) {
+          SC_REPORT_ERROR(name(), "Write response without a request");
+          continue;
+        }
+        typename axi4_::Resp resp = expected_fail[id].front() ? axi4_::Enc::XRESP::SLVERR
+                                                              : axi4_::Enc::XRESP::OKAY;
+        if (b.resp != resp) {
+          SC_REPORT_ERROR(name(), "Write response does not match its request");
+        }
+        expected_fail[id].pop_front();
+        if (++completed == NUM_REQUESTS) {
+          wr_cycles = cycle;
+          wr_done = true;
+        }
+      }
+    }
+  }
+};
+
+// A master, an AxiSplitter allowing maxOutstanding requests per ID, and
+// numSlaves slaves of different latencies
+class BenchIf {
+ public:
+  virtual ~BenchIf() {}
+  virtual BenchMaster& get_master() = 0;
+  virtual int outstanding() = 0;
+};
+
+template <int maxOutstanding>
+class Bench : public sc_module, public BenchIf {
+ public:
+  sc_in<bool> clk;
+  sc_in<bool> reset_bar;
+
+  BenchMaster master;
+  AxiSplitter<axiCfg, numSlaves, numAddrBitsToInspect, false, false, maxOutstanding> axi_splitter;
+  std::vector<LatencySlave*> slave;
+
+  typename axi4_::read::template chan<> axi_read_m;
+  typename axi4_::write::template chan<> axi_write_m;
+  nvhls::nv_array<typename axi4_::read::template chan<>, numSlaves> axi_read_s;
+  nvhls::nv_array<typename axi4_::write::template chan<>, numSlaves> axi_write_s;
+  sc_signal<NVUINTW(numAddrBitsToInspect)> addrBound[numSlaves][2];
+
+  Bench(sc_module_name name)
+      : sc_module(name),
+        clk("clk"),
+        reset_bar("reset_bar"),
+        master("master"),
+        axi_splitter("axi_splitter"),
+        axi_read_m("axi_read_m"),
+        axi_write_m("axi_write_m"),
+        axi_read_s("axi_read_s"),
+        axi_write_s("axi_write_s") {
+    master.clk(clk);
+    master.reset_bar(reset_bar);
+    master.if_rd(axi_read_m);
+    master.if_wr(axi_write_m);
+    axi_splitter.clk(clk);
+    axi_splitter.reset_bar(reset_bar);
+    axi_splitter.axi_rd_m(axi_read_m);
+    axi_splitter.axi_wr_m(axi_write_m);
+
+    for (int i = 0; i < numSlaves; i++) {
+      slave.push_back(new LatencySlave(sc_gen_unique_name("slave"), kLatency[i], i * slaveSize));
+      slave[i]->clk(clk);
+      slave[i]->reset_bar(reset_bar);
+      slave[i]->if_rd(axi_read_s[i]);
+      slave[i]->if_wr(axi_write_s[i]);
+      axi_splitter.axi_rd_s_ar[i](axi_read_s[i].ar);
+      axi_splitter.axi_rd_s_r[i](axi_read_s[i].r);
+      axi_splitter.axi_wr_s_aw[i](axi_write_s[i].aw);
+      axi_splitter.axi_wr_s_w[i](axi_write_s[i].w);
+      axi_splitter.axi_wr_s_b[i](axi_write_s[i].b);
+      axi_splitter.addrBound[i][0](addrBound[i][0]);
+      axi_splitter.addrBound[i][1](addrBound[i][1]);
+      addrBound[i][0].write(i * slaveSize);
+      addrBound[i][1].write((i + 1) * slaveSize - 1);
+    }
+  }
+
+  BenchMaster& get_master() { return master; }
+  int outstanding() { return maxOutstanding; }
+};
+
+SC_MODULE(testbench) {
+ public:
+  sc_clock clk;
+  sc_signal<bool> reset_bar;
+
+  Bench<1> bench1;
+  Bench<4> bench4;
+  Bench<16> bench16;
+  std::vector<BenchIf*> benches;
+
+  SC_CTOR(testbench)
+      : clk("clk", 1.0, SC_NS, 0.5, 0, SC_NS, true),
+        reset_bar("reset_bar"),
+        bench1("bench1"),
+        bench4("bench4"),
+        bench16("bench16") {
+    Connections::set_sim_clk(&clk);
+
+    bench1.clk(clk);
+    bench1.reset_bar(reset_bar);
+    bench4.clk(clk);
+    bench4.reset_bar(reset_bar);
+    bench16.clk(clk);
+    bench16.reset_bar(reset_bar);
+    benches.push_back(&bench1);
+    benches.push_back(&bench4);
+    benches.push_back(&bench16);
+
+    SC_THREAD(run);
+  }
+
+  void run() {
+    reset_bar = 1;
+    wait(2, SC_NS);
+    reset_bar = 0;
+    wait(2, SC_NS);
+    reset_bar = 1;
+
+    bool done = false;
+    while (!done) {
+      wait(1, SC_NS);
+      done = true;
+      for (unsigned i = 0; i < benches.size(); i++) {
+        done &= benches[i]->get_master().rd_done && benches[i]->get_master().wr_done;
+      }
+      if (sc_time_stamp() > sc_time(1000.0 * NUM_REQUESTS, SC_NS)) {
+        SC_REPORT_ERROR("testbench", "Requests did not complete");
+        done = true;
+      }
+    }
+
+    // Bandwidth in beats per cycle out of the 1 of each direction of the
+    // master port
+    std::vector<double> rd_bw, wr_bw;
+    cout << NUM_REQUESTS << " reads and writes of " << burstLen << " beats over "
+         << numIds << " IDs, slave latencies";
+    for (int i = 0; i < numSlaves; i++) cout << " " << kLatency[i];
+    cout << endl;
+    cout << "  outstanding/ID  read beats/cycle  write beats/cycle" << endl;
+    for (unsigned i = 0; i < benches.size(); i++) {
+      BenchMaster& m = benches[i]->get_master();
+      rd_bw.push_back(double(NUM_REQUESTS * burstLen) / m.rd_cycles);
+      wr_bw.push_back(double(NUM_REQUESTS * burstLen) / m.wr_cycles);
+      cout << setw(16) << benches[i]->outstanding() << fixed << setprecision(3)
+           << setw(18) << rd_bw[i] << setw(19) << wr_bw[i] << endl;
+    }
+    for (unsigned i = 1; i < benches.size(); i++) {
+      if ((rd_bw[i] < 0.95 * rd_bw[i - 1]) || (wr_bw[i] < 0.95 * wr_bw[i - 1])) {
+        SC_REPORT_ERROR("testbench", "More outstanding requests lowered the bandwidth");
+      }
+    }
+    if ((rd_bw.back() < 2 * rd_bw.front()) || (wr_bw.back() < 2 * wr_bw.front())) {
+      SC_REPORT_ERROR("testbench", "Outstanding requests did not hide the slave latency");
+    }
+    sc_stop();
+  }
+};
+
+int sc_main(int argc, char *argv[]) {
+  nvhls::set_random_seed();
+  testbench tb("tb");
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+  sc_start();
+  bool rc = (sc_report_handler::get_count(SC_ERROR) > 0);
+  if (rc)
+    DCOUT("TESTBENCH FAIL" << endl);
+  else
+    DCOUT("TESTBENCH PASS" << endl);
+  return rc;
+};
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <match_scverify.h>
+#include <testbench/nvhls_rand.h>
+#include <axi/testbench/AxiTraceFile.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <ctime>
+#include <stdexcept>
+
+#ifndef NUM_RECORDS
+#define NUM_RECORDS 1000000
+#endif
+
+typedef unsigned long long uint64;
+
+struct Request {
+  unsigned delay;
+  char type;
+  uint64 addr;
+  std::vector<unsigned char> data;
+};
+
+void check_record(const AxiTraceRecord& rec, const Request& req, unsigned dataBytes) {
+  assert(rec.delay == req.delay);
+  assert(rec.type == req.type);
+  assert(rec.addr == req.addr);
+  for (unsigned i = 0; i < dataBytes; i++) {
+    unsigned char expected = (i < req.data.size()) ? req.data[i] : 0;
+    if (rec.data[i] != expected) {
+      printf("byte %u of %llx is %02x, expected %02x\n", i, req.addr, rec.data[i], expected);
+      assert(0);
+    }
+  }
+}
+
+// CSV corner cases: CRLF and blank lines, blanks around fields, with and
+// without 0x, upper and lower case, short and over-wide data
+void test_csv() {
+  {
+    std::ofstream f("trace_test.csv");
+    f << "0,W,0x10000,0xf00dcafe12345678\r\n"
+      << "\n"
+      << "100,R, 0x10000 ,F00DCAFE12345678\n"
+      << "\r\n"
+      << "7,R,abc,0x1\n"
+      << "3,Q,x,y\n"
+      << "0,W,0x0,0x0123456789abcdef0123456789abcdef";
+  }
+  Request reqs[5] = {
+      {0, 'W', 0x10000, {0x78, 0x56, 0x34, 0x12, 0xfe, 0xca, 0x0d, 0xf0}},
+      {100, 'R', 0x10000, {0x78, 0x56, 0x34, 0x12, 0xfe, 0xca, 0x0d, 0xf0}},
+      {7, 'R', 0xabc, {0x01}},
+      {3, 'Q', 0, {}},
+      {0, 'W', 0, {0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01,
+                   0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01}},
+  };
+
+  // The strings of readCSV
+  CSVFileReader reader("trace_test.csv");
+  std::vector<std::vector<std::string> > list = reader.readCSV();
+  assert(list.size() == 5);
+  assert(list[1].size() == 4);
+  assert((list[1][2] == " 0x10000 ") && (list[1][3] == "F00DCAFE12345678"));
+  assert(list[0][3] == "0xf00dcafe12345678");
+
+  // and the numbers of streaming, at 8 and 16 bytes
+  for (unsigned dataBytes = 8; dataBytes <= 16; dataBytes += 8) {
+    AxiTraceReader trace("trace_test.csv", AxiTraceReader::Requests, dataBytes);
+    assert(!trace.isBinary());
+    AxiTraceRecord rec;
+    for (unsigned i = 0; i < 5; i++) {
+      assert(trace.next(rec));
+      check_record(rec, reqs[i], dataBytes);
+    }
+    assert(!trace.next(rec));
+    assert(trace.count() == 5);
+  }
+
+  // Binary round trip, read back wider and narrower
+  assert(AxiTraceWriter::convert("trace_test.csv", "trace_test.bin", AxiTraceReader::Requests, 16) == 5);
+  for (unsigned dataBytes = 4; dataBytes <= 32; dataBytes *= 2) {
+    AxiTraceReader trace("trace_test.bin", AxiTraceReader::Requests, dataBytes);
+    assert(trace.isBinary());
+    AxiTraceRecord rec;
+    for (unsigned i = 0; i < 5; i++) {
+      assert(trace.next(rec));
+      Request req = reqs[i];
+      if (req.data.size() > 16) req.data.resize(16);
+      check_record(rec, req, dataBytes);
+    }
+    assert(!trace.next(rec));
+  }
+
+  // Memory traces
+  {
+    std::ofstream f("trace_test.csv");
+    f << "0x20000,0xFFFF0000CCCC8888\n0x1234FDEC,0x0000c18c18c18c18\n";
+  }
+  assert(AxiTraceWriter::convert("trace_test.csv", "trace_test.bin", AxiTraceReader::Memory, 8) == 2);
+  const char* files[2] = {"trace_test.csv", "trace_test.bin"};
+  for (unsigned f = 0; f < 2; f++) {
+    AxiTraceReader trace(files[f], AxiTraceReader::Memory, 8);
+    assert(trace.isBinary() == (f == 1));
+    AxiTraceRecord rec;
+    assert(trace.next(rec) && (rec.addr == 0x20000) && (rec.data[0] == 0x88) &&
+           (rec.data[7] == 0xff));
+    assert(trace.next(rec) && (rec.addr == 0x1234FDEC) && (rec.data[0] == 0x18) &&
+           (rec.data[7] == 0x00));
+    assert(!trace.next(rec));
+  }
+
+  // An empty file has no records
+  { std::ofstream f("trace_test.csv"); }
+  AxiTraceReader empty("trace_test.csv", AxiTraceReader::Requests, 8);
+  AxiTraceRecord rec;
+  assert(!empty.next(rec));
+}
+
+// Missing and malformed traces throw, whether or not NDEBUG is defined
+template <class F>
+bool throws(F f, const char* expected) {
+  try {
+    f();
+  } catch (const std::runtime_error& e) {
+    return std::string(e.what()).find(expected) != std::string::npos;
+  }
+  return false;
+}
+
+void test_errors() {
+  assert(throws([] { AxiTraceReader t("trace_test_missing.csv", AxiTraceReader::Requests, 8); },
+                "Cannot open trace file trace_test_missing.csv"));
+  assert(throws([] { CSVFileReader r("trace_test_missing.csv"); r.nextRecord(); },
+                "Cannot open CSV file trace_test_missing.csv"));
+
+  { std::ofstream f("trace_test.csv"); f << "0,W,0x10,0x1\n"; }
+  assert(AxiTraceWriter::convert("trace_test.csv", "trace_test.bin", AxiTraceReader::Requests, 8) == 1);
+  assert(throws([] { AxiTraceReader t("trace_test.bin", AxiTraceReader::Memory, 8); },
+                "holds the wrong kind of records"));
+
+  { std::ofstream f("trace_test.csv"); f << "0,W,0x10,0x1\n" << "1,R,0x1g,0x1\n"; }
+  assert(throws([] {
+    AxiTraceReader t("trace_test.csv", AxiTraceReader::Requests, 8);
+    AxiTraceRecord rec;
+    while (t.next(rec)) {}
+  }, "trace_test.csv:2: Invalid hex digit"));
+  assert(throws([] {
+    AxiTraceReader t("trace_test.csv", AxiTraceReader::Memory, 8);
+    AxiTraceRecord rec;
+    t.next(rec);
+  }, "trace_test.csv:1: Each memory entry must have two elements"));
+  remove("trace_test.csv");
+  remove("trace_test.bin");
+}
+
+double seconds(clock_t t0) { return double(clock() - t0) / CLOCKS_PER_SEC; }
+
+// Streams a trace of NUM_RECORDS random requests as CSV and as binary, and
+// checks every record
+void test_large() {
+  const unsigned dataBytes = 8;
+  nvhls::set_random_seed();
+  unsigned seed = rand();
+  {
+    srand(seed);
+    FILE* f = fopen("trace_test.csv", "w");
+    assert(f);
+    for (unsigned i = 0; i < NUM_RECORDS; i++) {
+      unsigned delay = rand() % 4;
+      uint64 addr = (uint64(rand()) << 3) & 0xffffffffULL;
+      uint64 data = (uint64(rand()) << 32) ^ rand();
+      fprintf(f, "%u,%c,0x%llx,0x%016llx\n", delay, (rand() & 1) ? 'R' : 'W', addr, data);
+    }
+    fclose(f);
+  }
+
+  const char* files[2] = {"trace_test.csv", "trace_test.bin"};
+  clock_t t0 = clock();
+  assert(AxiTraceWriter::convert(files[0], files[1], AxiTraceReader::Requests, dataBytes) == NUM_RECORDS);
+  printf("Converted %u requests in %.2fs\n", NUM_RECORDS, seconds(t0));
+
+  for (unsigned f = 0; f < 2; f++) {
+    srand(seed);
+    AxiTraceReader trace(files[f], AxiTraceReader::Requests, dataBytes);
+    AxiTraceRecord rec;
+    Request req;
+    req.data.resize(dataBytes);
+    t0 = clock();
+    for (unsigned i = 0; i < NUM_RECORDS; i++) {
+      req.delay = rand() % 4;
+      req.addr = (uint64(rand()) << 3) & 0xffffffffULL;
+      uint64 data = (uint64(rand()) << 32) ^ rand();
+      req.type = (rand() & 1) ? 'R' : 'W';
+      for (unsigned b = 0; b < dataBytes; b++) {
+        req.data[b] = data >> (8 * b);
+      }
+      assert(trace.next(rec));
+      check_record(rec, req, dataBytes);
+    }
+    assert(!trace.next(rec));
+    double s = seconds(t0);
+    std::ifstream in(files[f], std::ios::binary | std::ios::ate);
+    printf("%-6s %10lld bytes, %.2fs, %.3g requests/s\n", f ? "binary" : "CSV",
+           (long long)in.tellg(), s, (s > 0) ? (NUM_RECORDS / s) : 0);
+  }
+  remove(files[0]);
+  remove(files[1]);
+}
+
+CCS_MAIN(int argc, char *argv[]) {
+  test_csv();
+  test_errors();
+  test_large();
+
+  DCOUT("CMODEL PASS" << endl);
+  CCS_RETURN(0);
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <match_scverify.h>
+#include <testbench/nvhls_rand.h>
+#include <axi/testbench/DramModel.h>
+
+#include <vector>
+
+typedef unsigned long long uint64;
+
+// Small timings that are easy to add up; refresh is out of the way unless a
+// test asks for it
+template <int policy, int refreshInterval = 1000000>
+struct testCfg {
+  enum {
+    numChannels = 1,
+    numBanks = 4,
+    rowBytes = 1024,
+    busBytes = 16,
+    interleaveBytes = 256,
+    tRCD = 10,
+    tRP = 12,
+    tCL = 14,
+    tCWL = 8,
+    tRAS = 30,
+    tRRD = 2,
+    tFAW = 20,
+    tWR = 15,
+    tWTR = 6,
+    tRTW = 4,
+    tREFI = refreshInterval,
+    tRFC = 100,
+    queueDepth = 16,
+    starvationLimit = 200,
+    pagePolicy = policy,
+  };
+};
+
+typedef testCfg<dram::OpenPage> openCfg;
+typedef testCfg<dram::ClosedPage> closedCfg;
+
+// Address of row and bank with the test mapping (one channel, four 256-byte
+// chunks per row)
+uint64 addr_of(unsigned bank, unsigned row) {
+  return (uint64(row) * 4 + bank) * 1024;
+}
+
+// Cycles from issuing one request to the idle model until it completes
+template <class Model>
+unsigned latency(Model& m, bool write, uint64 addr, unsigned bytes) {
+  static uint64 tag = 0;
+  m.push(write, addr, bytes, ++tag);
+  for (unsigned cycles = 1; cycles < 10000; cycles++) {
+    m.tick();
+    uint64 done;
+    if (m.pop_done(done)) {
+      assert(done == tag);
+      assert(m.outstanding() == 0);
+      return cycles;
+    }
+  }
+  assert(0);
+  return 0;
+}
+
+template <class Model>
+void idle(Model& m, unsigned cycles) {
+  for (unsigned i = 0; i < cycles; i++) {
+    m.tick();
+  }
+}
+
+void check(const char* what, unsigned got, unsigned expected) {
+  if (got != expected) {
+    printf("%s: %u cycles, expected %u\n", what, got, expected);
+    assert(0);
+  }
+}
+
+void test_timing() {
+  typedef dram::DramModel<openCfg> Model;
+  Model m;
+
+  uint64 addr, done;
+  unsigned channel, bank;
+  m.map(addr_of(2, 7) + 300, channel, bank, addr);
+  assert((channel == 0) && (bank == 2) && (addr == 7));
+
+  // 64 bytes are 4 data cycles
+  check("read miss", latency(m, false, addr_of(0, 0), 64), 10 + 14 + 4);
+  check("read hit", latency(m, false, addr_of(0, 0) + 64, 64), 14 + 4);
+  check("write hit", latency(m, true, addr_of(0, 0) + 128, 64), 8 + 4);
+  idle(m, 50);
+  check("read conflict", latency(m, false, addr_of(0, 1), 64), 12 + 10 + 14 + 4);
+  // The row was opened 40 cycles ago and still has 10 cycles of tWR after the
+  // write data
+  check("write after open", latency(m, true, addr_of(0, 1), 64), 8 + 4);
+  check("conflict before tWR", latency(m, false, addr_of(0, 2), 64),
+        15 + 12 + 10 + 14 + 4);
+  // tRAS holds a row for 30 cycles after the activate; the miss took 28
+  check("other bank miss", latency(m, false, addr_of(1, 0), 64), 10 + 14 + 4);
+  check("conflict within tRAS", latency(m, false, addr_of(1, 1), 64),
+        2 + 12 + 10 + 14 + 4);
+  check("write miss", latency(m, true, addr_of(3, 0), 256), 10 + 8 + 16);
+
+  Model::BankStats s = m.get_bank_stats(0, 0);
+  assert((s.reads == 4) && (s.writes == 2) && (s.hits == 3) && (s.misses == 1) &&
+         (s.conflicts == 2));
+  s = m.get_bank_stats(0, 1);
+  assert((s.reads == 2) && (s.hits == 0) && (s.misses == 1) && (s.conflicts == 1));
+
+  // A piece per 256-byte chunk: 1024 bytes to an open row take 64 data cycles
+  check("row read", latency(m, false, addr_of(1, 1), 1024), 14 + 64);
+  // A burst across banks: the piece that hits goes first, and the activate of
+  // the other bank hides behind its data
+  check("two banks", latency(m, false, addr_of(2, 0) + 768, 512), 14 + 16 + 16);
+  assert(m.get_bank_stats(0, 2).misses == 1);
+  assert(m.get_bank_stats(0, 3).hits == 1);
+
+  // Read to write turnaround: the write data waits tRTW after the read data
+  m.push(false, addr_of(1, 1), 64, 100);
+  m.push(true, addr_of(1, 1) + 64, 64, 101);
+  unsigned cycles = 0;
+  uint64 turnarounds = m.get_channel_stats(0).turnarounds;
+  while (m.outstanding() > 0) {
+    m.tick();
+    cycles++;
+  }
+  assert(m.pop_done(done) && (done == 100));
+  assert(m.pop_done(done) && (done == 101));
+  check("read then write", cycles, 14 + 4 + 4 + 4);
+  // Write to read: the read data waits tWTR after the write data
+  m.push(true, addr_of(1, 1), 64, 102);
+  m.push(false, addr_of(1, 1) + 64, 64, 103);
+  cycles = 0;
+  while (m.outstanding() > 0) {
+    m.tick();
+    cycles++;
+  }
+  check("write then read", cycles, 8 + 4 + 6 + 4);
+  assert(m.get_channel_stats(0).turnarounds == turnarounds + 2);
+  while (m.pop_done(done)) {
+  }
+}
+
+void test_scheduling() {
+  typedef dram::DramModel<openCfg> Model;
+  Model m;
+  uint64 done;
+
+  // First ready: a younger hit to the open row goes before an older conflict
+  latency(m, false, addr_of(0, 0), 64);
+  idle(m, 50);
+  m.push(false, addr_of(0, 1), 64, 1);
+  m.push(false, addr_of(0, 0) + 64, 64, 2);
+  while (m.outstanding() > 0) {
+    m.tick();
+  }
+  assert(m.pop_done(done) && (done == 2));
+  assert(m.pop_done(done) && (done == 1));
+
+  // A row keeps getting hits, but the conflicting request gets its row once it
+  // is starvationLimit cycles old
+  m.push(false, addr_of(0, 2), 64, 3);
+  uint64 start = m.cycle();
+  uint64 tag = 10;
+  bool starved_done = false;
+  for (unsigned i = 0; (i < 2000) && !starved_done; i++) {
+    if (m.can_push(addr_of(0, 1), 64)) {
+      m.push(false, addr_of(0, 1) + 64 * (tag % 4), 64, tag);
+      tag++;
+    }
+    m.tick();
+    while (m.pop_done(done)) {
+      starved_done |= (done == 3);
+    }
+  }
+  assert(starved_done);
+  assert(m.cycle() - start < 200 + 100);
+  assert(m.cycle() - start > 200);
+
+  // Closed page: the second access to a row after the first completed misses
+  typedef dram::DramModel<closedCfg> Closed;
+  Closed c;
+  check("closed miss", latency(c, false, addr_of(0, 0), 64), 10 + 14 + 4);
+  idle(c, 50);
+  check("closed miss again", latency(c, false, addr_of(0, 0) + 64, 64), 10 + 14 + 4);
+  // but queued hits still hit before the row is closed
+  c.push(false, addr_of(1, 0), 64, 1);
+  c.push(false, addr_of(1, 0) + 64, 64, 2);
+  while (c.outstanding() > 0) {
+    c.tick();
+  }
+  while (c.pop_done(done)) {
+  }
+  // and a different row does not pay the precharge
+  idle(c, 50);
+  check("closed other row", latency(c, false, addr_of(1, 1), 64), 10 + 14 + 4);
+  Closed::BankStats s = c.get_bank_stats(0, 1);
+  assert((s.hits == 1) && (s.misses == 2) && (s.conflicts == 0));
+
+  // Refresh: at tREFI the open row is precharged, and the banks are then busy
+  // for tRFC
+  typedef dram::DramModel<testCfg<dram::OpenPage, 500> > Refreshed;
+  Refreshed r;
+  latency(r, false, addr_of(0, 0), 64);
+  idle(r, 500 - r.cycle());
+  check("during refresh", latency(r, false, addr_of(0, 0), 64), 12 + 100 + 10 + 14 + 4);
+  assert(r.get_channel_stats(0).refreshes == 1);
+  // The open row was closed by the refresh, which is a miss, not a conflict
+  assert(r.get_bank_stats(0, 0).misses == 2);
+}
+
+// Streams requests of bytes, keeping outstanding of them in flight, and
+// returns the bandwidth after warm-up
+template <class cfg>
+double stream(dram::DramModel<cfg>& m, const char* pattern, unsigned bytes,
+              unsigned outstanding, unsigned cycles) {
+  const uint64 span = uint64(1) << 30;
+  uint64 next = 0;
+  uint64 tag = 0, done;
+  unsigned in_flight = 0;
+  for (unsigned i = 0; i < cycles; i++) {
+    if (i == cycles / 10) {
+      m.reset_stats();
+    }
+    while (in_flight < outstanding) {
+      uint64 addr;
+      if (pattern[0] == 's') {
+        addr = next;
+        next = (next + bytes) % span;
+      } else {
+        addr = ((uint64(rand()) << 20) ^ rand()) % span / bytes * bytes;
+      }
+      if (!m.can_push(addr, bytes)) {
+        break;
+      }
+      bool write = (pattern[1] == 'w') || ((pattern[1] == 'm') && (rand() & 1));
+      m.push(write, addr, bytes, tag++);
+      in_flight++;
+    }
+    m.tick();
+    while (m.pop_done(done)) {
+      in_flight--;
+    }
+  }
+  return m.bandwidth() / m.peak_bandwidth();
+}
+
+template <class cfg>
+void bench(const char* name, bool print_stats = false) {
+  const unsigned bytes = 64;
+  const char* patterns[4] = {"sr", "sm", "rr", "rm"};
+  const char* pattern_names[4] = {"seq read", "seq mixed", "rand read", "rand mixed"};
+  printf("%-10s", name);
+  double eff[4], hit_rate[4];
+  for (unsigned p = 0; p < 4; p++) {
+    dram::DramModel<cfg> m;
+    eff[p] = stream(m, patterns[p], bytes, 16 * cfg::numChannels, 100000);
+    hit_rate[p] = m.row_hit_rate();
+    printf(" %-10s %5.2f/%4.2f", pattern_names[p], eff[p], hit_rate[p]);
+    if ((p == 3) && print_stats) {
+      printf("\n");
+      m.print_stats(std::cout);
+    }
+  }
+  printf("\n");
+  assert(eff[0] > 0.85);
+  assert(hit_rate[0] > 0.85);
+  assert(eff[1] < eff[0]);
+  assert(eff[2] < eff[0]);
+  assert(hit_rate[2] < 0.2);
+  // Random accesses need an activate each, at most four per tFAW
+  const unsigned data_cycles = (bytes + cfg::busBytes - 1) / cfg::busBytes;
+  assert(eff[2] < 4.0 * data_cycles / cfg::tFAW + 0.02);
+  assert(eff[3] <= eff[2] + 0.05);
+}
+
+CCS_MAIN(int argc, char *argv[]) {
+  nvhls::set_random_seed();
+  test_timing();
+  test_scheduling();
+
+  printf("Bandwidth (fraction of peak) / row hit rate of 64-byte requests, 16 per channel in flight\n");
+  bench<dram::cfg::ddr4_2400>("DDR4-2400", true);
+  bench<dram::cfg::hbm2>("HBM2");
+  bench<openCfg>("test open");
+  bench<closedCfg>("test close");
+
+  DCOUT("CMODEL PASS" << endl);
+  CCS_RETURN(0);
+}
@@ -21,15 +21,18 @@
 //
 // Revision History:
 //  1.2.0    - Initial version
+//           - Per-instance random streams, burst/gap stalls, stall sequence record/replay
 //
 //*****************************************************************************************
 
 #ifndef __CONNECTIONS__PACER_H__
 #define __CONNECTIONS__PACER_H__
 #include <cstdlib>
+#include <stdint.h>
+#include <string>
+#include <vector>
 
 // TODO: add operator+ that combindes two pacers
-// TODO: add a deterministic Pacer as well
 /**
  * \brief Class used to inject random stalls in testbench
  * \ingroup Pacer
@@ -79,6 +82,23 @@
 
 class Pacer
 {
+public:
+  // Stall distributions:
+  //   MARKOV     enter a stall with stall_prob, stay stalled with hold_stall_prob (default)
+  //   BURST_GAP  alternate gaps and stall bursts with lengths uniform in [min, max] cycles
+  enum distribution { MARKOV, BURST_GAP };
+
+  // Seed derived from a global seed and a name, eg. a port's hierarchical name, so that
+  // each instance gets its own stream independent of elaboration order.
+  static uint64_t stream_seed(uint64_t global_seed, const std::string &name) {
+    uint64_t h = 14695981039346656037ULL; // FNV-1a
+    for (unsigned i = 0; i < name.length(); i++) {
+      h ^= static_cast<unsigned char>(name[i]);
+      h *= 1099511628211ULL;
+    }
+    return splitmix64(global_seed ^ h);
+  }
+
 protected:
   static const int precision = 1000;
 
@@ -86,29 +106,145 @@ protected:
   int hold_stall_prob;
   bool stalled;
 
+  // Private xorshift64* stream, used once seed() has been called; otherwise rand()
+  bool use_stream;
+  uint64_t state;
+
+  distribution dist;
+  unsigned min_gap, max_gap, min_burst, max_burst;
+  unsigned remaining;
+  bool in_burst;
+
+  // Stall sequence as alternating run lengths, starting with a run of non-stalled tics
+  bool recording;
+  std::vector<uint32_t> runs;
+  bool replaying;
+  unsigned replay_idx;
+  uint32_t replay_left;
+
+  static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+
+  uint64_t next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+  }
+
+  unsigned uniform(unsigned lo, unsigned hi) {
+    if (hi <= lo) { return lo; }
+    unsigned r = use_stream ? static_cast<unsigned>(next() >> 32) : static_cast<unsigned>(rand());
+    return lo + r % (hi - lo + 1);
+  }
+
   virtual bool random(const int &prob) {
+    if (use_stream) {
+      return (static_cast<int>((next() >> 33) % (precision + 1)) < prob);
+    }
     return (rand() % (precision + 1) < prob);
   }
 
+  void record(bool s) {
+    if (runs.empty()) {
+      if (s) { runs.push_back(0); }
+      runs.push_back(1);
+    } else if (((runs.size() & 1) == 0) != s) {
+      // runs.size() even means the last run is a stall run
+      runs.push_back(1);
+    } else {
+      ++runs.back();
+    }
+  }
+
+  bool replay_tic() {
+    while ((replay_left == 0) && (replay_idx < runs.size())) {
+      replay_left = runs[replay_idx++];
+    }
+    if (replay_left == 0) { return false; }
+    --replay_left;
+    // run replay_idx-1 is a stall run when its index is odd
+    return ((replay_idx - 1) & 1) == 1;
+  }
+
 public:
   Pacer(const float &stall_prob_, const float &hold_stall_prob_)
     : stall_prob(stall_prob_ * static_cast<float>(precision)),
       hold_stall_prob(hold_stall_prob_ * static_cast<float>(precision)),
-      stalled(false) {}
+      stalled(false), use_stream(false), state(0),
+      dist(MARKOV), min_gap(0), max_gap(0), min_burst(0), max_burst(0), remaining(0), in_burst(true),
+      recording(false), replaying(false), replay_idx(0), replay_left(0) {}
 
   virtual ~Pacer() {}
 
-  virtual void reset() { stalled = false; }
+  virtual void reset() { stalled = false; remaining = 0; in_burst = true; }
 
   virtual void set_stall_prob(float &newProb) { stall_prob=(static_cast<float>(newProb) * precision); }
   virtual void set_hold_stall_prob(float &newProb) { hold_stall_prob=(static_cast<float>(newProb) * precision); }
 
+  // Draw from a private stream instead of rand()
+  void seed(uint64_t s) {
+    use_stream = true;
+    state = splitmix64(s);
+    if (state == 0) { state = 1; }
+  }
+
+  void seed(uint64_t global_seed, const std::string &name) { seed(stream_seed(global_seed, name)); }
+
+  // Pick stall_prob and hold_stall_prob in [0, 0.99], as the Connections ports do
+  void randomize_probs() {
+    stall_prob = static_cast<int>(uniform(0, 99)) * precision / 100;
+    hold_stall_prob = static_cast<int>(uniform(0, 99)) * precision / 100;
+  }
+
+  // Switch to BURST_GAP: gaps of [min_gap_, max_gap_] tics, then stalls of [min_burst_, max_burst_] tics
+  void set_burst_gap(unsigned min_gap_, unsigned max_gap_, unsigned min_burst_, unsigned max_burst_) {
+    dist = BURST_GAP;
+    min_gap = min_gap_;
+    max_gap = max_gap_;
+    min_burst = min_burst_;
+    max_burst = max_burst_;
+    reset();
+  }
+
+  void set_markov() { dist = MARKOV; }
+
+  // Stall sequence export/replay
+  void start_recording() { recording = true; runs.clear(); }
+  bool is_recording() const { return recording; }
+  const std::vector<uint32_t> &recorded_runs() const { return runs; }
+
+  // Replay run lengths (non-stalled first, then alternating); no stalls once exhausted
+  void replay(const std::vector<uint32_t> &runs_) {
+    runs = runs_;
+    recording = false;
+    replaying = true;
+    replay_idx = 0;
+    replay_left = 0;
+  }
+
   // return whether we should stall this cycle
   virtual bool tic() {
 #ifdef DISABLE_PACER
     return false;
 #endif
-    if (stalled) {
+    if (replaying) { return replay_tic(); }
+    if (dist == BURST_GAP) {
+      if (max_burst == 0) {
+        in_burst = false;
+        remaining = 1;
+      }
+      while (remaining == 0) {
+        in_burst = !in_burst;
+        remaining = in_burst ? uniform(min_burst, max_burst) : uniform(min_gap, max_gap);
+      }
+      --remaining;
+      stalled = in_burst;
+    } else if (stalled) {
       if (!random(hold_stall_prob)) {
         stalled = false;
       }
@@ -117,6 +253,7 @@ public:
         stalled = true;
       }
     }
+    if (recording) { record(stalled); }
     return stalled;
   }
 
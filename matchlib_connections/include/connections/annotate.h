@@ -20,6 +20,7 @@
 //
 // Revision History:
 //  1.2.0    - Fixed bug in pathname handling in annotate_design()
+//  1.2.1    - Write message width of each channel to output.json
 //
 //*****************************************************************************************
 
@@ -132,6 +133,13 @@ namespace Connections
         v_channel.AddMember("dest_name", v_dest_name, d.GetAllocator());
       }
 
+      // Message width, informational only (used by annotate_explore.h to count buffer bits)
+      if (! v_channel.HasMember("width")) {
+        rapidjson::Value v_width;
+        v_width.SetUint((*it)->msg_width());
+        v_channel.AddMember("width", v_width, d.GetAllocator());
+      }
+
       // Annotate based on the value.
       assert(v_latency.IsInt());
       assert(v_capacity.IsInt());
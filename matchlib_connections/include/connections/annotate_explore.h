@@ -0,0 +1,541 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// annotate_explore.h
+//
+// Latency/capacity design-space exploration on top of annotate_design().
+//
+// The explorer re-runs the simulation executable (same design, same workload, same
+// command line) in parallel child processes, one per design point. Each child runs in
+// its own directory containing a generated <base_name>.input.json, and writes the usual
+// <base_name>.output.json and a <base_name>.profile.json channel profile (see
+// connections_profile.h). From the per-channel stall statistics of the points on the
+// current Pareto front the explorer picks the channels to deepen (highest backpressure)
+// or shorten (capacity unused or largest buffers without backpressure) next, until the
+// simulation budget is spent.
+//
+// Throughput of a point is the number of channel transfers per clock cycle summed over
+// all profiled channels. Buffer bits is the sum over explored channels of capacity times
+// message width. Channels along the boundary of the annotated design (UNBOUND or
+// TLM_INTERFACE) are left as given. Channels annotated with a nonzero latency keep it and
+// have their capacity explored down to 1. Wire channels (latency 0) are deepened by
+// turning them into a latency 1 buffer.
+//
+// All points and the Pareto front of throughput vs. buffer bits are written to
+// <base_name>.explore.json, and the input.json of each point is kept in
+// <base_name>.explore/pNNNN/.
+//
+// Requires CONNECTIONS_ACCURATE_SIM, a POSIX host and RapidJSON.
+//
+// Example usage in sc_main()
+//
+//  Connections::annotate_explorer dse("testbench");
+//  if ((argc > 1) && (std::string(argv[1]) == "explore")) {
+//    if (dse.explore(argc, argv, 64)) { return 0; }  // returns false in the child processes
+//  }
+//  Testbench testbench("testbench");
+//  Connections::annotate_design(testbench);
+//  profile_hierarchy(&testbench, "testbench.profile.json");
+//  sc_start();
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__ANNOTATE_EXPLORE_H__
+#define __CONNECTIONS__ANNOTATE_EXPLORE_H__
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+#include <unistd.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "connections.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/istreamwrapper.h>
+
+namespace Connections
+{
+
+#ifdef CONNECTIONS_ACCURATE_SIM
+
+  class annotate_explorer
+  {
+  public:
+    struct channel {
+      std::string name;
+      std::string src_name;
+      std::string dest_name;
+      unsigned width;
+      int latency;       // latency of the baseline annotation
+      int min_capacity;
+      int max_capacity;
+      bool fixed;        // on the design boundary, not explored
+    };
+
+    struct design_point {
+      unsigned id;
+      std::string dir;
+      std::vector<int> capacity;
+      bool ok;
+      bool expanded;
+      bool pareto;
+      double throughput;
+      unsigned long long buffer_bits;
+      std::vector<double> backpressure;
+      std::vector<int> max_occupancy;
+
+      design_point() : id(0), ok(false), expanded(false), pareto(false), throughput(0), buffer_bits(0) {}
+    };
+
+    explicit annotate_explorer(const std::string &base_name_, const std::string &output_dir_ = "")
+      : base_name(base_name_)
+      , output_dir(output_dir_.empty() ? base_name_ + ".explore" : output_dir_)
+      , max_capacity(64)
+      , fanout(4) {}
+
+    // True in the simulations launched by explore()
+    static bool is_child() {
+      return getenv("CONN_ANNOTATE_EXPLORE_CHILD") != 0;
+    }
+
+    // Upper bound on the capacity of any explored channel
+    void set_max_capacity(int c) { max_capacity = c; }
+
+    // Number of bottleneck channels deepened individually per expanded point
+    void set_fanout(unsigned f) { fanout = f; }
+
+    /**
+     * \brief Explore channel capacities of the design simulated by this executable.
+     *
+     * \param argc, argv  Command line of the executable, passed on to each simulation.
+     * \param budget      Maximum number of simulations, including the baseline.
+     * \param jobs        Number of simulations run in parallel (default: online cpus).
+     *
+     * \return false in the child simulations, which should go on to build and simulate
+     *         the design, true in the exploring process once the report is written.
+     */
+    bool explore(int argc, char **argv, unsigned budget, unsigned jobs = 0) {
+      if (is_child()) { return false; }
+
+      if (jobs == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = (n > 0) ? n : 1;
+      }
+      exe = executable_path(argv[0]);
+      args.assign(argv, argv + argc);
+      ::mkdir(output_dir.c_str(), 0777);
+
+      // Baseline: run with the input.json of the working directory as is
+      points.push_back(design_point());
+      launch(points[0], true);
+      collect_one();
+      if (!points[0].ok || channels.empty()) {
+        std::cerr << "Error: annotate_explorer baseline simulation failed, see "
+                  << points[0].dir << "/sim.log" << std::endl;
+        return true;
+      }
+
+      while (true) {
+        while ((running.size() < jobs) && (points.size() < budget)) {
+          if (candidates.empty()) { expand(); }
+          if (candidates.empty()) { break; }
+          design_point p;
+          p.id = points.size();
+          p.capacity = candidates.front();
+          candidates.erase(candidates.begin());
+          points.push_back(p);
+          launch(points.back(), false);
+        }
+        if (running.empty()) { break; }
+        collect_one();
+      }
+
+      mark_pareto();
+      write_report(base_name + ".explore.json");
+      print_front();
+      return true;
+    }
+
+    const std::vector<channel> &get_channels() const { return channels; }
+    const std::vector<design_point> &get_points() const { return points; }
+
+  private:
+    std::string base_name;
+    std::string output_dir;
+    int max_capacity;
+    unsigned fanout;
+
+    std::string exe;
+    std::vector<std::string> args;
+    std::vector<channel> channels;
+    std::vector<design_point> points;
+    std::vector<std::vector<int> > candidates;
+    std::set<std::string> seen;
+    std::map<pid_t, unsigned> running;
+
+    static std::string executable_path(const char *argv0) {
+      char buf[PATH_MAX];
+      ssize_t n = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+      if (n > 0) { buf[n] = 0; return buf; }
+      if (realpath(argv0, buf)) { return buf; }
+      return argv0;
+    }
+
+    static std::string key(const std::vector<int> &capacity) {
+      std::ostringstream os;
+      for (unsigned i=0; i < capacity.size(); i++) { os << capacity[i] << ","; }
+      return os.str();
+    }
+
+    int latency_of(unsigned i, int capacity) const {
+      if (channels[i].latency > 0) { return channels[i].latency; }
+      return (capacity > 0) ? 1 : 0;
+    }
+
+    unsigned long long buffer_bits(const std::vector<int> &capacity) const {
+      unsigned long long bits = 0;
+      for (unsigned i=0; i < channels.size(); i++) {
+        if (!channels[i].fixed) { bits += static_cast<unsigned long long>(capacity[i]) * channels[i].width; }
+      }
+      return bits;
+    }
+
+    void add_candidate(const std::vector<int> &capacity) {
+      if (seen.insert(key(capacity)).second) { candidates.push_back(capacity); }
+    }
+
+    //------------------------------------------------------------------------
+    // Simulation processes
+
+    void launch(design_point &p, bool baseline) {
+      std::ostringstream dir;
+      dir << output_dir << "/p" << std::setw(4) << std::setfill('0') << p.id;
+      p.dir = dir.str();
+      ::mkdir(p.dir.c_str(), 0777);
+
+      std::string input = p.dir + "/" + base_name + ".input.json";
+      if (baseline) {
+        std::ifstream src((base_name + ".input.json").c_str(), std::ios::binary);
+        if (src) {
+          std::ofstream dst(input.c_str(), std::ios::binary);
+          dst << src.rdbuf();
+        } else {
+          std::remove(input.c_str());
+        }
+      } else {
+        write_input(p, input);
+      }
+
+      std::cout.flush();
+      pid_t pid = fork();
+      if (pid == 0) {
+        std::vector<char *> cargv;
+        for (unsigned i=0; i < args.size(); i++) { cargv.push_back(const_cast<char *>(args[i].c_str())); }
+        cargv.push_back(0);
+        if ((chdir(p.dir.c_str()) != 0) ||
+            !freopen("sim.log", "w", stdout) || !freopen("sim.log", "a", stderr)) { _exit(127); }
+        setenv("CONN_ANNOTATE_EXPLORE_CHILD", "1", 1);
+        execv(exe.c_str(), &cargv[0]);
+        _exit(127);
+      }
+      if (pid < 0) {
+        std::cerr << "Error: annotate_explorer cannot fork simulation " << p.dir << std::endl;
+        return;
+      }
+      running[pid] = p.id;
+    }
+
+    void collect_one() {
+      int status = 0;
+      pid_t pid = waitpid(-1, &status, 0);
+      if (pid < 0) { running.clear(); return; }
+      std::map<pid_t, unsigned>::iterator it = running.find(pid);
+      if (it == running.end()) { return; }
+      design_point &p = points[it->second];
+      running.erase(it);
+
+      p.ok = WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+      if (p.ok && (p.id == 0)) { p.ok = read_baseline(p); }
+      if (p.ok) { p.ok = read_profile(p); }
+      std::cout << "Info: annotate_explorer " << p.dir << (p.ok ? "" : " FAILED")
+                << " throughput " << p.throughput << " buffer_bits " << p.buffer_bits << std::endl;
+    }
+
+    //------------------------------------------------------------------------
+    // JSON input and output
+
+    static bool parse(const std::string &fname, rapidjson::Document &d) {
+      std::ifstream ifs(fname.c_str());
+      if (ifs.fail()) { return false; }
+      rapidjson::IStreamWrapper isw(ifs);
+      d.ParseStream(isw);
+      return !d.HasParseError() && d.IsObject();
+    }
+
+    // Channel list, widths and starting annotation from the output.json of the baseline
+    bool read_baseline(design_point &p) {
+      rapidjson::Document d;
+      if (!parse(p.dir + "/" + base_name + ".output.json", d) || !d.HasMember("channels")) { return false; }
+      const rapidjson::Value &v_channels = d["channels"];
+      for (rapidjson::Value::ConstMemberIterator it = v_channels.MemberBegin(); it != v_channels.MemberEnd(); ++it) {
+        const rapidjson::Value &v = it->value;
+        channel c;
+        c.name = it->name.GetString();
+        c.src_name = v.HasMember("src_name") ? v["src_name"].GetString() : "";
+        c.dest_name = v.HasMember("dest_name") ? v["dest_name"].GetString() : "";
+        c.width = v.HasMember("width") ? v["width"].GetUint() : 0;
+        c.latency = v["latency"].GetInt();
+        c.fixed = (c.src_name == "UNBOUND") || (c.dest_name == "UNBOUND") ||
+                  (c.src_name == "TLM_INTERFACE") || (c.dest_name == "TLM_INTERFACE");
+        c.min_capacity = (c.latency > 0) ? 1 : 0;
+        c.max_capacity = std::max(max_capacity, v["capacity"].GetInt());
+        channels.push_back(c);
+        p.capacity.push_back(v["capacity"].GetInt());
+      }
+      seen.insert(key(p.capacity));
+      return true;
+    }
+
+    // Throughput and per-channel stall statistics from the profile of a point
+    bool read_profile(design_point &p) {
+      rapidjson::Document d;
+      if (!parse(p.dir + "/" + base_name + ".profile.json", d) || !d.HasMember("channels")) { return false; }
+      p.backpressure.assign(channels.size(), 0.0);
+      p.max_occupancy.assign(channels.size(), 0);
+      unsigned long long transfers = 0, cycles = 0;
+      const rapidjson::Value &v_channels = d["channels"];
+      for (rapidjson::SizeType r=0; r < v_channels.Size(); r++) {
+        const rapidjson::Value &v = v_channels[r];
+        transfers += v["transfers"].GetUint64();
+        cycles = std::max(cycles, static_cast<unsigned long long>(v["cycles"].GetUint64()));
+        std::string name = v["name"].GetString();
+        for (unsigned i=0; i < channels.size(); i++) {
+          const std::string &n = channels[i].name;
+          if ((name == n) || ((name.length() > n.length()) &&
+                              (name.compare(name.length() - n.length(), n.length(), n) == 0) &&
+                              (name[name.length() - n.length() - 1] == '.'))) {
+            p.backpressure[i] = v["backpressure"].GetDouble();
+            p.max_occupancy[i] = v["occupancy"]["max"].GetInt();
+          }
+        }
+      }
+      p.throughput = cycles ? static_cast<double>(transfers) / cycles : 0.0;
+      p.buffer_bits = buffer_bits(p.capacity);
+      return true;
+    }
+
+    void write_input(const design_point &p, const std::string &fname) const {
+      rapidjson::Document d;
+      d.SetObject();
+      rapidjson::Document::AllocatorType &a = d.GetAllocator();
+      rapidjson::Value v_channels(rapidjson::kObjectType);
+      for (unsigned i=0; i < channels.size(); i++) {
+        rapidjson::Value v(rapidjson::kObjectType);
+        v.AddMember("latency", latency_of(i, p.capacity[i]), a);
+        v.AddMember("capacity", p.capacity[i], a);
+        v.AddMember("src_name", rapidjson::Value(channels[i].src_name.c_str(), a), a);
+        v.AddMember("dest_name", rapidjson::Value(channels[i].dest_name.c_str(), a), a);
+        v_channels.AddMember(rapidjson::Value(channels[i].name.c_str(), a), v, a);
+      }
+      d.AddMember("channels", v_channels, a);
+      std::ofstream ofs(fname.c_str());
+      rapidjson::OStreamWrapper osw(ofs);
+      rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(osw);
+      d.Accept(writer);
+    }
+
+    void write_report(const std::string &fname) const {
+      rapidjson::Document d;
+      d.SetObject();
+      rapidjson::Document::AllocatorType &a = d.GetAllocator();
+
+      rapidjson::Value v_points(rapidjson::kArrayType);
+      rapidjson::Value v_front(rapidjson::kArrayType);
+      std::vector<unsigned> front = pareto_order();
+      for (unsigned i=0; i < front.size(); i++) { v_front.PushBack(front[i], a); }
+
+      for (unsigned k=0; k < points.size(); k++) {
+        const design_point &p = points[k];
+        rapidjson::Value v(rapidjson::kObjectType);
+        v.AddMember("id", p.id, a);
+        v.AddMember("dir", rapidjson::Value(p.dir.c_str(), a), a);
+        v.AddMember("ok", p.ok, a);
+        v.AddMember("pareto", p.pareto, a);
+        v.AddMember("throughput", p.throughput, a);
+        v.AddMember("buffer_bits", static_cast<uint64_t>(p.buffer_bits), a);
+        rapidjson::Value v_channels(rapidjson::kObjectType);
+        for (unsigned i=0; (i < channels.size()) && (i < p.capacity.size()); i++) {
+          rapidjson::Value v_c(rapidjson::kObjectType);
+          v_c.AddMember("latency", latency_of(i, p.capacity[i]), a);
+          v_c.AddMember("capacity", p.capacity[i], a);
+          if (i < p.backpressure.size()) { v_c.AddMember("backpressure", p.backpressure[i], a); }
+          v_channels.AddMember(rapidjson::Value(channels[i].name.c_str(), a), v_c, a);
+        }
+        v.AddMember("channels", v_channels, a);
+        v_points.PushBack(v, a);
+      }
+      d.AddMember("pareto", v_front, a);
+      d.AddMember("points", v_points, a);
+
+      std::ofstream ofs(fname.c_str());
+      if (!ofs.is_open()) {
+        std::cerr << "Cannot open file '" << fname << "'" << std::endl;
+        return;
+      }
+      rapidjson::OStreamWrapper osw(ofs);
+      rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(osw);
+      d.Accept(writer);
+    }
+
+    void print_front() const {
+      std::vector<unsigned> front = pareto_order();
+      std::cout << "Info: annotate_explorer ran " << points.size() << " simulations, Pareto front in "
+                << base_name << ".explore.json:" << std::endl;
+      std::cout << "  " << std::setw(12) << "buffer_bits" << std::setw(12) << "throughput" << "  input.json" << std::endl;
+      for (unsigned i=0; i < front.size(); i++) {
+        const design_point &p = points[front[i]];
+        std::cout << "  " << std::setw(12) << p.buffer_bits << std::setw(12) << p.throughput
+                  << "  " << p.dir << "/" << base_name << ".input.json" << std::endl;
+      }
+    }
+
+    //------------------------------------------------------------------------
+    // Search
+
+    static bool dominates(const design_point &a, const design_point &b) {
+      return (a.throughput >= b.throughput) && (a.buffer_bits <= b.buffer_bits) &&
+             ((a.throughput > b.throughput) || (a.buffer_bits < b.buffer_bits));
+    }
+
+    void mark_pareto() {
+      for (unsigned i=0; i < points.size(); i++) {
+        points[i].pareto = points[i].ok;
+        for (unsigned j=0; points[i].pareto && (j < points.size()); j++) {
+          if (points[j].ok && dominates(points[j], points[i])) { points[i].pareto = false; }
+        }
+      }
+    }
+
+    // Pareto points ordered by increasing buffer bits
+    std::vector<unsigned> pareto_order() const {
+      std::vector<unsigned> front;
+      for (unsigned i=0; i < points.size(); i++) {
+        if (points[i].pareto) { front.push_back(i); }
+      }
+      std::stable_sort(front.begin(), front.end(), [this](unsigned a, unsigned b) {
+        return points[a].buffer_bits < points[b].buffer_bits;
+      });
+      return front;
+    }
+
+    // Generate neighbours of the not yet expanded points on the current front
+    void expand() {
+      mark_pareto();
+      std::vector<unsigned> front = pareto_order();
+      for (unsigned k=0; (k < front.size()) && candidates.empty(); k++) {
+        design_point &p = points[front[k]];
+        if (p.expanded) { continue; }
+        p.expanded = true;
+        neighbours(p);
+      }
+    }
+
+    void neighbours(const design_point &p) {
+      std::vector<unsigned> order;
+      for (unsigned i=0; i < channels.size(); i++) {
+        if (!channels[i].fixed) { order.push_back(i); }
+      }
+      std::stable_sort(order.begin(), order.end(), [&p](unsigned a, unsigned b) {
+        return p.backpressure[a] > p.backpressure[b];
+      });
+
+      // Deepen the channels holding back their producers, one at a time and all together
+      std::vector<int> all = p.capacity;
+      unsigned deepened = 0;
+      for (unsigned k=0; k < order.size(); k++) {
+        unsigned i = order[k];
+        if ((p.backpressure[i] <= 0.0) || (p.capacity[i] >= channels[i].max_capacity)) { continue; }
+        int c = std::min(channels[i].max_capacity, p.capacity[i] + std::max(1, p.capacity[i] / 2));
+        all[i] = c;
+        if (deepened++ < fanout) {
+          std::vector<int> n = p.capacity;
+          n[i] = c;
+          add_candidate(n);
+        }
+      }
+      if (deepened > 1) { add_candidate(all); }
+
+      // Trim capacity the workload never used
+      std::vector<int> trim = p.capacity;
+      for (unsigned k=0; k < order.size(); k++) {
+        unsigned i = order[k];
+        trim[i] = std::max(channels[i].min_capacity, std::min(p.capacity[i], p.max_occupancy[i]));
+      }
+      add_candidate(trim);
+
+      // Shorten the largest buffers that see no backpressure
+      std::vector<unsigned> by_bits;
+      for (unsigned k=0; k < order.size(); k++) {
+        unsigned i = order[k];
+        if ((p.backpressure[i] <= 0.0) && (p.capacity[i] > channels[i].min_capacity)) { by_bits.push_back(i); }
+      }
+      std::stable_sort(by_bits.begin(), by_bits.end(), [this, &p](unsigned a, unsigned b) {
+        return p.capacity[a] * channels[a].width > p.capacity[b] * channels[b].width;
+      });
+      for (unsigned k=0; (k < by_bits.size()) && (k < 2); k++) {
+        unsigned i = by_bits[k];
+        std::vector<int> n = p.capacity;
+        n[i] = std::max(channels[i].min_capacity, p.capacity[i] - std::max(1, p.capacity[i] / 2));
+        add_candidate(n);
+      }
+    }
+  };
+
+#else
+
+  class annotate_explorer
+  {
+  public:
+    explicit annotate_explorer(const std::string &base_name_, const std::string &output_dir_ = "") {}
+    static bool is_child() { return false; }
+    void set_max_capacity(int c) {}
+    void set_fanout(unsigned f) {}
+    bool explore(int argc, char **argv, unsigned budget, unsigned jobs = 0) {
+      std::cerr << "WARNING: Cannot explore annotations unless running in sim accurate mode!" << std::endl;
+      return false;
+    }
+  };
+
+#endif
+
+}  // namespace Connections
+
+#endif // __CONNECTIONS__ANNOTATE_EXPLORE_H__
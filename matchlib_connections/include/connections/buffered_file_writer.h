@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// Double-buffered binary file writer, shared by the binary log writers
+// (channel_log_writer in connections_binlog.h and the toolkit's mem_log_writer)
+//
+// Callers reserve() space for each record in a fill buffer. A full fill buffer is handed
+// off to a background thread that writes it to disk while the other buffer fills, so the
+// simulation thread only blocks on I/O when the flush thread falls a whole buffer behind.
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__BUFFERED_FILE_WRITER_H__
+#define __CONNECTIONS__BUFFERED_FILE_WRITER_H__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Connections
+{
+
+  class buffered_file_writer
+  {
+  public:
+    buffered_file_writer()
+      : fp(0), fill_pos(0), flush_len(0), flush_pending(false), quit(false) {}
+
+    ~buffered_file_writer() { close(); }
+
+    bool is_open() const { return fp != 0; }
+
+    // buffer_bytes is the size of each of the two buffers
+    bool open(const std::string &name, size_t buffer_bytes = (4 << 20)) {
+      close();
+      fp = std::fopen(name.c_str(), "wb");
+      if (!fp) {
+        std::cerr << "Cannot open file '" << name << "'" << std::endl;
+        return false;
+      }
+
+      fill_buf.resize(buffer_bytes);
+      flush_buf.resize(buffer_bytes);
+      fill_pos = 0;
+      quit = false;
+      flush_pending = false;
+      flusher = std::thread(&buffered_file_writer::flush_thread, this);
+      return true;
+    }
+
+    // Writes out what is buffered and closes the file
+    void close() {
+      if (!fp) { return; }
+      hand_off();
+      {
+        std::unique_lock<std::mutex> lk(mtx);
+        cv_done.wait(lk, [this] { return !flush_pending; });
+        quit = true;
+      }
+      cv_work.notify_one();
+      flusher.join();
+      std::fclose(fp);
+      fp = 0;
+    }
+
+    // Space for the next n bytes of the file, valid until the next reserve() or close()
+    char *reserve(size_t n) {
+      if (fill_pos + n > fill_buf.size()) {
+        hand_off();
+        if (n > fill_buf.size()) { fill_buf.resize(n); }
+      }
+      char *p = &fill_buf[fill_pos];
+      fill_pos += n;
+      return p;
+    }
+
+  private:
+    std::FILE *fp;
+
+    std::vector<char> fill_buf;
+    std::vector<char> flush_buf;
+    size_t fill_pos;
+    size_t flush_len;
+    bool flush_pending;
+    bool quit;
+    std::thread flusher;
+    std::mutex mtx;
+    std::condition_variable cv_work;
+    std::condition_variable cv_done;
+
+    // Swap the fill buffer with the flush buffer once the flush thread is idle
+    void hand_off() {
+      if (fill_pos == 0) { return; }
+      {
+        std::unique_lock<std::mutex> lk(mtx);
+        cv_done.wait(lk, [this] { return !flush_pending; });
+        fill_buf.swap(flush_buf);
+        if (fill_buf.size() < flush_buf.size()) { fill_buf.resize(flush_buf.size()); }
+        flush_len = fill_pos;
+        fill_pos = 0;
+        flush_pending = true;
+      }
+      cv_work.notify_one();
+    }
+
+    void flush_thread() {
+      std::unique_lock<std::mutex> lk(mtx);
+      while (1) {
+        cv_work.wait(lk, [this] { return quit || flush_pending; });
+        if (flush_pending) {
+          lk.unlock();
+          std::fwrite(&flush_buf[0], 1, flush_len, fp);
+          lk.lock();
+          flush_pending = false;
+          cv_done.notify_one();
+        } else if (quit) {
+          return;
+        }
+      }
+    }
+  };
+
+}  // namespace Connections
+
+#endif  // __CONNECTIONS__BUFFERED_FILE_WRITER_H__
@@ -100,6 +100,13 @@
 #define HAS_SC_RESET_API
 #endif
 #include "Pacer.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #endif
 
 /**
@@ -155,7 +162,7 @@ namespace Connections
 //  SYN_PORT - Marshalled and never includes ConManager.
 //  MARSHALL_PORT - Marshalled and uses ConManager if not synthesis.
 //  DIRECT_PORT - Marshaller disabled and no type conversion needed at interfaces, uses ConManager.
-//  TLM_PORT - Like DIRECT_PORT, but interchange is through tlm_fifo. Event-based, does not use ConManager.
+//  TLM_PORT - Like DIRECT_PORT, but interchange is through tlm_fifo (or handoff_fifo with CONNECTIONS_TLM_HANDOFF). Event-based, does not use ConManager.
 //
 //  AUTO_PORT - TLM for normal SystemC and cosimulation (except binding to wrappers). SYN during HLS to present correct bit order.
   enum connections_port_t {SYN_PORT = 0, MARSHALL_PORT = 1, DIRECT_PORT = 2, TLM_PORT=3};
@@ -175,8 +182,11 @@ namespace Connections
    *   - DIRECT_PORT: Like MARSHALL_PORT, except without marshalling of msg ports into sc_lv bitvector, to save
    *     on simulation time.
    *   - TLM_PORT: rdy/val/msg ports do not exist, instead a shared tlm_fifo is used for each channel and simulation is
-   *     event-based through an evaluate <-> update delta cycle loop. Best performance, but not cycle accurate for complex
-   *     data dependencies and ports are not readibly viewable in a waveform viewer.
+   *     event-based using evaluate <-> update delta cycle loop. Best performance, but not cycle accurate for complex
+   *     data dependencies and ports are not readibly viewable in a waveform viewer. Define CONNECTIONS_TLM_HANDOFF to
+   *     use a handoff_fifo instead, where a Push() is visible at once and wakes only a consumer blocked in Pop(). It is
+   *     faster, but the results of PopNB(), PushNB() and the nb_can_* calls then depend on the order in which processes
+   *     run within a delta cycle, so simulation results may differ from those with tlm_fifo.
    *
    * All port types can bind to SYN_PORT, so that MARSHALL_PORT, DIRECT_PORT, and TLM_PORT can be used for the SystemC code during
    * RTL + SystemC co-simulation, while the co-simulation wrapper type maintains the RTL accurate SYN_PORT type.
@@ -525,6 +535,8 @@ namespace Connections
         clk_ptr = cp;
         do_sync_reset = 0;
         do_async_reset = 0;
+        idle_sleeping = 0;
+        idle_cycles = 0;
       }
       sc_clock *clk_ptr;
       sc_time post2pre_delay;
@@ -532,6 +544,8 @@ namespace Connections
       sc_time clock_edge; // time of next active edge during simulation, per clock
       bool do_sync_reset;
       bool do_async_reset;
+      bool idle_sleeping; // ConManager is skipping idle cycles, clock_edge is stale
+      unsigned long long idle_cycles; // cycles skipped, see enable_idle_skip()
     };
 
     std::vector<clk_info> clk_info_vector;
@@ -550,23 +564,16 @@ namespace Connections
     }
 
     void find_clocks(sc_object *obj) {
-      sc_clock *clk = dynamic_cast<sc_clock *>(obj);
-      if (clk) {
-        clk_info_vector.push_back(clk);
-        std::cout << "Connections Clock: " << clk->name() << " Period: " << clk->period() << std::endl;
-      }
-
-      std::vector<sc_object *> children = obj->get_child_objects();
-      for ( unsigned i = 0; i < children.size(); i++ ) {
-        if ( children[i] ) { find_clocks(children[i]); }
+      std::vector<sc_clock *> clks;
+      get_hier_index().find(obj, clks);
+      for (unsigned i=0; i < clks.size(); i++) {
+        clk_info_vector.push_back(clks[i]);
+        std::cout << "Connections Clock: " << clks[i]->name() << " Period: " << clks[i]->period() << std::endl;
       }
     }
 
     void start_of_simulation() {
-      const std::vector<sc_object *> tops = sc_get_top_level_objects();
-      for (unsigned i=0; i < tops.size(); i++) {
-        if (tops[i]) { find_clocks(tops[i]); }
-      }
+      find_clocks(0);
 
       for (unsigned c=0; c < clk_info_vector.size(); c++) {
         clk_info_vector[c].post2pre_delay = (sc_time((get_period_delay(c)-2*epsilon).to_seconds(), SC_SEC));
@@ -575,7 +582,19 @@ namespace Connections
       }
     }
 
+    // First active edge of clock c at or after the current time, given a past active edge
+    sc_time next_edge(int c, const sc_time &edge) const {
+      const sc_time now = sc_time_stamp();
+      if (now <= edge) { return edge; }
+      sc_dt::uint64 p = clk_info_vector[c].period_delay.value();
+      sc_dt::uint64 n = ((now - edge).value() + p - 1) / p;
+      return edge + clk_info_vector[c].period_delay * static_cast<double>(n);
+    }
+
     inline void check_on_clock_edge(int c) {
+      if (clk_info_vector[c].idle_sleeping) {
+        clk_info_vector[c].clock_edge = next_edge(c, clk_info_vector[c].clock_edge);
+      }
       if (clk_info_vector[c].clock_edge != sc_time_stamp()) {
         sc_process_handle h = sc_get_current_process_handle();
         std::ostringstream ss;
@@ -630,6 +649,13 @@ namespace Connections
     virtual bool Post() {return false;};
     virtual bool Pre()  {return false;};
     virtual bool PrePostReset()  {return false;};
+    // True if Pre() only reads signals and touches state private to this object,
+    // so that it may be evaluated on a host worker thread. See enable_parallel_clk_domains().
+    virtual bool PreThreadSafe() {return false;};
+    // True if Pre() and Post() would leave the port unchanged until IdleWakeEvent()
+    // fires or a Push() is made on it. See enable_idle_skip().
+    virtual bool Idle() {return false;};
+    virtual const sc_event *IdleWakeEvent() {return 0;};
     virtual std::string full_name() { return "unnamed"; }
     bool clock_registered;
     bool non_leaf_port;
@@ -643,16 +669,116 @@ namespace Connections
   };
 
 
+// Pool of host threads used by ConManager to evaluate the Pre() phase of the ports
+// of all clock domains that have an active edge at the same time. The calling
+// (simulation kernel) thread also executes jobs, and run() returns only once
+// every job has completed, so the kernel never observes a partially evaluated phase.
+  class sim_thread_pool
+  {
+  public:
+    sim_thread_pool() : jobs(0), next_job(0), pending(0), quit(false) {}
+
+    ~sim_thread_pool() { stop(); }
+
+    void start(unsigned n) {
+      for (unsigned i=0; i < n; i++) {
+        workers.push_back(std::thread(&sim_thread_pool::worker, this));
+      }
+    }
+
+    void stop() {
+      {
+        std::lock_guard<std::mutex> lk(mtx);
+        quit = true;
+      }
+      cv_work.notify_all();
+      for (unsigned i=0; i < workers.size(); i++) {
+        if (workers[i].joinable()) { workers[i].join(); }
+      }
+      workers.clear();
+    }
+
+    unsigned size() const { return workers.size(); }
+
+    void run(std::vector<std::function<void()> > &job_list) {
+      if (job_list.empty()) { return; }
+      // Nothing to share: skip waking the workers
+      if (job_list.size() == 1) {
+        job_list[0]();
+        return;
+      }
+
+      std::unique_lock<std::mutex> lk(mtx);
+      jobs = &job_list;
+      next_job = 0;
+      pending = job_list.size();
+      cv_work.notify_all();
+
+      while (next_job < jobs->size()) {
+        std::function<void()> &job = (*jobs)[next_job++];
+        lk.unlock();
+        job();
+        lk.lock();
+        --pending;
+      }
+
+      cv_done.wait(lk, [this] { return pending == 0; });
+      jobs = 0;
+    }
+
+  private:
+    std::vector<std::thread> workers;
+    std::vector<std::function<void()> > *jobs;
+    unsigned next_job;
+    unsigned pending;
+    bool quit;
+    std::mutex mtx;
+    std::condition_variable cv_work;
+    std::condition_variable cv_done;
+
+    void worker() {
+      std::unique_lock<std::mutex> lk(mtx);
+      while (1) {
+        cv_work.wait(lk, [this] { return quit || (jobs && (next_job < jobs->size())); });
+        if (quit) { return; }
+        std::function<void()> &job = (*jobs)[next_job++];
+        lk.unlock();
+        job();
+        lk.lock();
+        if (--pending == 0) { cv_done.notify_one(); }
+      }
+    }
+  };
+
   class ConManager
   {
   public:
-    ConManager() { }
+    ConManager()
+      : parallel_clk_domains(false)
+      , parallel_clk_deterministic(false)
+      , parallel_clk_threads(0)
+      , idle_skip(false)
+      , idle_skip_ready(false) {
+#ifdef CONNECTIONS_IDLE_SKIP
+      idle_skip = true;
+#endif
+#ifdef CONNECTIONS_PARALLEL_CLK_DOMAINS
+      parallel_clk_domains = true;
+#endif
+#ifdef CONNECTIONS_PARALLEL_CLK_DETERMINISTIC
+      parallel_clk_deterministic = true;
+#endif
+    }
 
     ~ConManager() {
       for (std::vector<std::vector<Blocking_abs *>*>::iterator it=tracked_per_clk.begin(); it!=tracked_per_clk.end(); ++it) {
         delete *it;
       }
       tracked_per_clk.clear();
+      for (std::vector<sc_event *>::iterator it=idle_wake_event.begin(); it!=idle_wake_event.end(); ++it) {
+        delete *it;
+      }
+      idle_wake_event.clear();
     }
 
     std::vector<Blocking_abs *> tracked;
@@ -715,6 +841,17 @@ namespace Connections
 
     std::vector<std::vector<Blocking_abs *>*> tracked_per_clk;
 
+    // Parallel clock domain mode, see enable_parallel_clk_domains()
+    bool parallel_clk_domains;
+    bool parallel_clk_deterministic;
+    unsigned parallel_clk_threads;
+    sim_thread_pool clk_thread_pool;
+
+    // Idle cycle skipping, see enable_idle_skip()
+    bool idle_skip;
+    bool idle_skip_ready;
+    std::vector<sc_event *> idle_wake_event;
+
     void init_sim_clk() {
       if (sim_clk_initialized) { return; }
 
@@ -722,12 +859,23 @@ namespace Connections
 
       get_sim_clk().start_of_simulation();
 
+      if (parallel_clk_domains) {
+        if (!parallel_clk_deterministic) {
+          unsigned n = parallel_clk_threads ? parallel_clk_threads : get_sim_clk().clk_info_vector.size();
+          if (n > 1) { clk_thread_pool.start(n - 1); } // kernel thread is also a worker
+        }
+        sc_spawn(sc_bind(&ConManager::run_domains, this), "connections_manager_run_domains");
+      }
+
       for (unsigned c=0; c < get_sim_clk().clk_info_vector.size(); c++) {
         map_event_to_clock[&(get_sim_clk().clk_info_vector[c].clk_ptr->posedge_event())] = c + 1; // add +1 encoding
         std::ostringstream ss, ssync;
         ss << "connections_manager_run_" << c;
-        sc_spawn(sc_bind(&ConManager::run, this, c), ss.str().c_str());
+        if (!parallel_clk_domains) {
+          sc_spawn(sc_bind(&ConManager::run, this, c), ss.str().c_str());
+        }
         tracked_per_clk.push_back(new std::vector<Blocking_abs *>);
+        idle_wake_event.push_back(new sc_event());
         ssync << ss.str();
         ss << "async_reset_thread";
         sc_spawn(sc_bind(&ConManager::async_reset_thread, this, c), ss.str().c_str());
@@ -839,6 +987,8 @@ namespace Connections
               SC_REPORT_ERROR("CONNECTIONS-212", ss.str().c_str());
             }
       }
+
+      idle_skip_ready = true;
     }
 
     void add_clock_event(Blocking_abs *c) {
@@ -1019,18 +1169,21 @@ namespace Connections
       get_sim_clk().post_delay(clk);  // align to occur just after the cycle
 
       SimConnectionsClk::clk_info &ci = get_sim_clk().clk_info_vector[clk];
+      bool do_post = true;
 
       while (1) {
-        // Post();
-        for (std::vector<Blocking_abs *>::iterator it=tracked_per_clk[clk]->begin(); it!=tracked_per_clk[clk]->end(); ) {
-          if ((*it)->Post()) {
-            ++it;
-          } else {
-            tracked_per_clk[clk]->erase(it);
+        if (do_post) {
+          // Post();
+          for (std::vector<Blocking_abs *>::iterator it=tracked_per_clk[clk]->begin(); it!=tracked_per_clk[clk]->end(); ) {
+            if ((*it)->Post()) {
+              ++it;
+            } else {
+              tracked_per_clk[clk]->erase(it);
+            }
           }
-        }
 
-        get_sim_clk().post2pre_delay(clk);
+          get_sim_clk().post2pre_delay(clk);
+        }
 
         //Pre();
         for (std::vector<Blocking_abs *>::iterator it=tracked_per_clk[clk]->begin(); it!=tracked_per_clk[clk]->end(); ) {
@@ -1057,6 +1210,220 @@ namespace Connections
             (*it)->PrePostReset();
           }
         }
+
+        do_post = !idle_skip || idle_sleep(clk);
+      }
+    }
+
+    // Called by run() just after an active edge. If every port of the clock is idle and
+    // no reset is asserted, suspends until a port may become active again, then realigns
+    // to the Post()/Pre() schedule of run(). Returns false if Pre() is the next phase due.
+    bool idle_sleep(int clk) {
+      SimConnectionsClk &sim_clk = get_sim_clk();
+      SimConnectionsClk::clk_info &ci = sim_clk.clk_info_vector[clk];
+
+      if (!idle_skip_ready || ci.do_sync_reset || ci.do_async_reset) { return true; }
+
+      std::vector<Blocking_abs *> &ports = *tracked_per_clk[clk];
+      for (unsigned i=0; i < ports.size(); i++) {
+        if (!ports[i]->Idle()) { return true; }
+      }
+
+      sc_event_or_list wake;
+      wake |= *idle_wake_event[clk];
+      for (unsigned i=0; i < ports.size(); i++) {
+        const sc_event *e = ports[i]->IdleWakeEvent();
+        if (e) { wake |= *e; }
+      }
+      add_reset_events(clk, wake);
+
+      const sc_time last_edge = ci.clock_edge;
+      ci.idle_sleeping = true;
+      wait(wake);
+      ci.idle_sleeping = false;
+
+      const sc_time now = sc_time_stamp();
+      const sc_time edge = sim_clk.next_edge(clk, last_edge);
+      unsigned long long skipped = (edge - last_edge).value() / ci.period_delay.value();
+
+      if (now + sim_clk.epsilon <= edge) {
+        // Pre() of the edge is still ahead
+        ci.clock_edge = edge - ci.period_delay;
+        ci.idle_cycles += skipped - 1;
+        if (now + sim_clk.epsilon < edge) { wait(edge - sim_clk.epsilon - now); }
+        return false;
+      }
+
+      // Woken between Pre() and Post() of the edge, Pre() found nothing to do
+      ci.clock_edge = edge;
+      ci.idle_cycles += skipped;
+      wait(edge + sim_clk.epsilon - now);
+      return true;
+    }
+
+    // Used by Push()/Pop() while blocked on a handshake signal that is low: suspends the
+    // calling thread until e fires or a reset changes, then until its next clock edge.
+    // Blocking threads are only parked when the reset signals of the clock are known.
+    void idle_wait(int clk, const sc_event &e) {
+#ifdef HAS_SC_RESET_API
+      if (idle_skip && idle_skip_ready) {
+        sc_event_or_list l;
+        l |= e;
+        add_reset_events(clk, l);
+        wait(l);
+      }
+#endif
+      wait();
+    }
+
+    // Wake the ConManager process of a clock after a Push(), see idle_sleep()
+    inline void idle_notify(int clk) {
+      if (idle_skip && idle_skip_ready) { idle_wake_event[clk]->notify(); }
+    }
+
+    void add_reset_events(int clk, sc_event_or_list &l) {
+      std::map<int, process_reset_info>::iterator it = map_clk_to_reset_info.find(clk);
+      if (it == map_clk_to_reset_info.end()) { return; }
+      if (it->second.async_reset_sig_if) { l |= it->second.async_reset_sig_if->value_changed_event(); }
+      if (it->second.sync_reset_sig_if) { l |= it->second.sync_reset_sig_if->value_changed_event(); }
+    }
+
+    // Single manager process used instead of one run() per clock when parallel clock
+    // domains are enabled. It follows exactly the Post()/Pre() schedule that run()
+    // produces for each clock, but gathers the Pre() phases of all domains that are
+    // due at the same time into one batch that is spread over clk_thread_pool.
+    void run_domains() {
+      SimConnectionsClk &sim_clk = get_sim_clk();
+      const unsigned n = sim_clk.clk_info_vector.size();
+      const sc_time pre2post(2*clk_statics<void>::epsilon);
+
+      std::vector<sc_time> next_time(n);
+      std::vector<bool> at_post(n, true);
+      std::vector<bool> after_pre(n, false);
+      std::vector<unsigned> pre_domains;
+      pre_keep.resize(n);
+
+      for (unsigned c=0; c < n; c++) {
+        next_time[c] = sc_time_stamp() + sim_clk.clk_info_vector[c].clock_edge + clk_statics<void>::epsilon;
+      }
+
+      while (1) {
+        sc_time t = next_time[0];
+        for (unsigned c=1; c < n; c++) {
+          if (next_time[c] < t) { t = next_time[c]; }
+        }
+        if (t > sc_time_stamp()) { wait(t - sc_time_stamp()); }
+
+        for (unsigned c=0; c < n; c++) {
+          if (!at_post[c] || (next_time[c] != t)) { continue; }
+          SimConnectionsClk::clk_info &ci = sim_clk.clk_info_vector[c];
+
+          if (after_pre[c] && (ci.do_sync_reset || ci.do_async_reset)) {
+            for (std::vector<Blocking_abs *>::iterator it=tracked_per_clk[c]->begin();
+                 it!=tracked_per_clk[c]->end(); ++it) {
+              (*it)->PrePostReset();
+            }
+          }
+
+          for (std::vector<Blocking_abs *>::iterator it=tracked_per_clk[c]->begin(); it!=tracked_per_clk[c]->end(); ) {
+            if ((*it)->Post()) {
+              ++it;
+            } else {
+              it = tracked_per_clk[c]->erase(it);
+            }
+          }
+
+          at_post[c] = false;
+          next_time[c] = t + ci.post2pre_delay;
+        }
+
+        pre_domains.clear();
+        for (unsigned c=0; c < n; c++) {
+          if (!at_post[c] && (next_time[c] == t)) { pre_domains.push_back(c); }
+        }
+
+        run_pre_phase(pre_domains);
+
+        for (unsigned d=0; d < pre_domains.size(); d++) {
+          unsigned c = pre_domains[d];
+          SimConnectionsClk::clk_info &ci = sim_clk.clk_info_vector[c];
+          ci.clock_edge += ci.period_delay;
+
+          if (ci.do_sync_reset || ci.do_async_reset) {
+            for (std::vector<Blocking_abs *>::iterator it=tracked_per_clk[c]->begin();
+                 it!=tracked_per_clk[c]->end(); ++it) {
+              (*it)->PrePostReset();
+            }
+          }
+
+          after_pre[c] = true;
+          at_post[c] = true;
+          next_time[c] = t + pre2post;
+        }
+      }
+    }
+
+  private:
+    // Per domain results of Pre(): 0 = deregister, 1 = keep, 2 = deferred to kernel thread
+    std::vector<std::vector<char> > pre_keep;
+    std::vector<std::function<void()> > pre_jobs;
+
+    static void pre_chunk(std::vector<Blocking_abs *> *ports, std::vector<char> *keep, unsigned b, unsigned e) {
+      for (unsigned i=b; i < e; i++) {
+        Blocking_abs *p = (*ports)[i];
+        (*keep)[i] = p->PreThreadSafe() ? (p->Pre() ? 1 : 0) : 2;
+      }
+    }
+
+    void run_pre_phase(const std::vector<unsigned> &domains) {
+      // Deterministic mode: evaluate serially, in clock and registration order,
+      // which is identical to what the per-clock run() processes do.
+      if (parallel_clk_deterministic || (clk_thread_pool.size() == 0)) {
+        for (unsigned d=0; d < domains.size(); d++) {
+          std::vector<Blocking_abs *> &ports = *tracked_per_clk[domains[d]];
+          for (std::vector<Blocking_abs *>::iterator it=ports.begin(); it!=ports.end(); ) {
+            if ((*it)->Pre()) {
+              ++it;
+            } else {
+              it = ports.erase(it);
+            }
+          }
+        }
+        return;
+      }
+
+      // Small chunks cost more in hand-off than they gain
+      static const unsigned min_chunk = 64;
+      const unsigned workers = clk_thread_pool.size() + 1;
+
+      pre_jobs.clear();
+      for (unsigned d=0; d < domains.size(); d++) {
+        std::vector<Blocking_abs *> *ports = tracked_per_clk[domains[d]];
+        std::vector<char> *keep = &pre_keep[domains[d]];
+        keep->assign(ports->size(), 1);
+
+        unsigned chunk = ports->size() / workers + 1;
+        if (chunk < min_chunk) { chunk = min_chunk; }
+        for (unsigned b=0; b < ports->size(); b += chunk) {
+          unsigned e = (b + chunk < ports->size()) ? (b + chunk) : ports->size();
+          pre_jobs.push_back(std::bind(&ConManager::pre_chunk, ports, keep, b, e));
+        }
+      }
+
+      clk_thread_pool.run(pre_jobs);
+
+      // Ports that are not thread safe (eg. channels crossing clock domains and TLM
+      // adapters) are the synchronization points between domains: evaluate them here,
+      // on the kernel thread, once every domain has completed its batch.
+      for (unsigned d=0; d < domains.size(); d++) {
+        std::vector<Blocking_abs *> &ports = *tracked_per_clk[domains[d]];
+        std::vector<char> &keep = pre_keep[domains[d]];
+        unsigned w = 0;
+        for (unsigned i=0; i < ports.size(); i++) {
+          if (keep[i] == 2) { keep[i] = ports[i]->Pre() ? 1 : 0; }
+          if (keep[i]) { ports[w++] = ports[i]; }
+        }
+        ports.resize(w);
       }
     }
   };
@@ -1270,8 +1637,378 @@ namespace Connections
     ConManager_statics<void>::rand_stall_print_debug_enable = false;
   }
 
+  // Registry of the random stall Pacers of all In ports. Each port's Pacer draws
+  // from its own stream, seeded from a global seed and the port's hierarchical
+  // name, so stall patterns do not change when ports are added or elaboration
+  // order changes.
+  class rand_stall_streams
+  {
+  public:
+    rand_stall_streams() : seed(default_seed()), recording(false), burst_gap(false) {}
+
+    uint64_t seed;
+    bool recording;
+    bool burst_gap;
+    unsigned min_gap, max_gap, min_burst, max_burst;
+    std::map<std::string, Pacer *> pacers;
+    std::map<std::string, std::vector<uint32_t> > replays;
+
+    // Called by In ports at construction. Two ports with the same name would draw the
+    // same stream and could not be told apart when recording or replaying, so that is
+    // an error, and the port registered first keeps the name.
+    void add(const std::string &name, Pacer *p) {
+      std::map<std::string, Pacer *>::iterator pit = pacers.find(name);
+      if ((pit != pacers.end()) && (pit->second != p)) {
+        SC_REPORT_ERROR("CONNECTIONS-114", ("Random stall stream of port " + name +
+                                            " already registered by another port with the same name").c_str());
+        return;
+      }
+      p->seed(seed, name);
+      p->randomize_probs();
+      if (burst_gap) { p->set_burst_gap(min_gap, max_gap, min_burst, max_burst); }
+      std::map<std::string, std::vector<uint32_t> >::iterator it = replays.find(name);
+      if (it != replays.end()) {
+        p->replay(it->second);
+      } else if (recording) {
+        p->start_recording();
+      }
+      pacers[name] = p;
+    }
+
+    void remove(Pacer *p) {
+      for (std::map<std::string, Pacer *>::iterator it = pacers.begin(); it != pacers.end(); ++it) {
+        if (it->second == p) { pacers.erase(it); return; }
+      }
+    }
+
+    // Port name without the valid signal or fifo suffix, as printed by rand stall debug
+    static std::string port_name(std::string name, const std::string &suffix) {
+      std::string nameSuff = "_" + suffix;
+      unsigned int suffLen = nameSuff.length();
+      if ((name.length() > suffLen) && (name.substr(name.length() - suffLen, suffLen) == nameSuff)) {
+        name.erase(name.length() - suffLen, suffLen);
+      }
+      return name;
+    }
+
+  private:
+    static uint64_t default_seed() {
+      if (const char *env = getenv("CONN_RAND_STALL_SEED")) { return strtoull(env, 0, 0); }
+#if defined(RAND_SEED)
+      return static_cast<uint64_t>(RAND_SEED);
+#elif defined(USE_TIME_RAND_SEED)
+      return static_cast<uint64_t>(time(NULL));
+#else
+      return 0;
+#endif
+    }
+  };
+
+  inline rand_stall_streams &get_rand_stall_streams()
+  {
+    static rand_stall_streams streams;
+    return streams;
+  }
+
+  /**
+   * \brief Set the global seed of the per-port random stall streams.
+   * \ingroup Connections
+   *
+   * Every In port draws its random stalls from its own stream, seeded from this
+   * global seed and the port's hierarchical name. The seed defaults to RAND_SEED
+   * (or the time with USE_TIME_RAND_SEED, else 0), and can be overridden at run time
+   * with the CONN_RAND_STALL_SEED environment variable. Must be called before the
+   * design is constructed.
+   *
+   * \par A Simple Example
+   * \code
+   *      #include <connections/connections.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *      ...
+   *      Connections::set_rand_stall_seed(1234);
+   *      Connections::enable_global_rand_stall();
+   *      testbench my_testbench("my_testbench");
+   *      ...
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  inline void set_rand_stall_seed(uint64_t seed)
+  {
+    get_rand_stall_streams().seed = seed;
+  }
+
+  /**
+   * \brief Use burst/gap random stalls on all In ports.
+   * \ingroup Connections
+   *
+   * Instead of entering and holding stalls with random probabilities, ports alternate
+   * gaps of min_gap..max_gap cycles without stalls and bursts of min_burst..max_burst
+   * stalled cycles, with lengths drawn uniformly from the port's stream. Applies to
+   * ports already constructed and to ports constructed later. Individual ports can
+   * be configured with set_rand_stall_burst_gap().
+   *
+   */
+  inline void set_global_rand_stall_burst_gap(unsigned min_gap, unsigned max_gap, unsigned min_burst, unsigned max_burst)
+  {
+    rand_stall_streams &rs = get_rand_stall_streams();
+    rs.burst_gap = true;
+    rs.min_gap = min_gap;
+    rs.max_gap = max_gap;
+    rs.min_burst = min_burst;
+    rs.max_burst = max_burst;
+    for (std::map<std::string, Pacer *>::iterator it = rs.pacers.begin(); it != rs.pacers.end(); ++it) {
+      it->second->set_burst_gap(min_gap, max_gap, min_burst, max_burst);
+    }
+  }
+
+  /**
+   * \brief Record the random stall sequence of every In port.
+   * \ingroup Connections
+   *
+   * Call before sc_start(), and write the sequences with export_rand_stall() once
+   * simulation is done. A failing stall pattern can then be replayed exactly with
+   * replay_rand_stall(), independent of the seed and of other ports.
+   *
+   * \par A Simple Example
+   * \code
+   *      #include <connections/connections.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *      ...
+   *      Connections::enable_global_rand_stall();
+   *      Connections::record_rand_stall();
+   *      sc_start();
+   *      Connections::export_rand_stall("stalls.txt");
+   *      ...
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  inline void record_rand_stall()
+  {
+    rand_stall_streams &rs = get_rand_stall_streams();
+    rs.recording = true;
+    for (std::map<std::string, Pacer *>::iterator it = rs.pacers.begin(); it != rs.pacers.end(); ++it) {
+      it->second->start_recording();
+    }
+  }
+
+  /**
+   * \brief Write the recorded random stall sequences to a file.
+   * \ingroup Connections
+   *
+   * One line per port: the port name, followed by alternating run lengths of
+   * non-stalled and stalled cycles, starting with a non-stalled run. Returns false
+   * if the file cannot be written.
+   *
+   */
+  inline bool export_rand_stall(const std::string &fname)
+  {
+    std::ofstream ofs(fname.c_str());
+    if (!ofs.is_open()) {
+      std::cerr << "Cannot open file '" << fname << "'" << std::endl;
+      return false;
+    }
+    rand_stall_streams &rs = get_rand_stall_streams();
+    for (std::map<std::string, Pacer *>::iterator it = rs.pacers.begin(); it != rs.pacers.end(); ++it) {
+      if (!it->second->is_recording()) { continue; }
+      ofs << it->first;
+      const std::vector<uint32_t> &runs = it->second->recorded_runs();
+      for (unsigned i = 0; i < runs.size(); i++) { ofs << " " << runs[i]; }
+      ofs << "\n";
+    }
+    return true;
+  }
+
+  /**
+   * \brief Replay random stall sequences written by export_rand_stall().
+   * \ingroup Connections
+   *
+   * Ports listed in the file replay their sequence and stop stalling once it is
+   * exhausted; other ports keep drawing from their streams. Can be called before or
+   * after the design is constructed, but before sc_start(). Random stalling must be
+   * enabled as in the recorded run. Returns false if the file cannot be read.
+   *
+   */
+  inline bool replay_rand_stall(const std::string &fname)
+  {
+    std::ifstream ifs(fname.c_str());
+    if (!ifs.is_open()) {
+      std::cerr << "Cannot open file '" << fname << "'" << std::endl;
+      return false;
+    }
+    rand_stall_streams &rs = get_rand_stall_streams();
+    std::string line;
+    while (std::getline(ifs, line)) {
+      std::istringstream ls(line);
+      std::string name;
+      if (!(ls >> name)) { continue; }
+      std::vector<uint32_t> runs;
+      uint32_t r;
+      while (ls >> r) { runs.push_back(r); }
+      rs.replays[name] = runs;
+      std::map<std::string, Pacer *>::iterator it = rs.pacers.find(name);
+      if (it != rs.pacers.end()) { it->second->replay(runs); }
+    }
+    return true;
+  }
+
 #endif //__CONN_RAND_STALL_FEATURE
 
+  /**
+   * \brief Evaluate Connections port bookkeeping of clock domains on host threads.
+   * \ingroup Connections
+   *
+   * Replaces the per-clock ConManager processes by a single process that follows the
+   * same schedule, and evaluates the Pre() phase of every port of all clock domains
+   * that are due at the same time on a pool of host threads. Ports that cannot be
+   * evaluated concurrently, most notably Combinational channels whose two ends are on
+   * different clocks, are evaluated on the simulation kernel thread after the
+   * parallel batch completes. Simulation results are identical to the default mode.
+   *
+   * Only the Pre() phase is spread over threads; process execution and signal updates
+   * stay on the kernel thread. The ports of each domain are split in jobs of at least
+   * 64 ports, and a batch of a single job is run on the kernel thread, so a clock edge
+   * at which only one domain of at most 64 ports is due is evaluated serially. The
+   * mode pays off when the Pre() phase is a large part of the run time: several clocks
+   * with coinciding edges and hundreds of ports each, or wide messages that are costly
+   * to unmarshall. Measure with the 90_parallel_clk_bench example of the MatchLib
+   * Toolkit before enabling it.
+   *
+   * Must be called before sc_start(). Also enabled with CONNECTIONS_PARALLEL_CLK_DOMAINS.
+   *
+   * \param num_threads  Total number of threads, including the kernel thread. Defaults to
+   *                     the number of clocks in the design.
+   *
+   * \par A Simple Example
+   * \code
+   *      #include <connections/connections.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *      ...
+   *      Connections::enable_parallel_clk_domains(4);
+   *      sc_start();
+   *      ...
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  inline void enable_parallel_clk_domains(unsigned num_threads = 0)
+  {
+    ConManager &cm = get_conManager();
+    if (cm.sim_clk_initialized) {
+      SC_REPORT_WARNING("CONNECTIONS-230", "enable_parallel_clk_domains() called after simulation start, ignored");
+      return;
+    }
+    cm.parallel_clk_domains = true;
+    cm.parallel_clk_deterministic = false;
+    cm.parallel_clk_threads = num_threads;
+  }
+
+  /**
+   * \brief Use the parallel clock domain scheduler, but evaluate all domains serially.
+   * \ingroup Connections
+   *
+   * Deterministic reference mode for enable_parallel_clk_domains(): ports are evaluated
+   * in clock and registration order on the simulation kernel thread. Also enabled with
+   * CONNECTIONS_PARALLEL_CLK_DOMAINS and CONNECTIONS_PARALLEL_CLK_DETERMINISTIC.
+   *
+   */
+  inline void enable_deterministic_clk_domains()
+  {
+    ConManager &cm = get_conManager();
+    if (cm.sim_clk_initialized) {
+      SC_REPORT_WARNING("CONNECTIONS-230", "enable_deterministic_clk_domains() called after simulation start, ignored");
+      return;
+    }
+    cm.parallel_clk_domains = true;
+    cm.parallel_clk_deterministic = true;
+  }
+
+  /**
+   * \brief Revert to one ConManager process per clock (default).
+   * \ingroup Connections
+   *
+   */
+  inline void disable_parallel_clk_domains()
+  {
+    ConManager &cm = get_conManager();
+    if (cm.sim_clk_initialized) {
+      SC_REPORT_WARNING("CONNECTIONS-230", "disable_parallel_clk_domains() called after simulation start, ignored");
+      return;
+    }
+    cm.parallel_clk_domains = false;
+  }
+
+  /**
+   * \brief Skip Connections port bookkeeping in clock cycles where nothing can change.
+   * \ingroup Connections
+   *
+   * In CONNECTIONS_ACCURATE_SIM the ConManager process of each clock evaluates the Post()
+   * and Pre() phase of every port once per cycle, and a thread blocked in Push() or Pop()
+   * wakes up every cycle to poll its port. With idle skipping, the ConManager process of a
+   * clock whose ports are all idle (no message buffered or in flight, no valid or stall
+   * asserted, no reset asserted) suspends until a valid signal rises or a Push() is made
+   * on one of them, and a thread blocked on a low valid or ready signal suspends until it
+   * rises. Cycle counts, and the time of every Push() and Pop(), are identical to the
+   * default mode.
+   *
+   * Clocks with ports that have random stalling enabled, or with port adapters that
+   * do not report idleness, are evaluated every cycle as before. Blocked threads are only
+   * suspended when HAS_SC_RESET_API is defined. With enable_parallel_clk_domains() only
+   * blocked threads are suspended.
+   *
+   * Must be called before sc_start(). Also enabled with CONNECTIONS_IDLE_SKIP.
+   *
+   * \par A Simple Example
+   * \code
+   *      #include <connections/connections.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *      ...
+   *      Connections::enable_idle_skip();
+   *      sc_start();
+   *      std::cout << Connections::get_idle_cycles() << " idle cycles skipped" << std::endl;
+   *      ...
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  inline void enable_idle_skip()
+  {
+    ConManager &cm = get_conManager();
+    if (cm.sim_clk_initialized) {
+      SC_REPORT_WARNING("CONNECTIONS-230", "enable_idle_skip() called after simulation start, ignored");
+      return;
+    }
+    cm.idle_skip = true;
+  }
+
+  /**
+   * \brief Number of clock cycles, summed over all clocks, skipped by enable_idle_skip().
+   * \ingroup Connections
+   *
+   */
+  inline unsigned long long get_idle_cycles()
+  {
+    unsigned long long n = 0;
+    SimConnectionsClk &sim_clk = get_sim_clk();
+    for (unsigned c=0; c < sim_clk.clk_info_vector.size(); c++) {
+      n += sim_clk.clk_info_vector[c].idle_cycles;
+    }
+    return n;
+  }
+
 #endif //CONNECTIONS_SIM_ONLY
 
 //------------------------------------------------------------------------
@@ -1410,6 +2147,158 @@ namespace Connections
 // TLM
 #if defined(CONNECTIONS_SIM_ONLY)
 
+  // Channel behind TLM_PORT Combinational when CONNECTIONS_TLM_HANDOFF is defined, a drop-in
+  // for tlm::tlm_fifo.
+  //
+  // tlm::tlm_fifo makes a put() visible to the reader in the next delta cycle, through
+  // request_update() and a delta notification that wakes every process waiting on the
+  // fifo. Here the message goes straight into a ring buffer of the same capacity and
+  // is visible at once. An event is notified (immediately) only when a process is
+  // actually blocked on the other side, or somebody asked for ok_to_*(), so a consumer
+  // blocked in Pop() is the only process woken by a Push(). When the producer runs
+  // ahead within the capacity, messages are batched in the buffer without any event
+  // and the consumer drains them without suspending.
+  //
+  // Since a put() or get() is seen at once, what a non-blocking call on the other side
+  // returns depends on whether its process runs before or after in the same delta
+  // cycle, which tlm::tlm_fifo hides. Hence it is opt-in.
+  template <typename T>
+  class handoff_fifo
+    : public virtual tlm::tlm_fifo_get_if<T>
+    , public virtual tlm::tlm_fifo_put_if<T>
+    , public sc_prim_channel
+  {
+  public:
+    explicit handoff_fifo(const char *name, int size = 1)
+      : sc_prim_channel(name)
+      , buf(size > 0 ? size : 1)
+      , head(0)
+      , count(0)
+      , get_waiters(0)
+      , put_waiters(0)
+      , notify_always(false) {}
+
+    // Get
+    T get(tlm::tlm_tag<T> * = 0) {
+      while (count == 0) { wait_for(written_event, get_waiters); }
+      T t = buf[head];
+      pop_front();
+      return t;
+    }
+
+    void get(T &t) { t = get(); }
+
+    bool nb_get(T &t) {
+      if (count == 0) { return false; }
+      t = buf[head];
+      pop_front();
+      return true;
+    }
+
+    bool nb_can_get(tlm::tlm_tag<T> * = 0) const { return count > 0; }
+
+    const sc_event &ok_to_get(tlm::tlm_tag<T> * = 0) const {
+      notify_always = true;
+      return written_event;
+    }
+
+    // Peek
+    T peek(tlm::tlm_tag<T> * = 0) const {
+      while (count == 0) { wait_for(written_event, get_waiters); }
+      return buf[head];
+    }
+
+    void peek(T &t) const { t = peek(); }
+
+    bool nb_peek(T &t) const {
+      if (count == 0) { return false; }
+      t = buf[head];
+      return true;
+    }
+
+    bool nb_can_peek(tlm::tlm_tag<T> * = 0) const { return count > 0; }
+
+    const sc_event &ok_to_peek(tlm::tlm_tag<T> * = 0) const {
+      notify_always = true;
+      return written_event;
+    }
+
+    // Put
+    void put(const T &t) {
+      while (count == buf.size()) { wait_for(read_event, put_waiters); }
+      push_back(t);
+    }
+
+    bool nb_put(const T &t) {
+      if (count == buf.size()) { return false; }
+      push_back(t);
+      return true;
+    }
+
+    bool nb_can_put(tlm::tlm_tag<T> * = 0) const { return count < buf.size(); }
+
+    const sc_event &ok_to_put(tlm::tlm_tag<T> * = 0) const {
+      notify_always = true;
+      return read_event;
+    }
+
+    // Debug interface
+    int used() const { return static_cast<int>(count); }
+    int size() const { return static_cast<int>(buf.size()); }
+
+    void debug() const {
+      std::cout << name() << " : " << count << "/" << buf.size() << " used" << std::endl;
+    }
+
+    bool nb_peek(T &t, int n) const {
+      if ((n < 0) || (static_cast<size_t>(n) >= count)) { return false; }
+      t = buf[(head + n) % buf.size()];
+      return true;
+    }
+
+    bool nb_poke(const T &t, int n = 0) {
+      if ((n < 0) || (static_cast<size_t>(n) >= count)) { return false; }
+      buf[(head + n) % buf.size()] = t;
+      return true;
+    }
+
+    const char *kind() const { return "handoff_fifo"; }
+
+  private:
+    std::vector<T> buf;
+    size_t head;
+    size_t count;
+    mutable unsigned get_waiters;  // processes blocked in get()/peek()
+    unsigned put_waiters;          // processes blocked in put()
+    mutable bool notify_always;    // an ok_to_*() event was handed out
+    sc_event written_event;
+    sc_event read_event;
+
+    static void wait_for(const sc_event &e, unsigned &waiters) {
+      ++waiters;
+      sc_core::wait(e);
+      --waiters;
+    }
+
+    void push_back(const T &t) {
+      buf[(head + count) % buf.size()] = t;
+      ++count;
+      if (get_waiters || notify_always) { written_event.notify(); }
+    }
+
+    void pop_front() {
+      head = (head + 1) % buf.size();
+      --count;
+      if (put_waiters || notify_always) { read_event.notify(); }
+    }
+  };
+
+#ifdef CONNECTIONS_TLM_HANDOFF
+  template <typename T> using tlm_port_fifo = handoff_fifo<T>;
+#else
+  template <typename T> using tlm_port_fifo = tlm::tlm_fifo<T>;
+#endif
+
   template <typename Message>
   class TLMToDirectOutPort : public Blocking_abs
   {
@@ -1419,7 +2308,7 @@ namespace Connections
     sc_out<Message> _DATNAME_;
 
     // Default constructor
-    explicit TLMToDirectOutPort(tlm::tlm_fifo<Message> &fifo)
+    explicit TLMToDirectOutPort(tlm_port_fifo<Message> &fifo)
       : _VLDNAME_(sc_gen_unique_name(_VLDNAMEOUTSTR_)),
         _RDYNAME_(sc_gen_unique_name(_RDYNAMEOUTSTR_ )),
         _DATNAME_(sc_gen_unique_name(_DATNAMEOUTSTR_)) {
@@ -1429,7 +2318,7 @@ namespace Connections
     }
 
     // Constructor
-    explicit TLMToDirectOutPort(const char *name, tlm::tlm_fifo<Message> &fifo)
+    explicit TLMToDirectOutPort(const char *name, tlm_port_fifo<Message> &fifo)
       : _VLDNAME_(CONNECTIONS_CONCAT(name, _VLDNAMESTR_)),
         _RDYNAME_(CONNECTIONS_CONCAT(name, _RDYNAMESTR_)),
         _DATNAME_(CONNECTIONS_CONCAT(name, _DATNAMESTR_)) {
@@ -1438,10 +2327,10 @@ namespace Connections
 
   protected:
     // Protected member variables
-    tlm::tlm_fifo<Message> *fifo;
+    tlm_port_fifo<Message> *fifo;
 
     // Initializer
-    void Init_SIM(const char *name, tlm::tlm_fifo<Message> &fifo) {
+    void Init_SIM(const char *name, tlm_port_fifo<Message> &fifo) {
       this->fifo = &fifo;
       get_conManager().add(this);
     }
@@ -1485,7 +2374,7 @@ namespace Connections
     sc_in<Message> _DATNAME_;
 
     // Default constructor
-    explicit DirectToTLMInPort(tlm::tlm_fifo<Message> &fifo)
+    explicit DirectToTLMInPort(tlm_port_fifo<Message> &fifo)
       : _VLDNAME_(sc_gen_unique_name(_VLDNAMEINSTR_)),
         _RDYNAME_(sc_gen_unique_name(_RDYNAMEINSTR_)),
         _DATNAME_(sc_gen_unique_name(_DATNAMEINSTR_)) {
@@ -1495,7 +2384,7 @@ namespace Connections
     }
 
     // Constructor
-    explicit DirectToTLMInPort (const char *name, tlm::tlm_fifo<Message> &fifo)
+    explicit DirectToTLMInPort (const char *name, tlm_port_fifo<Message> &fifo)
       : _VLDNAME_(CONNECTIONS_CONCAT(name, _VLDNAMESTR_)),
         _RDYNAME_(CONNECTIONS_CONCAT(name, _RDYNAMESTR_)),
         _DATNAME_(CONNECTIONS_CONCAT(name, _DATNAMESTR_)) {
@@ -1504,10 +2393,10 @@ namespace Connections
 
   protected:
     // Protected member variables
-    tlm::tlm_fifo<Message> *fifo;
+    tlm_port_fifo<Message> *fifo;
 
     // Initializer
-    void Init_SIM(const char *name, tlm::tlm_fifo<Message> &fifo) {
+    void Init_SIM(const char *name, tlm_port_fifo<Message> &fifo) {
       this->fifo = &fifo;
       get_conManager().add(this);
     }
@@ -1539,6 +2428,39 @@ namespace Connections
     }
   };
 
+  // Untyped access to the message bits of a marked port, for record/replay (port_recorder.h)
+  class port_marker_dat
+  {
+  public:
+    virtual ~port_marker_dat() {}
+    virtual void read(sc_lv_base &bits) = 0;          // bits currently on the port
+    virtual void bind_signal(const char *name) = 0;   // bind the port to a new signal
+    virtual void write(const sc_lv_base &bits) = 0;   // drive the signal made by bind_signal()
+  };
+
+  template <typename MsgBits, typename Port>
+  class port_marker_dat_impl : public port_marker_dat
+  {
+  public:
+    explicit port_marker_dat_impl(Port *p) : port(p), sig(0) {}
+
+    void read(sc_lv_base &bits) { bits = port->read(); }
+
+    void bind_signal(const char *name) {
+      sig = new sc_signal<MsgBits>(name);
+      (*port)(*sig);
+    }
+
+    void write(const sc_lv_base &bits) {
+      MsgBits v = bits;
+      sig->write(v);
+    }
+
+  private:
+    Port *port;
+    sc_signal<MsgBits> *sig;
+  };
+
   class in_port_marker : public sc_object
   {
   public:
@@ -1548,6 +2470,7 @@ namespace Connections
     sc_in<bool> *_VLDNAME_;
     sc_out<bool> *_RDYNAME_;
     sc_port_base *_DATNAME_;
+    port_marker_dat *dat_access;
     sc_object *bound_to;
     bool top_port;
 
@@ -1556,16 +2479,18 @@ namespace Connections
       _VLDNAME_ = 0;
       _RDYNAME_ = 0;
       _DATNAME_ = 0;
+      dat_access = 0;
       bound_to = 0;
       top_port = false;
     }
 
-    in_port_marker(const char *name, unsigned _w, sc_in<bool> *_val, sc_out<bool> *_rdy, sc_port_base *_msg)
+    in_port_marker(const char *name, unsigned _w, sc_in<bool> *_val, sc_out<bool> *_rdy, sc_port_base *_msg, port_marker_dat *_dat = 0)
       : sc_object(name) {
       named = true;
       _VLDNAME_ = _val;
       _RDYNAME_ = _rdy;
       _DATNAME_ = _msg;
+      dat_access = _dat;
       bound_to = 0;
       top_port = false;
 
@@ -1586,6 +2511,7 @@ namespace Connections
     sc_out<bool> *_VLDNAME_;
     sc_in<bool> *_RDYNAME_;
     sc_port_base *_DATNAME_;
+    port_marker_dat *dat_access;
     sc_object *bound_to;
     bool top_port;
 
@@ -1594,16 +2520,18 @@ namespace Connections
       _VLDNAME_ = 0;
       _RDYNAME_ = 0;
       _DATNAME_ = 0;
+      dat_access = 0;
       bound_to = 0;
       top_port = false;
     }
 
-    out_port_marker(const char *name, unsigned _w, sc_out<bool> *_val, sc_in<bool> *_rdy, sc_port_base *_msg)
+    out_port_marker(const char *name, unsigned _w, sc_out<bool> *_val, sc_in<bool> *_rdy, sc_port_base *_msg, port_marker_dat *_dat = 0)
       : sc_object(name) {
       named = true;
       _VLDNAME_ = _val;
       _RDYNAME_ = _rdy;
       _DATNAME_ = _msg;
+      dat_access = _dat;
       bound_to = 0;
       top_port = false;
 
@@ -1806,6 +2734,7 @@ namespace Connections
 
     virtual ~InBlocking_SimPorts_abs() {
 #ifdef __CONN_RAND_STALL_FEATURE
+      get_rand_stall_streams().remove(post_pacer);
       if (!!post_pacer) delete post_pacer;
       post_pacer = NULL;
 #endif
@@ -1914,6 +2843,11 @@ namespace Connections
       }
     }
 
+    // Stall in bursts of min_burst..max_burst cycles separated by gaps of min_gap..max_gap cycles
+    void set_rand_stall_burst_gap(unsigned min_gap, unsigned max_gap, unsigned min_burst, unsigned max_burst) {
+      post_pacer->set_burst_gap(min_gap, max_gap, min_burst, max_burst);
+    }
+
 
     /**
      * \brief Enable random stalling support on an input port.
@@ -2132,9 +3066,8 @@ namespace Connections
       rdy_set_by_api = false;
       get_conManager().add(this);
 #ifdef __CONN_RAND_STALL_FEATURE
-      double x = rand()%100;
-      double y = rand()%100;
-      post_pacer = new Pacer(x/100, y/100);
+      post_pacer = new Pacer(0, 0);
+      get_rand_stall_streams().add(rand_stall_streams::port_name(this->_VLDNAME_.name(), _VLDNAMESTR_), post_pacer);
       pacer_stall = false;
       local_rand_stall_override = false;
       local_rand_stall_enable = false;
@@ -2207,6 +3140,17 @@ namespace Connections
       return true;
     }
 
+    bool PreThreadSafe() { return true; }
+
+    bool Idle() {
+#ifdef __CONN_RAND_STALL_FEATURE
+      if (local_rand_stall_override ? local_rand_stall_enable : get_rand_stall_enable()) { return false; }
+#endif
+      return !data_val && rdy_set_by_api && this->_RDYNAME_.read() && !this->_VLDNAME_.read();
+    }
+
+    const sc_event *IdleWakeEvent() { return &this->_VLDNAME_.posedge_event(); }
+
 #ifdef __CONN_RAND_STALL_FEATURE
     bool Post() {
       if ((local_rand_stall_override ? local_rand_stall_enable : get_rand_stall_enable())) {
@@ -2263,6 +3207,12 @@ namespace Connections
 
     Message &Pop_SIM() {
       while (Empty_SIM()) {
+#ifdef CONNECTIONS_ACCURATE_SIM
+        if (!this->_VLDNAME_.read()) {
+          get_conManager().idle_wait(this->clock_number, this->_VLDNAME_.posedge_event());
+          continue;
+        }
+#endif
         wait();
       }
       return ConsumeBuf_SIM();
@@ -2494,17 +3444,23 @@ namespace Connections
     sc_in<MsgBits> _DATNAME_;
 
 #ifdef CONNECTIONS_SIM_ONLY
+    port_marker_dat_impl<MsgBits, sc_in<MsgBits> > marker_dat;
     in_port_marker marker;
 #endif
 
     InBlocking() : InBlocking_SimPorts_abs<Message>(),
-      _DATNAME_(sc_gen_unique_name(_DATNAMEINSTR_)) {}
+      _DATNAME_(sc_gen_unique_name(_DATNAMEINSTR_))
+#ifdef CONNECTIONS_SIM_ONLY
+      , marker_dat(&_DATNAME_)
+#endif
+    {}
 
     explicit InBlocking(const char *name) :
       InBlocking_SimPorts_abs<Message>(name)
       , _DATNAME_(CONNECTIONS_CONCAT(name, _DATNAMESTR_))
 #ifdef CONNECTIONS_SIM_ONLY
-      , marker(CONNECTIONS_CONCAT(name, "in_port_marker"), width, &(this->_VLDNAME_), &(this->_RDYNAME_), &_DATNAME_)
+      , marker_dat(&_DATNAME_)
+      , marker(CONNECTIONS_CONCAT(name, "in_port_marker"), width, &(this->_VLDNAME_), &(this->_RDYNAME_), &_DATNAME_, &marker_dat)
 #endif
     {}
 
@@ -2770,6 +3726,7 @@ namespace Connections
 
     virtual ~InBlocking() {
 #ifdef __CONN_RAND_STALL_FEATURE
+      get_rand_stall_streams().remove(post_pacer);
       if (!!post_pacer) delete post_pacer;
       post_pacer = NULL;
 #endif
@@ -2872,6 +3829,10 @@ namespace Connections
     void cancel_local_rand_stall_print_debug() {
       local_rand_stall_print_debug_override = false;
     }
+
+    void set_rand_stall_burst_gap(unsigned min_gap, unsigned max_gap, unsigned min_burst, unsigned max_burst) {
+      post_pacer->set_burst_gap(min_gap, max_gap, min_burst, max_burst);
+    }
 #endif // __CONN_RAND_STALL_FEATURE
 
   protected:
@@ -2885,9 +3846,8 @@ namespace Connections
     bool local_rand_stall_print_debug_enable;
 
     void Init_SIM(const char *name) {
-      double x = rand()%100;
-      double y = rand()%100;
-      post_pacer = new Pacer(x/100, y/100);
+      post_pacer = new Pacer(0, 0);
+      get_rand_stall_streams().add(rand_stall_streams::port_name(i_fifo.name(), "i_fifo"), post_pacer);
       local_rand_stall_override = false;
       local_rand_stall_enable = false;
       local_rand_stall_print_debug_override = false;
@@ -3279,6 +4239,8 @@ namespace Connections
       return true;
     }
 
+    bool PreThreadSafe() { return true; }
+
     bool Post() {
       if (val_set_by_api != this->_VLDNAME_.read()) {
         // something has changed the value of the signal not through API
@@ -3289,11 +4251,18 @@ namespace Connections
       return true;
     }
 
+    bool Idle() {
+      return !data_val && !val_set_by_api && !this->_VLDNAME_.read();
+    }
+
     void FillBuf_SIM(const Message &m) {
       CONNECTIONS_ASSERT_MSG(!data_val, "Unreachable state, asked to fill buffer but buffer already full!");
       data_val = true;
       transmit_data(m);
       data_buf = m;
+#ifdef CONNECTIONS_ACCURATE_SIM
+      get_conManager().idle_notify(this->clock_number);
+#endif
     }
 
     bool Empty_SIM() { return !data_val; }
@@ -3302,6 +4271,12 @@ namespace Connections
 
     void Push_SIM(const Message &m) {
       while (Full_SIM()) {
+#ifdef CONNECTIONS_ACCURATE_SIM
+        if (!this->_RDYNAME_.read()) {
+          get_conManager().idle_wait(this->clock_number, this->_RDYNAME_.posedge_event());
+          continue;
+        }
+#endif
         wait();
       }
       FillBuf_SIM(m);
@@ -3519,6 +4494,7 @@ namespace Connections
     typedef sc_lv<WMessage::width> MsgBits;
     sc_out<MsgBits> _DATNAME_;
 #ifdef CONNECTIONS_SIM_ONLY
+    port_marker_dat_impl<MsgBits, sc_out<MsgBits> > marker_dat;
     out_port_marker marker;
     OutBlocking<Message, MARSHALL_PORT> *driver;
 #endif
@@ -3526,8 +4502,10 @@ namespace Connections
     OutBlocking() : OutBlocking_SimPorts_abs<Message>(),
       _DATNAME_(sc_gen_unique_name(_DATNAMEOUTSTR_))
 #ifdef CONNECTIONS_SIM_ONLY
+      , marker_dat(&_DATNAME_)
       , driver(0)
       , log_stream(0)
+      , bin_log(0)
 #endif
     {}
 
@@ -3535,9 +4513,11 @@ namespace Connections
       : OutBlocking_SimPorts_abs<Message>(name)
       , _DATNAME_(CONNECTIONS_CONCAT(name, _DATNAMESTR_))
 #ifdef CONNECTIONS_SIM_ONLY
-      , marker(CONNECTIONS_CONCAT(name, "out_port_marker"), width, &(this->_VLDNAME_), &(this->_RDYNAME_), &_DATNAME_)
+      , marker_dat(&_DATNAME_)
+      , marker(CONNECTIONS_CONCAT(name, "out_port_marker"), width, &(this->_VLDNAME_), &(this->_RDYNAME_), &_DATNAME_, &marker_dat)
       , driver(0)
       , log_stream(0)
+      , bin_log(0)
 #endif
     {}
 
@@ -3684,6 +4664,8 @@ namespace Connections
 #ifdef CONNECTIONS_SIM_ONLY
       if (log_stream)
       { *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; }
+      if (bin_log)
+      { bin_log->write(log_number, bits); }
 #endif
     }
 
@@ -3717,11 +4699,17 @@ namespace Connections
 
     std::ofstream *log_stream;
     int log_number;
+    channel_log_writer *bin_log;
 
     void set_log(int num, std::ofstream *fp) {
       log_stream = fp;
       log_number = num;
     }
+
+    void set_binary_log(int num, channel_log_writer *w) {
+      bin_log = w;
+      log_number = num;
+    }
 #endif
   };
 
@@ -3856,6 +4844,8 @@ namespace Connections
 #ifdef CONNECTIONS_SIM_ONLY
       if (log_stream)
       { *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; }
+      if (bin_log)
+      { bin_log->write(log_number, convert_to_lv<Message>(m)); }
 #endif
 
     }
@@ -3886,11 +4876,17 @@ namespace Connections
 
     std::ofstream *log_stream{0};
     int log_number{0};
+    channel_log_writer *bin_log{0};
 
     void set_log(int num, std::ofstream *fp) {
       log_stream = fp;
       log_number = num;
     }
+
+    void set_binary_log(int num, channel_log_writer *w) {
+      bin_log = w;
+      log_number = num;
+    }
 #endif
   };
 
@@ -3938,7 +4934,10 @@ namespace Connections
 #endif
       o_fifo->put(m);
       write_log->write_log(m);
+#ifndef CONNECTIONS_TLM_HANDOFF
+      // Let tlm_fifo::update() publish the message before returning
       wait(sc_core::SC_ZERO_TIME);
+#endif
     }
 
 // PushNB
@@ -4094,6 +5093,11 @@ namespace Connections
       CONNECTIONS_ASSERT_MSG(0, "Unreachable virtual function in abstract class!");
       return 0;
     }
+
+    // Bits per message, used to size buffers in design-space exploration
+    virtual unsigned int msg_width() {
+      return 0;
+    }
   };
 #endif
 
@@ -4333,7 +5337,8 @@ namespace Connections
 #ifdef CONNECTIONS_SIM_ONLY
     : public Combinational_abs<Message>,
       public Connections_BA_abs,
-      public Blocking_abs
+      public Blocking_abs,
+      public sc_profile_marker
 #else
     : public Combinational_Ports_abs<Message>
 #endif
@@ -4593,6 +5598,35 @@ namespace Connections
       Connections::get_conManager().remove_annotate(this);
     }
 
+    unsigned int msg_width() {
+      return Wrapped<Message>::width;
+    }
+
+    // Port whose clock registration gives the clock domain of the channel
+    virtual Blocking_abs *profile_clock_port() { return this; }
+
+    virtual void set_profile(std::vector<channel_probe> &probes) {
+      channel_probe p;
+      p.name = this->name();
+      p.kind = "Combinational";
+      p.sample = [this](channel_sample &s) {
+        s.in_vld = this->_VLDNAMEIN_.read();
+        s.in_rdy = this->_RDYNAMEIN_.read();
+        s.out_vld = this->_VLDNAMEOUT_.read();
+        s.out_rdy = this->_RDYNAMEOUT_.read();
+        s.capacity = is_bypass() ? 0 : b.size();
+        s.occupancy = is_bypass() ? 0 : b.used();
+      };
+      p.edge = [this]() -> const sc_event * {
+        Blocking_abs *port = profile_clock_port();
+        int c = 0;
+        if (port->clock_registered) { c = port->clock_number; }
+        else if (this->clock_registered) { c = this->clock_number; }
+        return &(get_sim_clk().clk_info_vector[c].clk_ptr->posedge_event());
+      };
+      probes.push_back(p);
+    }
+
     const char *src_name() {
       if (in_str) {
         return in_str;
@@ -4643,6 +5677,10 @@ namespace Connections
       sim_in.cancel_local_rand_stall_print_debug();
     }
 
+    void set_rand_stall_burst_gap(unsigned min_gap, unsigned max_gap, unsigned min_burst, unsigned max_burst) {
+      sim_in.set_rand_stall_burst_gap(min_gap, max_gap, min_burst, max_burst);
+    }
+
 
   protected:
     OutBlocking<Message,port_marshall_type> sim_out;
@@ -4773,6 +5811,15 @@ namespace Connections
       return true;
     }
 
+    bool PreThreadSafe() {
+      // A channel whose ends are driven from different clocks is a clock domain
+      // crossing, keep it on the kernel thread.
+      if (in_bound && in_ptr && out_bound && out_ptr) {
+        return in_ptr->clock_number == out_ptr->clock_number;
+      }
+      return true;
+    }
+
     bool Post() {
       current_cycle++; // Increment to next cycle.
 
@@ -4796,12 +5843,27 @@ namespace Connections
       return true;
     }
 
+    // current_cycle only matters relative to the messages in b, so it may stop
+    // advancing while the channel is empty
+    bool Idle() {
+      if (is_bypass()) { return true; }
+      return b.is_empty() && rdy_set_by_api && _RDYNAMEIN_.read() && !val_set_by_api && !_VLDNAMEIN_.read();
+    }
+
+    const sc_event *IdleWakeEvent() {
+      if (is_bypass()) { return 0; }
+      return &_VLDNAMEIN_.posedge_event();
+    }
+
     void FillBuf_SIM(const Message &m) {
       BA_Message<Message> bam;
       bam.m = m;
       bam.ready_cycle = current_cycle + latency;
       assert(! b.is_full());
       b.write(bam);
+#ifdef CONNECTIONS_ACCURATE_SIM
+      get_conManager().idle_notify(this->clock_number);
+#endif
     }
 
     bool Empty_SIM() {
@@ -5004,6 +6066,18 @@ namespace Connections
     }
 #endif
 
+#ifdef CONNECTIONS_SIM_ONLY
+    Blocking_abs *profile_clock_port() {
+      OutBlocking<Message, MARSHALL_PORT> *d = &(this->sim_out);
+      if (driver) {
+        d = driver;
+        while (d->driver)
+        { d = d->driver; }
+      }
+      return d;
+    }
+#endif
+
     // Parent functions, to get around Catapult virtual function bug.
     void ResetRead() { return Combinational_SimPorts_abs<Message,MARSHALL_PORT>::ResetRead(); }
     void ResetWrite() { return Combinational_SimPorts_abs<Message,MARSHALL_PORT>::ResetWrite(); }
@@ -5143,6 +6217,28 @@ namespace Connections
         }
       }
 
+      bool set_binary_log(channel_log_writer *w, int &log_num) {
+        OutBlocking<Message, MARSHALL_PORT> *driver = &(parent.sim_out);
+        std::string path_name = parent.name();
+        if (parent.driver) {
+          driver = parent.driver;
+          while (driver->driver)
+          { driver = driver->driver; }
+          path_name = parent._DATNAMEOUT_.name();
+        }
+
+        driver->set_binary_log(++log_num, w);
+        w->add_channel(log_num, Wrapped<Message>::width, path_name);
+        return true;
+      }
+
+      bool set_wave(wave_writer *w) {
+        w->add(parent._VLDNAMEOUT_, parent._VLDNAMEOUT_.name());
+        w->add(parent._RDYNAMEOUT_, parent._RDYNAMEOUT_.name());
+        w->add(parent._DATNAMEOUT_, parent._DATNAMEOUT_.name());
+        return true;
+      }
+
     } dummyPortManager;
 #endif
   };
@@ -5207,6 +6303,18 @@ namespace Connections
     }
 #endif
 
+#ifdef CONNECTIONS_SIM_ONLY
+    Blocking_abs *profile_clock_port() {
+      OutBlocking<Message, DIRECT_PORT> *d = &(this->sim_out);
+      if (driver) {
+        d = driver;
+        while (d->driver)
+        { d = d->driver; }
+      }
+      return d;
+    }
+#endif
+
     // Parent functions, to get around Catapult virtual function bug.
     void ResetRead() { return Combinational_SimPorts_abs<Message,DIRECT_PORT>::ResetRead(); }
     void ResetWrite() { return Combinational_SimPorts_abs<Message,DIRECT_PORT>::ResetWrite(); }
@@ -5341,6 +6449,31 @@ namespace Connections
         }
       }
 
+      bool set_binary_log(channel_log_writer *w, int &log_num) {
+        OutBlocking<Message, DIRECT_PORT> *driver = &(parent.sim_out);
+        std::string path_name = parent.name();
+        if (parent.driver) {
+          driver = parent.driver;
+          while (driver->driver)
+          { driver = driver->driver; }
+          path_name = parent._DATNAMEOUT_.name();
+        }
+
+        driver->set_binary_log(++log_num, w);
+        w->add_channel(log_num, Wrapped<Message>::width, path_name);
+        return true;
+      }
+
+      bool set_wave(wave_writer *w) {
+        w->add(parent._VLDNAMEOUT_, parent._VLDNAMEOUT_.name());
+        w->add(parent._RDYNAMEOUT_, parent._RDYNAMEOUT_.name());
+        sc_signal<Message> *dat = &parent._DATNAMEOUT_;
+        w->add(dat->name(), Wrapped<Message>::width, dat->value_changed_event(), [dat](uint64_t *words) {
+          wave_writer::lv_to_words(convert_to_lv<Message>(dat->read()), words);
+        });
+        return true;
+      }
+
     } dummyPortManager;
 #endif
   };
@@ -5454,13 +6587,23 @@ namespace Connections
      return 1;
     }
 
+    virtual bool set_binary_log(channel_log_writer *w, int &log_num) {
+     bin_log = w;
+     log_number = ++log_num;
+     w->add_channel(log_number, Wrapped<Message>::width, fifo.name());
+     return 1;
+    }
+
     virtual void write_log(const Message& m) {
       if (log_stream)
        *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; 
+      if (bin_log)
+       bin_log->write(log_number, convert_to_lv<Message>(m));
     }
 
     std::ofstream *log_stream{0};
     int log_number{0};
+    channel_log_writer *bin_log{0};
 
   protected:
     void reset_msg() {
@@ -5477,7 +6620,7 @@ namespace Connections
     }
 
   public:
-    tlm::tlm_fifo<Message> fifo;
+    tlm_port_fifo<Message> fifo;
   };
 #endif // CONNECTIONS_SIM_ONLY
 
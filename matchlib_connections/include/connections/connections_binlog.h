@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// Binary channel log writer used by channel_logs::enable_binary()
+//
+// Each transfer is written as one record:
+//
+//   uint32_t channel   log number of the channel, as listed in the index file
+//   uint32_t nbytes    number of payload bytes following the header (multiple of 8)
+//   uint64_t time      sc_time_stamp().value(), in units of the resolution in the index
+//   uint32_t words[]   marshalled message bits, 32 bits per word, LSB first, zero padded
+//
+// Records go through a buffered_file_writer, which writes them to disk from a background
+// thread, so the simulation thread never formats or blocks on I/O unless the flush thread
+// falls a whole buffer behind.
+//
+// The index file is text:
+//
+//   connections_binlog 1
+//   resolution <time resolution in seconds>
+//   channel <log number> <width in bits> <path name>
+//   ...
+//   count <log number> <number of records>     (written on close)
+//
+// Use connections_binlog_reader.h to read, filter and convert logs back to text.
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__CONNECTIONS_BINLOG_H__
+#define __CONNECTIONS__CONNECTIONS_BINLOG_H__
+
+#include <systemc>
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "buffered_file_writer.h"
+
+namespace Connections
+{
+
+  struct channel_log_record_header {
+    uint32_t channel;
+    uint32_t nbytes;
+    uint64_t time;
+  };
+
+  class channel_log_writer
+  {
+  public:
+    ~channel_log_writer() { close(); }
+
+    bool is_open() const { return data.is_open(); }
+
+    // Open data and index files. buffer_bytes is the size of each of the two buffers.
+    bool open(const std::string &data_name, const std::string &index_name, size_t buffer_bytes = (4 << 20)) {
+      close();
+      if (!data.open(data_name, buffer_bytes)) { return false; }
+      index.open(index_name.c_str());
+      if (!index.is_open()) {
+        std::cerr << "Cannot open file '" << index_name << "'" << std::endl;
+        data.close();
+        return false;
+      }
+      index << "connections_binlog 1\n";
+      index << "resolution " << sc_core::sc_get_time_resolution().to_seconds() << "\n";
+      index.flush();
+      return true;
+    }
+
+    void close() {
+      if (!data.is_open()) { return; }
+      data.close();
+
+      for (unsigned i=0; i < counts.size(); i++) {
+        if (counts[i]) { index << "count " << i << " " << counts[i] << "\n"; }
+      }
+      index.close();
+    }
+
+    // Register a channel; its records will carry log_number as channel id
+    void add_channel(int log_number, unsigned width, const std::string &path_name) {
+      index << "channel " << log_number << " " << width << " " << path_name << "\n";
+      index.flush();
+      if (counts.size() <= static_cast<unsigned>(log_number)) { counts.resize(log_number + 1, 0); }
+    }
+
+    template <int W>
+    void write(int log_number, const sc_dt::sc_lv<W> &bits) {
+      static const unsigned nwords = (W + 31) / 32;
+      static const unsigned nbytes = ((nwords * 4 + 7) / 8) * 8;
+
+      char *p = data.reserve(sizeof(channel_log_record_header) + nbytes);
+      channel_log_record_header h;
+      h.channel = log_number;
+      h.nbytes = nbytes;
+      h.time = sc_core::sc_time_stamp().value();
+      std::memcpy(p, &h, sizeof(h));
+      p += sizeof(h);
+
+      for (unsigned i=0; i < nwords; i++) {
+        // sc_lv data plane; X and Z are not preserved
+        uint32_t w = bits.get_word(i);
+        if ((i == nwords - 1) && (W % 32)) { w &= (~0u >> (32 - (W % 32))); }
+        std::memcpy(p, &w, 4);
+        p += 4;
+      }
+      if (nwords & 1) { std::memset(p, 0, 4); }
+
+      ++counts[log_number];
+    }
+
+  private:
+    buffered_file_writer data;
+    std::ofstream index;
+    std::vector<unsigned long long> counts;
+  };
+
+}  // namespace Connections
+
+#endif  // __CONNECTIONS__CONNECTIONS_BINLOG_H__
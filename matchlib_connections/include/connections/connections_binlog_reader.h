@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// Reader for binary channel logs written by channel_logs::enable_binary()
+//
+// Does not depend on SystemC, so log post-processing tools can be built standalone.
+// The data file is memory mapped and records are decoded in place.
+//
+// Example usage:
+//
+//  #include <connections/connections_binlog_reader.h>
+//
+//  Connections::channel_log_reader r;
+//  if (r.open("log")) { return 1; }
+//
+//  // all records of one channel
+//  int ch = r.find_channel("top.dut.out1");
+//  for (Connections::channel_log_reader::iterator it = r.begin(ch); it != r.end(); ++it) {
+//    std::cout << it->time << " " << it->hex() << "\n";
+//  }
+//
+//  // same content as channel_logs::enable() produces
+//  r.to_text(std::cout);
+//
+// Note that the text conversion prints the marshalled message bits in hex, not the
+// result of the message type's operator<<, since the reader has no type information.
+// For built-in integer message types the two are the same. ac_int prints in upper case
+// with a 0x prefix, so the text logs of ac_int channels differ in format.
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__CONNECTIONS_BINLOG_READER_H__
+#define __CONNECTIONS__CONNECTIONS_BINLOG_READER_H__
+
+#include <stdint.h>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Connections
+{
+
+  class channel_log_reader
+  {
+  public:
+    struct channel_info {
+      int id;
+      unsigned width;
+      std::string name;
+      unsigned long long count;
+    };
+
+    struct record {
+      uint32_t channel;
+      uint64_t time;
+      unsigned width;
+      const uint32_t *words;
+
+      bool bit(unsigned i) const { return (words[i / 32] >> (i % 32)) & 1; }
+
+      // Marshalled bits as lower case hex without leading zeros
+      std::string hex() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string s;
+        for (int n = static_cast<int>((width + 3) / 4) - 1; n >= 0; n--) {
+          unsigned nib = (words[n / 8] >> ((n % 8) * 4)) & 0xf;
+          if (s.empty() && (nib == 0) && (n > 0)) { continue; }
+          s += digits[nib];
+        }
+        return s.empty() ? std::string("0") : s;
+      }
+    };
+
+    class iterator
+    {
+    public:
+      iterator() : r(0), pos(0), filter(-1) {}
+
+      const record &operator*() const { return rec; }
+      const record *operator->() const { return &rec; }
+
+      iterator &operator++() {
+        pos = next_pos;
+        load();
+        return *this;
+      }
+
+      bool operator==(const iterator &rhs) const { return pos == rhs.pos; }
+      bool operator!=(const iterator &rhs) const { return pos != rhs.pos; }
+
+      // Byte offset of the current record in the data file
+      size_t offset() const { return pos; }
+
+    private:
+      friend class channel_log_reader;
+      const channel_log_reader *r;
+      size_t pos;
+      size_t next_pos;
+      int filter;
+      record rec;
+
+      iterator(const channel_log_reader *r_, size_t pos_, int filter_) : r(r_), pos(pos_), filter(filter_) { load(); }
+
+      // Decode the record at pos, skipping records of other channels when filtering
+      void load() {
+        while (pos + header_bytes <= r->size) {
+          const char *p = r->data + pos;
+          uint32_t nbytes;
+          std::memcpy(&rec.channel, p, 4);
+          std::memcpy(&nbytes, p + 4, 4);
+          std::memcpy(&rec.time, p + 8, 8);
+          next_pos = pos + header_bytes + nbytes;
+          if (next_pos > r->size) { break; } // truncated log
+          if ((filter < 0) || (static_cast<int>(rec.channel) == filter)) {
+            rec.words = reinterpret_cast<const uint32_t *>(p + header_bytes);
+            rec.width = r->width_of(rec.channel);
+            if (rec.width == 0) { rec.width = nbytes * 8; }
+            return;
+          }
+          pos = next_pos;
+        }
+        pos = r->size;
+      }
+    };
+
+    channel_log_reader() : data(0), size(0), fd(-1), resolution(1e-12) {}
+
+    ~channel_log_reader() { close(); }
+
+    // Open <fname_base>_index.txt and map <fname_base>_data.bin. Returns 0 on success.
+    int open(const std::string &fname_base) {
+      close();
+      if (read_index(fname_base + "_index.txt")) { return 1; }
+
+      std::string data_name = fname_base + "_data.bin";
+      fd = ::open(data_name.c_str(), O_RDONLY);
+      if (fd < 0) {
+        std::cerr << "Cannot open file '" << data_name << "'" << std::endl;
+        return 1;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0) { close(); return 1; }
+      size = st.st_size;
+      if (size) {
+        void *m = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+          std::cerr << "Cannot map file '" << data_name << "'" << std::endl;
+          close();
+          return 1;
+        }
+        madvise(m, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(m);
+      }
+      return 0;
+    }
+
+    void close() {
+      if (data) { munmap(const_cast<char *>(data), size); }
+      if (fd >= 0) { ::close(fd); }
+      data = 0;
+      size = 0;
+      fd = -1;
+      channels.clear();
+      channel_index.clear();
+    }
+
+    // Iterate over all records, or only over the records of one channel
+    iterator begin(int channel = -1) const { return iterator(this, 0, channel); }
+    iterator end() const { iterator it; it.pos = size; return it; }
+
+    const std::vector<channel_info> &get_channels() const { return channels; }
+
+    // Log number of the channel with the given path name, -1 if not found
+    int find_channel(const std::string &name) const {
+      for (unsigned i=0; i < channels.size(); i++) {
+        if (channels[i].name == name) { return channels[i].id; }
+      }
+      return -1;
+    }
+
+    unsigned width_of(uint32_t channel) const {
+      std::map<int, unsigned>::const_iterator it = channel_index.find(channel);
+      return (it == channel_index.end()) ? 0 : channels[it->second].width;
+    }
+
+    double time_resolution() const { return resolution; }
+
+    // Format a time stamp the way sc_time is printed, eg. "10 ns" or "1500 ps"
+    std::string time_string(uint64_t t) const {
+      static const char *units[] = { "fs", "ps", "ns", "us", "ms", "s" };
+      if (t == 0) { return "0 s"; }
+      // express in fs, the finest unit SystemC supports
+      uint64_t fs_per_tick = static_cast<uint64_t>(resolution * 1e15 + 0.5);
+      std::ostringstream ss;
+      ss << t * fs_per_tick;
+      std::string s = ss.str();
+      unsigned u = 0;
+      while ((u < 5) && (s.length() > 3) && (s.compare(s.length() - 3, 3, "000") == 0)) {
+        s.erase(s.length() - 3);
+        u++;
+      }
+      return s + " " + units[u];
+    }
+
+    // Write records in the text format of channel_logs::enable(): "num | hex(msg) | time"
+    void to_text(std::ostream &os, int channel = -1) const {
+      for (iterator it = begin(channel); it != end(); ++it) {
+        os << std::dec << it->channel << " | " << it->hex() << " | " << time_string(it->time) << "\n";
+      }
+    }
+
+    // Write names file in the format of channel_logs::enable()
+    void names_to_text(std::ostream &os) const {
+      for (unsigned i=0; i < channels.size(); i++) {
+        os << channels[i].id << " " << channels[i].name << "\n";
+      }
+    }
+
+  private:
+    static const size_t header_bytes = 16;
+
+    const char *data;
+    size_t size;
+    int fd;
+    double resolution;
+    std::vector<channel_info> channels;
+    std::map<int, unsigned> channel_index;
+
+    int read_index(const std::string &index_name) {
+      std::ifstream in(index_name.c_str());
+      if (!in.is_open()) {
+        std::cerr << "Cannot open file '" << index_name << "'" << std::endl;
+        return 1;
+      }
+      std::string line;
+      while (std::getline(in, line)) {
+        std::istringstream ls(line);
+        std::string key;
+        ls >> key;
+        if (key == "resolution") {
+          ls >> resolution;
+        } else if (key == "channel") {
+          channel_info ci;
+          ls >> ci.id >> ci.width >> std::ws;
+          std::getline(ls, ci.name);
+          ci.count = 0;
+          channel_index[ci.id] = channels.size();
+          channels.push_back(ci);
+        } else if (key == "count") {
+          int id;
+          unsigned long long n;
+          ls >> id >> n;
+          if (channel_index.count(id)) { channels[channel_index[id]].count = n; }
+        }
+      }
+      return 0;
+    }
+  };
+
+}  // namespace Connections
+
+#endif  // __CONNECTIONS__CONNECTIONS_BINLOG_READER_H__
@@ -326,7 +326,7 @@ namespace Connections
 
 #ifdef CONNECTIONS_SIM_ONLY
   //------------------------------------------------------------------------
-  // Fifo - TLM_PORT specialization uses sized tlm::tlm_fifo
+  // Fifo - TLM_PORT specialization uses a sized tlm_port_fifo (tlm::tlm_fifo, or handoff_fifo with CONNECTIONS_TLM_HANDOFF)
   //------------------------------------------------------------------------
   template <typename Message, unsigned int NumEntries>
   class Fifo<Message, NumEntries, TLM_PORT> : public sc_module
@@ -377,7 +377,7 @@ namespace Connections
     }
 
   protected:
-    tlm::tlm_fifo<Message> fifo;
+    tlm_port_fifo<Message> fifo;
 
   public:
     #ifndef __SYNTHESIS__
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// Cached index of the sc_object hierarchy, shared by the passes that look for Connections
+// objects under a level of hierarchy: trace_hierarchy(), channel_logs::log_hierarchy(),
+// channel_profiler, port_scanner and the clock discovery of SimConnectionsClk.
+//
+// The whole tree is walked once, iteratively, in preorder. Each object gets its preorder
+// position and the position just past its subtree, so "is a descendant of" is a range
+// check and the objects under a root form one contiguous range. Objects of a given type
+// are classified with dynamic_cast the first time that type is asked for, then found
+// with a binary search over the range.
+//
+//   Connections::hier_index &idx = Connections::get_hier_index();
+//   std::vector<Connections::sc_trace_marker *> markers;
+//   idx.find(&top, markers);                        // markers under top, top included
+//   bool inside = idx.is_descendant_of(obj, &top);  // strict descendant
+//
+// Once elaboration is complete (from end_of_elaboration on) modules, ports and channels
+// can no longer be created, and the index is built once and kept. A query made during
+// elaboration builds a provisional index, rebuilt on the first query after elaboration,
+// or when asked for a root it does not know. Code that creates objects under an already
+// indexed module during elaboration and then queries again must call invalidate().
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__CONNECTIONS_HIER_INDEX_H__
+#define __CONNECTIONS__CONNECTIONS_HIER_INDEX_H__
+
+#include <systemc>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <typeinfo>
+#include <typeindex>
+#include <algorithm>
+
+namespace Connections
+{
+
+  class hier_index
+  {
+  public:
+    hier_index() : built(false), final(false) {}
+
+    // Drop the index, the next query rebuilds it
+    void invalidate() {
+      built = false;
+      final = false;
+      objects.clear();
+      subtree_end.clear();
+      position.clear();
+      by_type.clear();
+    }
+
+    // Number of objects in the index
+    size_t size() {
+      refresh(0);
+      return objects.size();
+    }
+
+    // All objects of type T under root (root included) in preorder, appended to found.
+    // With root == 0, all objects of type T in the design.
+    template <typename T>
+    void find(sc_core::sc_object *root, std::vector<T *> &found) {
+      refresh(root);
+      const std::vector<entry> &v = classify<T>();
+      size_t first = 0, last = objects.size();
+      if (root) {
+        std::unordered_map<const sc_core::sc_object *, unsigned>::const_iterator it = position.find(root);
+        if (it == position.end()) { return; }
+        first = it->second;
+        last = subtree_end[first];
+      }
+      typename std::vector<entry>::const_iterator b =
+        std::lower_bound(v.begin(), v.end(), static_cast<unsigned>(first), entry_before);
+      for (; (b != v.end()) && (b->pos < last); ++b) {
+        found.push_back(static_cast<T *>(b->ptr));
+      }
+    }
+
+    // Preorder position of obj, or -1 if it is not indexed. Orders objects found by
+    // separate find() calls the way a recursive walk would have visited them.
+    long position_of(sc_core::sc_object *obj) {
+      refresh(0);
+      std::unordered_map<const sc_core::sc_object *, unsigned>::const_iterator it = position.find(obj);
+      return (it == position.end()) ? -1 : static_cast<long>(it->second);
+    }
+
+    // True if child is below ancestor, not counting ancestor itself
+    bool is_descendant_of(sc_core::sc_object *child, sc_core::sc_object *ancestor) {
+      refresh(ancestor);
+      std::unordered_map<const sc_core::sc_object *, unsigned>::const_iterator c = position.find(child);
+      std::unordered_map<const sc_core::sc_object *, unsigned>::const_iterator a = position.find(ancestor);
+      if ((c == position.end()) || (a == position.end())) {
+        // Not indexed (created after the index was built), walk up instead
+        for (sc_core::sc_object *p = child->get_parent_object(); p; p = p->get_parent_object()) {
+          if (p == ancestor) { return true; }
+        }
+        return false;
+      }
+      return (a->second < c->second) && (c->second < subtree_end[a->second]);
+    }
+
+  private:
+    struct entry {
+      unsigned pos;  // preorder position of the object
+      void *ptr;     // the object, as the T * it was classified for
+    };
+
+    bool built;
+    bool final;
+    std::vector<sc_core::sc_object *> objects;   // preorder
+    std::vector<unsigned> subtree_end;           // one past the last descendant
+    std::unordered_map<const sc_core::sc_object *, unsigned> position;
+    std::map<std::type_index, std::vector<entry> > by_type;
+
+    static bool entry_before(const entry &e, unsigned pos) { return e.pos < pos; }
+
+    static bool elaboration_done() {
+      sc_core::sc_status s = sc_core::sc_get_status();
+      return (s != sc_core::SC_ELABORATION) && (s != sc_core::SC_BEFORE_END_OF_ELABORATION);
+    }
+
+    void refresh(sc_core::sc_object *root) {
+      if (built && final) { return; }
+      if (built && !elaboration_done() && (!root || position.count(root))) { return; }
+      invalidate();
+      build();
+    }
+
+    void build() {
+      const std::vector<sc_core::sc_object *> &tops = sc_core::sc_get_top_level_objects();
+
+      // Iterative preorder walk. todo holds the objects still to visit, with a 0 pushed
+      // below the children of each object to mark where its subtree ends.
+      std::vector<sc_core::sc_object *> todo;
+      std::vector<unsigned> open;
+      for (size_t i = tops.size(); i > 0; i--) {
+        if (tops[i - 1]) { todo.push_back(tops[i - 1]); }
+      }
+      while (!todo.empty()) {
+        sc_core::sc_object *obj = todo.back();
+        todo.pop_back();
+        if (!obj) {
+          // End of subtree marker
+          subtree_end[open.back()] = static_cast<unsigned>(objects.size());
+          open.pop_back();
+          continue;
+        }
+        unsigned pos = static_cast<unsigned>(objects.size());
+        objects.push_back(obj);
+        subtree_end.push_back(pos + 1);
+        position[obj] = pos;
+
+        const std::vector<sc_core::sc_object *> &children = obj->get_child_objects();
+        if (children.empty()) { continue; }
+        open.push_back(pos);
+        todo.push_back(0);
+        for (size_t i = children.size(); i > 0; i--) {
+          if (children[i - 1]) { todo.push_back(children[i - 1]); }
+        }
+      }
+
+      built = true;
+      final = elaboration_done();
+    }
+
+    template <typename T>
+    const std::vector<entry> &classify() {
+      std::map<std::type_index, std::vector<entry> >::iterator it = by_type.find(std::type_index(typeid(T)));
+      if (it != by_type.end()) { return it->second; }
+
+      std::vector<entry> &v = by_type[std::type_index(typeid(T))];
+      for (unsigned i=0; i < objects.size(); i++) {
+        if (T *p = dynamic_cast<T *>(objects[i])) {
+          entry e;
+          e.pos = i;
+          e.ptr = p;
+          v.push_back(e);
+        }
+      }
+      return v;
+    }
+  };
+
+  template <class Dummy>
+  struct hier_index_statics {
+    static hier_index index;
+  };
+
+  template <class Dummy>
+  hier_index hier_index_statics<Dummy>::index;
+
+  inline hier_index &get_hier_index()
+  {
+    return hier_index_statics<void>::index;
+  }
+
+}  // namespace Connections
+
+#endif  // __CONNECTIONS__CONNECTIONS_HIER_INDEX_H__
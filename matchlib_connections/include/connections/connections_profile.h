@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// connections_profile.h
+//
+// Per-channel throughput and stall profiler.
+//
+// Attaches to every Combinational channel and every matchlib Buffer, BypassBuffered,
+// Bypass and Pipeline under a level of hierarchy and samples its handshake signals
+// once per active edge of the channel's clock. For each channel it collects:
+//
+//   transfers          cycles with deq valid and ready
+//   stalled_on_ready   cycles with deq valid but not ready (consumer holding back)
+//   starved_on_valid   cycles with deq ready but not valid (producer not keeping up)
+//   input_blocked      cycles with enq valid but not ready (channel full)
+//   occupancy          histogram of the number of messages held by the channel
+//   latency            cycles from enq to deq of each message
+//
+// The JSON report lists channels ranked by backpressure, the fraction of cycles in
+// which the channel held back its producer. The consumer at the downstream end of a
+// run of highly ranked channels is usually the bottleneck.
+//
+// Requires CONNECTIONS_SIM_ONLY, MARSHALL_PORT or DIRECT_PORT channels, and RapidJSON.
+//
+// Example usage in sc_main()
+//
+//  Top top("top");
+//  Connections::channel_profiler prof("profile.json");
+//  prof.profile_hierarchy(top);
+//  sc_start();
+//  // report is written when prof is destroyed, or explicitly with prof.write_report()
+//
+// or, with a profiler owned by the library, in one call like trace_hierarchy():
+//
+//  profile_hierarchy(&top, "profile.json");
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__CONNECTIONS_PROFILE_H__
+#define __CONNECTIONS__CONNECTIONS_PROFILE_H__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <algorithm>
+#include <fstream>
+
+#include "connections.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/ostreamwrapper.h>
+
+namespace Connections
+{
+
+#ifdef CONNECTIONS_SIM_ONLY
+
+  class channel_profiler
+  {
+  public:
+    struct channel_stats {
+      channel_probe probe;
+      unsigned long long cycles;
+      unsigned long long transfers;
+      unsigned long long stalled_on_ready;
+      unsigned long long starved_on_valid;
+      unsigned long long input_blocked;
+      unsigned long long latency_count;
+      unsigned long long latency_sum;
+      unsigned long long latency_min;
+      unsigned long long latency_max;
+      unsigned capacity;
+      std::vector<unsigned long long> occupancy;
+      std::deque<unsigned long long> enq_cycle;
+
+      explicit channel_stats(const channel_probe &p)
+        : probe(p), cycles(0), transfers(0), stalled_on_ready(0), starved_on_valid(0)
+        , input_blocked(0), latency_count(0), latency_sum(0), latency_min(0), latency_max(0)
+        , capacity(0) {}
+
+      double backpressure() const {
+        unsigned long long held = std::max(stalled_on_ready, input_blocked);
+        return cycles ? static_cast<double>(held) / cycles : 0.0;
+      }
+    };
+
+    explicit channel_profiler(const std::string &report_name_ = "") : report_name(report_name_), started(false) {}
+
+    ~channel_profiler() {
+      if (!report_name.empty()) { write_report(report_name); }
+    }
+
+    // Attach to all profilable channels under obj. Call before sc_start().
+    void profile_hierarchy(sc_object &obj) {
+      std::vector<channel_probe> probes;
+      collect(&obj, probes);
+      for (unsigned i=0; i < probes.size(); i++) { channels.push_back(channel_stats(probes[i])); }
+      if (!started) {
+        started = true;
+        sc_spawn(sc_bind(&channel_profiler::start, this), sc_gen_unique_name("channel_profiler"));
+      }
+    }
+
+    const std::vector<channel_stats> &get_channels() const { return channels; }
+
+    // File the report is written to when the profiler is destroyed, empty for none
+    const std::string &get_report_name() const { return report_name; }
+    void set_report_name(const std::string &name) { report_name = name; }
+
+    // Channel indices ordered from most to least backpressure
+    std::vector<unsigned> ranking() const {
+      std::vector<unsigned> order(channels.size());
+      for (unsigned i=0; i < order.size(); i++) { order[i] = i; }
+      std::stable_sort(order.begin(), order.end(), [this](unsigned a, unsigned b) {
+        return channels[a].backpressure() > channels[b].backpressure();
+      });
+      return order;
+    }
+
+    void write_report(const std::string &fname) const {
+      rapidjson::Document d;
+      d.SetObject();
+      rapidjson::Document::AllocatorType &a = d.GetAllocator();
+
+      rapidjson::Value v_channels(rapidjson::kArrayType);
+      std::vector<unsigned> order = ranking();
+      for (unsigned r=0; r < order.size(); r++) {
+        const channel_stats &c = channels[order[r]];
+        rapidjson::Value v(rapidjson::kObjectType);
+        v.AddMember("rank", r + 1, a);
+        v.AddMember("name", rapidjson::Value(c.probe.name.c_str(), a), a);
+        v.AddMember("kind", rapidjson::Value(c.probe.kind.c_str(), a), a);
+        v.AddMember("cycles", static_cast<uint64_t>(c.cycles), a);
+        v.AddMember("transfers", static_cast<uint64_t>(c.transfers), a);
+        v.AddMember("throughput", c.cycles ? static_cast<double>(c.transfers) / c.cycles : 0.0, a);
+        v.AddMember("stalled_on_ready", static_cast<uint64_t>(c.stalled_on_ready), a);
+        v.AddMember("starved_on_valid", static_cast<uint64_t>(c.starved_on_valid), a);
+        v.AddMember("input_blocked", static_cast<uint64_t>(c.input_blocked), a);
+        v.AddMember("backpressure", c.backpressure(), a);
+        v.AddMember("capacity", c.capacity, a);
+
+        rapidjson::Value v_occ(rapidjson::kObjectType);
+        rapidjson::Value v_hist(rapidjson::kArrayType);
+        unsigned long long occ_sum = 0, occ_n = 0;
+        unsigned occ_max = 0;
+        for (unsigned i=0; i < c.occupancy.size(); i++) {
+          v_hist.PushBack(static_cast<uint64_t>(c.occupancy[i]), a);
+          occ_sum += c.occupancy[i] * i;
+          occ_n += c.occupancy[i];
+          if (c.occupancy[i]) { occ_max = i; }
+        }
+        v_occ.AddMember("mean", occ_n ? static_cast<double>(occ_sum) / occ_n : 0.0, a);
+        v_occ.AddMember("max", occ_max, a);
+        v_occ.AddMember("histogram", v_hist, a);
+        v.AddMember("occupancy", v_occ, a);
+
+        rapidjson::Value v_lat(rapidjson::kObjectType);
+        v_lat.AddMember("count", static_cast<uint64_t>(c.latency_count), a);
+        v_lat.AddMember("min", static_cast<uint64_t>(c.latency_min), a);
+        v_lat.AddMember("max", static_cast<uint64_t>(c.latency_max), a);
+        v_lat.AddMember("mean", c.latency_count ? static_cast<double>(c.latency_sum) / c.latency_count : 0.0, a);
+        v.AddMember("latency", v_lat, a);
+
+        v_channels.PushBack(v, a);
+      }
+      d.AddMember("channels", v_channels, a);
+
+      std::ofstream ofs(fname.c_str());
+      if (!ofs.is_open()) {
+        std::cerr << "Cannot open file '" << fname << "'" << std::endl;
+        return;
+      }
+      rapidjson::OStreamWrapper osw(ofs);
+      rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(osw);
+      d.Accept(writer);
+    }
+
+  private:
+    std::string report_name;
+    bool started;
+    std::vector<channel_stats> channels;
+    std::vector<std::vector<unsigned> > groups;
+
+    void collect(sc_object *obj, std::vector<channel_probe> &probes) {
+      std::vector<sc_profile_marker *> markers;
+      get_hier_index().find(obj, markers);
+      for (unsigned i=0; i < markers.size(); i++) {
+        markers[i]->set_profile(probes);
+      }
+    }
+
+    // Group channels by clock edge once all ports have registered their clocks,
+    // then sample each group with one method process.
+    void start() {
+      wait(100, SC_PS);  // after ConManager::check_registration
+
+      std::map<const sc_event *, unsigned> group_of;
+      for (unsigned i=0; i < channels.size(); i++) {
+        const sc_event *e = channels[i].probe.edge();
+        if (group_of.find(e) == group_of.end()) {
+          group_of[e] = groups.size();
+          groups.push_back(std::vector<unsigned>());
+        }
+        groups[group_of[e]].push_back(i);
+      }
+
+      for (std::map<const sc_event *, unsigned>::iterator it = group_of.begin(); it != group_of.end(); ++it) {
+        sc_spawn_options opt;
+        opt.spawn_method();
+        opt.set_sensitivity(it->first);
+        opt.dont_initialize();
+        sc_spawn(sc_bind(&channel_profiler::sample, this, it->second), sc_gen_unique_name("channel_profiler_sample"), &opt);
+      }
+    }
+
+    // Signals read at the edge hold the values of the cycle that just completed
+    void sample(unsigned g) {
+      const std::vector<unsigned> &group = groups[g];
+      for (unsigned i=0; i < group.size(); i++) {
+        channel_stats &c = channels[group[i]];
+        channel_sample s;
+        c.probe.sample(s);
+
+        c.cycles++;
+        if (s.in_vld && s.in_rdy) { c.enq_cycle.push_back(c.cycles); }
+        if (s.in_vld && !s.in_rdy) { c.input_blocked++; }
+
+        if (s.out_vld && s.out_rdy) {
+          c.transfers++;
+          if (!c.enq_cycle.empty()) {
+            unsigned long long lat = c.cycles - c.enq_cycle.front();
+            c.enq_cycle.pop_front();
+            if ((c.latency_count == 0) || (lat < c.latency_min)) { c.latency_min = lat; }
+            if (lat > c.latency_max) { c.latency_max = lat; }
+            c.latency_sum += lat;
+            c.latency_count++;
+          }
+        } else if (s.out_vld) {
+          c.stalled_on_ready++;
+        } else if (s.out_rdy) {
+          c.starved_on_valid++;
+        }
+
+        if (s.capacity > c.capacity) { c.capacity = s.capacity; }
+        unsigned occ = std::min(s.occupancy, std::max(s.capacity, 1u));
+        if (c.occupancy.size() <= occ) { c.occupancy.resize(occ + 1, 0); }
+        c.occupancy[occ]++;
+      }
+    }
+  };
+
+  // The profiler owned by the library. A non-empty report_name sets its report file on
+  // any call; since it writes a single report, a name that differs from one already
+  // set is an error.
+  inline channel_profiler &get_channel_profiler(const std::string &report_name = "") {
+    static channel_profiler prof;
+    if (!report_name.empty() && (report_name != prof.get_report_name())) {
+      if (prof.get_report_name().empty()) {
+        prof.set_report_name(report_name);
+      } else {
+        SC_REPORT_ERROR("channel_profiler", ("the report is already written to '" + prof.get_report_name()
+                                             + "', cannot also write it to '" + report_name + "'").c_str());
+      }
+    }
+    return prof;
+  }
+
+#endif // CONNECTIONS_SIM_ONLY
+
+}  // namespace Connections
+
+// Function: profile_hierarchy(sc_object* obj, std::string report_name)
+//  Profile all Connections channels in the hierarchy. The report is written
+//  at program exit. It may be called for several hierarchies, all with the same
+//  report_name; a different report_name is reported as an error.
+//
+static inline void profile_hierarchy( sc_object *obj, const std::string &report_name = "channel_profile.json" )
+{
+#ifdef CONNECTIONS_SIM_ONLY
+  Connections::get_channel_profiler(report_name).profile_hierarchy(*obj);
+#endif
+}
+
+#endif // __CONNECTIONS__CONNECTIONS_PROFILE_H__
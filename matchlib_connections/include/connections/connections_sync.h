@@ -488,6 +488,13 @@ namespace Connections
       sc_trace(fp, this->vld, this->vld.name());
     }
 
+    virtual bool set_wave(Connections::wave_writer* w)
+    {
+      w->add(this->rdy, this->rdy.name());
+      w->add(this->vld, this->vld.name());
+      return true;
+    }
+
     virtual bool set_log(std::ofstream* os, int& log_num, std::string& path_name) { return false; }
 #endif
   };
@@ -618,6 +625,12 @@ namespace Connections
       sc_trace(fp, this->vld, this->vld.name());
     }
 
+    virtual bool set_wave(Connections::wave_writer* w)
+    {
+      w->add(this->vld, this->vld.name());
+      return true;
+    }
+
     virtual bool set_log(std::ofstream* os, int& log_num, std::string& path_name) { return false; }
 #endif
   };
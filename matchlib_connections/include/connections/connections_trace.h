@@ -33,6 +33,8 @@
 //
 //
 // Revision History:
+//  1.2.6    - Find markers through the cached hier_index, see connections_hier_index.h
+//  1.2.5    - Add compressed waveform writer, see connections_wave.h
 //  1.2.4    - CAT-26848: Add waveform tracing for Matchlib SyncChannel
 //  1.2.0    - Refactored tracing from mc_connections.h
 //
@@ -59,6 +61,11 @@ struct MyType
 **/
 
 #ifdef CONNECTIONS_SIM_ONLY
+#include <functional>
+#include "connections_binlog.h"
+#include "connections_wave.h"
+#include "connections_hier_index.h"
+
 namespace Connections 
 {
   // Used to mark and select Connections Sync and Combinational channels for tracing
@@ -67,6 +74,34 @@ namespace Connections
   public:
     virtual void set_trace(sc_trace_file *trace_file_ptr) = 0;
     virtual bool set_log(std::ofstream *os, int &log_num, std::string &path_name) = 0;
+    // Binary logging is optional: channels that do not support it are skipped
+    virtual bool set_binary_log(channel_log_writer *w, int &log_num) { return false; }
+    // Compressed waveform tracing is optional as well
+    virtual bool set_wave(wave_writer *w) { return false; }
+  };
+
+  // Handshake state of a channel at an active clock edge, see connections_profile.h
+  struct channel_sample {
+    bool in_vld, in_rdy;    // producer side
+    bool out_vld, out_rdy;  // consumer side
+    unsigned occupancy;     // messages held by the channel
+    unsigned capacity;      // 0 for unbuffered channels
+  };
+
+  struct channel_probe {
+    std::string name;
+    std::string kind;
+    std::function<void(channel_sample &)> sample;
+    // Resolved at start of simulation, once ports are bound and clocks are registered
+    std::function<const sc_event *()> edge;
+  };
+
+  // Used to mark and select Connections Combinational channels and matchlib
+  // Buffer, Bypass and Pipeline modules for profiling
+  class sc_profile_marker
+  {
+  public:
+    virtual void set_profile(std::vector<channel_probe> &probes) = 0;
   };
 }
 #endif
@@ -83,18 +118,38 @@ namespace Connections
 static inline void trace_hierarchy( sc_object *obj, sc_trace_file *file_ptr )
 {
 #ifdef CONNECTIONS_SIM_ONLY
-  if ( Connections::sc_trace_marker *p = dynamic_cast<Connections::sc_trace_marker *>(obj) ) {
-    p->set_trace(file_ptr);
-  }
-  std::vector<sc_object *> children = obj->get_child_objects();
-  for ( unsigned i = 0; i < children.size(); i++ ) {
-    if ( children[i] ) {
-      trace_hierarchy(children[i], file_ptr);
-    }
+  std::vector<Connections::sc_trace_marker *> markers;
+  Connections::get_hier_index().find(obj, markers);
+  for ( unsigned i = 0; i < markers.size(); i++ ) {
+    markers[i]->set_trace(file_ptr);
   }
 #endif
 }
 
+// Function: trace_hierarchy(sc_object* obj, Connections::wave_writer* w)
+//  Trace all Connections signal types in the hierarchy to a compressed waveform
+//  file instead of a VCD file. Signals are selected with w->set_filter().
+//
+// Example usage in sc_main()
+//
+//  Top top("top");
+//  Connections::wave_writer wave;
+//  wave.open("trace.cwave");
+//  trace_hierarchy(&top, &wave);
+//
+// Convert to VCD with matchlib_toolkit/examples/bin/wave2vcd.cpp.
+//
+#ifdef CONNECTIONS_SIM_ONLY
+static inline void trace_hierarchy( sc_object *obj, Connections::wave_writer *w )
+{
+  std::vector<Connections::sc_trace_marker *> markers;
+  Connections::get_hier_index().find(obj, markers);
+  for ( unsigned i = 0; i < markers.size(); i++ ) {
+    markers[i]->set_wave(w);
+  }
+}
+#endif
+
 // Logging Connections channel data under a level of hierarchy.
 // Object names are by default in channel_logs_names.txt
 // Object values are by default in channel_logs_data.txt
@@ -109,6 +164,15 @@ static inline void trace_hierarchy( sc_object *obj, sc_trace_file *file_ptr )
 //  logs.enable("log", true);
 //  logs.log_hierarchy(top);
 //
+// For long simulations use enable_binary() instead of enable(). Transfers are then written
+// as fixed width binary records to <base>_data.bin, flushed by a background thread, and
+// channel names and widths go to <base>_index.txt. See connections_binlog_reader.h to
+// iterate over, filter and convert binary logs to the text format above.
+//
+//  channel_logs logs;
+//  logs.enable_binary("log");
+//  logs.log_hierarchy(top);
+//
 
 class channel_logs
 {
@@ -118,6 +182,9 @@ public:
   int log_num{0};
   std::ofstream log_stream;
   std::ofstream log_names;
+#ifdef CONNECTIONS_SIM_ONLY
+  Connections::channel_log_writer bin_writer;
+#endif
 
   channel_logs() {}
 
@@ -147,18 +214,34 @@ public:
     return 0;
   }
 
+  int enable_binary( std::string fname_base = "", size_t buffer_bytes = (4 << 20) ) {
+#ifdef CONNECTIONS_SIM_ONLY
+    if ( fname_base.empty() ) {
+      fname_base = "channel_logs";
+    }
+    if ( !bin_writer.open(fname_base + "_data.bin", fname_base + "_index.txt", buffer_bytes) ) {
+      return 1;
+    }
+#endif
+    return 0;
+  }
+
   void log_hier_helper( sc_object *obj ) {
 #ifdef CONNECTIONS_SIM_ONLY
-    if ( Connections::sc_trace_marker *p = dynamic_cast<Connections::sc_trace_marker *>(obj) ) {
+    std::vector<Connections::sc_trace_marker *> markers;
+    Connections::get_hier_index().find(obj, markers);
+    for ( unsigned i = 0; i < markers.size(); i++ ) {
+      Connections::sc_trace_marker *p = markers[i];
       std::string path_name;
+      bool text_logged = false;
       if ( log_stream.is_open() && log_names.is_open() && p->set_log(&log_stream, log_num, path_name) ) {
         log_names << log_num << " " << path_name << "\n";
+        text_logged = true;
       }
-    }
-    std::vector<sc_object *> children = obj->get_child_objects();
-    for ( unsigned i = 0; i < children.size(); i++ ) {
-      if ( children[i] ) {
-        log_hier_helper(children[i]);
+      if ( bin_writer.is_open() ) {
+        // Keep the same log number in both logs when text logging is also enabled
+        if ( text_logged ) { --log_num; }
+        p->set_binary_log(&bin_writer, log_num);
       }
     }
 #endif
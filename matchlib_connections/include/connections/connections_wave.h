@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// Compressed waveform writer, an alternative to sc_trace() VCD files for trace_hierarchy()
+//
+// Each traced signal gets a method process sensitive to its value change event, which
+// appends a binary record to an in-memory block. Full blocks are compressed and handed to
+// a buffered_file_writer, which writes them to disk from a background thread. Compared to a VCD file this avoids formatting every change as
+// text, and comparing every traced value on every delta cycle.
+//
+// Signals can be selected by regular expressions on their hierarchical names, and tracing
+// can be restricted to time windows, or to the intervals in which a trigger signal is
+// high. See connections_wave_format.h for the file format, connections_wave_reader.h to
+// read it and convert it to VCD.
+//
+// Example usage in sc_main()
+//
+//  Top top("top");
+//  Connections::wave_writer wave;
+//  wave.open("trace.cwave");
+//  wave.set_filter("top\\.dut\\.", "\\.rdy$");     // trace the DUT, but not ready signals
+//  wave.add_window(sc_time(10, SC_US), sc_time(20, SC_US));
+//  trace_hierarchy(&top, &wave);
+//  wave.add(top.reset_bar, "top.reset_bar");      // any sc_signal<bool> or sc_signal<sc_lv<W> >
+//  sc_start();
+//  wave.close();                                   // or when wave is destroyed
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__CONNECTIONS_WAVE_H__
+#define __CONNECTIONS__CONNECTIONS_WAVE_H__
+
+#include <systemc>
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <regex>
+#include <functional>
+
+#include "connections_wave_format.h"
+#include "buffered_file_writer.h"
+
+namespace Connections
+{
+
+  class wave_writer
+  {
+  public:
+    wave_writer()
+      : block_bytes(0), always_on(true), active_count(0), started(false), in_block(false)
+      , block_on(false), block_first(0), last_time(0), has_include(false), has_exclude(false) {}
+
+    ~wave_writer() { close(); }
+
+    bool is_open() const { return out.is_open(); }
+
+    // Open the waveform file, before sc_start(). block_bytes is the uncompressed size of
+    // a block of value changes; larger blocks compress better and use more memory.
+    bool open(const std::string &fname, size_t block_bytes_ = (1 << 20)) {
+      close();
+      if (!out.open(fname)) { return false; }
+
+      wave_file_header h;
+      std::memcpy(h.magic, "CONNWAVE", 8);
+      h.version = 1;
+      h.reserved = 0;
+      h.resolution = sc_core::sc_get_time_resolution().to_seconds();
+      std::memcpy(out.reserve(sizeof(h)), &h, sizeof(h));
+
+      block_bytes = block_bytes_;
+      fill.reserve(block_bytes + 256);
+
+      sc_core::sc_spawn(sc_bind(&wave_writer::start, this), sc_core::sc_gen_unique_name("wave_writer_start"));
+      return true;
+    }
+
+    void close() {
+      if (!out.is_open()) { return; }
+      write_blocks();
+      out.close();
+    }
+
+    // Only trace signals whose hierarchical name contains a match of include, and no match
+    // of exclude (ECMAScript syntax). An empty expression matches everything. Applies to
+    // signals added afterwards.
+    void set_filter(const std::string &include, const std::string &exclude = "") {
+      has_include = !include.empty();
+      has_exclude = !exclude.empty();
+      if (has_include) { include_re = std::regex(include); }
+      if (has_exclude) { exclude_re = std::regex(exclude); }
+    }
+
+    bool selected(const std::string &name) const {
+      if (has_include && !std::regex_search(name, include_re)) { return false; }
+      if (has_exclude && std::regex_search(name, exclude_re)) { return false; }
+      return true;
+    }
+
+    // Trace only from start to stop. Windows and triggers may be combined, tracing is on
+    // while inside any of them. Without any, tracing is on for the whole simulation.
+    void add_window(const sc_core::sc_time &start, const sc_core::sc_time &stop) {
+      always_on = false;
+      sc_core::sc_spawn(sc_bind(&wave_writer::window_thread, this, start, stop),
+                        sc_core::sc_gen_unique_name("wave_writer_window"));
+    }
+
+    // Trace while start is high, or, if stop is given, from each rising edge of start to
+    // the next rising edge of stop.
+    void add_trigger(const sc_core::sc_signal_in_if<bool> &start, const sc_core::sc_signal_in_if<bool> *stop = 0) {
+      always_on = false;
+      sc_core::sc_spawn(sc_bind(&wave_writer::trigger_thread, this, &start, stop),
+                        sc_core::sc_gen_unique_name("wave_writer_trigger"));
+    }
+
+    // Trace a signal of the given width. fetch() writes its current value into
+    // (width + 63) / 64 words, LSB first. Returns false if the name is filtered out.
+    bool add(const std::string &name, unsigned width, const sc_core::sc_event &changed,
+             const std::function<void(uint64_t *)> &fetch) {
+      if (!out.is_open() || (width == 0) || !selected(name)) { return false; }
+
+      unsigned id = signals.size();
+      signals.push_back(signal_info());
+      signal_info &s = signals.back();
+      s.width = width;
+      s.fetch = fetch;
+      s.value.assign((width + 63) / 64, 0);
+      fetch(&s.value[0]);
+      if (scratch.size() < s.value.size()) { scratch.resize(s.value.size()); }
+
+      wave_put_varint(decl, id);
+      wave_put_varint(decl, width);
+      wave_put_varint(decl, name.size());
+      decl.insert(decl.end(), name.begin(), name.end());
+
+      sc_core::sc_spawn_options opt;
+      opt.spawn_method();
+      opt.set_sensitivity(&changed);
+      opt.dont_initialize();
+      sc_core::sc_spawn(sc_bind(&wave_writer::changed, this, id), sc_core::sc_gen_unique_name("wave_writer_signal"), &opt);
+      return true;
+    }
+
+    bool add(const sc_core::sc_signal_in_if<bool> &sig, const std::string &name) {
+      const sc_core::sc_signal_in_if<bool> *p = &sig;
+      return add(name, 1, sig.value_changed_event(), [p](uint64_t *w) { w[0] = p->read(); });
+    }
+
+    template <int W>
+    bool add(const sc_core::sc_signal_in_if<sc_dt::sc_lv<W> > &sig, const std::string &name) {
+      const sc_core::sc_signal_in_if<sc_dt::sc_lv<W> > *p = &sig;
+      return add(name, W, sig.value_changed_event(), [p](uint64_t *w) { lv_to_words(p->read(), w); });
+    }
+
+    // sc_lv data plane into 64 bit words; X and Z are not preserved
+    template <int W>
+    static void lv_to_words(const sc_dt::sc_lv<W> &v, uint64_t *w) {
+      static const unsigned nwords32 = (W + 31) / 32;
+      for (unsigned i=0; i < (W + 63) / 64; i++) {
+        uint64_t lo = v.get_word(2 * i);
+        uint64_t hi = (2 * i + 1 < nwords32) ? v.get_word(2 * i + 1) : 0;
+        w[i] = lo | (hi << 32);
+      }
+      if (W % 64) { w[(W - 1) / 64] &= (~uint64_t(0) >> (64 - (W % 64))); }
+    }
+
+  private:
+    struct signal_info {
+      unsigned width;
+      std::function<void(uint64_t *)> fetch;
+      std::vector<uint64_t> value;
+    };
+
+    buffered_file_writer out;
+    size_t block_bytes;
+    std::vector<signal_info> signals;
+    std::vector<uint64_t> scratch;
+
+    bool always_on;
+    unsigned active_count;
+    bool started;
+
+    // Block being filled
+    std::vector<unsigned char> fill;
+    std::vector<unsigned char> decl;
+    bool in_block;
+    bool block_on;
+    uint64_t block_first;
+    uint64_t last_time;
+
+    bool has_include, has_exclude;
+    std::regex include_re, exclude_re;
+
+    std::vector<unsigned char> packed;
+
+    bool is_on() const { return always_on || (active_count > 0); }
+
+    void start() {
+      started = true;
+      if (is_on()) { begin_block(true); }
+    }
+
+    void changed(unsigned id) {
+      signal_info &s = signals[id];
+      s.fetch(&scratch[0]);
+      if (std::memcmp(&scratch[0], &s.value[0], s.value.size() * 8) == 0) { return; }
+      std::memcpy(&s.value[0], &scratch[0], s.value.size() * 8);
+
+      if (!started || !is_on()) { return; }
+      if (!in_block) {
+        begin_block(true); // snapshot already holds the new value
+      } else {
+        put_time();
+        put_value(id);
+      }
+      check_full();
+    }
+
+    void window_thread(sc_core::sc_time start_t, sc_core::sc_time stop_t) {
+      if (start_t > sc_core::sc_time_stamp()) { sc_core::wait(start_t - sc_core::sc_time_stamp()); }
+      window_edge(true);
+      if (stop_t > sc_core::sc_time_stamp()) { sc_core::wait(stop_t - sc_core::sc_time_stamp()); }
+      window_edge(false);
+    }
+
+    void trigger_thread(const sc_core::sc_signal_in_if<bool> *start_sig, const sc_core::sc_signal_in_if<bool> *stop_sig) {
+      bool first = true;
+      while (1) {
+        if (!(first && start_sig->read())) { sc_core::wait(start_sig->posedge_event()); }
+        first = false;
+        window_edge(true);
+        if (stop_sig) {
+          sc_core::wait(stop_sig->posedge_event());
+        } else {
+          sc_core::wait(start_sig->negedge_event());
+        }
+        window_edge(false);
+      }
+    }
+
+    void window_edge(bool open_window) {
+      bool was_on = is_on();
+      if (open_window) {
+        ++active_count;
+      } else if (active_count) {
+        --active_count;
+      }
+      if (!started || (was_on == is_on())) { return; }
+
+      if (!in_block) { begin_block(was_on); }
+      put_time();
+      if (is_on()) {
+        wave_put_varint(fill, wave_tag_dumpon);
+        put_snapshot();
+      } else {
+        wave_put_varint(fill, wave_tag_dumpoff);
+      }
+      check_full();
+    }
+
+    void begin_block(bool on) {
+      in_block = true;
+      block_on = on;
+      block_first = last_time = sc_core::sc_time_stamp().value();
+      put_snapshot();
+    }
+
+    void put_snapshot() {
+      for (unsigned i=0; i < signals.size(); i++) { put_value(i); }
+    }
+
+    void put_time() {
+      uint64_t t = sc_core::sc_time_stamp().value();
+      if (t != last_time) {
+        wave_put_varint(fill, wave_tag_time);
+        wave_put_varint(fill, t - last_time);
+        last_time = t;
+      }
+    }
+
+    void put_value(unsigned id) {
+      const signal_info &s = signals[id];
+      wave_put_varint(fill, id + wave_tag_first_id);
+      unsigned nbytes = (s.width + 7) / 8;
+      for (unsigned b=0; b < nbytes; b++) {
+        fill.push_back(static_cast<unsigned char>(s.value[b / 8] >> ((b % 8) * 8)));
+      }
+    }
+
+    void check_full() {
+      if (fill.size() >= block_bytes) { write_blocks(); }
+    }
+
+    // Write pending declarations, then the current block
+    void write_blocks() {
+      if (!decl.empty()) { write_block('S', decl, 0, 0, false); }
+      if (in_block) { write_block('V', fill, block_first, last_time, block_on); }
+      decl.clear();
+      fill.clear();
+      in_block = false;
+    }
+
+    void write_block(uint8_t kind, const std::vector<unsigned char> &raw, uint64_t first, uint64_t last, bool on) {
+      wave_block_header h;
+      std::memset(&h, 0, sizeof(h));
+      h.kind = kind;
+      h.flags = on ? 1 : 0;
+      h.raw_bytes = raw.size();
+      h.first_time = first;
+      h.last_time = last;
+
+      const std::vector<unsigned char> *payload = &raw;
+      if ((kind == 'V') && !raw.empty()) {
+        wave_compress(&raw[0], raw.size(), packed);
+        if (packed.size() < raw.size()) {
+          h.codec = 1;
+          payload = &packed;
+        }
+      }
+      h.stored_bytes = payload->size();
+      std::memcpy(out.reserve(sizeof(h)), &h, sizeof(h));
+      if (!payload->empty()) { std::memcpy(out.reserve(payload->size()), &(*payload)[0], payload->size()); }
+    }
+  };
+
+}  // namespace Connections
+
+#endif  // __CONNECTIONS__CONNECTIONS_WAVE_H__
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// Compressed waveform file format, shared by connections_wave.h (writer) and
+// connections_wave_reader.h (reader). Does not depend on SystemC.
+//
+// File layout:
+//
+//   wave_file_header                       magic, version, time resolution
+//   { wave_block_header, payload } ...
+//
+// Block kinds:
+//
+//   'S'  signal declarations, payload is never compressed:
+//          { varint id, varint width, varint name length, name bytes } ...
+//   'V'  value changes between first_time and last_time, payload is compressed
+//        with wave_compress() when that makes it smaller (codec 1), else raw (codec 0).
+//        Uncompressed payload is a sequence of varint tags:
+//          0          time advance, followed by varint delta to the previous time
+//          1          dumpoff, tracing is suspended until the next dumpon
+//          2          dumpon, followed by the value of every declared signal
+//          id + 3     value change of signal id, followed by (width + 7) / 8 bytes, LSB first
+//        Every 'V' block starts with the value of every signal declared so far, so a
+//        reader may skip blocks that end before the time window it is interested in.
+//
+// All integers in headers are little endian. Times are in units of the resolution.
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__CONNECTIONS_WAVE_FORMAT_H__
+#define __CONNECTIONS__CONNECTIONS_WAVE_FORMAT_H__
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+
+namespace Connections
+{
+
+  struct wave_file_header {
+    char magic[8];        // "CONNWAVE"
+    uint32_t version;
+    uint32_t reserved;
+    double resolution;    // seconds per time unit
+  };
+
+  struct wave_block_header {
+    uint8_t kind;         // 'S' or 'V'
+    uint8_t codec;        // 0 raw, 1 wave_compress()
+    uint16_t flags;       // bit 0: tracing on at first_time ('V' blocks)
+    uint32_t raw_bytes;
+    uint32_t stored_bytes;
+    uint32_t reserved2;
+    uint64_t first_time;
+    uint64_t last_time;
+  };
+
+  enum wave_tag { wave_tag_time = 0, wave_tag_dumpoff = 1, wave_tag_dumpon = 2, wave_tag_first_id = 3 };
+
+  inline void wave_put_varint(std::vector<unsigned char> &b, uint64_t v) {
+    while (v >= 0x80) {
+      b.push_back(static_cast<unsigned char>(v | 0x80));
+      v >>= 7;
+    }
+    b.push_back(static_cast<unsigned char>(v));
+  }
+
+  // Returns false on truncated input
+  inline bool wave_get_varint(const unsigned char *&p, const unsigned char *end, uint64_t &v) {
+    v = 0;
+    for (unsigned shift = 0; (p < end) && (shift < 64); shift += 7) {
+      unsigned char c = *p++;
+      v |= static_cast<uint64_t>(c & 0x7f) << shift;
+      if (!(c & 0x80)) { return true; }
+    }
+    return false;
+  }
+
+  // Byte oriented LZ77 with a 64KB window, in the spirit of LZ4. Value change streams
+  // repeat the same tags and small time deltas, so this is enough to get most of the
+  // gain of a general purpose compressor without an external dependency.
+  //
+  // Output is a sequence of { varint literal count, literals, varint match length - 4,
+  // varint offset }, the last sequence having no match when input ends with literals.
+  inline void wave_compress(const unsigned char *in, size_t n, std::vector<unsigned char> &out) {
+    static const unsigned hash_bits = 14;
+    static const size_t min_match = 4;
+    std::vector<uint32_t> table(1u << hash_bits, 0xffffffffu);
+    out.clear();
+
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + min_match <= n) {
+      uint32_t seq;
+      std::memcpy(&seq, in + i, 4);
+      uint32_t h = (seq * 2654435761u) >> (32 - hash_bits);
+      uint32_t cand = table[h];
+      table[h] = static_cast<uint32_t>(i);
+
+      if ((cand != 0xffffffffu) && (i - cand < 65536) && (std::memcmp(in + cand, in + i, 4) == 0)) {
+        size_t len = min_match;
+        while ((i + len < n) && (in[cand + len] == in[i + len])) { ++len; }
+
+        wave_put_varint(out, i - anchor);
+        out.insert(out.end(), in + anchor, in + i);
+        wave_put_varint(out, len - min_match);
+        wave_put_varint(out, i - cand);
+        i += len;
+        anchor = i;
+      } else {
+        ++i;
+      }
+    }
+
+    if (anchor < n) {
+      wave_put_varint(out, n - anchor);
+      out.insert(out.end(), in + anchor, in + n);
+    }
+  }
+
+  // Returns false if the input is corrupt
+  inline bool wave_decompress(const unsigned char *p, size_t n, std::vector<unsigned char> &out, size_t raw_bytes) {
+    const unsigned char *end = p + n;
+    out.resize(raw_bytes);
+    size_t o = 0;
+    while (o < raw_bytes) {
+      uint64_t lit, len, off;
+      if (!wave_get_varint(p, end, lit) || (lit > raw_bytes - o) || (lit > static_cast<size_t>(end - p))) { return false; }
+      if (lit) { std::memcpy(&out[o], p, lit); }
+      p += lit;
+      o += lit;
+      if (o >= raw_bytes) { break; }
+
+      if (!wave_get_varint(p, end, len) || !wave_get_varint(p, end, off)) { return false; }
+      len += 4;
+      if ((off == 0) || (off > o) || (len > raw_bytes - o)) { return false; }
+      // overlapping copy, byte by byte
+      for (size_t k=0; k < len; k++, o++) { out[o] = out[o - off]; }
+    }
+    return true;
+  }
+
+}  // namespace Connections
+
+#endif  // __CONNECTIONS__CONNECTIONS_WAVE_FORMAT_H__
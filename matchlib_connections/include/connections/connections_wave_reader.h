@@ -0,0 +1,480 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// Reader for waveform files written by Connections::wave_writer
+//
+// Does not depend on SystemC, so waveform tools can be built standalone. The file is
+// memory mapped; blocks that end before the requested time window are skipped without
+// being decompressed.
+//
+// Example usage:
+//
+//  #include <connections/connections_wave_reader.h>
+//
+//  Connections::wave_reader r;
+//  if (r.open("trace.cwave")) { return 1; }
+//
+//  // all value changes of one signal
+//  int id = r.find_signal("top.dut.out1_vld");
+//  r.for_each([&](const Connections::wave_reader::event &e) {
+//    if ((e.kind == Connections::wave_reader::event::value) && (e.id == id)) {
+//      std::cout << e.time << " " << e.bit(0) << "\n";
+//    }
+//  });
+//
+//  // VCD for viewers that do not read this format
+//  std::ofstream vcd("trace.vcd");
+//  r.to_vcd(vcd);
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__CONNECTIONS_WAVE_READER_H__
+#define __CONNECTIONS__CONNECTIONS_WAVE_READER_H__
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <regex>
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "connections_wave_format.h"
+
+namespace Connections
+{
+
+  class wave_reader
+  {
+  public:
+    struct signal_info {
+      unsigned width;
+      std::string name;
+    };
+
+    struct event {
+      enum kind_t { block, value, dumpoff, dumpon } kind;
+      uint64_t time;
+      bool on;                     // tracing on at time, block events only
+      bool snapshot;               // value restated at block start or after dumpon
+      unsigned id;
+      unsigned width;
+      const unsigned char *bytes;  // (width + 7) / 8 bytes, LSB first
+
+      bool bit(unsigned i) const { return (bytes[i / 8] >> (i % 8)) & 1; }
+    };
+
+    wave_reader() : data(0), size(0), fd(-1), resolution(1e-12) {}
+
+    ~wave_reader() { close(); }
+
+    // Map the file and read all signal declarations. Returns 0 on success.
+    int open(const std::string &fname) {
+      close();
+      fd = ::open(fname.c_str(), O_RDONLY);
+      if (fd < 0) {
+        std::cerr << "Cannot open file '" << fname << "'" << std::endl;
+        return 1;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0) { close(); return 1; }
+      size = st.st_size;
+      if (size < sizeof(wave_file_header)) {
+        std::cerr << "File '" << fname << "' is not a Connections waveform file" << std::endl;
+        close();
+        return 1;
+      }
+      void *m = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m == MAP_FAILED) {
+        std::cerr << "Cannot map file '" << fname << "'" << std::endl;
+        close();
+        return 1;
+      }
+      madvise(m, size, MADV_SEQUENTIAL);
+      data = static_cast<const unsigned char *>(m);
+
+      wave_file_header h;
+      std::memcpy(&h, data, sizeof(h));
+      if ((std::memcmp(h.magic, "CONNWAVE", 8) != 0) || (h.version != 1)) {
+        std::cerr << "File '" << fname << "' is not a Connections waveform file" << std::endl;
+        close();
+        return 1;
+      }
+      resolution = h.resolution;
+
+      // Index blocks, a truncated last block is ignored
+      size_t pos = sizeof(wave_file_header);
+      while (pos + sizeof(wave_block_header) <= size) {
+        wave_block_header bh;
+        std::memcpy(&bh, data + pos, sizeof(bh));
+        size_t payload = pos + sizeof(bh);
+        if (payload + bh.stored_bytes > size) { break; }
+        if (bh.kind == 'S') {
+          read_declarations(data + payload, bh.stored_bytes);
+        } else if (bh.kind == 'V') {
+          block_info bi;
+          bi.header = bh;
+          bi.payload = payload;
+          blocks.push_back(bi);
+        }
+        pos = payload + bh.stored_bytes;
+      }
+      return 0;
+    }
+
+    void close() {
+      if (data) { munmap(const_cast<unsigned char *>(data), size); }
+      if (fd >= 0) { ::close(fd); }
+      data = 0;
+      size = 0;
+      fd = -1;
+      signals.clear();
+      blocks.clear();
+    }
+
+    const std::vector<signal_info> &get_signals() const { return signals; }
+
+    // Id of the signal with the given hierarchical name, -1 if not found
+    int find_signal(const std::string &name) const {
+      for (unsigned i=0; i < signals.size(); i++) {
+        if (signals[i].name == name) { return i; }
+      }
+      return -1;
+    }
+
+    double time_resolution() const { return resolution; }
+
+    uint64_t end_time() const { return blocks.empty() ? 0 : blocks.back().header.last_time; }
+
+    // Call f(const event &) for every event of the blocks overlapping [from, to]. The first
+    // block delivered starts at or before from, so its snapshot gives the state at from.
+    // Returns false if a corrupt block was found.
+    template <class F>
+    bool for_each(F f, uint64_t from = 0, uint64_t to = ~uint64_t(0)) const {
+      size_t b = 0;
+      while ((b + 1 < blocks.size()) && (blocks[b + 1].header.first_time <= from)) { ++b; }
+
+      std::vector<unsigned char> raw;
+      for (; (b < blocks.size()) && (blocks[b].header.first_time <= to); b++) {
+        const block_info &bi = blocks[b];
+        const unsigned char *p = data + bi.payload;
+        size_t n = bi.header.raw_bytes;
+        if (bi.header.codec == 1) {
+          if (!wave_decompress(p, bi.header.stored_bytes, raw, n)) { return false; }
+          p = raw.empty() ? 0 : &raw[0];
+        }
+        if (!decode_block(f, bi.header, p, n)) { return false; }
+      }
+      return true;
+    }
+
+    // Write a VCD file of the time window [from, to], restricted to the signals whose
+    // name contains a match of filter. Times are in units of the resolution.
+    bool to_vcd(std::ostream &os, uint64_t from = 0, uint64_t to = ~uint64_t(0), const std::string &filter = "") const {
+      std::vector<int> code(signals.size(), -1);
+      std::vector<unsigned> order;
+      std::regex re(filter.empty() ? std::string(".*") : filter);
+      for (unsigned i=0; i < signals.size(); i++) {
+        if (filter.empty() || std::regex_search(signals[i].name, re)) {
+          code[i] = order.size();
+          order.push_back(i);
+        }
+      }
+      write_vcd_header(os, order, code);
+
+      vcd_state st(signals, code);
+      bool ok = for_each([&](const event &e) { st.apply(os, e, from, to); }, from, to);
+      st.finish(os, from);
+      return ok;
+    }
+
+    // Format the 1, 10 or 100 times fs .. s unit of the resolution, eg. "1 ps"
+    std::string timescale() const {
+      static const char *units[] = { "fs", "ps", "ns", "us", "ms", "s" };
+      uint64_t fs = static_cast<uint64_t>(resolution * 1e15 + 0.5);
+      unsigned u = 0;
+      while ((u < 5) && fs && ((fs % 1000) == 0)) {
+        fs /= 1000;
+        u++;
+      }
+      std::ostringstream ss;
+      ss << fs << " " << units[u];
+      return ss.str();
+    }
+
+  private:
+    struct block_info {
+      wave_block_header header;
+      size_t payload;
+    };
+
+    const unsigned char *data;
+    size_t size;
+    int fd;
+    double resolution;
+    std::vector<signal_info> signals;
+    std::vector<block_info> blocks;
+
+    void read_declarations(const unsigned char *p, size_t n) {
+      const unsigned char *end = p + n;
+      while (p < end) {
+        uint64_t id, width, len;
+        if (!wave_get_varint(p, end, id) || !wave_get_varint(p, end, width) || !wave_get_varint(p, end, len)) { return; }
+        if (len > static_cast<size_t>(end - p)) { return; }
+        if (signals.size() <= id) { signals.resize(id + 1); }
+        signals[id].width = width;
+        signals[id].name.assign(reinterpret_cast<const char *>(p), len);
+        p += len;
+      }
+    }
+
+    template <class F>
+    bool decode_block(F &f, const wave_block_header &bh, const unsigned char *p, size_t n) const {
+      const unsigned char *end = p + n;
+      event e;
+      e.kind = event::block;
+      e.time = bh.first_time;
+      e.on = bh.flags & 1;
+      e.snapshot = false;
+      e.id = 0;
+      e.width = 0;
+      e.bytes = 0;
+      f(e);
+
+      // a snapshot lists the signals declared so far once each, in id order
+      bool snapshot = true;
+      unsigned snapshot_id = 0;
+      e.on = false;
+      while (p < end) {
+        uint64_t tag;
+        if (!wave_get_varint(p, end, tag)) { return false; }
+        if (tag == wave_tag_time) {
+          uint64_t delta;
+          if (!wave_get_varint(p, end, delta)) { return false; }
+          e.time += delta;
+          snapshot = false;
+        } else if (tag == wave_tag_dumpoff) {
+          e.kind = event::dumpoff;
+          e.snapshot = false;
+          f(e);
+          snapshot = false;
+        } else if (tag == wave_tag_dumpon) {
+          e.kind = event::dumpon;
+          e.snapshot = false;
+          f(e);
+          snapshot = true;
+          snapshot_id = 0;
+        } else {
+          e.kind = event::value;
+          e.id = tag - wave_tag_first_id;
+          if (e.id >= signals.size()) { return false; }
+          e.width = signals[e.id].width;
+          unsigned nbytes = (e.width + 7) / 8;
+          if (nbytes > static_cast<size_t>(end - p)) { return false; }
+          e.bytes = p;
+          snapshot = snapshot && (e.id == snapshot_id++);
+          e.snapshot = snapshot;
+          p += nbytes;
+          f(e);
+        }
+      }
+      return true;
+    }
+
+    static std::string vcd_code(unsigned n) {
+      std::string s;
+      do {
+        s += static_cast<char>('!' + (n % 94));
+        n /= 94;
+      } while (n);
+      return s;
+    }
+
+    static std::vector<std::string> split_name(const std::string &name) {
+      std::vector<std::string> v;
+      size_t start = 0, dot;
+      while ((dot = name.find('.', start)) != std::string::npos) {
+        v.push_back(name.substr(start, dot - start));
+        start = dot + 1;
+      }
+      v.push_back(name.substr(start));
+      return v;
+    }
+
+    void write_vcd_header(std::ostream &os, const std::vector<unsigned> &order, const std::vector<int> &code) const {
+      os << "$version Connections wave_reader $end\n";
+      os << "$timescale " << timescale() << " $end\n";
+
+      std::vector<std::pair<std::vector<std::string>, unsigned> > names;
+      for (unsigned i=0; i < order.size(); i++) {
+        names.push_back(std::make_pair(split_name(signals[order[i]].name), order[i]));
+      }
+      std::sort(names.begin(), names.end());
+
+      std::vector<std::string> scope;
+      for (unsigned i=0; i < names.size(); i++) {
+        const std::vector<std::string> &path = names[i].first;
+        size_t common = 0;
+        while ((common < scope.size()) && (common + 1 < path.size()) && (scope[common] == path[common])) { ++common; }
+        while (scope.size() > common) {
+          os << "$upscope $end\n";
+          scope.pop_back();
+        }
+        while (scope.size() + 1 < path.size()) {
+          scope.push_back(path[scope.size()]);
+          os << "$scope module " << scope.back() << " $end\n";
+        }
+        const signal_info &s = signals[names[i].second];
+        os << "$var wire " << s.width << " " << vcd_code(code[names[i].second]) << " " << path.back();
+        if (s.width > 1) { os << " [" << (s.width - 1) << ":0]"; }
+        os << " $end\n";
+      }
+      while (!scope.empty()) {
+        os << "$upscope $end\n";
+        scope.pop_back();
+      }
+      os << "$enddefinitions $end\n";
+    }
+
+    // Tracks signal values while events are converted to VCD value changes
+    struct vcd_state {
+      const std::vector<signal_info> &signals;
+      const std::vector<int> &code;
+      std::vector<std::string> codes;
+      std::vector<std::vector<unsigned char> > cur;
+      std::vector<std::vector<unsigned char> > printed;
+      std::vector<bool> printed_valid;
+      bool on;
+      bool dumped;          // $dumpvars written
+      bool dumpon_open;     // dumpon seen, its snapshot not printed yet
+      uint64_t dumpon_time;
+      uint64_t last_printed_time;
+      bool time_printed;
+
+      vcd_state(const std::vector<signal_info> &s, const std::vector<int> &c)
+        : signals(s), code(c), cur(s.size()), printed(s.size()), printed_valid(s.size(), false)
+        , on(false), dumped(false), dumpon_open(false), dumpon_time(0), last_printed_time(0), time_printed(false) {
+        for (unsigned i=0; i < s.size(); i++) {
+          cur[i].assign((s[i].width + 7) / 8, 0);
+          codes.push_back(c[i] < 0 ? std::string() : vcd_code(c[i]));
+        }
+      }
+
+      void put_time(std::ostream &os, uint64_t t) {
+        if (!time_printed || (t != last_printed_time)) {
+          os << "#" << t << "\n";
+          last_printed_time = t;
+          time_printed = true;
+        }
+      }
+
+      void put_value(std::ostream &os, unsigned id, bool x) {
+        const signal_info &s = signals[id];
+        const std::string &c = codes[id];
+        if (s.width == 1) {
+          os << (x ? 'x' : static_cast<char>('0' + (cur[id][0] & 1))) << c << "\n";
+          return;
+        }
+        os << "b";
+        if (x) {
+          os << "x";
+        } else {
+          int msb = s.width - 1;
+          while ((msb > 0) && !((cur[id][msb / 8] >> (msb % 8)) & 1)) { --msb; }
+          for (int i = msb; i >= 0; i--) { os << static_cast<char>('0' + ((cur[id][i / 8] >> (i % 8)) & 1)); }
+        }
+        os << " " << c << "\n";
+      }
+
+      void put_all(std::ostream &os, bool x) {
+        for (unsigned i=0; i < signals.size(); i++) {
+          if (code[i] < 0) { continue; }
+          put_value(os, i, x);
+          printed[i] = cur[i];
+          printed_valid[i] = !x;
+        }
+      }
+
+      void dump_vars(std::ostream &os, uint64_t t) {
+        put_time(os, t);
+        os << "$dumpvars\n";
+        put_all(os, !on);
+        os << "$end\n";
+        dumped = true;
+      }
+
+      void close_dumpon(std::ostream &os) {
+        if (!dumpon_open) { return; }
+        put_time(os, dumpon_time);
+        os << "$dumpon\n";
+        put_all(os, false);
+        os << "$end\n";
+        dumpon_open = false;
+      }
+
+      void apply(std::ostream &os, const event &e, uint64_t from, uint64_t to) {
+        if (e.time > to) { return; }
+        if ((e.kind != event::value) || !e.snapshot) { close_dumpon(os); }
+        if (!dumped && (e.time > from)) { dump_vars(os, from); }
+
+        switch (e.kind) {
+          case event::block:
+            on = e.on;
+            break;
+          case event::dumpoff:
+            on = false;
+            if (dumped) {
+              put_time(os, e.time);
+              os << "$dumpoff\n";
+              put_all(os, true);
+              os << "$end\n";
+            }
+            break;
+          case event::dumpon:
+            on = true;
+            if (dumped) {
+              dumpon_open = true;
+              dumpon_time = e.time;
+            }
+            break;
+          case event::value:
+            std::memcpy(&cur[e.id][0], e.bytes, cur[e.id].size());
+            if (dumped && on && !dumpon_open && (code[e.id] >= 0) &&
+                (!printed_valid[e.id] || (printed[e.id] != cur[e.id]))) {
+              put_time(os, e.time);
+              put_value(os, e.id, false);
+              printed[e.id] = cur[e.id];
+              printed_valid[e.id] = true;
+            }
+            break;
+        }
+      }
+
+      void finish(std::ostream &os, uint64_t from) {
+        close_dumpon(os);
+        if (!dumped) { dump_vars(os, from); }
+      }
+    };
+  };
+
+}  // namespace Connections
+
+#endif  // __CONNECTIONS__CONNECTIONS_WAVE_READER_H__
@@ -84,6 +84,179 @@ void connections_cast_vector_to_type(const sc_lv<vec_width> &vec, bool is_signed
   vector_to_type(vec, is_signed, data);
 }
 
+//------------------------------------------------------------------------
+// Two-state packed-word backend
+//
+// Defining CONNECTIONS_MARSHALLER_2STATE makes Marshaller hold messages in packed
+// uint64_t words instead of an sc_lv, and insert and extract common field types
+// (C integer types, enums, bool, ac_int, sc_int, sc_uint, sc_bv) with shifts and
+// masks. Other field types still go through type_to_vector()/vector_to_type() one
+// field at a time. Conversion to sc_lv only happens in GetResult() and the sc_lv
+// constructor, i.e. where a message meets a signal. X and Z bits read from an
+// sc_lv become 0, so use the default 4-state backend for X-propagation checks.
+// The 2-state backend is the default in CONNECTIONS_FAST_SIM, unless
+// CONNECTIONS_MARSHALLER_4STATE is defined. It is never used for synthesis.
+
+#if defined(CONNECTIONS_FAST_SIM) && !defined(CONNECTIONS_MARSHALLER_4STATE) && !defined(CONNECTIONS_MARSHALLER_2STATE)
+#define CONNECTIONS_MARSHALLER_2STATE
+#endif
+
+#if defined(CONNECTIONS_MARSHALLER_2STATE) && !defined(__SYNTHESIS__)
+#define CONNECTIONS_MARSHALLER_PACKED
+#include <stdint.h>
+#include <type_traits>
+
+// OR len (<= 64) bits of v into w at bit idx. Fields are appended to zeroed words.
+inline void connections_packed_insert(uint64_t *w, unsigned idx, unsigned len, uint64_t v)
+{
+  if (len < 64) { v &= ((static_cast<uint64_t>(1) << len) - 1); }
+  unsigned wi = idx >> 6;
+  unsigned bi = idx & 63;
+  w[wi] |= v << bi;
+  if (bi && (bi + len > 64)) { w[wi + 1] |= v >> (64 - bi); }
+}
+
+// Extract len (<= 64) bits of w at bit idx
+inline uint64_t connections_packed_extract(const uint64_t *w, unsigned idx, unsigned len)
+{
+  unsigned wi = idx >> 6;
+  unsigned bi = idx & 63;
+  uint64_t v = w[wi] >> bi;
+  if (bi && (bi + len > 64)) { v |= w[wi + 1] << (64 - bi); }
+  if (len < 64) { v &= ((static_cast<uint64_t>(1) << len) - 1); }
+  return v;
+}
+
+// Copy an sc_lv in or out of the packed words, 32 bits at a time
+template <int W>
+inline void connections_packed_put_lv(const sc_lv<W> &bits, uint64_t *w, unsigned idx)
+{
+  for (int i = 0; i < (W + 31) / 32; i++) {
+    unsigned len = (W - 32 * i < 32) ? (W - 32 * i) : 32;
+    connections_packed_insert(w, idx + 32 * i, len, bits.get_word(i) & ~bits.get_cword(i));
+  }
+}
+
+template <int W>
+inline void connections_packed_get_lv(const uint64_t *w, unsigned idx, sc_lv<W> &bits)
+{
+  for (int i = 0; i < (W + 31) / 32; i++) {
+    unsigned len = (W - 32 * i < 32) ? (W - 32 * i) : 32;
+    bits.set_word(i, static_cast<sc_digit>(connections_packed_extract(w, idx + 32 * i, len)));
+    bits.set_cword(i, 0);
+  }
+}
+
+// Field packers: the generic one converts through sc_lv, overloads below handle
+// the common types natively.
+template <int FieldSize, typename T>
+inline typename std::enable_if<!std::is_integral<T>::value && !std::is_enum<T>::value>::type
+connections_packed_put(const T &d, uint64_t *w, unsigned idx)
+{
+  sc_lv<FieldSize> bits;
+  connections_cast_type_to_vector(d, FieldSize, bits);
+  connections_packed_put_lv<FieldSize>(bits, w, idx);
+}
+
+template <int FieldSize, typename T>
+inline typename std::enable_if<!std::is_integral<T>::value && !std::is_enum<T>::value>::type
+connections_packed_get(const uint64_t *w, unsigned idx, T &d)
+{
+  sc_lv<FieldSize> bits;
+  connections_packed_get_lv<FieldSize>(w, idx, bits);
+  connections_cast_vector_to_type(bits, false, &d);
+}
+
+template <int FieldSize, typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+connections_packed_put(const T &d, uint64_t *w, unsigned idx)
+{
+  connections_packed_insert(w, idx, FieldSize, static_cast<uint64_t>(d));
+}
+
+template <int FieldSize, typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+connections_packed_get(const uint64_t *w, unsigned idx, T &d)
+{
+  d = static_cast<T>(connections_packed_extract(w, idx, FieldSize));
+}
+
+template <int FieldSize, int W, bool S>
+inline void connections_packed_put(const ac_int<W,S> &d, uint64_t *w, unsigned idx)
+{
+  for (int i = 0; i < W; i += 64) {
+    connections_packed_insert(w, idx + i, (W - i < 64) ? (W - i) : 64, (d >> i).to_uint64());
+  }
+}
+
+template <int FieldSize, int W, bool S>
+inline void connections_packed_get(const uint64_t *w, unsigned idx, ac_int<W,S> &d)
+{
+  if (W <= 64) {
+    d = connections_packed_extract(w, idx, W);
+    return;
+  }
+  ac_int<W,false> t = 0;
+  for (int i = ((W - 1) / 64) * 64; i >= 0; i -= 64) {
+    t <<= 64;
+    t |= ac_int<W,false>(connections_packed_extract(w, idx + i, (W - i < 64) ? (W - i) : 64));
+  }
+  d = t;
+}
+
+template <int FieldSize, int W>
+inline void connections_packed_put(const sc_uint<W> &d, uint64_t *w, unsigned idx)
+{
+  connections_packed_insert(w, idx, W, d.to_uint64());
+}
+
+template <int FieldSize, int W>
+inline void connections_packed_get(const uint64_t *w, unsigned idx, sc_uint<W> &d)
+{
+  d = connections_packed_extract(w, idx, W);
+}
+
+template <int FieldSize, int W>
+inline void connections_packed_put(const sc_int<W> &d, uint64_t *w, unsigned idx)
+{
+  connections_packed_insert(w, idx, W, static_cast<uint64_t>(d.to_int64()));
+}
+
+template <int FieldSize, int W>
+inline void connections_packed_get(const uint64_t *w, unsigned idx, sc_int<W> &d)
+{
+  d = connections_packed_extract(w, idx, W);
+}
+
+template <int FieldSize, int W>
+inline void connections_packed_put(const sc_bv<W> &d, uint64_t *w, unsigned idx)
+{
+  for (int i = 0; i < (W + 31) / 32; i++) {
+    connections_packed_insert(w, idx + 32 * i, (W - 32 * i < 32) ? (W - 32 * i) : 32, d.get_word(i));
+  }
+}
+
+template <int FieldSize, int W>
+inline void connections_packed_get(const uint64_t *w, unsigned idx, sc_bv<W> &d)
+{
+  for (int i = 0; i < (W + 31) / 32; i++) {
+    d.set_word(i, static_cast<sc_digit>(connections_packed_extract(w, idx + 32 * i, (W - 32 * i < 32) ? (W - 32 * i) : 32)));
+  }
+}
+
+template <int FieldSize, int W>
+inline void connections_packed_put(const sc_lv<W> &d, uint64_t *w, unsigned idx)
+{
+  connections_packed_put_lv<W>(d, w, idx);
+}
+
+template <int FieldSize, int W>
+inline void connections_packed_get(const uint64_t *w, unsigned idx, sc_lv<W> &d)
+{
+  connections_packed_get_lv<W>(w, idx, d);
+}
+#endif
+
 //------------------------------------------------------------------------
 // Marshaller
 
@@ -135,7 +308,12 @@ void connections_cast_vector_to_type(const sc_lv<vec_width> &vec, bool is_signed
 template <unsigned int Size>
 class Marshaller
 {
+#ifdef CONNECTIONS_MARSHALLER_PACKED
+  static const unsigned int NumWords = (Size + 63) / 64;
+  uint64_t glob[NumWords];
+#else
   sc_lv<Size> glob;
+#endif
   unsigned int cur_idx;
   bool is_marshalling;
 
@@ -145,8 +323,18 @@ public:
    *     convert type to bits;
    *   else:
    *     convert bits to type. */
+#ifdef CONNECTIONS_MARSHALLER_PACKED
+  Marshaller() : cur_idx(0), is_marshalling(true) {
+    for (unsigned i = 0; i < NumWords; i++) { glob[i] = 0; }
+  }
+  Marshaller(const sc_lv<Size> &v) : cur_idx(0), is_marshalling(false) {
+    for (unsigned i = 0; i < NumWords; i++) { glob[i] = 0; }
+    connections_packed_put_lv<Size>(v, glob, 0);
+  }
+#else
   Marshaller() : glob(0), cur_idx(0), is_marshalling(true) {}
   Marshaller(sc_lv<Size> v) : glob(v), cur_idx(0), is_marshalling(false) {}
+#endif
 
 #ifndef __SYNTHESIS__
   static_assert(Size < MARSHALL_LIMIT, "Size must be less than MARSHALL_LIMIT");
@@ -156,6 +344,14 @@ public:
   template <typename T, int FieldSize>
   void AddField(T &d) {
     CONNECTIONS_SIM_ONLY_ASSERT_MSG(cur_idx + FieldSize <= Size, "Field size exceeded Size. Is a message's width enum missing an element, and are all fields marshalled?");
+#ifdef CONNECTIONS_MARSHALLER_PACKED
+    if (is_marshalling) {
+      connections_packed_put<FieldSize>(d, glob, cur_idx);
+    } else {
+      connections_packed_get<FieldSize>(glob, cur_idx, d);
+    }
+    cur_idx += FieldSize;
+#else
     if (is_marshalling) {
       sc_lv<FieldSize> bits;
       connections_cast_type_to_vector(d, FieldSize, bits);
@@ -166,12 +362,27 @@ public:
       connections_cast_vector_to_type(bits, false, &d);
       cur_idx += FieldSize;
     }
+#endif
+  }
+
+  /* Switch a filled Marshaller to extraction, so that a message can be converted
+   * to another type of the same width without going through a bit vector. */
+  void Rewind() {
+    CONNECTIONS_SIM_ONLY_ASSERT_MSG(cur_idx==Size, "Size doesn't match current index. Is a message's width enum missing an element, and are all fields marshalled?");
+    cur_idx = 0;
+    is_marshalling = false;
   }
 
   /* Return the bit vector. */
   sc_lv<Size> GetResult() {
     CONNECTIONS_SIM_ONLY_ASSERT_MSG(cur_idx==Size, "Size doesn't match current index. Is a message's width enum missing an element, and are all fields marshalled?");
+#ifdef CONNECTIONS_MARSHALLER_PACKED
+    sc_lv<Size> result;
+    connections_packed_get_lv<Size>(glob, 0, result);
+    return result;
+#else
     return glob.range(Size - 1, 0);
+#endif
   }
 };
 
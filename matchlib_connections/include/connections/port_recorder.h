@@ -0,0 +1,483 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//*****************************************************************************************
+// port_recorder.h
+//
+// Record and replay of the In/Out port traffic of one module, to simulate a block
+// deep inside a large model on its own.
+//
+// port_recorder captures every transfer on the In/Out ports of a module that
+// port_scanner lists (ports bound to channels outside of the module), with the cycle in
+// which the message was first offered (valid), the cycle it was transferred, and the
+// message bits. For Out ports it also captures the ready pattern of the consumer, and
+// optionally the level of a reset signal.
+//
+// port_replayer binds to the In/Out ports of a standalone instance of the same module.
+// It offers each recorded input no earlier than its recorded cycle and holds it until the
+// module accepts it, replays the recorded ready pattern on the outputs, and checks every
+// output message, and the cycles at which inputs and outputs transfer, against the
+// recording. As long as the module behaves as recorded the replay is cycle exact.
+//
+// Cycles count the active edges of the clock given to the recorder and replayer, starting
+// from the beginning of simulation. Requires CONNECTIONS_SIM_ONLY and MARSHALL_PORT ports
+// in the recorded module.
+//
+// Example usage in the full model
+//
+//  Top top("top");
+//  Connections::port_recorder rec("rec", top.soc.blk, top.clk, "blk.rec", &top.rst_bar);
+//  sc_start();
+//
+// and in a standalone testbench
+//
+//  sc_clock clk("clk", 1, SC_NS, 0.5, 0, SC_NS, true);
+//  sc_signal<bool> rst_bar;
+//  Block blk("blk");
+//  blk.clk(clk);
+//  blk.rst_bar(rst_bar);
+//  Connections::port_replayer replay("replay", blk, clk, "blk.rec", &rst_bar);
+//  sc_start();   // stops when all recorded traffic has been replayed
+//
+// The record file is text, one item per line:
+//
+//  P <port> In|Out <width> <name>      port, name relative to the module
+//  R <cycle> <0|1>                     reset level from this cycle on
+//  Y <port> <cycle> <0|1>              Out port ready level from this cycle on
+//  T <port> <offer> <transfer> <bits>  transfer of a message
+//  E <cycle>                           end of recording
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__PORT_RECORDER_H__
+#define __CONNECTIONS__PORT_RECORDER_H__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <sstream>
+
+#include "connections.h"
+#include "port_scanner.h"
+
+namespace Connections
+{
+
+#ifdef CONNECTIONS_SIM_ONLY
+
+  // Contents of a record file
+  class port_traffic
+  {
+  public:
+    struct transfer {
+      unsigned long long offer;
+      unsigned long long cycle;
+      std::string bits;
+    };
+
+    struct level {
+      unsigned long long cycle;
+      bool value;
+    };
+
+    struct port {
+      bool is_in;
+      unsigned width;
+      std::string name;
+      std::deque<transfer> transfers;
+      std::vector<level> rdy;
+    };
+
+    std::vector<port> ports;
+    std::vector<level> reset;
+    unsigned long long end_cycle;
+
+    port_traffic() : end_cycle(0) {}
+
+    bool read(const std::string &fname) {
+      std::ifstream ifs(fname.c_str());
+      if (!ifs.is_open()) { return false; }
+      std::string line;
+      while (std::getline(ifs, line)) {
+        std::istringstream is(line);
+        std::string tag;
+        is >> tag;
+        if (tag == "P") {
+          unsigned idx;
+          std::string dir;
+          port p;
+          is >> idx >> dir >> p.width >> p.name;
+          p.is_in = (dir == "In");
+          if (ports.size() <= idx) { ports.resize(idx + 1); }
+          ports[idx] = p;
+        } else if (tag == "R") {
+          level l;
+          is >> l.cycle >> l.value;
+          reset.push_back(l);
+        } else if (tag == "Y") {
+          unsigned idx;
+          level l;
+          is >> idx >> l.cycle >> l.value;
+          if (idx < ports.size()) { ports[idx].rdy.push_back(l); }
+        } else if (tag == "T") {
+          unsigned idx;
+          transfer t;
+          is >> idx >> t.offer >> t.cycle >> t.bits;
+          if (idx < ports.size()) { ports[idx].transfers.push_back(t); }
+        } else if (tag == "E") {
+          is >> end_cycle;
+        }
+      }
+      return true;
+    }
+
+    // Level in effect at a cycle, given level changes in cycle order. The cursor only moves
+    // forward, so stepping it through all the cycles of a recording costs O(1) per cycle.
+    class level_cursor
+    {
+    public:
+      level_cursor() : pos(0) {}
+
+      // cycle must not decrease from one call to the next
+      bool at(const std::vector<level> &v, unsigned long long cycle, bool dflt) {
+        while ((pos < v.size()) && (v[pos].cycle <= cycle)) { pos++; }
+        return (pos == 0) ? dflt : v[pos - 1].value;
+      }
+
+    private:
+      size_t pos;
+    };
+  };
+
+  // Name of a port marker relative to module, without the marker suffix
+  inline std::string port_record_name(sc_object *marker, sc_object *module) {
+    std::string name = marker->name();
+    std::string root = std::string(module->name()) + ".";
+    if (name.compare(0, root.length(), root) == 0) { name.erase(0, root.length()); }
+    const char *suffix[] = {"_in_port_marker", "_out_port_marker"};
+    for (unsigned i=0; i < 2; i++) {
+      std::string s = suffix[i];
+      if ((name.length() > s.length()) && (name.compare(name.length() - s.length(), s.length(), s) == 0)) {
+        name.erase(name.length() - s.length());
+      }
+    }
+    return name;
+  }
+
+  class port_recorder : public sc_module
+  {
+    SC_HAS_PROCESS(port_recorder);
+
+  public:
+    port_recorder(sc_module_name nm, sc_object &module_, sc_clock &clk, const std::string &fname_,
+                  const sc_signal_in_if<bool> *rst_ = 0)
+      : sc_module(nm), module(&module_), fname(fname_), rst(rst_), cycle(0), last_rst(-1), ended(false) {
+      SC_METHOD(sample);
+      sensitive << clk.posedge_event();
+      dont_initialize();
+    }
+
+    ~port_recorder() { finish(); }
+
+  private:
+    struct port_state {
+      in_port_marker *in;
+      out_port_marker *out;
+      bool offered;
+      unsigned long long offer;
+      int last_rdy;
+      sc_lv_base bits;
+
+      explicit port_state(unsigned w) : in(0), out(0), offered(false), offer(0), last_rdy(-1), bits(w) {}
+    };
+
+    sc_object *module;
+    std::string fname;
+    const sc_signal_in_if<bool> *rst;
+    std::ofstream ofs;
+    std::vector<port_state> ports;
+    unsigned long long cycle;
+    int last_rst;
+    bool ended;
+
+    void start_of_simulation() {
+      std::vector<in_port_marker *> ins;
+      std::vector<out_port_marker *> outs;
+      port_scanner scanner;
+      scanner.find_ports(module, module, ins, outs);
+
+      ofs.open(fname.c_str());
+      if (!ofs.is_open()) {
+        SC_REPORT_ERROR("CONNECTIONS-401", ("Cannot open port record file " + fname).c_str());
+        return;
+      }
+      for (unsigned i=0; i < ins.size(); i++) {
+        if (!ins[i]->dat_access) { continue; }
+        ports.push_back(port_state(ins[i]->w));
+        ports.back().in = ins[i];
+        ofs << "P " << ports.size() - 1 << " In " << ins[i]->w << " " << port_record_name(ins[i], module) << "\n";
+      }
+      for (unsigned i=0; i < outs.size(); i++) {
+        if (!outs[i]->dat_access) { continue; }
+        ports.push_back(port_state(outs[i]->w));
+        ports.back().out = outs[i];
+        ofs << "P " << ports.size() - 1 << " Out " << outs[i]->w << " " << port_record_name(outs[i], module) << "\n";
+      }
+    }
+
+    void end_of_simulation() { finish(); }
+
+    void finish() {
+      if (ended || !ofs.is_open()) { return; }
+      ended = true;
+      ofs << "E " << cycle << "\n";
+      ofs.close();
+    }
+
+    // Signals read at the edge hold the values of the cycle that ends with it
+    void sample() {
+      if (!ofs.is_open() || ended) { return; }
+      cycle++;
+
+      if (rst) {
+        int r = rst->read();
+        if (r != last_rst) { ofs << "R " << cycle << " " << r << "\n"; }
+        last_rst = r;
+      }
+
+      for (unsigned i=0; i < ports.size(); i++) {
+        port_state &p = ports[i];
+        bool vld, rdy;
+        if (p.in) {
+          vld = p.in->_VLDNAME_->read();
+          rdy = p.in->_RDYNAME_->read();
+        } else {
+          vld = p.out->_VLDNAME_->read();
+          rdy = p.out->_RDYNAME_->read();
+          if (static_cast<int>(rdy) != p.last_rdy) { ofs << "Y " << i << " " << cycle << " " << rdy << "\n"; }
+          p.last_rdy = rdy;
+        }
+
+        if (vld && !p.offered) {
+          p.offered = true;
+          p.offer = cycle;
+        }
+        if (vld && rdy) {
+          port_marker_dat *d = p.in ? p.in->dat_access : p.out->dat_access;
+          d->read(p.bits);
+          ofs << "T " << i << " " << p.offer << " " << cycle << " " << p.bits.to_string() << "\n";
+          p.offered = false;
+        }
+      }
+    }
+  };
+
+  class port_replayer : public sc_module
+  {
+    SC_HAS_PROCESS(port_replayer);
+
+  public:
+    /**
+     * \param dut           Standalone instance of the recorded module, with its In/Out ports unbound.
+     * \param clk           Clock of dut.
+     * \param fname         Record file written by port_recorder.
+     * \param rst           Reset signal of dut, driven as recorded if given.
+     * \param drain_cycles  Cycles past the end of the recording to wait for missing outputs.
+     */
+    port_replayer(sc_module_name nm, sc_object &dut, sc_clock &clk, const std::string &fname,
+                  sc_signal<bool> *rst_ = 0, unsigned drain_cycles_ = 1000)
+      : sc_module(nm), rst(rst_), drain_cycles(drain_cycles_), cycle(0)
+      , check_timing(true), transfers(0), data_errors(0), timing_errors(0), done(false) {
+      if (!traffic.read(fname)) {
+        SC_REPORT_ERROR("CONNECTIONS-401", ("Cannot open port record file " + fname).c_str());
+        return;
+      }
+
+      for (unsigned i=0; i < traffic.ports.size(); i++) {
+        const port_traffic::port &t = traffic.ports[i];
+        std::string base = std::string(dut.name()) + "." + t.name;
+        std::string sig_name = t.name;
+        for (unsigned k=0; k < sig_name.length(); k++) { if (sig_name[k] == '.') { sig_name[k] = '_'; } }
+
+        port_state p(t.width);
+        p.vld = new sc_signal<bool>((sig_name + "_vld").c_str());
+        p.rdy = new sc_signal<bool>((sig_name + "_rdy").c_str());
+        if (t.is_in) {
+          p.in = dynamic_cast<in_port_marker *>(sc_find_object((base + "_in_port_marker").c_str()));
+          if (p.in && p.in->dat_access) {
+            (*p.in->_VLDNAME_)(*p.vld);
+            (*p.in->_RDYNAME_)(*p.rdy);
+            p.in->dat_access->bind_signal((sig_name + "_dat").c_str());
+          }
+        } else {
+          p.out = dynamic_cast<out_port_marker *>(sc_find_object((base + "_out_port_marker").c_str()));
+          if (p.out && p.out->dat_access) {
+            (*p.out->_VLDNAME_)(*p.vld);
+            (*p.out->_RDYNAME_)(*p.rdy);
+            p.out->dat_access->bind_signal((sig_name + "_dat").c_str());
+          }
+        }
+        if (!(p.in || p.out)) {
+          SC_REPORT_ERROR("CONNECTIONS-402", ("Recorded port " + t.name + " not found in " + dut.name()).c_str());
+        }
+        ports.push_back(p);
+      }
+
+      SC_METHOD(tick);
+      sensitive << clk.posedge_event();
+      dont_initialize();
+    }
+
+    // Report cycle differences as warnings instead of errors
+    void set_check_timing(bool check) { check_timing = check; }
+
+    bool passed() const { return done && (data_errors == 0) && (!check_timing || (timing_errors == 0)); }
+
+  private:
+    struct port_state {
+      in_port_marker *in;
+      out_port_marker *out;
+      sc_signal<bool> *vld;
+      sc_signal<bool> *rdy;
+      bool driving;
+      bool offered;
+      unsigned long long offer;
+      sc_lv_base bits;
+      port_traffic::level_cursor rdy_level;
+
+      explicit port_state(unsigned w)
+        : in(0), out(0), vld(0), rdy(0), driving(false), offered(false), offer(0), bits(w) {}
+    };
+
+    port_traffic traffic;
+    std::vector<port_state> ports;
+    sc_signal<bool> *rst;
+    port_traffic::level_cursor rst_level;
+    unsigned drain_cycles;
+    unsigned long long cycle;
+    bool check_timing;
+    unsigned long long transfers, data_errors, timing_errors;
+    bool done;
+
+    void start_of_simulation() { drive(); }
+
+    void end_of_simulation() {
+      CONNECTIONS_COUT("Info: port_replayer " << name() << ": " << transfers << " transfers replayed, "
+                       << data_errors << " data mismatches, " << timing_errors << " timing differences" << endl);
+    }
+
+    void timing(const port_traffic::port &t, const char *what, unsigned long long expected) {
+      timing_errors++;
+      std::ostringstream os;
+      os << t.name << " " << what << " in cycle " << cycle << ", recorded in cycle " << expected;
+      if (check_timing) {
+        SC_REPORT_ERROR("CONNECTIONS-403", os.str().c_str());
+      } else {
+        SC_REPORT_WARNING("CONNECTIONS-403", os.str().c_str());
+      }
+    }
+
+    void tick() {
+      cycle++;
+      observe();
+      drive();
+
+      bool pending = false;
+      for (unsigned i=0; i < ports.size(); i++) {
+        if (!traffic.ports[i].transfers.empty()) { pending = true; }
+      }
+      if (!done && !pending && (cycle >= traffic.end_cycle)) {
+        done = true;
+        sc_stop();
+      } else if (!done && (cycle > traffic.end_cycle + drain_cycles)) {
+        done = true;
+        SC_REPORT_ERROR("CONNECTIONS-404", "Recorded transfers not replayed by end of drain period");
+        sc_stop();
+      }
+    }
+
+    // Transfers in the cycle that ends with this edge
+    void observe() {
+      for (unsigned i=0; i < ports.size(); i++) {
+        port_state &p = ports[i];
+        port_traffic::port &t = traffic.ports[i];
+        if (p.in) {
+          if (p.driving && p.rdy->read()) {
+            if (t.transfers.front().cycle != cycle) { timing(t, "input accepted", t.transfers.front().cycle); }
+            t.transfers.pop_front();
+            p.driving = false;
+            transfers++;
+          }
+        } else if (p.out) {
+          bool vld = p.vld->read();
+          if (vld && !p.offered) {
+            p.offered = true;
+            p.offer = cycle;
+          }
+          if (vld && p.rdy->read()) {
+            p.offered = false;
+            transfers++;
+            p.out->dat_access->read(p.bits);
+            if (t.transfers.empty()) {
+              data_errors++;
+              SC_REPORT_ERROR("CONNECTIONS-405", (t.name + " output beyond the recorded transfers: " + p.bits.to_string()).c_str());
+              continue;
+            }
+            const port_traffic::transfer &x = t.transfers.front();
+            if (p.bits.to_string() != x.bits) {
+              data_errors++;
+              SC_REPORT_ERROR("CONNECTIONS-405", (t.name + " output " + p.bits.to_string() + " != recorded " + x.bits).c_str());
+            }
+            if (x.offer != p.offer) { timing(t, "output offered", x.offer); }
+            if (x.cycle != cycle) { timing(t, "output accepted", x.cycle); }
+            t.transfers.pop_front();
+          }
+        }
+      }
+    }
+
+    // Drive the values for the next cycle
+    void drive() {
+      unsigned long long next = cycle + 1;
+      if (rst && !traffic.reset.empty()) {
+        rst->write(rst_level.at(traffic.reset, next, traffic.reset[0].value));
+      }
+
+      for (unsigned i=0; i < ports.size(); i++) {
+        port_state &p = ports[i];
+        port_traffic::port &t = traffic.ports[i];
+        if (p.in) {
+          if (!p.driving && !t.transfers.empty() && (t.transfers.front().offer <= next)) {
+            p.driving = true;
+            p.bits = t.transfers.front().bits.c_str();
+            p.in->dat_access->write(p.bits);
+          }
+          p.vld->write(p.driving);
+        } else if (p.out) {
+          // Consumer always ready once past the end of the recording, so late outputs drain
+          bool r = true;
+          if ((next <= traffic.end_cycle) && !t.rdy.empty()) { r = p.rdy_level.at(t.rdy, next, t.rdy[0].value); }
+          p.rdy->write(r);
+        }
+      }
+    }
+  };
+
+#endif // CONNECTIONS_SIM_ONLY
+
+}  // namespace Connections
+
+#endif // __CONNECTIONS__PORT_RECORDER_H__
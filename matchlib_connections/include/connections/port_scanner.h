@@ -20,6 +20,8 @@
 //
 // Revision History:
 //  1.2.0 - Initial version
+//  1.2.1 - Added find_ports() for port_recorder.h
+//  1.2.2 - Walk the hierarchy through the cached hier_index
 //
 //*****************************************************************************************
 
@@ -45,43 +47,61 @@ namespace Connections
   {
   public:
     bool is_descendent_of(sc_object *child, sc_object *ancestor) {
-      sc_object *parent = child->get_parent_object();
-
-      if (!parent) { return false; }
+      return get_hier_index().is_descendant_of(child, ancestor);
+    }
 
-      if (parent == ancestor) { return true; }
+    // Marker of an In port bound to a channel outside of wrap_object, or 0
+    Connections::in_port_marker *boundary_in_port(Connections::in_port_marker *p, sc_object *wrap_object) {
+      p->end_of_elaboration();
 
-      return is_descendent_of(parent, ancestor);
+      if (p->bound_to && p->top_port) {
+        if (!is_descendent_of(p->bound_to, wrap_object)) { return p; }
+      }
+      return 0;
     }
 
-    void scan_port(sc_object *obj, sc_object *wrap_object, std::ostream &os) {
-      if (Connections::in_port_marker *p = dynamic_cast<Connections::in_port_marker *>(obj)) {
-        p->end_of_elaboration();
+    // Marker of an Out port bound to a channel outside of wrap_object, or 0
+    Connections::out_port_marker *boundary_out_port(Connections::out_port_marker *p, sc_object *wrap_object) {
+      p->end_of_elaboration();
 
-        if (p->bound_to && p->top_port) {
-          if (!is_descendent_of(p->bound_to, wrap_object)) {
-            os << "In " << std::dec << p->w << " " << p->_UTIL_DATNAME_->name() << "\n";
-          }
-        }
+      if (p->bound_to && p->top_port) {
+        if (!is_descendent_of(p->bound_to, wrap_object)) { return p; }
       }
+      return 0;
+    }
 
-      if (Connections::out_port_marker *p = dynamic_cast<Connections::out_port_marker *>(obj)) {
-        p->end_of_elaboration();
+    // Collect the In/Out ports that scan() lists
+    void find_ports(sc_object *obj, sc_object *wrap_object,
+                    std::vector<Connections::in_port_marker *> &ins, std::vector<Connections::out_port_marker *> &outs) {
+      std::vector<Connections::in_port_marker *> in_markers;
+      std::vector<Connections::out_port_marker *> out_markers;
+      get_hier_index().find(obj, in_markers);
+      get_hier_index().find(obj, out_markers);
 
-        if (p->bound_to && p->top_port) {
-          if (!is_descendent_of(p->bound_to, wrap_object)) {
-            os << "Out " << std::dec << p->w << " " << p->_UTIL_DATNAME_->name() << "\n";
-          }
-        }
+      for (unsigned i = 0; i < in_markers.size(); i++) {
+        if (Connections::in_port_marker *p = boundary_in_port(in_markers[i], wrap_object)) { ins.push_back(p); }
+      }
+      for (unsigned i = 0; i < out_markers.size(); i++) {
+        if (Connections::out_port_marker *p = boundary_out_port(out_markers[i], wrap_object)) { outs.push_back(p); }
       }
     }
 
+    // Lists ports in hierarchy order, In and Out interleaved
     void scan_hierarchy(sc_object *obj, sc_object *wrap_object, std::ostream &os) {
-      scan_port(obj, wrap_object, os);
-
-      std::vector<sc_object *> children = obj->get_child_objects();
-      for ( unsigned i = 0; i < children.size(); i++ ) {
-        if ( children[i] ) { scan_hierarchy( children[i], wrap_object, os); }
+      std::vector<Connections::in_port_marker *> ins;
+      std::vector<Connections::out_port_marker *> outs;
+      find_ports(obj, wrap_object, ins, outs);
+
+      hier_index &idx = get_hier_index();
+      unsigned i = 0, o = 0;
+      while ((i < ins.size()) || (o < outs.size())) {
+        if ((o == outs.size()) || ((i < ins.size()) && (idx.position_of(ins[i]) < idx.position_of(outs[o])))) {
+          os << "In " << std::dec << ins[i]->w << " " << ins[i]->_UTIL_DATNAME_->name() << "\n";
+          i++;
+        } else {
+          os << "Out " << std::dec << outs[o]->w << " " << outs[o]->_UTIL_DATNAME_->name() << "\n";
+          o++;
+        }
       }
     }
 
@@ -9,6 +9,13 @@ echo --------------------------------------------------
 set -v
 
 make build
-./sim_sc
+./sim_sc > sim_default.log
+./sim_sc idle_skip > sim_idle_skip.log
+
+# skipping idle cycles must not change any transfer, its time, or the printed times
+diff chan_log_data.txt chan_log_idle_skip_data.txt
+diff chan_log_names.txt chan_log_idle_skip_names.txt
+diff sim_default.log <(grep -v "idle cycles skipped" sim_idle_skip.log)
+grep "idle cycles skipped" sim_idle_skip.log
 
 make clean
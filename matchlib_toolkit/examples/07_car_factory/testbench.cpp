@@ -213,14 +213,20 @@ int sc_main(int argc, char **argv)
   sc_trace_file *trace_file_ptr = sc_trace_static::setup_trace_file("trace");
   trace_file_ptr->set_time_unit(0.1, SC_SEC);
 
+  // "sim_sc idle_skip" lets the ConManager skip the cycles in which all channels are idle,
+  // and logs to chan_log_idle_skip. Its output and channel logs must match the default run.
+  bool idle_skip = (argc > 1) && (std::string(argv[1]) == "idle_skip");
+  if (idle_skip) { Connections::enable_idle_skip(); }
+
   Top top("top");
   trace_hierarchy(&top, trace_file_ptr);
 
   channel_logs logs;
-  logs.enable("chan_log");
+  logs.enable(idle_skip ? "chan_log_idle_skip" : "chan_log");
   logs.log_hierarchy(top);
 
   sc_start();
+  if (idle_skip) { std::cout << "idle cycles skipped: " << Connections::get_idle_cycles() << std::endl; }
   if (sc_report_handler::get_count(SC_ERROR) > 0) {
     std::cout << "Simulation FAILED" << std::endl;
     return -1;
@@ -0,0 +1,528 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2020 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+#pragma once
+
+#include <mc_connections.h>
+#include "auto_gen_fields.h"
+#include "auto_gen_port_info.h"
+#include "axi4_segment.h"
+
+/**
+ *  * \brief desc_dma address map as seen by the CPU
+*/
+struct desc_dma_address_map {
+  uint64_t  desc_addr;    // address of the first descriptor of a chain
+  uint64_t  irq_count;    // raise irq once this many descriptors have completed (0 or 1: every descriptor)
+  uint64_t  irq_timeout;  // or this many clocks after the oldest unreported completion (0: no timeout)
+  uint64_t  start;        // queue the chain at desc_addr
+};
+
+enum desc_ctrl_t {DESC_IRQ=1};  // raise irq when this descriptor completes
+
+/**
+ *  * \brief transfer descriptor, stored in memory as 4 64 bit words:
+ *  *   word 0: src_addr   [31:0], dst_addr   [63:32]
+ *  *   word 1: row_len    [31:0], rows [47:32], ctrl [63:48]
+ *  *   word 2: src_stride [31:0], dst_stride [63:32]
+ *  *   word 3: next       [31:0]
+ *  * Each of the rows (0 means 1) copies row_len bytes and then advances the source and target
+ *  * addresses by their strides. Descriptors linked by next (0 ends the chain) form a scatter/gather list.
+*/
+struct sg_desc {
+  ac_int<32, false> src_addr {0};
+  ac_int<32, false> dst_addr {0};
+  ac_int<32, false> row_len {0};
+  ac_int<16, false> rows {0};
+  ac_int<16, false> ctrl {0};
+  ac_int<32, false> src_stride {0};
+  ac_int<32, false> dst_stride {0};
+  ac_int<32, false> next {0};
+  bool error {0};  // not stored in memory: the descriptor fetch failed
+
+  static const int words = 4;
+
+  void set_word(int i, uint64_t v) {
+    switch (i) {
+      case 0: src_addr = v; dst_addr = v >> 32; break;
+      case 1: row_len = v; rows = v >> 32; ctrl = v >> 48; break;
+      case 2: src_stride = v; dst_stride = v >> 32; break;
+      default: next = v; break;
+    }
+  }
+
+  uint64_t get_word(int i) const {
+    switch (i) {
+      case 0: return src_addr.to_uint64() | (dst_addr.to_uint64() << 32);
+      case 1: return row_len.to_uint64() | (rows.to_uint64() << 32) | (ctrl.to_uint64() << 48);
+      case 2: return src_stride.to_uint64() | (dst_stride.to_uint64() << 32);
+      default: return next.to_uint64();
+    }
+  }
+
+  AUTO_GEN_FIELD_METHODS(sg_desc, ( \
+     src_addr \
+   , dst_addr \
+   , row_len \
+   , rows \
+   , ctrl \
+   , src_stride \
+   , dst_stride \
+   , next \
+   , error \
+  ) )
+  //
+};
+
+/**
+ *  * \brief read burst issued by the descriptor engine: a descriptor fetch or data, and its beats - 1
+*/
+struct desc_dma_rd_tag {
+  bool desc {0};
+  ac_int<32, false> beats {0};
+
+  AUTO_GEN_FIELD_METHODS(desc_dma_rd_tag, ( \
+     desc \
+   , beats \
+  ) )
+  //
+};
+
+/**
+ *  * \brief one per write burst (or rejected descriptor), in issue order, for the completion process
+*/
+struct desc_dma_done {
+  bool write {0};  // a write response is expected
+  bool last {0};   // last write burst of its descriptor
+  bool irq {0};    // the descriptor asked for an irq
+  bool error {0};  // the descriptor was rejected
+
+  AUTO_GEN_FIELD_METHODS(desc_dma_done, ( \
+     write \
+   , last \
+   , irq \
+   , error \
+  ) )
+  //
+};
+
+/**
+ *  * \brief interrupt coalescing settings
+*/
+struct desc_dma_irq_cfg {
+  ac_int<16, false> count {0};
+  ac_int<32, false> timeout {0};
+
+  AUTO_GEN_FIELD_METHODS(desc_dma_irq_cfg, ( \
+     count \
+   , timeout \
+  ) )
+  //
+};
+
+typedef axi::axi4_segment<axi::cfg::standard> local_axi;
+
+/**
+ *  * \brief descriptor ring dma module
+ *
+ *  Unlike dma, which copies one command at a time and waits for its write response before
+ *  taking the next one, desc_dma fetches chains of descriptors from memory and keeps up to
+ *  rd_outstanding read bursts and wr_outstanding write bursts in flight across descriptors.
+ *  The next descriptor is fetched while the rows of the current one are issued.
+ *
+ *  irq carries the number of descriptors completed since the previous irq, with bit 31 set
+ *  if any of them failed. It is raised per irq_count descriptors, after irq_timeout clocks,
+ *  or when a descriptor with DESC_IRQ completes.
+*/
+#pragma hls_design top
+class desc_dma : public sc_module, public local_axi
+{
+public:
+  // bursts kept in flight. Define SEGMENT_W_OUTSTANDING to at least wr_outstanding, or
+  // the w_segment holds each write burst until the response of the previous one.
+  static const int rd_outstanding = 8;
+  static const int wr_outstanding = 8;
+
+  sc_in<bool> CCS_INIT_S1(clk);
+  sc_in<bool> CCS_INIT_S1(rst_bar);
+
+  r_master<> CCS_INIT_S1(r_master0);
+  w_master<> CCS_INIT_S1(w_master0);
+  r_slave<>  CCS_INIT_S1(r_slave0);
+  w_slave<>  CCS_INIT_S1(w_slave0);
+  Connections::Out<sc_uint<32>> CCS_INIT_S1(irq);
+
+  AUTO_GEN_PORT_INFO(desc_dma, ( \
+    clk \
+  , rst_bar \
+  , r_master0 \
+  , w_master0 \
+  , r_slave0 \
+  , w_slave0 \
+  , irq \
+  ) )
+  //
+
+  SC_CTOR(desc_dma) {
+    SC_THREAD(slave_process);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(desc_process);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(read_data_process);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(resp_process);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+
+    start_fifo.clk(clk);
+    start_fifo.rst(rst_bar);
+    start_fifo.enq(start_in);
+    start_fifo.deq(start_out);
+
+    desc_fifo.clk(clk);
+    desc_fifo.rst(rst_bar);
+    desc_fifo.enq(desc_in);
+    desc_fifo.deq(desc_out);
+
+    rd_tag_fifo.clk(clk);
+    rd_tag_fifo.rst(rst_bar);
+    rd_tag_fifo.enq(rd_tag_in);
+    rd_tag_fifo.deq(rd_tag_out);
+
+    rd_credit_fifo.clk(clk);
+    rd_credit_fifo.rst(rst_bar);
+    rd_credit_fifo.enq(rd_credit_in);
+    rd_credit_fifo.deq(rd_credit_out);
+
+    aw_fifo.clk(clk);
+    aw_fifo.rst(rst_bar);
+    aw_fifo.enq(aw_in);
+    aw_fifo.deq(w_segment0_ex_aw_chan);
+
+    done_fifo.clk(clk);
+    done_fifo.rst(rst_bar);
+    done_fifo.enq(done_in);
+    done_fifo.deq(done_out);
+
+    wr_credit_fifo.clk(clk);
+    wr_credit_fifo.rst(rst_bar);
+    wr_credit_fifo.enq(wr_credit_in);
+    wr_credit_fifo.deq(wr_credit_out);
+
+    AXI4_W_SEGMENT_BIND(w_segment0, clk, rst_bar, w_master0);
+    AXI4_R_SEGMENT_BIND(r_segment0, clk, rst_bar, r_master0);
+  }
+
+private:
+  typedef ac_int<32, false> addr_t;
+
+  // chains queued by the start register
+  Connections::Fifo<addr_t, 4> CCS_INIT_S1(start_fifo);
+  Connections::Combinational<addr_t> CCS_INIT_S1(start_in);
+  Connections::Combinational<addr_t> CCS_INIT_S1(start_out);
+
+  Connections::Combinational<desc_dma_irq_cfg> CCS_INIT_S1(irq_cfg_chan);
+
+  // fetched descriptors. The fifos below are sized so that their writers never wait on them,
+  // which keeps the read data flowing while desc_process waits for credits.
+  Connections::Fifo<sg_desc, 2> CCS_INIT_S1(desc_fifo);
+  Connections::Combinational<sg_desc> CCS_INIT_S1(desc_in);
+  Connections::Combinational<sg_desc> CCS_INIT_S1(desc_out);
+
+  // read bursts in issue order, and a credit as each data burst completes
+  Connections::Fifo<desc_dma_rd_tag, rd_outstanding + 2> CCS_INIT_S1(rd_tag_fifo);
+  Connections::Combinational<desc_dma_rd_tag> CCS_INIT_S1(rd_tag_in);
+  Connections::Combinational<desc_dma_rd_tag> CCS_INIT_S1(rd_tag_out);
+  Connections::Fifo<bool, rd_outstanding> CCS_INIT_S1(rd_credit_fifo);
+  Connections::Combinational<bool> CCS_INIT_S1(rd_credit_in);
+  Connections::Combinational<bool> CCS_INIT_S1(rd_credit_out);
+
+  // write bursts wait here for their data, so that desc_process can go on issuing reads
+  Connections::Fifo<ex_aw_payload, wr_outstanding> CCS_INIT_S1(aw_fifo);
+  Connections::Combinational<ex_aw_payload> CCS_INIT_S1(aw_in);
+
+  // write bursts in issue order, and a credit as each write response arrives
+  Connections::Fifo<desc_dma_done, wr_outstanding> CCS_INIT_S1(done_fifo);
+  Connections::Combinational<desc_dma_done> CCS_INIT_S1(done_in);
+  Connections::Combinational<desc_dma_done> CCS_INIT_S1(done_out);
+  Connections::Fifo<bool, wr_outstanding> CCS_INIT_S1(wr_credit_fifo);
+  Connections::Combinational<bool> CCS_INIT_S1(wr_credit_in);
+  Connections::Combinational<bool> CCS_INIT_S1(wr_credit_out);
+
+  // write and read segmenters segment long bursts to conform to AXI4 protocol (which allows 256 beats maximum).
+  AXI4_W_SEGMENT(w_segment0)
+  AXI4_R_SEGMENT(r_segment0)
+
+  void fetch_desc(addr_t addr) {
+    desc_dma_rd_tag tag;
+    tag.desc = true;
+    tag.beats = sg_desc::words - 1;
+    rd_tag_in.Push(tag);
+
+    ex_ar_payload ar;
+    ar.addr = addr;
+    ar.ex_len = sg_desc::words - 1;
+    r_segment0_ex_ar_chan.Push(ar);
+  }
+
+  // desc_process walks the descriptor chains and issues a read and a write burst per row.
+  // it only waits when rd_outstanding reads or wr_outstanding writes are already in flight.
+  void desc_process() {
+    start_out.ResetRead();
+    desc_out.ResetRead();
+    rd_tag_in.ResetWrite();
+    r_segment0_ex_ar_chan.ResetWrite();
+    rd_credit_out.ResetRead();
+    aw_in.ResetWrite();
+    done_in.ResetWrite();
+    wr_credit_out.ResetRead();
+
+    ac_int<8, false> rd_inflight = 0;
+    ac_int<8, false> wr_inflight = 0;
+
+    wait();
+
+    while (1) {
+      fetch_desc(start_out.Pop());
+
+      while (1) {
+        sg_desc d = desc_out.Pop();
+
+        desc_dma_done done;
+        done.irq = (d.ctrl & DESC_IRQ) != 0;
+        done.error = d.error || (d.row_len == 0) ||
+                     (((d.src_addr | d.dst_addr | d.row_len | d.src_stride | d.dst_stride | d.next)
+                       & (bytesPerBeat - 1)) != 0);
+
+        if (done.error) {
+          // a bad descriptor ends its chain
+          CCS_LOG("discarding invalid DMA descriptor");
+          done.last = true;
+          done_in.Push(done);
+          break;
+        }
+
+        // fetch the next descriptor while the rows of this one are issued
+        if (d.next != 0) { fetch_desc(d.next); }
+
+        ex_ar_payload ar;
+        ex_aw_payload aw;
+        ar.addr = d.src_addr;
+        aw.addr = d.dst_addr;
+        ac_int<32, false> len = d.row_len;
+        ac_int<16, false> rows = (d.rows == 0) ? ac_int<16, false>(1) : d.rows;
+        if ((d.src_stride == d.row_len) && (d.dst_stride == d.row_len)) {
+          // contiguous rows are copied as one burst
+          len = d.row_len * rows;
+          rows = 1;
+        }
+        ar.ex_len = (len / bytesPerBeat) - 1;
+        aw.ex_len = ar.ex_len;
+
+        desc_dma_rd_tag tag;
+        tag.beats = ar.ex_len;
+        done.write = true;
+
+        while (1) {
+          if (rd_inflight == rd_outstanding) {
+            rd_credit_out.Pop();
+            --rd_inflight;
+          }
+          if (wr_inflight == wr_outstanding) {
+            wr_credit_out.Pop();
+            --wr_inflight;
+          }
+
+          rd_tag_in.Push(tag);
+          r_segment0_ex_ar_chan.Push(ar);
+          ++rd_inflight;
+
+          aw_in.Push(aw);
+          done.last = (rows == 1);
+          done_in.Push(done);
+          ++wr_inflight;
+
+          if (--rows == 0) { break; }
+          ar.addr += d.src_stride;
+          aw.addr += d.dst_stride;
+        }
+
+        if (d.next == 0) { break; }
+      }
+    }
+  }
+
+  // read_data_process sends descriptor beats to desc_process and data beats to the write segmenter
+  void read_data_process() {
+    r_master0.r.Reset();
+    rd_tag_out.ResetRead();
+    desc_in.ResetWrite();
+    rd_credit_in.ResetWrite();
+    w_segment0_w_chan.ResetWrite();
+
+    wait();
+
+    while (1) {
+      desc_dma_rd_tag tag = rd_tag_out.Pop();
+      sg_desc d;
+      int word = 0;
+
+#pragma hls_pipeline_init_interval 1
+#pragma pipeline_stall_mode flush
+      while (1) {
+        r_payload r = r_master0.r.Pop();
+        if (tag.desc) {
+          d.set_word(word++, r.data.to_uint64());
+          if (r.resp != Enc::XRESP::OKAY) { d.error = true; }
+        } else {
+          w_payload w;
+          w.data = r.data;
+          w_segment0_w_chan.Push(w);
+        }
+
+        if (tag.beats-- == 0) { break; }
+      }
+
+      if (tag.desc) {
+        desc_in.Push(d);
+      } else {
+        rd_credit_in.Push(true);
+      }
+    }
+  }
+
+  // resp_process retires write bursts as their responses arrive and coalesces the
+  // completed descriptors into irqs
+  void resp_process() {
+    w_segment0_b_chan.ResetRead();
+    done_out.ResetRead();
+    wr_credit_in.ResetWrite();
+    irq_cfg_chan.ResetRead();
+    irq.Reset();
+
+    wait();
+
+    desc_dma_irq_cfg cfg;
+    desc_dma_done done;
+    bool done_vld = false;
+    bool error = false;
+    ac_int<16, false> pending = 0;  // completed descriptors not yet reported
+    ac_int<32, false> timer = 0;    // clocks since the oldest of them completed
+
+#pragma hls_pipeline_init_interval 1
+#pragma pipeline_stall_mode flush
+    while (1) {
+      wait();
+
+      desc_dma_irq_cfg new_cfg;
+      if (irq_cfg_chan.PopNB(new_cfg)) { cfg = new_cfg; }
+
+      if (!done_vld) { done_vld = done_out.PopNB(done); }
+
+      bool fire = false;
+      b_payload b;
+      if (done_vld && (!done.write || w_segment0_b_chan.PopNB(b))) {
+        done_vld = false;
+        if (done.write) {
+          wr_credit_in.Push(true);
+          if (b.resp != Enc::XRESP::OKAY) { error = true; }
+        }
+        if (done.error) { error = true; }
+        if (done.last) {
+          ++pending;
+          fire = done.irq || done.error || (pending >= cfg.count);
+        }
+      }
+
+      if ((pending != 0) && (cfg.timeout != 0) && (++timer >= cfg.timeout)) { fire = true; }
+
+      if (fire) {
+        sc_uint<32> v = pending.to_uint();
+        v[31] = error;
+        irq.Push(v);
+        pending = 0;
+        timer = 0;
+        error = false;
+      }
+    }
+  }
+
+  // slave_process accepts incoming axi4 requests from slave0 and programs the dma registers.
+  // each write to the start register queues the chain at desc_addr for desc_process.
+  void slave_process() {
+    r_slave0.reset();
+    w_slave0.reset();
+    start_in.ResetWrite();
+    irq_cfg_chan.ResetWrite();
+
+    wait();
+
+    addr_t desc_addr = 0;
+    desc_dma_irq_cfg cfg;
+
+    while (1) {
+      aw_payload aw;
+      w_payload w;
+      b_payload b;
+
+      if (w_slave0.get_single_write(aw, w, b)) {
+        b.resp = Enc::XRESP::SLVERR;
+        switch (aw.addr) {
+          case offsetof(desc_dma_address_map, desc_addr):
+            desc_addr = w.data;
+            b.resp = Enc::XRESP::OKAY;
+            break;
+          case offsetof(desc_dma_address_map, irq_count):
+            cfg.count = w.data;
+            irq_cfg_chan.Push(cfg);
+            b.resp = Enc::XRESP::OKAY;
+            break;
+          case offsetof(desc_dma_address_map, irq_timeout):
+            cfg.timeout = w.data;
+            irq_cfg_chan.Push(cfg);
+            b.resp = Enc::XRESP::OKAY;
+            break;
+          case offsetof(desc_dma_address_map, start):
+            start_in.Push(desc_addr);
+            b.resp = Enc::XRESP::OKAY;
+            break;
+        }
+        w_slave0.b.Push(b);
+      }
+    }
+  }
+};
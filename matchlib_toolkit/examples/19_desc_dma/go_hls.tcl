@@ -0,0 +1,41 @@
+set sfd [file dir [info script]]
+
+options defaults
+
+options set /Input/CppStandard c++11
+options set /Input/CompilerFlags {-DCONNECTIONS_ACCURATE_SIM -DSEGMENT_W_OUTSTANDING=8}
+options set /Input/SearchPath {$MGC_HOME/shared/examples/matchlib/toolkit/include} -append
+options set /Input/SearchPath {$MGC_HOME/shared/pkgs/matchlib/cmod/include} -append
+options set /Input/SearchPath {$MGC_HOME/shared/pkgs/boostpp/pp/include} -append
+
+project new
+
+flow package require /SCVerify
+# Set to a non-zero number to enable automatic random stall injection on handshake interfaces
+#flow package option set /SCVerify/AUTOWAIT 0
+# Allow initial toggle of reset
+#flow package option set /SCVerify/ENABLE_RESET_TOGGLE true
+# Turn on to enable systematic STALL_FLAG toggling (requires STALL_FLAG directive to be set)
+#flow package option set /SCVerify/ENABLE_STALL_TOGGLE true
+
+flow package require /QuestaSIM
+flow package option set /QuestaSIM/ENABLE_CODE_COVERAGE true
+flow package option set /QuestaSIM/MSIM_DOFILE $sfd/msim.do
+
+solution file add "$sfd/desc_dma.h" -type CHEADER
+solution file add "$sfd/testbench.cpp" -type C++ -exclude true
+
+go analyze
+directive set -DESIGN_HIERARCHY desc_dma
+
+go compile
+solution library add nangate-45nm_beh -- -rtlsyntool OasysRTL -vendor Nangate -technology 045nm
+
+go libraries
+directive set -CLOCKS {clk {-CLOCK_PERIOD 2.0}}
+
+go assembly
+go architect
+go allocate
+go extract
+
@@ -0,0 +1,14 @@
+#!/bin/bash
+
+set -e
+
+echo --------------------------------------------------
+echo PREHLS TEST: `pwd`
+echo --------------------------------------------------
+
+set -v
+
+make build
+./sim_sc
+
+make clean
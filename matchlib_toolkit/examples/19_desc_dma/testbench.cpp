@@ -0,0 +1,278 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2020 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+
+#include "desc_dma.h"
+#include "ram.h"
+#include <mc_scverify.h>
+
+typedef axi::axi4_segment<axi::cfg::standard> local_axi;
+
+/**
+ *  * \brief a chain of descriptors run by the testbench. Descriptor i copies rows of
+ *  * row_len bytes, from rows * src_stride * i past the source base to rows * dst_stride * i
+ *  * past the target base.
+*/
+struct chain_test {
+  const char* name;
+  int descs;
+  int row_len;
+  int rows;
+  int src_stride;
+  int dst_stride;
+};
+
+class Top : public sc_module, public local_axi
+{
+public:
+  ram             CCS_INIT_S1(ram1);
+  CCS_DESIGN(desc_dma) CCS_INIT_S1(dma1);
+
+  sc_clock clk;
+  SC_SIG(bool, rst_bar);
+
+  w_chan<> CCS_INIT_S1(dma_w_slave);
+  r_chan<> CCS_INIT_S1(dma_r_slave);
+  w_chan<> CCS_INIT_S1(dma_w_master);
+  r_chan<> CCS_INIT_S1(dma_r_master);
+  Connections::Combinational<sc_uint<32>> CCS_INIT_S1(dma_irq);
+  w_master<>    CCS_INIT_S1(tb_w_master);
+  r_master<>    CCS_INIT_S1(tb_r_master);
+
+  SC_CTOR(Top)
+    :   clk("clk", 1, SC_NS, 0.5,0,SC_NS,true) {
+
+    tb_w_master(dma_w_slave);
+    tb_r_master(dma_r_slave);
+
+    ram1.clk(clk);
+    ram1.rst_bar(rst_bar);
+    ram1.r_slave0(dma_r_master);
+    ram1.w_slave0(dma_w_master);
+
+    dma1.clk(clk);
+    dma1.rst_bar(rst_bar);
+    dma1.r_master0(dma_r_master);
+    dma1.w_master0(dma_w_master);
+    dma1.r_slave0(dma_r_slave);
+    dma1.w_slave0(dma_w_slave);
+    dma1.irq(dma_irq);
+
+    SC_CTHREAD(reset, clk);
+
+    SC_THREAD(stim);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(irq_mon);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+
+    sc_object_tracer<sc_clock> trace_clk(clk);
+  }
+
+  // irq coalescing used by the tests
+  int irq_count = 8;
+  int irq_timeout = 64;
+
+  // updated by irq_mon
+  int completed = 0;
+  int irqs = 0;
+  bool irq_error = false;
+  sc_time last_irq_time;
+
+  void stim() {
+    CCS_LOG("Stimulus started");
+    tb_w_master.reset();
+    tb_r_master.reset();
+    wait();
+
+    tb_w_master.single_write(offsetof(desc_dma_address_map, irq_count),   irq_count);
+    tb_w_master.single_write(offsetof(desc_dma_address_map, irq_timeout), irq_timeout);
+
+    // a mix of transfer sizes, each a gather list of descriptors with gaps between the sources,
+    // followed by 2D transfers that gather, scatter and copy a contiguous block
+    chain_test tests[] = {
+      {"8B",        32,    8,  1,    16,    8},
+      {"64B",       32,   64,  1,   128,   64},
+      {"256B",      32,  256,  1,   512,  256},
+      {"1KB",       32, 1024,  1,  2048, 1024},
+      {"4KB",       16, 4096,  1,  8192, 4096},
+      {"2D gather",  4,   64, 32,   256,   64},
+      {"2D scatter", 4,   64, 32,    64,  256},
+      {"2D block",   4,  256,  8,   256,  256},
+    };
+
+    for (unsigned t=0; t < sizeof(tests) / sizeof(tests[0]); t++) {
+      run_chain(t, tests[t]);
+    }
+
+    bad_desc_test();
+
+    CCS_LOG("peak rate is " << bytesPerBeat << " bytes/clock");
+    sc_stop();
+    wait();
+  }
+
+  // starts the chain of descriptors at desc_addr and waits until descs of them have completed
+  bool run_descs(uint64_t desc_addr, int descs, sc_time& elapsed) {
+    completed = 0;
+    irqs = 0;
+    irq_error = false;
+
+    tb_w_master.single_write(offsetof(desc_dma_address_map, desc_addr), desc_addr);
+    sc_time start_time = sc_time_stamp();
+    tb_w_master.single_write(offsetof(desc_dma_address_map, start),     0x1);
+
+    while (completed < descs) {
+      wait();
+      if (sc_time_stamp() - start_time > sc_time(1, SC_MS)) {
+        SC_REPORT_ERROR("testbench", "timeout waiting for dma irq");
+        return false;
+      }
+    }
+
+    elapsed = last_irq_time - start_time;
+    return true;
+  }
+
+  void write_desc(uint64_t addr, const sg_desc& d) {
+    for (int w=0; w < sg_desc::words; w++) {
+      ram1.write_word(addr + (w * bytesPerBeat), d.get_word(w));
+    }
+  }
+
+  void run_chain(int t, const chain_test& c) {
+    uint64_t desc_base = 0x10000   + (t * 0x1000);
+    uint64_t src_base  = 0x1000000 + (t * 0x100000);
+    uint64_t dst_base  = 0x8000000 + (t * 0x100000);
+    int desc_bytes = sg_desc::words * bytesPerBeat;
+
+    for (int i=0; i < c.descs; i++) {
+      sg_desc d;
+      d.src_addr   = src_base + (i * c.rows * c.src_stride);
+      d.dst_addr   = dst_base + (i * c.rows * c.dst_stride);
+      d.row_len    = c.row_len;
+      d.rows       = c.rows;
+      d.src_stride = c.src_stride;
+      d.dst_stride = c.dst_stride;
+      d.next       = (i + 1 < c.descs) ? (desc_base + ((i + 1) * desc_bytes)) : 0;
+      d.ctrl       = (i + 1 < c.descs) ? 0 : DESC_IRQ;
+      write_desc(desc_base + (i * desc_bytes), d);
+    }
+
+    sc_time elapsed;
+    if (!run_descs(desc_base, c.descs, elapsed)) { return; }
+
+    if (irq_error) {
+      SC_REPORT_ERROR("testbench", "dma irq reported an error");
+    }
+
+    // unwritten ram words read as their address, so each target word must hold its source address
+    int mismatches = 0;
+    for (int i=0; i < c.descs; i++) {
+      for (int r=0; r < c.rows; r++) {
+        for (int b=0; b < c.row_len; b += bytesPerBeat) {
+          uint64_t s = src_base + (((i * c.rows) + r) * c.src_stride) + b;
+          uint64_t d = dst_base + (((i * c.rows) + r) * c.dst_stride) + b;
+          uint64_t v = ram1.debug_read_addr(d).to_uint64();
+          if ((v != s) && (mismatches++ < 4)) {
+            CCS_LOG("ram source and target data mismatch! " << std::hex << " s:" << s << " t: " << d << " v: " << v);
+          }
+        }
+      }
+    }
+    if (mismatches) {
+      SC_REPORT_ERROR("testbench", "dma target data mismatch");
+    }
+
+    int bytes = c.descs * c.rows * c.row_len;
+    double clocks = elapsed / sc_time(1, SC_NS);
+    CCS_LOG(c.name << ": " << std::dec << c.descs << " descriptors, " << bytes << " bytes in "
+            << clocks << " clocks, " << (bytes / clocks) << " bytes/clock, " << irqs << " irqs");
+  }
+
+  // a descriptor with an unaligned length is rejected, ends its chain and flags the irq
+  void bad_desc_test() {
+    uint64_t desc_addr = 0x20000;
+    sg_desc d;
+    d.src_addr = 0x1000;
+    d.dst_addr = 0x2000;
+    d.row_len  = bytesPerBeat + 4;
+    d.next     = desc_addr;
+    write_desc(desc_addr, d);
+
+    sc_time elapsed;
+    if (!run_descs(desc_addr, 1, elapsed)) { return; }
+
+    if (!irq_error) {
+      SC_REPORT_ERROR("testbench", "invalid descriptor not reported");
+    }
+  }
+
+  void irq_mon() {
+    dma_irq.ResetRead();
+    wait();
+
+    while (1) {
+      sc_uint<32> v = dma_irq.Pop();
+      completed += v.range(15, 0).to_uint();
+      irq_error |= (v[31] == 1);
+      irqs++;
+      last_irq_time = sc_time_stamp();
+    }
+  }
+
+  void reset() {
+    rst_bar.write(0);
+    wait(5);
+    rst_bar.write(1);
+    wait();
+  }
+};
+
+int sc_main(int argc, char **argv)
+{
+  sc_report_handler::set_actions("/IEEE_Std_1666/deprecated", SC_DO_NOTHING);
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+  sc_trace_file *trace_file_ptr = sc_trace_static::setup_trace_file("trace");
+
+  Top top("top");
+  trace_hierarchy(&top, trace_file_ptr);
+
+  sc_start();
+  if (sc_report_handler::get_count(SC_ERROR) > 0) {
+    std::cout << "Simulation FAILED" << std::endl;
+    return -1;
+  }
+  std::cout << "Simulation PASSED" << std::endl;
+  return 0;
+}
@@ -14,4 +14,7 @@ make sim_sc
 make fast_sim_sc
 ./fast_sim_sc
 
+make lt_sim_sc
+./lt_sim_sc
+
 make clean
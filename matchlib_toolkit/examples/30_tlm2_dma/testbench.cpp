@@ -39,10 +39,22 @@ typedef axi::axi4_segment<axi::cfg::standard> local_axi;
 #include "wrap_ram_tlm2.h"
 #include "wrap_dma_tlm2.h"
 
+// With TLM2_LT the RAM is the loosely timed tlm2_lt_ram instead of the wrapped
+// Matchlib ram, and after the DMA a software-like initiator exercises it.
+#ifdef TLM2_LT
+#include "tlm2_lt.h"
+#include <ctime>
+#endif
+
 class Top : public sc_module, public local_axi
 {
 public:
+#ifdef TLM2_LT
+  tlm2_lt_ram<local_axi> CCS_INIT_S1(ram1);
+  tlm2_lt_initiator CCS_INIT_S1(cpu);
+#else
   wrap_ram_tlm2 CCS_INIT_S1(ram1);
+#endif
   wrap_dma_tlm2 CCS_INIT_S1(dma1);
 
   sc_clock clk;
@@ -55,8 +67,12 @@ public:
   SC_CTOR(Top)
     :   clk("clk", 1, SC_NS, 0.5,0,SC_NS,true) {
 
+#ifdef TLM2_LT
+    cpu.tlm2_initiator(ram1.tlm2_target);
+#else
     ram1.clk(clk);
     ram1.rst_bar(rst_bar);
+#endif
 
     dma1.clk(clk);
     dma1.rst_bar(rst_bar);
@@ -84,6 +100,7 @@ public:
   }
 
   sc_time start_time, end_time;
+  bool dma_finished{false};
   int beats = 0x40;
   int source_addr = 0x1000;
   int target_addr = 0x4000;
@@ -114,8 +131,11 @@ public:
     start_time = sc_time_stamp();
 
     wait(2000, SC_NS);
-    CCS_LOG("stopping sim due to testbench timeout");
-    sc_stop();
+    if (!dma_finished) {
+      CCS_LOG("stopping sim due to testbench timeout");
+      SC_REPORT_ERROR("testbench", "timeout");
+      sc_stop();
+    }
     wait();
   }
 
@@ -136,17 +156,75 @@ public:
       CCS_LOG("clock period: " << sc_time(1, SC_NS));
 
       for (int i=0; i < beats; i++) {
-        int s = ram1.ram1.debug_read_addr(source_addr + (i * axi_cfg::dataWidth/8));
-        int t = ram1.ram1.debug_read_addr(target_addr + (i * axi_cfg::dataWidth/8));
+        int s = ram1.debug_read_addr(source_addr + (i * axi_cfg::dataWidth/8));
+        int t = ram1.debug_read_addr(target_addr + (i * axi_cfg::dataWidth/8));
         if (s != t) {
           CCS_LOG("ram source and target data mismatch! Beat#: " << i << " " <<  std::hex << " s:" << s << " t: " << t);
+          SC_REPORT_ERROR("testbench", "data mismatch");
         }
       }
 
+      dma_finished = true;
+#ifdef TLM2_LT
+      software();
+#endif
       sc_stop();
     }
   }
 
+#ifdef TLM2_LT
+  // Software-like traffic, as from an ISS running a copy loop: each 64 bit word
+  // is loaded, incremented and stored.  The same loop runs with plain b_transport
+  // calls, with sequential writes aggregated into bursts, and with DMI.
+  void software() {
+    const uint64_t src = 0x10000;
+    const uint64_t dst = 0x40000;
+    const int words = 0x4000;
+    const int reps = 4;
+
+    struct { const char* name; bool dmi; unsigned burst; } modes[] = {
+      { "b_transport",                    false, 0 },
+      { "b_transport, burst aggregation", false, 256 },
+      { "DMI",                            true,  0 }
+    };
+
+    tlm_utils::tlm_quantumkeeper::set_global_quantum(sc_time(1, SC_US));
+
+    for (unsigned m=0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+      ram1.invalidate_dmi();
+      cpu.use_dmi = modes[m].dmi;
+      cpu.max_burst = modes[m].burst;
+      cpu.reset_stats();
+      cpu.qk.reset();
+
+      sc_time sim_start = sc_time_stamp();
+      clock_t wall_start = clock();
+
+      for (int r=0; r < reps; r++)
+        for (int i=0; i < words; i++)
+          cpu.write<uint64_t>(dst + (i * 8), cpu.read<uint64_t>(src + (i * 8)) + r + m);
+      cpu.sync();
+
+      double secs = double(clock() - wall_start) / CLOCKS_PER_SEC;
+      uint64_t accesses = 2ULL * words * reps;
+      CCS_LOG(modes[m].name << ": " << std::dec << accesses << " accesses, "
+        << cpu.transactions << " transactions, " << cpu.dmi_accesses << " DMI accesses, "
+        << "sim time: " << (sc_time_stamp() - sim_start) << ", accesses/sec: "
+        << ((secs > 0) ? uint64_t(accesses / secs) : 0));
+
+      for (int i=0; i < words; i++) {
+        uint64_t s = ram1.debug_read_addr(src + (i * 8)).to_uint64();
+        uint64_t t = ram1.debug_read_addr(dst + (i * 8)).to_uint64();
+        if (t != (s + reps - 1 + m)) {
+          CCS_LOG("software copy mismatch! word#: " << std::dec << i << std::hex << " s: " << s << " t: " << t);
+          SC_REPORT_ERROR("testbench", "software copy mismatch");
+          break;
+        }
+      }
+    }
+  }
+#endif
+
   void dbg_mon() {
     dma_dbg.ResetRead();
     wait();
@@ -72,6 +72,23 @@
 
 using namespace tlm;
 
+// TLM2 data is little-endian bytes, while an ac_int beat is not stored as its bytes
+// (an ac_int<64,false> occupies 12 bytes), so beats are packed and unpacked explicitly.
+
+template <class beat_t>
+void tlm2_beat_to_bytes(const beat_t& beat, unsigned char* bytes, int n) {
+  for (int i=0; i < n; i++)
+    bytes[i] = beat.template slc<8>(i * 8).to_uint();
+}
+
+template <class beat_t>
+beat_t tlm2_bytes_to_beat(const unsigned char* bytes, int n) {
+  beat_t beat = 0;
+  for (int i=0; i < n; i++)
+    beat.set_slc(i * 8, ac_int<8, false>(bytes[i]));
+  return beat;
+}
+
 template <class axi_cfg>
 class axi4_slave_to_tlm2_initiator 
   : public sc_module
@@ -88,11 +105,14 @@ public:
   // need read_buf and write_buf, static size 256 * datawidth as per axi4 protocol.
   // can accept concurrent read and write bursts from axi4_slave, but tlm2 write will
   // not occur until all axi4 write beats are received.
-  // not handling any endianness conversion or write byte enables currently (easy to add)
+  // write strobes are passed on as tlm2 byte enables.
+  // the delay annotated by the tlm2 target is waited out in whole clock cycles
+  // before the read data or write response is returned.
   // not handling any axi4 narrow transfers currently (fairly easy to add)
 
-  ac_int<axi_cfg::bytesPerBeat*8, false> read_buf[256];
-  ac_int<axi_cfg::bytesPerBeat*8, false> write_buf[256];
+  unsigned char read_buf[256 * axi_cfg::bytesPerBeat];
+  unsigned char write_buf[256 * axi_cfg::bytesPerBeat];
+  unsigned char write_be[256 * axi_cfg::bytesPerBeat];
 
   SC_HAS_PROCESS(axi4_slave_to_tlm2_initiator);
 
@@ -108,6 +128,12 @@ public:
     async_reset_signal_is(rst_bar, false);
   }
 
+  void wait_annotated(const sc_time& delay) {
+    sc_clock* clock = dynamic_cast<sc_clock*>(clk.get_interface());
+    if (clock && (delay > SC_ZERO_TIME))
+      wait((int)ceil(delay / clock->period()));
+  }
+
   void slave_r_process() {
     r_slave0.reset();
     wait();
@@ -124,7 +150,7 @@ public:
       sc_assert((start_addr % axi_cfg::bytesPerBeat) == 0);
 
       tlm::tlm_generic_payload trans;
-      sc_time zero_time(SC_ZERO_TIME);
+      sc_time delay(SC_ZERO_TIME);
 
       trans.set_read();
       trans.set_address(start_addr);
@@ -134,12 +160,14 @@ public:
       trans.set_byte_enable_length(0);
       trans.set_streaming_width(data_len);
 
-      tlm2_initiator->b_transport(trans, zero_time);
+      tlm2_initiator->b_transport(trans, delay);
+      wait_annotated(delay);
 
       while (1) {
         typename axi_cfg::r_payload r;
 
-        r.data = read_buf[read_beat++];
+        r.data = tlm2_bytes_to_beat<decltype(r.data)>(
+          &read_buf[(read_beat++) * axi_cfg::bytesPerBeat], axi_cfg::bytesPerBeat);
         r.resp = (trans.get_response_status() == TLM_OK_RESPONSE) ?  
          axi_cfg::Enc::XRESP::OKAY : axi_cfg::Enc::XRESP::SLVERR;
 
@@ -160,6 +188,7 @@ public:
       uint64_t start_addr = aw.addr;
       uint64_t data_len = (int)(aw.len + 1) * (int)axi_cfg::bytesPerBeat;
       int write_beat{0};
+      bool all_enabled{true};
 
       sc_assert((start_addr % axi_cfg::bytesPerBeat) == 0);
 
@@ -168,24 +197,27 @@ public:
       while (1) {
         typename axi_cfg::w_payload w = w_slave0.w.Pop();
         decltype(w.wstrb) all_on{~0};
-        sc_assert(w.wstrb == all_on);
-        write_buf[write_beat++] = w.data;
+        all_enabled &= (w.wstrb == all_on);
+        for (int i=0; i < axi_cfg::bytesPerBeat; i++)
+          write_be[write_beat * axi_cfg::bytesPerBeat + i] = w.wstrb[i] ? TLM_BYTE_ENABLED : TLM_BYTE_DISABLED;
+        tlm2_beat_to_bytes(w.data, &write_buf[(write_beat++) * axi_cfg::bytesPerBeat], axi_cfg::bytesPerBeat);
 
         if (!w_slave0.next_multi_write(aw)) { break; }
       }
 
       tlm::tlm_generic_payload trans;
-      sc_time zero_time(SC_ZERO_TIME);
+      sc_time delay(SC_ZERO_TIME);
 
       trans.set_write();
       trans.set_address(start_addr);
       trans.set_data_ptr((unsigned char*)&write_buf);
       trans.set_data_length(data_len);
-      trans.set_byte_enable_ptr(0);
-      trans.set_byte_enable_length(0);
+      trans.set_byte_enable_ptr(all_enabled ? 0 : (unsigned char*)&write_be);
+      trans.set_byte_enable_length(all_enabled ? 0 : data_len);
       trans.set_streaming_width(data_len);
 
-      tlm2_initiator->b_transport(trans, zero_time);
+      tlm2_initiator->b_transport(trans, delay);
+      wait_annotated(delay);
 
       b.resp  = (trans.get_response_status() == TLM_OK_RESPONSE) ?  
          axi_cfg::Enc::XRESP::OKAY : axi_cfg::Enc::XRESP::SLVERR;
@@ -240,6 +272,12 @@ public:
 
   virtual void b_transport(int tag, tlm_generic_payload& trans, sc_time& tm) {
     sc_assert(tag == 0);
+    // a temporally decoupled initiator may be ahead of simulation time:
+    // catch up before talking to the clocked axi4 model
+    if (tm > SC_ZERO_TIME) {
+      wait(tm);
+      tm = SC_ZERO_TIME;
+    }
     current_trans = &trans;
     // separate thread used here is needed for proper handling of reset calls for Matchlib
     // not properly handling "dynamic resets" here, would need to clear the fifos in that case
@@ -260,8 +298,6 @@ public:
     uint64_t addr   = current_trans->get_address();
     uint64_t len    = current_trans->get_data_length();
     unsigned char* data_ptr = current_trans->get_data_ptr();
-    typedef ac_int<axi_cfg::bytesPerBeat*8, false> beat_t;
-    beat_t* beat_ptr = (beat_t*)data_ptr;
 
     current_trans->set_response_status(TLM_OK_RESPONSE);
 
@@ -280,7 +316,8 @@ public:
 
       do {
         typename axi_cfg::w_payload w;
-        w.data = *beat_ptr++;
+        w.data = tlm2_bytes_to_beat<decltype(w.data)>(data_ptr, axi_cfg::bytesPerBeat);
+        data_ptr += axi_cfg::bytesPerBeat;
         w_segment0_w_chan.Push(w);
       } while (aw.ex_len--);
 
@@ -302,7 +339,8 @@ public:
       do {
         typename axi_cfg::r_payload r;
         r = r_master0.r.Pop();
-        *beat_ptr++ = r.data;
+        tlm2_beat_to_bytes(r.data, data_ptr, axi_cfg::bytesPerBeat);
+        data_ptr += axi_cfg::bytesPerBeat;
         if (r.resp != axi_cfg::Enc::XRESP::OKAY)
           current_trans->set_response_status(TLM_GENERIC_ERROR_RESPONSE);
       } while (ar.ex_len--);
@@ -57,4 +57,8 @@ public:
     target_to_master.w_master0(ram_slave_w_chan);
     tlm2_target(target_to_master.tlm2_target);
   }
+
+  NVUINTW(axi_cfg::dataWidth) debug_read_addr(uint32_t addr) {
+    return ram1.debug_read_addr(addr);
+  }
 };
@@ -265,9 +265,24 @@ int sc_main(int argc, char **argv)
 #endif
   logs.log_hierarchy(top);
 
+#ifdef CONN_RAND_STALL
+  // Replay a previously exported stall pattern, otherwise record this one
+  char *replay_str = getenv("RAND_STALL_REPLAY");
+  if (replay_str) {
+    Connections::replay_rand_stall(replay_str);
+  } else {
+    Connections::record_rand_stall();
+  }
+#endif
+
   trace_hierarchy(&top, trace_file_ptr);
 
   sc_start();
+#ifdef CONN_RAND_STALL
+  if (!replay_str) {
+    Connections::export_rand_stall("rand_stall.txt");
+  }
+#endif
   if (sc_report_handler::get_count(SC_ERROR) > 0) {
     std::cout << "Simulation FAILED" << std::endl;
     return -1;
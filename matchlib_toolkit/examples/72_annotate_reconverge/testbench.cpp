@@ -36,6 +36,8 @@
 #ifndef __SYNTHESIS__
 #ifndef CCS_SYSC
 #include <connections/annotate.h>
+#include <connections/connections_profile.h>
+#include <connections/annotate_explore.h>
 #endif
 #endif
 
@@ -113,6 +115,16 @@ int sc_main(int argc, char **argv)
   // Configure error handling
   sc_report_handler::set_actions("/IEEE_Std_1666/deprecated", SC_DO_NOTHING);
   sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+  #ifndef __SYNTHESIS__
+  #ifndef CCS_SYSC
+  // "sim_sc explore" sizes the channel buffers, starting from testbench.input.json
+  Connections::annotate_explorer dse("testbench");
+  if ((argc > 1) && (std::string(argv[1]) == "explore")) {
+    if (dse.explore(argc, argv, 32)) { return 0; }
+  }
+  #endif
+  #endif
+
   // Create a trace file
   sc_trace_file *trace_file_ptr = sc_trace_static::setup_trace_file("trace");
 
@@ -129,6 +141,8 @@ int sc_main(int argc, char **argv)
   #ifndef __SYNTHESIS__
   #ifndef CCS_SYSC
   Connections::annotate_design(testbench);
+  // Per-channel stall/latency report, written to testbench.profile.json at exit
+  profile_hierarchy(&testbench, "testbench.profile.json");
   #endif
   #endif
 
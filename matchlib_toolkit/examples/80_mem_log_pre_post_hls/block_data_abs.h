@@ -34,6 +34,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <mem_binlog.h>
 
 
 class block_data_abs;
@@ -103,7 +104,13 @@ public:
         , use_ts(_use_ts)
         , write_cnt(_write_cnt)
       {
-        if (name != "") {
+#ifdef EXTENDED_ARRAY_BINARY_LOG
+        binary_log = true;
+#endif
+        if ((name != "") && binary_log) {
+          mem_read_binlog.open(name + "_read.bin", elem_width, use_ts);
+          mem_write_binlog.open(name + "_write.bin", elem_width, use_ts);
+        } else if (name != "") {
           mem_read_log.rdbuf()->pubsetbuf(0, 0);
           mem_write_log.rdbuf()->pubsetbuf(0, 0);
           mem_read_log.open(name + "_read.log");
@@ -115,8 +122,17 @@ public:
       uint32_t* write_cnt;
       ofstream mem_read_log;
       ofstream mem_write_log;
+      bool binary_log{false};
+      mem_log_writer mem_read_binlog;
+      mem_log_writer mem_write_binlog;
 
       void write_cb(int rsc_num, int row, sc_lv_base& rhs) {
+        if (binary_log) {
+          ++write_cnt[row];
+          mem_write_binlog.write(row, write_cnt[row], rhs);
+          return;
+        }
+
         std::ostringstream os;
         if (use_ts)
           os << sc_time_stamp();
@@ -129,6 +145,11 @@ public:
       }
 
       void read_cb(int rsc_num, int row, sc_dt::sc_subref<sc_lv_base> lhs) {
+        if (binary_log) {
+          mem_read_binlog.write(row, write_cnt[row], lhs);
+          return;
+        }
+
         std::ostringstream os;
         if (use_ts)
           os << sc_time_stamp();
@@ -10,5 +10,9 @@ set -v
 
 make build
 ./sim_sc
+# the binary channel log converted to text must match the text channel log
+./channel_log2txt chan_log_bin
+diff chan_log_data.txt chan_log_bin_data.txt
+diff chan_log_names.txt chan_log_bin_names.txt
 
 make clean
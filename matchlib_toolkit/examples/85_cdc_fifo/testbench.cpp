@@ -110,6 +110,8 @@ int sc_main(int argc, char *argv[])
   testbench top("top");
   channel_logs logs;
   logs.enable("chan_log", true);
+  // Also log in binary, channel_log2txt must convert it back to the text log (see test_prehls.sh)
+  logs.enable_binary("chan_log_bin");
   logs.log_hierarchy(top);
   trace_hierarchy(&top, trace_file_ptr);
   sc_start();
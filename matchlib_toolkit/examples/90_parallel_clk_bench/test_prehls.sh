@@ -0,0 +1,22 @@
+#!/bin/bash
+
+set -e
+
+echo --------------------------------------------------
+echo PREHLS TEST: `pwd`
+echo --------------------------------------------------
+
+set -v
+
+make build
+./sim_sc > sim_default.log
+./sim_sc parallel > sim_parallel.log
+./sim_sc deterministic > sim_deterministic.log
+grep -H "Run time" sim_default.log sim_parallel.log sim_deterministic.log
+
+# all modes must transfer the same messages, only the mode and run time may differ
+timing='Mode:|Run time'
+diff <(grep -Ev "$timing" sim_default.log) <(grep -Ev "$timing" sim_parallel.log)
+diff <(grep -Ev "$timing" sim_default.log) <(grep -Ev "$timing" sim_deterministic.log)
+
+make clean
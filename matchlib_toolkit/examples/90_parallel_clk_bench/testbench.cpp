@@ -0,0 +1,178 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2020 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+// Run time of a design whose clock domains all have their edges at the same time, in
+// the default mode and with the Pre() phase of the domains evaluated on host threads
+// (see Connections::enable_parallel_clk_domains() and README).
+
+#include <mc_connections.h>
+#include <chrono>
+
+// Wide messages make the unmarshalling done by In ports in Pre() the dominant cost,
+// which is the case the parallel mode is meant for.
+typedef ac_int<512, false> wide_t;
+
+static const int N_DOMAINS = 4;
+static const int N_CHANS = 128;    // Combinational channels per clock domain
+static const int N_CYCLES = 10000;
+
+static wide_t make_msg(unsigned d, unsigned c, unsigned long i)
+{
+  wide_t m = 0;
+  for (int w = 0; w < 8; w++) {
+    m.set_slc(64 * w, ac_int<64, false>(((d * N_CHANS + c) * 0x9e3779b97f4a7c15ULL) ^ (i << w)));
+  }
+  return m;
+}
+
+// One clock domain: a producer and a consumer process that each service all N_CHANS
+// channels every cycle, so the number of ports grows without adding processes.
+class domain : public sc_module
+{
+public:
+  sc_in<bool> CCS_INIT_S1(clk);
+  sc_in<bool> CCS_INIT_S1(rst_bar);
+
+  Connections::Combinational<wide_t> chan[N_CHANS];
+
+  unsigned id;
+  unsigned long received;
+  unsigned long errors;
+
+  SC_HAS_PROCESS(domain);
+
+  domain(sc_module_name nm, unsigned id_) : sc_module(nm), id(id_), received(0), errors(0) {
+    SC_THREAD(stim);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(resp);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+  void stim() {
+    unsigned long sent[N_CHANS] = {0};
+    for (int c = 0; c < N_CHANS; c++) { chan[c].ResetWrite(); }
+    wait();
+
+    while (1) {
+      for (int c = 0; c < N_CHANS; c++) {
+        if (chan[c].PushNB(make_msg(id, c, sent[c]))) { ++sent[c]; }
+      }
+      wait();
+    }
+  }
+
+  void resp() {
+    unsigned long expected[N_CHANS] = {0};
+    for (int c = 0; c < N_CHANS; c++) { chan[c].ResetRead(); }
+    wait();
+
+    while (1) {
+      for (int c = 0; c < N_CHANS; c++) {
+        wide_t m;
+        if (!chan[c].PopNB(m)) { continue; }
+        if ((m != make_msg(id, c, expected[c])) && (errors++ < 10)) {
+          std::cout << name() << ": mismatch on channel " << c << std::endl;
+        }
+        ++expected[c];
+        ++received;
+      }
+      wait();
+    }
+  }
+};
+
+class Top : public sc_module
+{
+public:
+  sc_clock *clk[N_DOMAINS];
+  domain *dom[N_DOMAINS];
+  sc_signal<bool> CCS_INIT_S1(rst_bar);
+
+  SC_CTOR(Top) {
+    for (int d = 0; d < N_DOMAINS; d++) {
+      std::ostringstream clk_name, dom_name;
+      clk_name << "clk" << d;
+      dom_name << "dom" << d;
+      clk[d] = new sc_clock(clk_name.str().c_str(), 1, SC_NS, 0.5, 0, SC_NS, true);
+      dom[d] = new domain(dom_name.str().c_str(), d);
+      dom[d]->clk(*clk[d]);
+      dom[d]->rst_bar(rst_bar);
+    }
+
+    SC_THREAD(reset);
+    sensitive << clk[0]->posedge_event();
+  }
+
+  void reset() {
+    rst_bar.write(0);
+    wait(5);
+    rst_bar.write(1);
+    wait();
+  }
+};
+
+int sc_main(int argc, char **argv)
+{
+  sc_report_handler::set_actions("/IEEE_Std_1666/deprecated", SC_DO_NOTHING);
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+
+  // "sim_sc parallel [threads]" evaluates the clock domains on host threads, "sim_sc
+  // deterministic" uses the same scheduler serially.
+  std::string mode = (argc > 1) ? argv[1] : "default";
+  unsigned threads = (argc > 2) ? atoi(argv[2]) : 0;
+  if (mode == "parallel") { Connections::enable_parallel_clk_domains(threads); }
+  if (mode == "deterministic") { Connections::enable_deterministic_clk_domains(); }
+
+  Top top("top");
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  sc_start(N_CYCLES, SC_NS);
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+
+  std::cout << "Mode: " << mode << std::endl;
+  std::cout << N_DOMAINS << " clock domains of " << N_CHANS << " channels, " << N_CYCLES << " cycles" << std::endl;
+  unsigned long errors = 0;
+  for (int d = 0; d < N_DOMAINS; d++) {
+    std::cout << top.dom[d]->name() << " received " << top.dom[d]->received << " messages" << std::endl;
+    errors += top.dom[d]->errors;
+  }
+  std::cout << "Run time: " << dt.count() << " seconds, " << N_CYCLES / dt.count() << " cycles/s" << std::endl;
+
+  if ((errors > 0) || (sc_report_handler::get_count(SC_ERROR) > 0)) {
+    std::cout << "Simulation FAILED" << std::endl;
+    return -1;
+  }
+  std::cout << "Simulation PASSED" << std::endl;
+  return 0;
+}
@@ -9,6 +9,14 @@ echo --------------------------------------------------
 set -v
 
 make build
-./sim_sc
+./sim_sc > sim_default.log
+./sim_sc parallel > sim_parallel.log
+./sim_sc deterministic > sim_deterministic.log
+
+# the deterministic run must reproduce the default run exactly, and the parallel run
+# must match it apart from lines reporting host timing or thread counts
+diff sim_default.log sim_deterministic.log
+timing='seconds|threads|wall clock|CPU time'
+diff <(grep -Ev "$timing" sim_default.log) <(grep -Ev "$timing" sim_parallel.log)
 
 make clean
@@ -111,6 +111,11 @@ int sc_main(int argc, char **argv)
   sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
   trace_file_ptr = sc_create_vcd_trace_file("trace");
 
+  // "sim_sc parallel" evaluates the two clock domains on host threads,
+  // "sim_sc deterministic" uses the same scheduler serially. Output must match the default run.
+  if ((argc > 1) && (std::string(argv[1]) == "parallel")) { Connections::enable_parallel_clk_domains(); }
+  if ((argc > 1) && (std::string(argv[1]) == "deterministic")) { Connections::enable_deterministic_clk_domains(); }
+
   Top top("top");
   trace_hierarchy(&top, trace_file_ptr);
   sc_start();
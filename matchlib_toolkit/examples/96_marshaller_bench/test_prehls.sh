@@ -0,0 +1,15 @@
+#!/bin/bash
+
+set -e
+
+echo --------------------------------------------------
+echo PREHLS TEST: `pwd`
+echo --------------------------------------------------
+
+set -v
+
+make build
+./sim_sc
+./sim_sc_2state
+
+make clean
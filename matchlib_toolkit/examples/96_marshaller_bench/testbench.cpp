@@ -0,0 +1,206 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2020 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+// Messages per second through the Marshaller, for the backend selected at compile time.
+// Build once as is and once with -DCONNECTIONS_MARSHALLER_2STATE to compare (see README).
+
+#include <mc_connections.h>
+#include <TypeToBits.h>
+#include <mem_array.h>
+#include <chrono>
+#include "auto_gen_fields.h"
+
+struct bench_msg {
+  ac_int<32, false> addr {0};
+  ac_int<64, false> data {0};
+  ac_int<8, false>  strb {0};
+  ac_int<4, false>  id   {0};
+  bool              last {0};
+
+  AUTO_GEN_FIELD_METHODS(bench_msg, ( \
+     addr \
+   , data \
+   , strb \
+   , id \
+   , last \
+  ) )
+  //
+};
+
+static const int N_MSGS = 1000000;
+static const int N_XFERS = 200000;
+
+static bench_msg make_msg(int i)
+{
+  bench_msg m;
+  m.addr = i * 64;
+  m.data = (ac_int<64, false>(i) << 32) | ac_int<64, false>(~i & 0xffffffff);
+  m.strb = i & 0xff;
+  m.id   = i & 0xf;
+  m.last = i & 1;
+  return m;
+}
+
+template <class F>
+static double msgs_per_sec(int n, F f)
+{
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+  return n / dt.count();
+}
+
+static int errors = 0;
+
+static void check(bool ok, const char *what)
+{
+  if (!ok && (errors++ < 10)) { std::cout << "Mismatch in " << what << std::endl; }
+}
+
+// Producer/consumer over a MARSHALL_PORT Combinational channel
+class Top : public sc_module
+{
+public:
+  sc_clock clk;
+  sc_signal<bool> CCS_INIT_S1(rst_bar);
+
+  Connections::Combinational<bench_msg> CCS_INIT_S1(chan);
+
+  SC_CTOR(Top)
+    :   clk("clk", 1, SC_NS, 0.5,0,SC_NS,true) {
+    SC_CTHREAD(reset, clk);
+
+    SC_THREAD(stim);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(resp);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+  void stim() {
+    chan.ResetWrite();
+    wait();
+    for (int i = 0; i < N_XFERS; i++) {
+      chan.Push(make_msg(i));
+    }
+    wait();
+  }
+
+  void resp() {
+    chan.ResetRead();
+    wait();
+    for (int i = 0; i < N_XFERS; i++) {
+      check(chan.Pop() == make_msg(i), "Combinational transfer");
+    }
+    sc_stop();
+  }
+
+  void reset() {
+    rst_bar.write(0);
+    wait(5);
+    rst_bar.write(1);
+    wait();
+  }
+};
+
+int sc_main(int argc, char **argv)
+{
+  sc_report_handler::set_actions("/IEEE_Std_1666/deprecated", SC_DO_NOTHING);
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+
+#ifdef CONNECTIONS_MARSHALLER_PACKED
+  std::cout << "Marshaller backend: 2-state packed words" << std::endl;
+#else
+  std::cout << "Marshaller backend: 4-state sc_lv" << std::endl;
+#endif
+
+  static const int W = Wrapped<bench_msg>::width;
+  std::vector<sc_lv<W> > bits(1024);
+  std::vector<bench_msg> msgs(1024);
+  for (int i = 0; i < 1024; i++) { msgs[i] = make_msg(i); }
+
+  // Marshall, as done by Out port Push()
+  double marshall = msgs_per_sec(N_MSGS, [&]() {
+    for (int i = 0; i < N_MSGS; i++) {
+      Marshaller<W> m;
+      Wrapped<bench_msg> wm(msgs[i & 1023]);
+      wm.Marshall(m);
+      bits[i & 1023] = m.GetResult();
+    }
+  });
+
+  // Unmarshall, as done by In port Pop()
+  double unmarshall = msgs_per_sec(N_MSGS, [&]() {
+    for (int i = 0; i < N_MSGS; i++) {
+      Marshaller<W> m(bits[i & 1023]);
+      Wrapped<bench_msg> result;
+      result.Marshall(m);
+      msgs[i & 1023] = result.val;
+    }
+  });
+  for (int i = 0; i < 1024; i++) { check(msgs[i] == make_msg(i), "Marshaller"); }
+
+  // Round trip through an NVUINT, as used by scratchpads
+  double nvuint = msgs_per_sec(N_MSGS, [&]() {
+    for (int i = 0; i < N_MSGS; i++) {
+      msgs[i & 1023] = NVUINTToType<bench_msg>(TypeToNVUINT(msgs[i & 1023]));
+    }
+  });
+  for (int i = 0; i < 1024; i++) { check(msgs[i] == make_msg(i), "TypeToNVUINT/NVUINTToType"); }
+
+  // mem_array_sep write and read back
+  mem_array_sep<bench_msg, 1024, 4> mem;
+  double memory = msgs_per_sec(N_MSGS, [&]() {
+    for (int i = 0; i < N_MSGS; i++) {
+      mem.write((i >> 2) & 255, i & 3, msgs[i & 1023]);
+      msgs[i & 1023] = mem.read((i >> 2) & 255, i & 3);
+    }
+  });
+  for (int i = 0; i < 1024; i++) { check(msgs[i] == make_msg(i), "mem_array_sep"); }
+
+  Top top("top");
+  double xfers = msgs_per_sec(N_XFERS, [&]() { sc_start(); });
+
+  std::cout << "Marshall:             " << marshall   << " msgs/s" << std::endl;
+  std::cout << "Unmarshall:           " << unmarshall << " msgs/s" << std::endl;
+  std::cout << "TypeToNVUINT round:   " << nvuint     << " msgs/s" << std::endl;
+  std::cout << "mem_array_sep wr+rd:  " << memory     << " msgs/s" << std::endl;
+  std::cout << "Combinational:        " << xfers      << " msgs/s" << std::endl;
+
+  if ((errors > 0) || (sc_report_handler::get_count(SC_ERROR) > 0)) {
+    std::cout << "Simulation FAILED" << std::endl;
+    return -1;
+  }
+  std::cout << "Simulation PASSED" << std::endl;
+  return 0;
+}
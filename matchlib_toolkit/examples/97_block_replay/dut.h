@@ -0,0 +1,96 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2020 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+#pragma once
+#include <mc_connections.h>
+
+// Multiplies each input by 3, pausing every 5th message to vary the input timing of accum
+class scaler : public sc_module
+{
+public:
+  sc_in<bool> CCS_INIT_S1(clk);
+  sc_in<bool> CCS_INIT_S1(rst_bar);
+
+  Connections::In <uint32> CCS_INIT_S1(in1);
+  Connections::Out<uint32> CCS_INIT_S1(out1);
+
+  SC_CTOR(scaler) {
+    SC_THREAD(main);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+private:
+
+  void main() {
+    in1.Reset();
+    out1.Reset();
+    wait();
+
+    unsigned count = 0;
+    while (1) {
+      uint32_t t = in1.Pop();
+      if ((++count % 5) == 0) { wait(3); }
+      out1.Push(t * 3);
+    }
+  }
+};
+
+// Sums groups of 4 inputs. This is the block recorded and replayed standalone.
+class accum : public sc_module
+{
+public:
+  sc_in<bool> CCS_INIT_S1(clk);
+  sc_in<bool> CCS_INIT_S1(rst_bar);
+
+  Connections::In <uint32> CCS_INIT_S1(in1);
+  Connections::Out<uint32> CCS_INIT_S1(out1);
+
+  SC_CTOR(accum) {
+    SC_THREAD(main);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+private:
+
+  void main() {
+    in1.Reset();
+    out1.Reset();
+    wait();
+
+    while (1) {
+      uint32_t sum = 0;
+      for (int i = 0; i < 4; i++) { sum += in1.Pop(); }
+      out1.Push(sum);
+    }
+  }
+};
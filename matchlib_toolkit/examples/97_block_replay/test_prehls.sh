@@ -0,0 +1,17 @@
+#!/bin/bash
+
+set -e
+
+echo --------------------------------------------------
+echo PREHLS TEST: `pwd`
+echo --------------------------------------------------
+
+set -v
+
+make build
+./sim_sc
+./sim_sc replay
+./sim_sc long
+./sim_sc replay long
+
+make clean
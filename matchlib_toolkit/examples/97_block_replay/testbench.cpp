@@ -0,0 +1,163 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2020 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+
+#include "dut.h"
+#include <connections/port_recorder.h>
+#include <mc_scverify.h>
+
+// Full model: stim -> scaler -> accum -> resp, with accum's port traffic recorded
+class Top : public sc_module
+{
+public:
+  scaler CCS_INIT_S1(scaler1);
+  accum  CCS_INIT_S1(accum1);
+
+  sc_clock clk;
+  SC_SIG(bool, rst_bar);
+
+  Connections::Combinational<uint32>        CCS_INIT_S1(din);
+  Connections::Combinational<uint32>        CCS_INIT_S1(scaled);
+  Connections::Combinational<uint32>        CCS_INIT_S1(dout);
+
+  int outputs;  // accum outputs to pop before sc_stop (accum sums 4 inputs per output)
+
+  SC_CTOR(Top) :
+    clk("clk", 1, SC_NS, 0.5,0,SC_NS,true),
+    outputs(10)
+  {
+    sc_object_tracer<sc_clock> trace_clk(clk);
+
+    scaler1.clk(clk);
+    scaler1.rst_bar(rst_bar);
+    scaler1.in1(din);
+    scaler1.out1(scaled);
+
+    accum1.clk(clk);
+    accum1.rst_bar(rst_bar);
+    accum1.in1(scaled);
+    accum1.out1(dout);
+
+    SC_CTHREAD(reset, clk);
+
+    SC_THREAD(stim);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(resp);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+  void stim() {
+    din.ResetWrite();
+    wait();
+
+    for (int i = 0; i < (4 * outputs); i++) { din.Push(i); }
+    while (1) { wait(); }
+  }
+
+  // Pops with a stall every 3rd output, so accum also sees back pressure
+  void resp() {
+    dout.ResetRead();
+    wait();
+
+    for (int i = 0; i < outputs; i++) {
+      if ((i % 3) == 2) { wait(2); }
+      uint32 v = dout.Pop();
+      if (i < 10) { CCS_LOG("TB resp sees: " << std::dec << v); }
+    }
+    sc_stop();
+  }
+
+  void reset() {
+    rst_bar.write(0);
+    wait(5);
+    rst_bar.write(1);
+  }
+};
+
+// Standalone accum driven from the recording
+class Replay : public sc_module
+{
+public:
+  accum  CCS_INIT_S1(accum1);
+
+  sc_clock clk;
+  SC_SIG(bool, rst_bar);
+
+  Connections::port_replayer replay;
+
+  SC_HAS_PROCESS(Replay);
+
+  Replay(sc_module_name nm, const char *rec_file) :
+    sc_module(nm),
+    clk("clk", 1, SC_NS, 0.5,0,SC_NS,true),
+    replay("replay", accum1, clk, rec_file, &rst_bar)
+  {
+    accum1.clk(clk);
+    accum1.rst_bar(rst_bar);
+  }
+};
+
+int sc_main(int argc, char **argv)
+{
+  sc_report_handler::set_actions("/IEEE_Std_1666/deprecated", SC_DO_NOTHING);
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+
+  // "sim_sc long" records 100000 accum outputs to accum1_long.rec instead of 10 to accum1.rec
+  bool replay_run = (argc > 1) && (std::string(argv[1]) == "replay");
+  bool long_run = (argc > (replay_run ? 2 : 1)) && (std::string(argv[replay_run ? 2 : 1]) == "long");
+  const char *rec_file = long_run ? "accum1_long.rec" : "accum1.rec";
+
+  // "sim_sc replay [long]" simulates accum alone from the recording of a "sim_sc [long]" run
+  if (replay_run) {
+    Replay replay("replay", rec_file);
+    sc_start();
+    if ((sc_report_handler::get_count(SC_ERROR) > 0) || !replay.replay.passed()) {
+      std::cout << "Simulation FAILED" << std::endl;
+      return -1;
+    }
+    std::cout << "Simulation PASSED" << std::endl;
+    return 0;
+  }
+
+  Top top("top");
+  if (long_run) { top.outputs = 100000; }
+  Connections::port_recorder rec("rec", top.accum1, top.clk, rec_file, &top.rst_bar);
+  sc_start();
+  if (sc_report_handler::get_count(SC_ERROR) > 0) {
+    std::cout << "Simulation FAILED" << std::endl;
+    return -1;
+  }
+  std::cout << "Simulation PASSED" << std::endl;
+  return 0;
+}
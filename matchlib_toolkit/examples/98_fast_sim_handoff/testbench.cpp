@@ -0,0 +1,187 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2020 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+// Messages per second through a chain of TLM_PORT Combinational channels, for the
+// channel selected at compile time. Build once as is and once with
+// -DCONNECTIONS_TLM_HANDOFF to compare (see README).
+
+#include <mc_connections.h>
+#include <chrono>
+
+typedef ac_int<64, false> bench_msg;
+
+static const int N_XFERS = 200000;
+static const int N_STAGES = 4;
+
+static int errors = 0;
+
+static void check(bool ok, const char *what)
+{
+  if (!ok && (errors++ < 10)) { std::cout << "Mismatch in " << what << std::endl; }
+}
+
+static bench_msg make_msg(int i)
+{
+  return (bench_msg(i) << 32) | bench_msg(~i & 0xffffffff);
+}
+
+// Pass-through stage, blocks in Pop() until its producer Push()es
+class stage : public sc_module
+{
+public:
+  sc_in<bool> CCS_INIT_S1(clk);
+  sc_in<bool> CCS_INIT_S1(rst_bar);
+
+  Connections::In<bench_msg> CCS_INIT_S1(in1);
+  Connections::Out<bench_msg> CCS_INIT_S1(out1);
+
+  SC_CTOR(stage) {
+    SC_THREAD(main);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+  void main() {
+    in1.Reset();
+    out1.Reset();
+    wait();
+    while (1) {
+      out1.Push(in1.Pop());
+    }
+  }
+};
+
+// stim -> N_STAGES stages -> resp
+//
+// The first N_XFERS messages are pushed one per clock cycle, the consumer being
+// blocked in Pop() when each one arrives. The next N_XFERS are pushed back to back,
+// so that the producer runs ahead of the consumer within the channel capacity.
+class Top : public sc_module
+{
+public:
+  sc_clock clk;
+  sc_signal<bool> CCS_INIT_S1(rst_bar);
+
+  stage *stages[N_STAGES];
+  Connections::Combinational<bench_msg> *chans[N_STAGES + 1];
+
+  std::chrono::steady_clock::time_point t_start, t_mid, t_end;
+  sc_time sim_mid;
+
+  SC_CTOR(Top)
+    :   clk("clk", 1, SC_NS, 0.5,0,SC_NS,true) {
+    for (int i = 0; i <= N_STAGES; i++) {
+      chans[i] = new Connections::Combinational<bench_msg>(sc_gen_unique_name("chan"));
+    }
+    for (int i = 0; i < N_STAGES; i++) {
+      stages[i] = new stage(sc_gen_unique_name("stage"));
+      stages[i]->clk(clk);
+      stages[i]->rst_bar(rst_bar);
+      stages[i]->in1(*chans[i]);
+      stages[i]->out1(*chans[i + 1]);
+    }
+
+    SC_CTHREAD(reset, clk);
+
+    SC_THREAD(stim);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(resp);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+  void stim() {
+    chans[0]->ResetWrite();
+    wait();
+    for (int i = 0; i < N_XFERS; i++) {
+      chans[0]->Push(make_msg(i));
+      wait();
+    }
+    for (int i = N_XFERS; i < 2 * N_XFERS; i++) {
+      chans[0]->Push(make_msg(i));
+    }
+    wait();
+  }
+
+  void resp() {
+    chans[N_STAGES]->ResetRead();
+    wait();
+    t_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 2 * N_XFERS; i++) {
+      check(chans[N_STAGES]->Pop() == make_msg(i), "Combinational transfer");
+      if (i == N_XFERS - 1) {
+        t_mid = std::chrono::steady_clock::now();
+        sim_mid = sc_time_stamp();
+      }
+    }
+    t_end = std::chrono::steady_clock::now();
+    sc_stop();
+  }
+
+  void reset() {
+    rst_bar.write(0);
+    wait(5);
+    rst_bar.write(1);
+    wait();
+  }
+};
+
+int sc_main(int argc, char **argv)
+{
+  sc_report_handler::set_actions("/IEEE_Std_1666/deprecated", SC_DO_NOTHING);
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+
+#ifdef CONNECTIONS_TLM_HANDOFF
+  std::cout << "TLM_PORT channel: handoff_fifo" << std::endl;
+#else
+  std::cout << "TLM_PORT channel: tlm::tlm_fifo" << std::endl;
+#endif
+
+  Top top("top");
+  sc_start();
+
+  std::chrono::duration<double> per_cycle = top.t_mid - top.t_start;
+  std::chrono::duration<double> batched = top.t_end - top.t_mid;
+
+  std::cout << "One per cycle:        " << N_XFERS / per_cycle.count() << " msgs/s through "
+            << N_STAGES + 1 << " channels, last at " << top.sim_mid << std::endl;
+  std::cout << "Back to back:         " << N_XFERS / batched.count() << " msgs/s through "
+            << N_STAGES + 1 << " channels, last at " << sc_time_stamp() << std::endl;
+
+  if ((errors > 0) || (sc_report_handler::get_count(SC_ERROR) > 0)) {
+    std::cout << "Simulation FAILED" << std::endl;
+    return -1;
+  }
+  std::cout << "Simulation PASSED" << std::endl;
+  return 0;
+}
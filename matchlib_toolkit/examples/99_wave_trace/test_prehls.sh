@@ -0,0 +1,16 @@
+#!/bin/bash
+
+set -e
+
+echo --------------------------------------------------
+echo PREHLS TEST: `pwd`
+echo --------------------------------------------------
+
+set -v
+
+make build
+./sim_sc
+./wave2vcd trace.cwave trace_cwave.vcd
+./vcd_compare trace.vcd trace_cwave.vcd
+
+make clean
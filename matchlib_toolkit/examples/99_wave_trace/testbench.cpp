@@ -0,0 +1,159 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2020 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+// Traces the same design to a VCD file with sc_trace() and to a compressed waveform
+// with Connections::wave_writer, so that the two can be compared after converting the
+// compressed waveform with wave2vcd (see README).
+
+#include <mc_connections.h>
+
+static const int N_XFERS = 200;
+
+// Adds 0x100 to each message, stalling now and then so that the channels see both
+// back pressure and idle cycles
+class dut : public sc_module
+{
+public:
+  sc_in<bool> CCS_INIT_S1(clk);
+  sc_in<bool> CCS_INIT_S1(rst_bar);
+
+  Connections::In <uint32> CCS_INIT_S1(in1);
+  Connections::Out<uint32> CCS_INIT_S1(out1);
+
+  SC_CTOR(dut) {
+    SC_THREAD(main);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+  void main() {
+    in1.Reset();
+    out1.Reset();
+    wait();
+    while (1) {
+      uint32 t = in1.Pop();
+      if ((t % 7) == 3) { wait(2); }
+      out1.Push(t + 0x100);
+    }
+  }
+};
+
+class Top : public sc_module
+{
+public:
+  dut CCS_INIT_S1(dut1);
+
+  sc_clock clk;
+  SC_SIG(bool, rst_bar);
+
+  Connections::Combinational<uint32> CCS_INIT_S1(in1);
+  Connections::Combinational<uint32> CCS_INIT_S1(out1);
+
+  SC_CTOR(Top)
+    :   clk("clk", 1, SC_NS, 0.5,0,SC_NS,true) {
+    dut1.clk(clk);
+    dut1.rst_bar(rst_bar);
+    dut1.in1(in1);
+    dut1.out1(out1);
+
+    SC_CTHREAD(reset, clk);
+
+    SC_THREAD(stim);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+
+    SC_THREAD(resp);
+    sensitive << clk.posedge_event();
+    async_reset_signal_is(rst_bar, false);
+  }
+
+  void stim() {
+    in1.ResetWrite();
+    wait();
+
+    for (int i = 0; i < N_XFERS; i++) {
+      in1.Push(i);
+      if ((i % 5) == 4) { wait(3); }
+    }
+  }
+
+  void resp() {
+    out1.ResetRead();
+    wait();
+
+    for (int i = 0; i < N_XFERS; i++) {
+      uint32 t = out1.Pop();
+      if (t != uint32(i + 0x100)) {
+        SC_REPORT_ERROR("resp", "unexpected message");
+      }
+      if ((i % 11) == 10) { wait(4); }
+    }
+
+    // Let the channels settle, so that the end of the simulation does not cut off a
+    // change in one of the traces
+    wait(5);
+    sc_stop();
+  }
+
+  void reset() {
+    rst_bar.write(0);
+    wait(5);
+    rst_bar.write(1);
+    wait();
+  }
+};
+
+int sc_main(int argc, char **argv)
+{
+  sc_report_handler::set_actions("/IEEE_Std_1666/deprecated", SC_DO_NOTHING);
+  sc_report_handler::set_actions(SC_ERROR, SC_DISPLAY);
+
+  sc_trace_file *trace_file_ptr = sc_trace_static::setup_trace_file("trace");
+
+  Top top("top");
+  trace_hierarchy(&top, trace_file_ptr);
+
+  Connections::wave_writer wave;
+  if (!wave.open("trace.cwave")) { return -1; }
+  trace_hierarchy(&top, &wave);
+
+  sc_start();
+
+  wave.close();
+  sc_close_vcd_trace_file(trace_file_ptr);
+
+  if (sc_report_handler::get_count(SC_ERROR) > 0) {
+    std::cout << "Simulation FAILED" << std::endl;
+    return -1;
+  }
+  std::cout << "Simulation PASSED" << std::endl;
+  return 0;
+}
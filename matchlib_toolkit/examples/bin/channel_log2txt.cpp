@@ -0,0 +1,41 @@
+// Convert binary channel logs (channel_logs::enable_binary()) to the text format
+// produced by channel_logs::enable(), so existing scripts like gen_logs.sh keep working.
+//
+// Build:
+//   g++ -O2 -I$CONNECTIONS_HOME/include channel_log2txt.cpp -o channel_log2txt
+//
+// Usage:
+//   channel_log2txt <basename> [channel path name]
+//
+// Writes <basename>_data.txt and <basename>_names.txt, or only the records of the
+// given channel to stdout.
+
+#include <connections/connections_binlog_reader.h>
+
+int main(int argc, char **argv)
+{
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <basename> [channel path name]" << std::endl;
+    return 1;
+  }
+
+  std::string base = argv[1];
+  Connections::channel_log_reader r;
+  if (r.open(base)) { return 1; }
+
+  if (argc > 2) {
+    int ch = r.find_channel(argv[2]);
+    if (ch < 0) {
+      std::cerr << "Channel '" << argv[2] << "' not found in log" << std::endl;
+      return 1;
+    }
+    r.to_text(std::cout, ch);
+    return 0;
+  }
+
+  std::ofstream data((base + "_data.txt").c_str());
+  std::ofstream names((base + "_names.txt").c_str());
+  r.to_text(data);
+  r.names_to_text(names);
+  return 0;
+}
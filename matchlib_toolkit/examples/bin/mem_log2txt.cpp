@@ -0,0 +1,37 @@
+// Convert binary memory logs (extended_array with binary logging) to the text format
+// of extended_array, so existing scripts and diffs keep working.
+//
+// Build:
+//   g++ -O2 -I../../include mem_log2txt.cpp -o mem_log2txt
+//
+// Usage:
+//   mem_log2txt <log.bin> [log.txt]
+//
+// Writes the text log to the given file, or to stdout.
+
+#include <mem_binlog_reader.h>
+#include <fstream>
+
+int main(int argc, char **argv)
+{
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <log.bin> [log.txt]" << std::endl;
+    return 1;
+  }
+
+  mem_log_reader r;
+  if (r.open(argv[1])) { return 1; }
+
+  if (argc > 2) {
+    std::ofstream out(argv[2]);
+    if (!out) {
+      std::cerr << "Cannot open file '" << argv[2] << "'" << std::endl;
+      return 1;
+    }
+    r.to_text(out);
+    return 0;
+  }
+
+  r.to_text(std::cout);
+  return 0;
+}
@@ -0,0 +1,77 @@
+// Compare two binary memory logs (extended_array with binary logging), typically
+// the pre-HLS and post-HLS logs of the same memory, without converting them to text.
+//
+// Records are compared in order on element index, write count and data. Time stamps
+// are ignored unless -t is given, since pre-HLS and post-HLS timing usually differ.
+//
+// Build:
+//   g++ -O2 -I../../include mem_log_diff.cpp -o mem_log_diff
+//
+// Usage:
+//   mem_log_diff [-t] [-n max_diffs] <log1.bin> <log2.bin>
+//
+// Prints the first differences in the text log format, with record numbers.
+// Exit status is 0 if the logs are the same, 1 if they differ, 2 on errors.
+
+#include <mem_binlog_reader.h>
+#include <cstdlib>
+#include <algorithm>
+
+int main(int argc, char **argv)
+{
+  bool compare_time = false;
+  uint64_t max_diffs = 10;
+  int a = 1;
+
+  for (; (a < argc) && (argv[a][0] == '-'); a++) {
+    std::string opt = argv[a];
+    if (opt == "-t") {
+      compare_time = true;
+    } else if ((opt == "-n") && (a + 1 < argc)) {
+      max_diffs = std::strtoull(argv[++a], 0, 0);
+    } else {
+      break;
+    }
+  }
+
+  if (argc - a != 2) {
+    std::cerr << "Usage: " << argv[0] << " [-t] [-n max_diffs] <log1.bin> <log2.bin>" << std::endl;
+    return 2;
+  }
+
+  mem_log_reader r1, r2;
+  if (r1.open(argv[a]) || r2.open(argv[a + 1])) { return 2; }
+
+  if (r1.width() != r2.width()) {
+    std::cerr << "Element widths differ: " << r1.width() << " and " << r2.width() << std::endl;
+    return 1;
+  }
+
+  uint64_t n = std::min(r1.size(), r2.size());
+  uint64_t diffs = 0;
+
+  for (uint64_t i=0; i < n; i++) {
+    mem_log_reader::record x = r1[i];
+    mem_log_reader::record y = r2[i];
+    if (r1.same(x, r2, y, compare_time)) { continue; }
+
+    if (diffs < max_diffs) {
+      std::cout << "record " << std::dec << i << ":\n";
+      std::cout << "< " << r1.text(x) << "\n";
+      std::cout << "> " << r2.text(y) << "\n";
+    }
+    diffs++;
+  }
+
+  if (r1.size() != r2.size()) {
+    std::cout << std::dec << "record counts differ: " << r1.size() << " and " << r2.size() << "\n";
+  }
+
+  if (diffs || (r1.size() != r2.size())) {
+    std::cout << std::dec << diffs << " of " << n << " records differ\n";
+    return 1;
+  }
+
+  std::cout << "No differences in " << std::dec << n << " records\n";
+  return 0;
+}
@@ -0,0 +1,189 @@
+// Compare the value changes of the signals that two VCD files have in common, for
+// example a VCD written by sc_trace() and one converted by wave2vcd.
+//
+// Signals are matched on their hierarchical names, joining $scope names and the $var
+// name with '.', so files that spell the hierarchy as scopes or as dotted names match.
+// The SystemC scope that sc_trace() puts around all signals is left out of the names.
+// Times are compared in fs, so the files may use different timescales. Only the last
+// value of a signal at each time is compared, since a VCD written by sc_trace() does
+// not show changes within a time step. Vector values are compared without leading zeros.
+//
+// Build:
+//   g++ -O2 -std=c++11 vcd_compare.cpp -o vcd_compare
+//
+// Usage:
+//   vcd_compare <a.vcd> <b.vcd>
+//
+// Prints the first difference of each signal that differs, and the signals found in only
+// one of the files. Exit status is 0 if all common signals match, 1 if any differ or the
+// files have no signals in common, 2 on errors.
+
+#include <stdint.h>
+#include <cstdlib>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <iostream>
+
+struct vcd_signal {
+  unsigned width;
+  std::vector<std::pair<uint64_t, std::string> > changes;  // (time in fs, value)
+};
+
+struct vcd_file {
+  std::map<std::string, vcd_signal> signals;
+
+  // Record value as the value of sig at time t, dropping changes that restore the
+  // previous value
+  static void put(vcd_signal &sig, uint64_t t, const std::string &value) {
+    std::vector<std::pair<uint64_t, std::string> > &c = sig.changes;
+    if (!c.empty() && (c.back().first == t)) { c.pop_back(); }
+    if (c.empty() || (c.back().second != value)) { c.push_back(std::make_pair(t, value)); }
+  }
+
+  static std::string normalize(std::string v) {
+    for (unsigned i=0; i < v.size(); i++) { v[i] = std::tolower(v[i]); }
+    size_t first = v.find_first_not_of('0');
+    if (first == std::string::npos) { return "0"; }
+    return v.substr(first);
+  }
+
+  // Multiplier to fs of a $timescale such as "1 ps", "1ps" or "100 ns"
+  static bool timescale_fs(const std::string &ts, uint64_t &fs) {
+    static const char *units[] = { "fs", "ps", "ns", "us", "ms", "s" };
+    size_t n = 0;
+    while ((n < ts.size()) && std::isdigit(ts[n])) { ++n; }
+    if (n == 0) { return false; }
+    uint64_t mult = std::strtoull(ts.substr(0, n).c_str(), 0, 10);
+    std::string unit = ts.substr(n);
+    for (unsigned u=0; u < 6; u++) {
+      if (unit == units[u]) {
+        fs = mult;
+        return true;
+      }
+      mult *= 1000;
+    }
+    return false;
+  }
+
+  bool read(const std::string &fname) {
+    std::ifstream in(fname.c_str());
+    if (!in.is_open()) {
+      std::cerr << "Cannot open file '" << fname << "'" << std::endl;
+      return false;
+    }
+
+    std::map<std::string, std::vector<vcd_signal *> > codes;
+    std::vector<std::string> scope;
+    uint64_t fs = 1000;  // 1 ps unless $timescale says otherwise
+    uint64_t t = 0;
+    std::string tok;
+
+    while (in >> tok) {
+      if (tok == "$scope") {
+        std::string kind, name, end;
+        in >> kind >> name >> end;
+        scope.push_back(name);
+      } else if (tok == "$upscope") {
+        in >> tok;
+        if (!scope.empty()) { scope.pop_back(); }
+      } else if (tok == "$var") {
+        std::string type, code, ref;
+        unsigned width = 0;
+        in >> type >> width >> code >> ref;
+        while ((in >> tok) && (tok != "$end")) {}  // optional bit range
+        std::string name;
+        unsigned first = (!scope.empty() && (scope[0] == "SystemC")) ? 1 : 0;
+        for (unsigned i=first; i < scope.size(); i++) { name += scope[i] + "."; }
+        name += ref;
+        vcd_signal &sig = signals[name];
+        sig.width = width;
+        codes[code].push_back(&sig);
+      } else if (tok == "$timescale") {
+        std::string ts;
+        while ((in >> tok) && (tok != "$end")) { ts += tok; }
+        if (!timescale_fs(ts, fs)) {
+          std::cerr << "Unknown timescale '" << ts << "' in '" << fname << "'" << std::endl;
+          return false;
+        }
+      } else if ((tok == "$dumpvars") || (tok == "$dumpon") || (tok == "$dumpoff") ||
+                 (tok == "$end") || (tok == "$enddefinitions")) {
+        // value changes inside these sections are handled as any other
+      } else if (tok[0] == '$') {
+        while ((in >> tok) && (tok != "$end")) {}  // $version, $date, $comment
+      } else if (tok[0] == '#') {
+        t = std::strtoull(tok.c_str() + 1, 0, 10) * fs;
+      } else {
+        std::string value, code;
+        char c = std::tolower(tok[0]);
+        if ((c == 'b') || (c == 'r')) {
+          value = tok.substr(1);
+          in >> code;
+          if (c == 'r') { value = "r" + value; }
+        } else {
+          value = tok.substr(0, 1);
+          code = tok.substr(1);
+        }
+        std::map<std::string, std::vector<vcd_signal *> >::iterator it = codes.find(code);
+        if (it == codes.end()) {
+          std::cerr << "Undeclared identifier '" << code << "' in '" << fname << "'" << std::endl;
+          return false;
+        }
+        for (unsigned i=0; i < it->second.size(); i++) { put(*it->second[i], t, normalize(value)); }
+      }
+    }
+    return true;
+  }
+};
+
+int main(int argc, char **argv)
+{
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <a.vcd> <b.vcd>" << std::endl;
+    return 2;
+  }
+
+  vcd_file a, b;
+  if (!a.read(argv[1]) || !b.read(argv[2])) { return 2; }
+
+  unsigned compared = 0, differ = 0;
+  std::map<std::string, vcd_signal>::const_iterator ia, ib;
+  for (ia = a.signals.begin(); ia != a.signals.end(); ++ia) {
+    ib = b.signals.find(ia->first);
+    if (ib == b.signals.end()) {
+      std::cout << "only in " << argv[1] << ": " << ia->first << std::endl;
+      continue;
+    }
+    ++compared;
+    const std::vector<std::pair<uint64_t, std::string> > &ca = ia->second.changes;
+    const std::vector<std::pair<uint64_t, std::string> > &cb = ib->second.changes;
+    if (ia->second.width != ib->second.width) {
+      std::cout << ia->first << ": width " << ia->second.width << " vs " << ib->second.width << std::endl;
+      ++differ;
+      continue;
+    }
+    size_t i = 0;
+    while ((i < ca.size()) && (i < cb.size()) && (ca[i] == cb[i])) { ++i; }
+    if ((i == ca.size()) && (i == cb.size())) { continue; }
+    ++differ;
+    std::cout << ia->first << ": ";
+    if (i == ca.size()) {
+      std::cout << "only " << argv[2] << " changes at " << cb[i].first << " fs" << std::endl;
+    } else if (i == cb.size()) {
+      std::cout << "only " << argv[1] << " changes at " << ca[i].first << " fs" << std::endl;
+    } else {
+      std::cout << ca[i].second << " at " << ca[i].first << " fs vs "
+                << cb[i].second << " at " << cb[i].first << " fs" << std::endl;
+    }
+  }
+  for (ib = b.signals.begin(); ib != b.signals.end(); ++ib) {
+    if (a.signals.find(ib->first) == a.signals.end()) {
+      std::cout << "only in " << argv[2] << ": " << ib->first << std::endl;
+    }
+  }
+
+  std::cout << compared << " signals compared, " << differ << " differ" << std::endl;
+  return ((compared == 0) || (differ > 0)) ? 1 : 0;
+}
@@ -0,0 +1,54 @@
+// Convert a compressed waveform file (Connections::wave_writer) to VCD, for viewers
+// that only read VCD.
+//
+// Build:
+//   g++ -O2 -std=c++11 -I$CONNECTIONS_HOME/include wave2vcd.cpp -o wave2vcd
+//
+// Usage:
+//   wave2vcd <in.cwave> <out.vcd> [-f regex] [-b begin] [-e end]
+//
+// -f keeps only the signals whose hierarchical name contains a match of regex.
+// -b and -e restrict the output to a time window, in units of the time resolution
+// of the simulation (see the $timescale of the output).
+
+#include <connections/connections_wave_reader.h>
+#include <fstream>
+#include <cstdlib>
+
+int main(int argc, char **argv)
+{
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <in.cwave> <out.vcd> [-f regex] [-b begin] [-e end]" << std::endl;
+    return 1;
+  }
+
+  std::string filter;
+  uint64_t from = 0, to = ~uint64_t(0);
+  for (int i = 3; i + 1 < argc; i += 2) {
+    std::string opt = argv[i];
+    if (opt == "-f") {
+      filter = argv[i + 1];
+    } else if (opt == "-b") {
+      from = std::strtoull(argv[i + 1], 0, 10);
+    } else if (opt == "-e") {
+      to = std::strtoull(argv[i + 1], 0, 10);
+    } else {
+      std::cerr << "Unknown option '" << opt << "'" << std::endl;
+      return 1;
+    }
+  }
+
+  Connections::wave_reader r;
+  if (r.open(argv[1])) { return 1; }
+
+  std::ofstream vcd(argv[2]);
+  if (!vcd.is_open()) {
+    std::cerr << "Cannot open file '" << argv[2] << "'" << std::endl;
+    return 1;
+  }
+  if (!r.to_vcd(vcd, from, to, filter)) {
+    std::cerr << "Waveform file '" << argv[1] << "' is corrupt, output is incomplete" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -399,7 +399,21 @@ namespace axi
       // one bit per each aw_payload item, true iff it is last burst in overall segmented burst
       Connections::Combinational<bool>          CCS_INIT_S1(last_burst_chan);
 
+#ifdef SEGMENT_W_OUTSTANDING
+      // define SEGMENT_W_OUTSTANDING to let that many bursts wait for their write responses,
+      // so that the next burst can be sent without waiting for the b of the previous one
+      Connections::Fifo<bool, SEGMENT_W_OUTSTANDING> CCS_INIT_S1(last_burst_fifo);
+      Connections::Combinational<bool>          CCS_INIT_S1(last_burst_fifo_out);
+#endif
+
       SC_CTOR(w_segment) {
+#ifdef SEGMENT_W_OUTSTANDING
+        last_burst_fifo.clk(clk);
+        last_burst_fifo.rst(rst_bar);
+        last_burst_fifo.enq(last_burst_chan);
+        last_burst_fifo.deq(last_burst_fifo_out);
+#endif
+
         SC_THREAD(ex_aw_process);
         sensitive << clk.pos();
         async_reset_signal_is(rst_bar, false);
@@ -505,7 +519,11 @@ namespace axi
 
       void b_process() {
         b_in.Reset();
+#ifdef SEGMENT_W_OUTSTANDING
+        last_burst_fifo_out.ResetRead();
+#else
         last_burst_chan.ResetRead();
+#endif
         b_chan.Reset();
         bool id_valid = false;
         wait();
@@ -538,7 +556,11 @@ namespace axi
             }
             comb.resp = comb.resp | r.resp;
 
+#ifdef SEGMENT_W_OUTSTANDING
+            bool last_burst = last_burst_fifo_out.Pop();
+#else
             bool last_burst = last_burst_chan.Pop();
+#endif
 
             if (last_burst) {
               // LOG("b_chan_Push: ");
@@ -38,18 +38,33 @@
 #include <iostream>
 #include <iomanip>
 #include <ac_array_1D.h>
+#ifndef __SYNTHESIS__
+#include <mem_binlog.h>
+#endif
+
+// With binary logging (the _binary_log constructor argument, or EXTENDED_ARRAY_BINARY_LOG
+// defined for all arrays) the logs are <name>_read.bin and <name>_write.bin, written by
+// a background thread. Convert them to the text logs with examples/bin/mem_log2txt,
+// or compare them with examples/bin/mem_log_diff.
 
 template <typename T, unsigned N>
 class extended_array : public ac_array_1D<T,N> {
 public:
 
-  extended_array(std::string _nm = "", bool _add_time_stamp=0, bool _umr_assert=1) 
+  extended_array(std::string _nm = "", bool _add_time_stamp=0, bool _umr_assert=1, bool _binary_log=0) 
   {
 #ifndef __SYNTHESIS__
     name = _nm;
     add_time_stamp = _add_time_stamp;
     umr_assert = _umr_assert;
-    if (name != "") {
+    binary_log = _binary_log;
+#ifdef EXTENDED_ARRAY_BINARY_LOG
+    binary_log = 1;
+#endif
+    if ((name != "") && binary_log) {
+      mem_read_binlog.open(name + "_read.bin", elem_width, add_time_stamp);
+      mem_write_binlog.open(name + "_write.bin", elem_width, add_time_stamp);
+    } else if (name != "") {
       mem_read_log.open(name + "_read.log");
       mem_write_log.open(name + "_write.log");
     }
@@ -69,10 +84,13 @@ public:
   static const int elem_width{Wrapped<T>::width};
   ofstream mem_read_log;
   ofstream mem_write_log;
+  mem_log_writer mem_read_binlog;
+  mem_log_writer mem_write_binlog;
   std::string name;
   uint32_t write_cnt[N];
   bool add_time_stamp;
   bool umr_assert;
+  bool binary_log;
 
 
   struct elem_proxy {
@@ -83,6 +101,14 @@ public:
     elem_proxy(extended_array& _array, unsigned _idx) : array(_array), ext_array(_array), idx(_idx) {}
 
     operator T () { 
+      if (ext_array.binary_log) {
+        assert(idx < N);
+        if (ext_array.umr_assert)
+          assert(ext_array.write_cnt[idx] > 0); // assert on uninitialized memory read (UMR)
+        ext_array.mem_read_binlog.write(idx, ext_array.write_cnt[idx], array[idx]);
+        return array[idx];
+      }
+
       std::ostringstream os;
       if (ext_array.add_time_stamp)
         os << sc_time_stamp();
@@ -99,6 +125,14 @@ public:
     }
 
     const T& operator=(const T& v) { 
+      if (ext_array.binary_log) {
+        assert(idx < N);
+        ++ext_array.write_cnt[idx];
+        array[idx] = v;
+        ext_array.mem_write_binlog.write(idx, ext_array.write_cnt[idx], array[idx]);
+        return array[idx];
+      }
+
       std::ostringstream os;
       if (ext_array.add_time_stamp)
         os << sc_time_stamp();
@@ -0,0 +1,156 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2024 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+#pragma once
+
+//*****************************************************************************************
+// Binary memory access log writer, used by extended_array when binary logging is enabled
+//
+// Each log file (e.g. mem_prehls_read.bin) starts with a 32 byte header:
+//
+//   char     magic[8]   "MEMBLOG1"
+//   uint32_t width      element width in bits
+//   uint32_t nwords     32 bit data words per record (even, so records stay 8 byte aligned)
+//   uint32_t flags      bit 0: records carry time stamps
+//   uint32_t reserved
+//   uint64_t res_fs     time resolution in fs
+//
+// followed by one fixed size record per access:
+//
+//   uint32_t index      element index
+//   uint32_t write_cnt  number of writes to the element so far
+//   uint64_t time       sc_time_stamp().value(), 0 without time stamps
+//   uint32_t words[]    element bits, LSB first, zero padded
+//
+// The file is written through the Connections buffered_file_writer, the double-buffered
+// background writer of the binary channel logs.
+//
+// Use mem_binlog_reader.h to read logs, convert them to the text format, or compare them.
+//
+//*****************************************************************************************
+
+#include <systemc.h>
+#include <ac_int.h>
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <connections/buffered_file_writer.h>
+
+struct mem_log_file_header {
+  char     magic[8];
+  uint32_t width;
+  uint32_t nwords;
+  uint32_t flags;
+  uint32_t reserved;
+  uint64_t res_fs;
+};
+
+struct mem_log_record_header {
+  uint32_t index;
+  uint32_t write_cnt;
+  uint64_t time;
+};
+
+// Element bits as 32 bit words, LSB first: directly for ac_int, through sc_lv_base otherwise
+template <int W, bool S>
+inline void mem_log_words(const ac_int<W, S>& v, unsigned width, uint32_t* words) {
+  static const int NW = (W + 31) / 32;
+  ac_int<W, false> u = v;
+  ac_int<NW * 32, false> wide = u;
+  for (int i=0; i < NW; i++)
+    words[i] = wide.template slc<32>(i * 32).to_uint();
+}
+
+template <class T>
+inline void mem_log_words(const T& v, unsigned width, uint32_t* words) {
+  sc_lv_base val(width);
+  val = v;
+  for (unsigned i=0; i < (width + 31) / 32; i++) {
+    words[i] = val.get_word(i);
+    if (((i + 1) * 32) > width)
+      words[i] &= (~0u >> (((i + 1) * 32) - width));
+  }
+}
+
+class mem_log_writer {
+public:
+  mem_log_writer()
+    : width(0), nwords(0), time_stamps(false), record_bytes(0) {}
+
+  bool is_open() const { return out.is_open(); }
+
+  // buffer_bytes is the size of each of the two buffers
+  bool open(const std::string& fname, unsigned _width, bool _time_stamps, size_t buffer_bytes = (4 << 20)) {
+    if (!out.open(fname, buffer_bytes))
+      return false;
+
+    width = _width;
+    nwords = (((width + 31) / 32) + 1) & ~1u;
+    time_stamps = _time_stamps;
+    record_bytes = sizeof(mem_log_record_header) + (nwords * 4);
+
+    mem_log_file_header h;
+    std::memcpy(h.magic, "MEMBLOG1", 8);
+    h.width = width;
+    h.nwords = nwords;
+    h.flags = time_stamps ? 1 : 0;
+    h.reserved = 0;
+    h.res_fs = (uint64_t)(sc_get_time_resolution().to_seconds() * 1e15 + 0.5);
+    std::memcpy(out.reserve(sizeof(h)), &h, sizeof(h));
+    return true;
+  }
+
+  void close() { out.close(); }
+
+  template <class T>
+  void write(uint32_t index, uint32_t write_cnt, const T& v) {
+    if (!out.is_open())
+      return;
+    char* p = out.reserve(record_bytes);
+
+    mem_log_record_header h;
+    h.index = index;
+    h.write_cnt = write_cnt;
+    h.time = time_stamps ? sc_time_stamp().value() : 0;
+    std::memcpy(p, &h, sizeof(h));
+
+    uint32_t* words = reinterpret_cast<uint32_t*>(p + sizeof(h));
+    words[nwords - 1] = 0;
+    mem_log_words(v, width, words);
+  }
+
+private:
+  Connections::buffered_file_writer out;
+  unsigned width;
+  unsigned nwords;
+  bool time_stamps;
+  size_t record_bytes;
+};
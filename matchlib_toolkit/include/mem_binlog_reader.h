@@ -0,0 +1,201 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2024 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+#pragma once
+
+//*****************************************************************************************
+// Reader for binary memory access logs written by extended_array (see mem_binlog.h)
+//
+// Does not depend on SystemC, so log post-processing tools can be built standalone.
+// The log file is memory mapped and records are decoded in place.
+//
+// Example usage:
+//
+//  #include <mem_binlog_reader.h>
+//
+//  mem_log_reader r;
+//  if (r.open("mem_prehls_write.bin")) { return 1; }
+//
+//  for (uint64_t i=0; i < r.size(); i++)
+//    std::cout << r.text(r[i]) << "\n";
+//
+//  // same content as the text log of extended_array
+//  r.to_text(std::cout);
+//
+//*****************************************************************************************
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+class mem_log_reader {
+public:
+  struct record {
+    uint32_t index;
+    uint32_t write_cnt;
+    uint64_t time;
+    const uint32_t* words;
+
+    bool bit(unsigned i) const { return (words[i / 32] >> (i % 32)) & 1; }
+  };
+
+  mem_log_reader() : data(0), bytes(0), fd(-1), width_(0), nwords(0), record_bytes(0), flags(0), res_fs(1000) {}
+
+  ~mem_log_reader() { close(); }
+
+  // Maps the log file. Returns 0 on success.
+  int open(const std::string& fname) {
+    close();
+    fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+      std::cerr << "Cannot open file '" << fname << "'" << std::endl;
+      return 1;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < header_bytes)) {
+      std::cerr << "File '" << fname << "' is not a binary memory log" << std::endl;
+      close();
+      return 1;
+    }
+    bytes = st.st_size;
+    void* m = mmap(0, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m == MAP_FAILED) {
+      std::cerr << "Cannot map file '" << fname << "'" << std::endl;
+      close();
+      return 1;
+    }
+    madvise(m, bytes, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(m);
+
+    uint32_t reserved;
+    std::memcpy(&width_, data + 8, 4);
+    std::memcpy(&nwords, data + 12, 4);
+    std::memcpy(&flags, data + 16, 4);
+    std::memcpy(&reserved, data + 20, 4);
+    std::memcpy(&res_fs, data + 24, 8);
+    record_bytes = 16 + (nwords * 4);
+    if ((std::memcmp(data, "MEMBLOG1", 8) != 0) || (nwords < ((width_ + 31) / 32)) || (res_fs == 0)) {
+      std::cerr << "File '" << fname << "' is not a binary memory log" << std::endl;
+      close();
+      return 1;
+    }
+    return 0;
+  }
+
+  void close() {
+    if (data) { munmap(const_cast<char*>(data), bytes); }
+    if (fd >= 0) { ::close(fd); }
+    data = 0;
+    bytes = 0;
+    fd = -1;
+  }
+
+  unsigned width() const { return width_; }
+  bool time_stamps() const { return flags & 1; }
+
+  // Number of records; a truncated last record is ignored
+  uint64_t size() const { return data ? ((bytes - header_bytes) / record_bytes) : 0; }
+
+  record operator[](uint64_t i) const {
+    const char* p = data + header_bytes + (i * record_bytes);
+    record r;
+    std::memcpy(&r.index, p, 4);
+    std::memcpy(&r.write_cnt, p + 4, 4);
+    std::memcpy(&r.time, p + 8, 8);
+    r.words = reinterpret_cast<const uint32_t*>(p + 16);
+    return r;
+  }
+
+  // Element bits, as many as the element width, MSB first
+  std::string bits(const record& r) const {
+    std::string s(width_, '0');
+    for (unsigned i=0; i < width_; i++)
+      if (r.bit(i)) { s[width_ - 1 - i] = '1'; }
+    return s;
+  }
+
+  // Format a time stamp the way sc_time is printed, eg. "10 ns" or "1500 ps"
+  std::string time_string(uint64_t t) const {
+    static const char* units[] = { "fs", "ps", "ns", "us", "ms", "s" };
+    if (t == 0) { return "0 s"; }
+    std::ostringstream ss;
+    ss << t * res_fs;
+    std::string s = ss.str();
+    unsigned u = 0;
+    while ((u < 5) && (s.length() > 3) && (s.compare(s.length() - 3, 3, "000") == 0)) {
+      s.erase(s.length() - 3);
+      u++;
+    }
+    return s + " " + units[u];
+  }
+
+  // A record in the text format of extended_array: "index write_cnt bits time"
+  std::string text(const record& r) const {
+    std::ostringstream os;
+    os << std::setfill('0') << std::setw(8) << std::hex << r.index << " " << r.write_cnt << " "
+       << bits(r) << " " << (time_stamps() ? time_string(r.time) : std::string());
+    return os.str();
+  }
+
+  // Same content as the text log of extended_array
+  void to_text(std::ostream& os) const {
+    for (uint64_t i=0; i < size(); i++)
+      os << text((*this)[i]) << "\n";
+  }
+
+  // Whether two records have the same index, write count and bits, and optionally time
+  bool same(const record& a, const mem_log_reader& rb, const record& b, bool compare_time = false) const {
+    if ((a.index != b.index) || (a.write_cnt != b.write_cnt) || (width_ != rb.width_))
+      return false;
+    if (compare_time && ((a.time * res_fs) != (b.time * rb.res_fs)))
+      return false;
+    return std::memcmp(a.words, b.words, ((width_ + 31) / 32) * 4) == 0;
+  }
+
+private:
+  static const size_t header_bytes = 32;
+
+  const char* data;
+  size_t bytes;
+  int fd;
+  uint32_t width_;
+  uint32_t nwords;
+  size_t record_bytes;
+  uint32_t flags;
+  uint64_t res_fs;
+};
@@ -38,12 +38,21 @@ typedef axi::axi4_segment<axi::cfg::standard> local_axi;
 
 #ifdef USE_EXTENDED_ARRAY
 #include <extended_array.h>
-#endif
-
 #include <ac_array_1D.h>
+#else
+#include <sparse_mem.h>
+#endif
 
 /**
  *  \brief A simple RAM module with 1 axi4 read slave and 1 axi4 write slave
+ *
+ *  The RAM covers the whole axi4 address space in a sparse_mem, so only the pages
+ *  a test touches are allocated. A page reads as its word addresses until written.
+ *  Software images are loaded with load_binary() or load_elf(), and if dump_file
+ *  is set the pages touched are dumped to it at the end of simulation.
+ *
+ *  With USE_EXTENDED_ARRAY the RAM is instead an extended_array of sz words,
+ *  for its access logging and checks, and image loading is not available.
 */
 
 class ram : public sc_module, public local_axi
@@ -62,13 +71,13 @@ public:
   ) )
   //
 
-  static const int sz = 0x10000; // size in axi_cfg::dataWidth words
-
   typedef NVUINTW(axi_cfg::dataWidth) arr_t;
 #ifdef USE_EXTENDED_ARRAY
+  static const int sz = 0x10000; // size in axi_cfg::dataWidth words
   extended_array<arr_t, sz>* array{0};
 #else
-  ac_array_1D<arr_t, sz>* array{0};
+  sparse_mem mem{12, bytesPerBeat};
+  std::string dump_file;
 #endif
 
   SC_HAS_PROCESS(ram);
@@ -78,8 +87,9 @@ public:
       log_nm = std::string(this->name()) + "_" + log_nm;
     
     array = new extended_array<arr_t, sz>(log_nm, use_time_stamp);
-#else
-    array = new ac_array_1D<arr_t, sz>();
+
+    for (int i=0; i < sz; i++)
+    { (*array)[i] = arr_t(i * bytesPerBeat); }
 #endif
 
     SC_THREAD(slave_r_process);
@@ -89,22 +99,47 @@ public:
     SC_THREAD(slave_w_process);
     sensitive << clk.pos();
     async_reset_signal_is(rst_bar, false);
-
-    for (int i=0; i < sz; i++)
-    { (*array)[i] = arr_t(i * bytesPerBeat); }
   }
 
+#ifdef USE_EXTENDED_ARRAY
   ~ram() {
     delete array;
   }
 
+  bool valid_addr(uint64_t addr) { return addr < (sz * bytesPerBeat); }
+  arr_t read_word(uint64_t addr) { return (*array)[addr / bytesPerBeat]; }
+  void write_word(uint64_t addr, arr_t data) { (*array)[addr / bytesPerBeat] = data; }
+#else
+  bool valid_addr(uint64_t) { return true; }  // mem covers the whole address space
+  arr_t read_word(uint64_t addr) { return mem.get<arr_t>(addr - (addr % bytesPerBeat)); }
+  void write_word(uint64_t addr, arr_t data) { mem.set(addr - (addr % bytesPerBeat), data); }
+
+  void load_binary(std::string filename, uint64_t addr) {
+    if (!mem.load_binary(filename, addr))
+      SC_REPORT_ERROR("ram", ("unable to load " + filename).c_str());
+  }
+
+  // returns the entry point of the image
+  uint64_t load_elf(std::string filename) {
+    uint64_t entry = 0;
+    if (!mem.load_elf(filename, &entry))
+      SC_REPORT_ERROR("ram", ("unable to load ELF file " + filename).c_str());
+    return entry;
+  }
+
+  void end_of_simulation() {
+    if ((dump_file != "") && !mem.dump(dump_file))
+      SC_REPORT_ERROR("ram", ("unable to write " + dump_file).c_str());
+  }
+#endif
+
   NVUINTW(axi_cfg::dataWidth) debug_read_addr(uint32_t addr) {
-    if (addr >= (sz * bytesPerBeat)) {
+    if (!valid_addr(addr)) {
       SC_REPORT_ERROR("ram", "invalid addr");
       return 0;
     }
 
-    return ((*array)[addr / bytesPerBeat]);
+    return read_word(addr);
   }
 
   void slave_r_process() {
@@ -121,11 +156,11 @@ public:
       while (1) {
         r_payload r;
 
-        if (ar.addr >= (sz * bytesPerBeat)) {
+        if (!valid_addr(ar.addr)) {
           SC_REPORT_ERROR("ram", "invalid addr");
           r.resp = Enc::XRESP::SLVERR;
         } else {
-          r.data = (*array)[ar.addr / bytesPerBeat];
+          r.data = read_word(ar.addr);
         }
 
         if (!r_slave0.next_multi_read(ar, r)) { break; }
@@ -148,17 +183,17 @@ public:
       while (1) {
         w_payload w = w_slave0.w.Pop();
 
-        if (aw.addr >= (sz * bytesPerBeat)) {
+        if (!valid_addr(aw.addr)) {
           SC_REPORT_ERROR("ram", "invalid addr");
           b.resp = Enc::XRESP::SLVERR;
         } else {
           decltype(w.wstrb) all_on{~0};
 
           if (w.wstrb == all_on) {
-            (*array)[aw.addr / bytesPerBeat] = w.data.to_uint64();
+            write_word(aw.addr, w.data.to_uint64());
           } else {
             CCS_LOG("write strobe enabled");
-            arr_t orig  = (*array)[aw.addr / bytesPerBeat];
+            arr_t orig  = read_word(aw.addr);
             arr_t wdata = w.data.to_uint64();
 
 #pragma hls_unroll
@@ -167,7 +202,7 @@ public:
                 orig = nvhls::set_slc(orig, nvhls::get_slc<8>(wdata, (i*8)), (i*8));
               }
 
-            (*array)[aw.addr / bytesPerBeat] = orig;
+            write_word(aw.addr, orig);
           }
         }
 
@@ -0,0 +1,314 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2024 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <ac_int.h>
+
+/**
+ *  \brief Sparse byte-addressed memory for simulation models of large address spaces
+ *
+ *  Storage is kept in pages of (1 << page_bits) bytes, allocated the first time
+ *  they are touched, so a model can cover a full 32 or 64 bit address space and
+ *  only pays for the pages a test uses. A new page is zero, or when fill_bytes
+ *  is set, each fill_bytes little-endian word holds its own byte address (the
+ *  initial contents of ram.h).
+ *
+ *  Binary and ELF images are mapped copy-on-write rather than read: pages fully
+ *  covered by the image point into a private mapping of the file, so nothing is
+ *  read from disk until it is accessed, and writes only copy the pages written.
+ *
+ *  dump() writes the pages present in $readmemh format, e.g. at end of simulation.
+ */
+
+class sparse_mem {
+public:
+  sparse_mem(unsigned _page_bits = 12, unsigned _fill_bytes = 0)
+    : page_bits(_page_bits)
+    , page_bytes(1ULL << _page_bits)
+    , fill_bytes(_fill_bytes)
+  {}
+
+  ~sparse_mem() {
+    for (unsigned i=0; i < owned.size(); i++)
+      delete [] owned[i];
+    for (unsigned i=0; i < mappings.size(); i++)
+      munmap(mappings[i].first, mappings[i].second);
+  }
+
+  // Page holding addr, allocated on first touch
+  unsigned char* page(uint64_t addr) {
+    uint64_t num = addr >> page_bits;
+    if (last_page && (num == last_num))
+      return last_page;
+
+    unsigned char*& p = pages[num];
+    if (!p) {
+      p = new unsigned char[page_bytes];
+      owned.push_back(p);
+      fill(p, num << page_bits);
+    }
+    last_num = num;
+    last_page = p;
+    return p;
+  }
+
+  void read(uint64_t addr, void* data, uint64_t len) {
+    unsigned char* d = (unsigned char*)data;
+    while (len) {
+      uint64_t offset = addr & (page_bytes - 1);
+      uint64_t n = std::min(len, page_bytes - offset);
+      memcpy(d, page(addr) + offset, n);
+      addr += n; d += n; len -= n;
+    }
+  }
+
+  void write(uint64_t addr, const void* data, uint64_t len) {
+    const unsigned char* d = (const unsigned char*)data;
+    while (len) {
+      uint64_t offset = addr & (page_bytes - 1);
+      uint64_t n = std::min(len, page_bytes - offset);
+      memcpy(page(addr) + offset, d, n);
+      addr += n; d += n; len -= n;
+    }
+  }
+
+  // Word accessors for ac_int words stored little-endian
+  template <class T>
+  T get(uint64_t addr) {
+    unsigned char bytes[T::width / 8];
+    read(addr, bytes, sizeof(bytes));
+    T v = 0;
+    for (unsigned i=0; i < sizeof(bytes); i++)
+      v.set_slc(i * 8, ac_int<8, false>(bytes[i]));
+    return v;
+  }
+
+  template <class T>
+  void set(uint64_t addr, const T& v) {
+    unsigned char bytes[T::width / 8];
+    for (unsigned i=0; i < sizeof(bytes); i++)
+      bytes[i] = v.template slc<8>(i * 8).to_uint();
+    write(addr, bytes, sizeof(bytes));
+  }
+
+  // Only the bytes whose byte enable bit is set are written
+  template <class T, class B>
+  void set(uint64_t addr, const T& v, const B& byte_enables) {
+    for (unsigned i=0; i < T::width / 8; i++)
+      if (byte_enables[i]) {
+        unsigned char b = v.template slc<8>(i * 8).to_uint();
+        write(addr + i, &b, 1);
+      }
+  }
+
+  // Maps a raw binary image at addr. Returns false if the file cannot be read.
+  bool load_binary(const std::string& filename, uint64_t addr) {
+    unsigned char* image;
+    uint64_t size;
+    if (!map_file(filename, image, size))
+      return false;
+    place(addr, image, size);
+    return true;
+  }
+
+  // Maps the loadable segments of a little-endian ELF32 or ELF64 file at their
+  // physical addresses, zeroing the rest of each segment (.bss). Returns false
+  // if the file cannot be read or is not such an ELF file.
+  bool load_elf(const std::string& filename, uint64_t* entry = 0) {
+    unsigned char* image;
+    uint64_t size;
+    if (!map_file(filename, image, size) || (size < EI_NIDENT) || (memcmp(image, ELFMAG, SELFMAG) != 0) ||
+        (image[EI_DATA] != ELFDATA2LSB))
+      return false;
+
+    bool is64 = (image[EI_CLASS] == ELFCLASS64);
+    if (!is64 && (image[EI_CLASS] != ELFCLASS32))
+      return false;
+
+    uint64_t e_entry, e_phoff, e_phentsize, e_phnum;
+    if (is64) {
+      Elf64_Ehdr eh;
+      if (size < sizeof(eh)) return false;
+      memcpy(&eh, image, sizeof(eh));
+      e_entry = eh.e_entry; e_phoff = eh.e_phoff; e_phentsize = eh.e_phentsize; e_phnum = eh.e_phnum;
+    } else {
+      Elf32_Ehdr eh;
+      if (size < sizeof(eh)) return false;
+      memcpy(&eh, image, sizeof(eh));
+      e_entry = eh.e_entry; e_phoff = eh.e_phoff; e_phentsize = eh.e_phentsize; e_phnum = eh.e_phnum;
+    }
+
+    if ((e_phentsize < (is64 ? sizeof(Elf64_Phdr) : sizeof(Elf32_Phdr))) ||
+        (e_phoff + (e_phnum * e_phentsize) > size))
+      return false;
+
+    for (uint64_t i=0; i < e_phnum; i++) {
+      uint64_t p_type, p_offset, p_paddr, p_filesz, p_memsz;
+      const unsigned char* ph = image + e_phoff + (i * e_phentsize);
+      if (is64) {
+        Elf64_Phdr p;
+        memcpy(&p, ph, sizeof(p));
+        p_type = p.p_type; p_offset = p.p_offset; p_paddr = p.p_paddr; p_filesz = p.p_filesz; p_memsz = p.p_memsz;
+      } else {
+        Elf32_Phdr p;
+        memcpy(&p, ph, sizeof(p));
+        p_type = p.p_type; p_offset = p.p_offset; p_paddr = p.p_paddr; p_filesz = p.p_filesz; p_memsz = p.p_memsz;
+      }
+
+      if (p_type != PT_LOAD)
+        continue;
+      if ((p_offset + p_filesz > size) || (p_filesz > p_memsz))
+        return false;
+
+      place(p_paddr, image + p_offset, p_filesz);
+      zero(p_paddr + p_filesz, p_memsz - p_filesz);
+    }
+
+    if (entry)
+      *entry = e_entry;
+    return true;
+  }
+
+  // Writes the pages present, in address order, in $readmemh format with byte addresses
+  bool dump(const std::string& filename) {
+    std::ofstream out(filename.c_str());
+    if (!out)
+      return false;
+
+    std::vector<uint64_t> nums;
+    for (auto it = pages.begin(); it != pages.end(); ++it)
+      nums.push_back(it->first);
+    std::sort(nums.begin(), nums.end());
+
+    out << "// " << nums.size() << " pages of " << page_bytes << " bytes\n";
+    out << std::hex << std::setfill('0');
+    for (unsigned i=0; i < nums.size(); i++) {
+      const unsigned char* p = pages[nums[i]];
+      out << "@" << std::setw(8) << (nums[i] << page_bits) << "\n";
+      for (uint64_t b=0; b < page_bytes; b++)
+        out << std::setw(2) << (unsigned)p[b] << (((b % 16) == 15) ? "\n" : " ");
+    }
+    return true;
+  }
+
+  uint64_t pages_present() const { return pages.size(); }
+
+  const unsigned page_bits;
+  const uint64_t page_bytes;
+  const unsigned fill_bytes;
+
+private:
+  std::unordered_map<uint64_t, unsigned char*> pages;
+  std::vector<unsigned char*> owned;
+  std::vector<std::pair<void*, size_t> > mappings;
+  uint64_t last_num{0};
+  unsigned char* last_page{0};
+
+  sparse_mem(const sparse_mem&);
+  sparse_mem& operator=(const sparse_mem&);
+
+  void fill(unsigned char* p, uint64_t addr) {
+    if (!fill_bytes) {
+      memset(p, 0, page_bytes);
+      return;
+    }
+    for (uint64_t i=0; i < page_bytes; i++) {
+      uint64_t word = (addr + i) - ((addr + i) % fill_bytes);
+      unsigned byte = (addr + i) % fill_bytes;
+      p[i] = (byte < 8) ? (unsigned char)(word >> (byte * 8)) : 0;
+    }
+  }
+
+  // Private writable mapping of a file; image is 0 and size 0 for an empty file.
+  // Returns false if the file cannot be opened or mapped.
+  bool map_file(const std::string& filename, unsigned char*& image, uint64_t& size) {
+    image = 0;
+    size = 0;
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+    bool ok = (fstat(fd, &st) == 0);
+    if (ok && (st.st_size > 0)) {
+      void* p = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      ok = (p != MAP_FAILED);
+      if (ok) {
+        size = st.st_size;
+        image = (unsigned char*)p;
+        mappings.push_back(std::make_pair(p, (size_t)size));
+      }
+    }
+    close(fd);
+    return ok;
+  }
+
+  // Pages fully covered by the image and not yet present point into it,
+  // the partially covered ones are copied
+  void place(uint64_t addr, unsigned char* image, uint64_t len) {
+    while (len) {
+      uint64_t offset = addr & (page_bytes - 1);
+      uint64_t n = std::min(len, page_bytes - offset);
+      uint64_t num = addr >> page_bits;
+      if ((n == page_bytes) && !pages.count(num)) {
+        pages[num] = image;
+      } else {
+        memcpy(page(addr) + offset, image, n);
+      }
+      addr += n; image += n; len -= n;
+    }
+  }
+
+  void zero(uint64_t addr, uint64_t len) {
+    while (len) {
+      uint64_t offset = addr & (page_bytes - 1);
+      uint64_t n = std::min(len, page_bytes - offset);
+      memset(page(addr) + offset, 0, n);
+      addr += n; len -= n;
+    }
+  }
+};
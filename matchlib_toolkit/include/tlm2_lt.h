@@ -0,0 +1,373 @@
+/**************************************************************************
+ *                                                                        *
+ *  Catapult(R) MatchLib Toolkit Example Design Library                   *
+ *                                                                        *
+ *  Software Version: 2.1       *
+ *                                                                        *
+ *  Release Date    : Mon Jan 15 20:15:38 PST 2024       *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2.1.1       *
+ *                                                                        *
+ *  Copyright 2024 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+
+#pragma once
+
+//*****************************************************************************************
+// File: tlm2_lt.h
+//
+// Description: Loosely timed (LT) TLM2 models for virtual platforms that embed
+//   Matchlib models:
+//     tlm2_lt_ram       - RAM target backed by a sparse_mem, its own or the one of a
+//                         Matchlib ram. A whole burst is served per b_transport, and DMI
+//                         and debug transport are supported.
+//     tlm2_lt_initiator - initiator port for software-like models (e.g. an ISS), with
+//                         quantum keeper temporal decoupling, DMI, and aggregation of
+//                         sequential writes into bursts.
+//
+// Revision History:
+//    2.1.1 - 
+//*****************************************************************************************
+
+
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/multi_passthrough_target_socket.h"
+#include "tlm_utils/tlm_quantumkeeper.h"
+#include <nvhls_types.h>
+#include <sparse_mem.h>
+
+#include <vector>
+#include <cstring>
+
+
+// By default the RAM has its own sparse_mem with the initial contents of ram.h, covering
+// the whole address space. Pass the mem of a Matchlib ram (ram.h) instead to serve the
+// same storage that the ram serves over AXI4, e.g. to give software models DMI into it.
+// DMI is granted one sparse_mem page at a time, since only a page is contiguous.
+// A transaction takes latency for its first beat and beat_time for each further beat;
+// DMI accesses take latency each.
+
+template <class axi_cfg>
+class tlm2_lt_ram 
+  : public sc_module
+  , public axi_cfg
+{
+public:
+  tlm_utils::multi_passthrough_target_socket<tlm2_lt_ram> tlm2_target;
+
+  sc_time latency;
+  sc_time beat_time;
+
+  sparse_mem& mem;
+
+  uint64_t transactions{0};
+  uint64_t dmi_grants{0};
+
+  tlm2_lt_ram(sc_module_name nm, sparse_mem* backing = 0)
+   : sc_module(nm)
+   , tlm2_target("tlm2_target")
+   , latency(1, SC_NS)
+   , beat_time(SC_ZERO_TIME)
+   , mem(backing ? *backing : own_mem)
+  {
+    tlm2_target.register_b_transport(this, &tlm2_lt_ram::b_transport);
+    tlm2_target.register_get_direct_mem_ptr(this, &tlm2_lt_ram::get_direct_mem_ptr);
+    tlm2_target.register_transport_dbg(this, &tlm2_lt_ram::transport_dbg);
+  }
+
+  NVUINTW(axi_cfg::dataWidth) debug_read_addr(uint64_t addr) {
+    return mem.get<NVUINTW(axi_cfg::dataWidth)>(addr - (addr % axi_cfg::bytesPerBeat));
+  }
+
+  // Revokes all DMI pointers, e.g. before the backing store is changed behind the initiators' backs
+  void invalidate_dmi() {
+    for (unsigned i=0; i < tlm2_target.size(); i++)
+      tlm2_target[i]->invalidate_direct_mem_ptr(0, (sc_dt::uint64)-1);
+  }
+
+  virtual void b_transport(int tag, tlm::tlm_generic_payload& trans, sc_time& delay) {
+    uint64_t addr = trans.get_address();
+    unsigned len  = trans.get_data_length();
+
+    transactions++;
+
+    if (trans.get_streaming_width() < len) {
+      trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE);
+      return;
+    }
+
+    if (trans.is_read())
+      read(addr, trans.get_data_ptr(), len, trans);
+    else if (trans.is_write())
+      write(addr, trans.get_data_ptr(), len, trans);
+
+    unsigned beats = (len + axi_cfg::bytesPerBeat - 1) / axi_cfg::bytesPerBeat;
+    delay += latency;
+    if (beats > 1)
+      delay += beat_time * (beats - 1);
+
+    trans.set_dmi_allowed(true);
+    trans.set_response_status(tlm::TLM_OK_RESPONSE);
+  }
+
+  virtual bool get_direct_mem_ptr(int tag, tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi) {
+    uint64_t start = trans.get_address() & ~(mem.page_bytes - 1);
+
+    dmi.allow_read_write();
+    dmi.set_dmi_ptr(mem.page(start));
+    dmi.set_start_address(start);
+    dmi.set_end_address(start + mem.page_bytes - 1);
+    dmi.set_read_latency(latency);
+    dmi.set_write_latency(latency);
+    dmi_grants++;
+    return true;
+  }
+
+  virtual unsigned int transport_dbg(int tag, tlm::tlm_generic_payload& trans) {
+    unsigned len = trans.get_data_length();
+
+    if (trans.is_read())
+      mem.read(trans.get_address(), trans.get_data_ptr(), len);
+    else if (trans.is_write())
+      mem.write(trans.get_address(), trans.get_data_ptr(), len);
+
+    return len;
+  }
+
+private:
+  sparse_mem own_mem{12, axi_cfg::bytesPerBeat};
+
+  void read(uint64_t addr, unsigned char* data, unsigned len, tlm::tlm_generic_payload& trans) {
+    unsigned char* be = trans.get_byte_enable_ptr();
+    unsigned be_len   = trans.get_byte_enable_length();
+
+    if (!be || (be_len == 0)) {
+      mem.read(addr, data, len);
+      return;
+    }
+
+    for (unsigned i=0; i < len; i++)
+      if (be[i % be_len] == tlm::TLM_BYTE_ENABLED)
+        mem.read(addr + i, &data[i], 1);
+  }
+
+  // writes len bytes, leaving the bytes disabled by the byte enables (if any) untouched;
+  // a zero byte enable length is treated as no byte enables
+  void write(uint64_t addr, const unsigned char* data, unsigned len, tlm::tlm_generic_payload& trans) {
+    unsigned char* be = trans.get_byte_enable_ptr();
+    unsigned be_len   = trans.get_byte_enable_length();
+
+    if (!be || (be_len == 0)) {
+      mem.write(addr, data, len);
+      return;
+    }
+
+    for (unsigned i=0; i < len; i++)
+      if (be[i % be_len] == tlm::TLM_BYTE_ENABLED)
+        mem.write(addr + i, &data[i], 1);
+  }
+};
+
+
+// Initiator port for software-like models that issue many small accesses, such as an ISS.
+// read() and write() are called from a thread of the owning model:
+//  - the model runs ahead of simulation time by up to the global quantum
+//    (tlm_quantumkeeper::set_global_quantum()) and only then yields to the kernel;
+//  - when the target grants DMI, accesses are plain memcpy's into the target's storage
+//    with no transaction at all;
+//  - otherwise, with max_burst set, sequential writes are gathered into one b_transport
+//    of up to max_burst bytes, issued before the next read, non-sequential write or sync.
+//    Only enable this for memory-like targets.
+// Time the model spends computing is added with inc().
+
+class tlm2_lt_initiator : public sc_module
+{
+public:
+  tlm_utils::simple_initiator_socket<tlm2_lt_initiator> tlm2_initiator;
+  tlm_utils::tlm_quantumkeeper qk;
+
+  bool use_dmi{true};
+  unsigned max_burst{0};
+
+  uint64_t dmi_accesses{0};
+  uint64_t transactions{0};
+
+  tlm2_lt_initiator(sc_module_name nm)
+   : sc_module(nm)
+   , tlm2_initiator("tlm2_initiator")
+  {
+    tlm2_initiator.register_invalidate_direct_mem_ptr(this, &tlm2_lt_initiator::invalidate_direct_mem_ptr);
+    qk.reset();
+  }
+
+  bool read(uint64_t addr, void* data, unsigned len) {
+    flush();
+    return access(tlm::TLM_READ_COMMAND, addr, (unsigned char*)data, len);
+  }
+
+  bool write(uint64_t addr, const void* data, unsigned len) {
+    const unsigned char* bytes = (const unsigned char*)data;
+
+    if ((max_burst == 0) || (len > max_burst) || find_dmi(tlm::TLM_WRITE_COMMAND, addr, len)) {
+      flush();
+      return access(tlm::TLM_WRITE_COMMAND, addr, (unsigned char*)bytes, len);
+    }
+
+    if (!pending.empty() &&
+        ((addr != (pending_addr + pending.size())) || ((pending.size() + len) > max_burst)))
+      flush();
+
+    if (pending.empty())
+      pending_addr = addr;
+    pending.insert(pending.end(), bytes, bytes + len);
+    return true;
+  }
+
+  template <class T>
+  T read(uint64_t addr) {
+    T v{0};
+    read(addr, &v, sizeof(T));
+    return v;
+  }
+
+  template <class T>
+  bool write(uint64_t addr, const T& v) {
+    return write(addr, &v, sizeof(T));
+  }
+
+  // Issues the pending aggregated write, if any
+  bool flush() {
+    if (pending.empty())
+      return true;
+
+    std::vector<unsigned char> burst;
+    burst.swap(pending);
+    bool ok = access(tlm::TLM_WRITE_COMMAND, pending_addr, &burst[0], burst.size());
+    if (!ok)
+      SC_REPORT_ERROR("tlm2_lt_initiator", "aggregated write failed");
+    return ok;
+  }
+
+  // Time spent computing, between accesses
+  void inc(const sc_time& t) {
+    qk.inc(t);
+    if (qk.need_sync())
+      sync();
+  }
+
+  // Catches simulation time up with the local time of the model
+  void sync() {
+    flush();
+    qk.sync();
+  }
+
+  void reset_stats() {
+    dmi_accesses = 0;
+    transactions = 0;
+  }
+
+  void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end) {
+    for (unsigned i=0; i < dmi.size(); ) {
+      if ((dmi[i].get_start_address() <= end) && (dmi[i].get_end_address() >= start))
+        dmi.erase(dmi.begin() + i);
+      else
+        i++;
+    }
+  }
+
+private:
+  std::vector<tlm::tlm_dmi> dmi;
+  unsigned last_dmi{0};
+  std::vector<unsigned char> pending;
+  uint64_t pending_addr{0};
+
+  // Looks in the region that served the previous access first, since a target may grant
+  // many small regions (tlm2_lt_ram grants one page each)
+  tlm::tlm_dmi* find_dmi(tlm::tlm_command cmd, uint64_t addr, unsigned len) {
+    if (!use_dmi)
+      return 0;
+
+    if ((last_dmi < dmi.size()) && covers(dmi[last_dmi], cmd, addr, len))
+      return &dmi[last_dmi];
+
+    for (unsigned i=0; i < dmi.size(); i++) {
+      if (covers(dmi[i], cmd, addr, len)) {
+        last_dmi = i;
+        return &dmi[i];
+      }
+    }
+    return 0;
+  }
+
+  static bool covers(const tlm::tlm_dmi& d, tlm::tlm_command cmd, uint64_t addr, unsigned len) {
+    return (addr >= d.get_start_address()) && ((addr + len - 1) <= d.get_end_address()) &&
+           ((cmd == tlm::TLM_READ_COMMAND) ? d.is_read_allowed() : d.is_write_allowed());
+  }
+
+  bool access(tlm::tlm_command cmd, uint64_t addr, unsigned char* data, unsigned len) {
+    bool ok = true;
+    tlm::tlm_dmi* d = find_dmi(cmd, addr, len);
+
+    if (d) {
+      unsigned char* p = d->get_dmi_ptr() + (addr - d->get_start_address());
+      if (cmd == tlm::TLM_READ_COMMAND) {
+        memcpy(data, p, len);
+        qk.inc(d->get_read_latency());
+      } else {
+        memcpy(p, data, len);
+        qk.inc(d->get_write_latency());
+      }
+      dmi_accesses++;
+    } else {
+      tlm::tlm_generic_payload trans;
+      sc_time delay = qk.get_local_time();
+
+      trans.set_command(cmd);
+      trans.set_address(addr);
+      trans.set_data_ptr(data);
+      trans.set_data_length(len);
+      trans.set_byte_enable_ptr(0);
+      trans.set_byte_enable_length(0);
+      trans.set_streaming_width(len);
+      trans.set_dmi_allowed(false);
+      trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+      tlm2_initiator->b_transport(trans, delay);
+      qk.set(delay);
+      transactions++;
+      ok = trans.is_response_ok();
+
+      if (use_dmi && trans.is_dmi_allowed()) {
+        tlm::tlm_dmi region;
+        trans.set_address(addr);
+        if (tlm2_initiator->get_direct_mem_ptr(trans, region))
+          dmi.push_back(region);
+      }
+    }
+
+    if (qk.need_sync())
+      qk.sync();
+
+    return ok;
+  }
+};